@@ -91,6 +91,11 @@ kwlError kwlEngine_hostSpecificDeinitialize(kwlEngine* engine)
     return KWL_NO_ERROR;
 }
 
+void kwlEngine_hostSpecificWaitForMixer(kwlEngine* engine)
+{
+    /*the mixer runs in the remote IO callback.*/
+}
+
 void audioSessionInterruptionCallback(void *inClientData,  UInt32 inInterruptionState)
 {
     if (inInterruptionState == kAudioSessionBeginInterruption)
@@ -198,23 +203,10 @@ OSStatus coreAudioOutputCallback(void *inRefCon,
     
     const int numChannels = ioData->mBuffers[0].mNumberChannels;
     short* buffer = (short*) ioData->mBuffers[0].mData;
-    int currFrame = 0;
-    while (currFrame < inNumberFrames)
-    {
-        int numFramesToMix = inNumberFrames - currFrame;
-        if (numFramesToMix > KWL_TEMP_BUFFER_SIZE_IN_FRAMES)
-        {
-            numFramesToMix = KWL_TEMP_BUFFER_SIZE_IN_FRAMES;
-        }
+    KWL_ASSERT(numChannels == mixer->numOutChannels);
     
-        /*prepare a new buffer*/
-        kwlMixer_render(mixer, mixer->outBuffer, numFramesToMix);
-
-        kwlFloatToInt16(mixer->outBuffer, 
-                        &buffer[currFrame * numChannels], 
-                        numFramesToMix * numChannels);
-        currFrame += numFramesToMix;
-    }
+    /*mix, clamp and convert to 16 bit samples straight into the remote IO buffer.*/
+    kwlMixer_renderToHostBuffer(mixer, buffer, KWL_SAMPLE_FORMAT_INT16, inNumberFrames);
     
     return noErr;
 }
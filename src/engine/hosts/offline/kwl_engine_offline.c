@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_engine_offline.h"
+#include "../../kwl_assert.h"
+#include "../../kwl_engine.h"
+#include "../../kwl_synchronization.h"
+
+/** Renders a number of frames through the mixer of a given engine instance. */
+static int kwlOfflineHost_renderMixer(kwlInstanceHandle instance, 
+                                      void* outBuffer, 
+                                      kwlSampleFormat format, 
+                                      int numFrames)
+{
+    if (instance == NULL)
+    {
+        return 0;
+    }
+    
+    while (kwlAtomicCompareAndSwap(&instance->isOfflineHostRendering, 0, 1) == 0)
+    {
+        /*the engine thread is rendering a single buffer while blocking, so just spin.*/
+    }
+    
+    kwlMixer_renderToHostBuffer(instance->mixer, outBuffer, format, numFrames);
+    
+    kwlMemoryBarrier();
+    instance->isOfflineHostRendering = 0;
+    return numFrames;
+}
+
+int kwlOfflineHost_render(float* outBuffer, int numFrames)
+{
+    return kwlOfflineHost_renderMixer(kwlInstanceGetCurrent(), outBuffer, KWL_SAMPLE_FORMAT_FLOAT32, numFrames);
+}
+
+int kwlOfflineHost_renderInt16(short* outBuffer, int numFrames)
+{
+    return kwlOfflineHost_renderMixer(kwlInstanceGetCurrent(), outBuffer, KWL_SAMPLE_FORMAT_INT16, numFrames);
+}
+
+int kwlOfflineHost_renderInt24(unsigned char* outBuffer, int numFrames)
+{
+    return kwlOfflineHost_renderMixer(kwlInstanceGetCurrent(), outBuffer, KWL_SAMPLE_FORMAT_INT24, numFrames);
+}
+
+int kwlOfflineHost_renderInstance(kwlInstanceHandle instance, float* outBuffer, int numFrames)
+{
+    return kwlOfflineHost_renderMixer(instance, outBuffer, KWL_SAMPLE_FORMAT_FLOAT32, numFrames);
+}
+
+int kwlOfflineHost_renderInstanceInt16(kwlInstanceHandle instance, short* outBuffer, int numFrames)
+{
+    return kwlOfflineHost_renderMixer(instance, outBuffer, KWL_SAMPLE_FORMAT_INT16, numFrames);
+}
+
+int kwlOfflineHost_renderInstanceInt24(kwlInstanceHandle instance, unsigned char* outBuffer, int numFrames)
+{
+    return kwlOfflineHost_renderMixer(instance, outBuffer, KWL_SAMPLE_FORMAT_INT24, numFrames);
+}
+
+int kwlOfflineHost_getNumOutputChannels(void)
+{
+    kwlInstanceHandle instance = kwlInstanceGetCurrent();
+    return instance != NULL ? instance->mixer->numOutChannels : 0;
+}
+
+/** 
+ * Initializes the offline host. No audio device is opened, the engine's mixer is 
+ * driven by calls to kwlOfflineHost_render.
+ */
+kwlError kwlEngine_hostSpecificInitialize(kwlEngine* engine, int sampleRate, int numOutChannels, int numInChannels, int bufferSize)
+{
+    /*nothing to set up, the mixer of each engine instance is rendered on demand.*/
+    return KWL_NO_ERROR;
+}
+
+/**
+ * Shuts down the offline host.
+ */
+kwlError kwlEngine_hostSpecificDeinitialize(kwlEngine* engine)
+{
+    return KWL_NO_ERROR;
+}
+
+/**
+ * Renders a buffer, discarding the output, since nothing is mixed unless the application 
+ * renders. Does nothing if another thread is rendering, in which case that thread makes
+ * the mixer handle the request.
+ */
+void kwlEngine_hostSpecificWaitForMixer(kwlEngine* engine)
+{
+    if (kwlAtomicCompareAndSwap(&engine->isOfflineHostRendering, 0, 1) == 0)
+    {
+        return;
+    }
+    
+    const int numFrames = engine->bufferSize > 0 ? engine->bufferSize : KWL_TEMP_BUFFER_SIZE_IN_FRAMES;
+    kwlMixer_renderToHostBuffer(engine->mixer, NULL, KWL_SAMPLE_FORMAT_FLOAT32, numFrames);
+    
+    kwlMemoryBarrier();
+    engine->isOfflineHostRendering = 0;
+}
@@ -0,0 +1,92 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+/*! \file */ 
+
+#ifndef KWL__ENGINE_OFFLINE_H
+#define KWL__ENGINE_OFFLINE_H
+
+#include "../../kowalski.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * Renders a number of frames through the mixer of the current engine instance. The offline
+ * host has no audio device, so audio is only mixed when this function is called, 
+ * which makes rendering deterministic. Useful for replaying API call traces and for
+ * profiling the mixer. Blocking calls like \c kwlEngineDataUnload and \c kwlDeinitialize
+ * render on the calling thread until they are done, discarding the output, unless another
+ * thread is rendering.
+ * @param outBuffer A buffer receiving the interleaved output samples, or NULL to discard them.
+ * Must hold \c numFrames times the number of output channels samples.
+ * @param numFrames The number of frames to render.
+ * @return The number of frames rendered, i.e zero if the engine is not initialized.
+ */
+int kwlOfflineHost_render(float* outBuffer, int numFrames);
+
+/**
+ * Like \c kwlOfflineHost_render, but outputs signed 16 bit samples, dithered 
+ * if enabled using \c kwlDitherSetEnabled.
+ */
+int kwlOfflineHost_renderInt16(short* outBuffer, int numFrames);
+
+/**
+ * Like \c kwlOfflineHost_render, but outputs packed, little endian, signed 24 bit 
+ * samples, i.e three bytes per sample, dithered if enabled using \c kwlDitherSetEnabled.
+ */
+int kwlOfflineHost_renderInt24(unsigned char* outBuffer, int numFrames);
+
+/**
+ * Returns the number of output channels of the current engine instance, or zero 
+ * if no instance is current.
+ */
+int kwlOfflineHost_getNumOutputChannels(void);
+
+/**
+ * Like \c kwlOfflineHost_render, but renders a given engine instance, which does not need to be 
+ * current. Different instances can be rendered on different threads at the same time, and while 
+ * API calls are made for other instances.
+ * @param instance The instance to render, or NULL to render nothing.
+ */
+int kwlOfflineHost_renderInstance(kwlInstanceHandle instance, float* outBuffer, int numFrames);
+
+/**
+ * Like \c kwlOfflineHost_renderInt16, but renders a given engine instance.
+ * @see kwlOfflineHost_renderInstance
+ */
+int kwlOfflineHost_renderInstanceInt16(kwlInstanceHandle instance, short* outBuffer, int numFrames);
+
+/**
+ * Like \c kwlOfflineHost_renderInt24, but renders a given engine instance.
+ * @see kwlOfflineHost_renderInstance
+ */
+int kwlOfflineHost_renderInstanceInt24(kwlInstanceHandle instance, unsigned char* outBuffer, int numFrames);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL__ENGINE_OFFLINE_H*/
@@ -51,44 +51,17 @@ static int paCallback(const void *inputBuffer,
       final output buffers.*/
     kwlMixer *mixer = (kwlMixer*)userData;    
     
-    /*Get the number of output channels.*/
-    const int numOutChannels = mixer->numOutChannels;
+    /*Fill the output buffer. The mixer renders straight into
+      the float buffer provided by PortAudio, without any
+      intermediate copy.*/
+    kwlMixer_renderToHostBuffer(mixer, 
+                                outputBuffer, 
+                                KWL_SAMPLE_FORMAT_FLOAT32, 
+                                (int)framesPerBuffer);
     
-    /*Fill the output buffer. For efficiency reasons, the 
-      mixer has an internal maximum buffer size determined 
-      by KWL_TEMP_BUFFER_SIZE_IN_FRAMES. If the size of the 
-      requested output buffer exceeds the internal buffer 
-      size, multiple calls to kwlMixer_render 
-      are made. This is typically not the case.*/
-    int currFrame = 0;
-    while (currFrame < framesPerBuffer)
-    {
-        /*Compute the number of frames to mix.*/
-        int numFramesToMix = framesPerBuffer - currFrame;
-        if (numFramesToMix > KWL_TEMP_BUFFER_SIZE_IN_FRAMES)
-        {
-            numFramesToMix = KWL_TEMP_BUFFER_SIZE_IN_FRAMES;
-        }
-        
-        /*Perform mixing.*/
-        kwlMixer_render(mixer, 
-                                          mixer->outBuffer, 
-                                          numFramesToMix);
-        
-        /*Copy mixed samples to the output buffer*/
-        int outIdx = currFrame * numOutChannels;
-        
-        kwlMemcpy(&((float*)outputBuffer)[outIdx], 
-                  mixer->outBuffer, 
-                  sizeof(float) * numOutChannels * numFramesToMix);
-        
-        kwlMixer_processInputBuffer(mixer, 
-                                         &((float*)inputBuffer)[outIdx], 
-                                         numFramesToMix);
-        
-        /*Increment write position*/
-        currFrame += numFramesToMix;
-    }
+    kwlMixer_processInputBuffer(mixer, 
+                                (const float*)inputBuffer, 
+                                (int)framesPerBuffer);
     
     /*Return 0 to indicate that everything went well.*/
     return 0;
@@ -154,3 +127,11 @@ kwlError kwlEngine_hostSpecificDeinitialize(kwlEngine* engine)
     KWL_ASSERT(err == paNoError);
     return KWL_NO_ERROR;
 }
+
+/**
+ * Does nothing, the mixer runs in the PortAudio stream callback.
+ * @param engine
+ */
+void kwlEngine_hostSpecificWaitForMixer(kwlEngine* engine)
+{
+}
@@ -35,17 +35,9 @@ void kwlSDLAudioCallback(void *userData, Uint8 *stream, int numBytes)
     /*compute the number of frames corresponding to the requested number of bytes*/
     int numFrames = numBytes / numChannels / bytesPerOutSample;
 
-    /*get the next buffer from the software mixer*/
-    
-    kwlMixer_render(mixer, 
-                                      (float*)&mixer->outBuffer, 
-                                      numFrames, 
-                                      mixer->numChannels);
-    
-    /*convert the 32 bit float samples of the mixer to 16 bit ints for output.*/
-    short* streamShort = (short*)stream;
-    
-    kwlFloatToInt16(mixer->outBuffer, streamShort, numChannels * numFrames);
+    /*mix the next buffer and convert the 32 bit float samples of the 
+      mixer to 16 bit ints straight into the output stream.*/
+    kwlMixer_renderToHostBuffer(mixer, stream, KWL_SAMPLE_FORMAT_INT16, numFrames);
     /*
     for (int ch = 0; ch < numChannels; ch++)
     {
@@ -109,3 +101,11 @@ kwlError kwlEngine_hostSpecificDeinitialize(kwlEngine* engine)
     SDL_CloseAudio();
     return KWL_NO_ERROR;
 }
+
+/**
+ * Does nothing, the mixer runs in the SDL audio callback.
+ * @param engine
+ */
+void kwlEngine_hostSpecificWaitForMixer(kwlEngine* engine)
+{
+}
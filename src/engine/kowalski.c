@@ -24,6 +24,7 @@ freely, subject to the following restrictions:
 #include "kwl_eventinstance.h"
 #include "kowalski.h"
 #include "kowalski.h"
+#include "kwl_apitrace.h"
 #include "kwl_audiofileutil.h"
 #include "kwl_dspunit.h"
 #include "kwl_memory.h"
@@ -35,6 +36,45 @@ freely, subject to the following restrictions:
 
 kwlEngine* engine = NULL;
 
+/** 
+ * The number of threads adding a command to the command queue of any instance. Counted 
+ * before the closed flag of the instance is checked, so kwlDeinitialize can wait for 
+ * producers that may still be writing to the queue it is about to free.
+ */
+static volatile unsigned int numCommandProducers = 0;
+
+/** 
+ * Replaces the current instance. \c engine may be read from other threads through
+ * kwlInstanceGetCurrent, so it is written atomically.
+ */
+static void kwlPublishEngine(kwlEngine* instance)
+{
+    kwlEngine* current;
+    do
+    {
+        current = (kwlEngine*)kwlAtomicLoadPointer((void* volatile*)&engine);
+    }
+    while (kwlAtomicCompareAndSwapPointer((void* volatile*)&engine, current, instance) == 0);
+}
+
+/**
+ * Stops an instance from accepting commands and returns once no other thread is adding
+ * a command to its queue, after which the queue may be freed. Unpublishes the instance 
+ * if it is current.
+ */
+static void kwlCloseCommandQueue(kwlEngine* instance)
+{
+    kwlAtomicCompareAndSwap(&instance->isCommandQueueClosed, 0, 1);
+    kwlAtomicCompareAndSwapPointer((void* volatile*)&engine, instance, NULL);
+    
+    /*producers only copy a single command while counted, so spinning is fine here.
+      a producer that is counted after this check sees the closed flag and backs off.*/
+    while (kwlAtomicAdd(&numCommandProducers, 0) != 0)
+    {
+        kwlMemoryBarrier();
+    }
+}
+
 kwlError error = KWL_NO_ERROR;
 
 static void kwlSetError(kwlError err)
@@ -50,6 +90,137 @@ static void kwlSetError(kwlError err)
     }
 }
 
+/** The writer of the API call trace being recorded, if any. */
+static kwlAPITraceWriter traceWriter;
+/** Non-zero if API calls are being recorded. */
+static int isTraceRecording = 0;
+/** 
+ * Non-zero while recording is suspended, i.e during blocking calls 
+ * that update the engine internally.
+ */
+static int traceSuspendCount = 0;
+/** The number of kwlUpdate calls in progress, which is more than one if updates are made from callbacks. */
+static int traceUpdateDepth = 0;
+
+/** 
+ * The API state that belongs to an engine instance, i.e the error flag and the 
+ * trace recording state. Saved in the engine while another instance is current.
+ */
+typedef struct kwlInstanceState
+{
+    kwlError error;
+    kwlAPITraceWriter traceWriter;
+    int isTraceRecording;
+    int traceSuspendCount;
+    int traceUpdateDepth;
+} kwlInstanceState;
+
+/**
+ * Returns the number of frames the mixer of the current engine instance has rendered, 
+ * which is the position in the output a recorded call is replayed at.
+ */
+static long long kwlTraceGetFrame(void)
+{
+    if (engine == NULL)
+    {
+        return 0;
+    }
+    
+    kwlMixerStats stats;
+    kwlMixer_getStats(engine->mixer, &stats);
+    return stats.numFramesRendered;
+}
+
+/**
+ * Starts a trace record for an API call.
+ * @param opcode The opcode of the call.
+ * @return Non-zero if the call is being recorded, in which case the caller 
+ * should write the arguments of the call to \c traceWriter.
+ */
+static int kwlTraceBeginRecord(kwlAPITraceOpcode opcode)
+{
+    if (isTraceRecording == 0 || traceSuspendCount > 0)
+    {
+        return 0;
+    }
+    
+    kwlAPITraceWriter_beginRecord(&traceWriter, opcode, kwlTraceGetFrame(), 0);
+    return 1;
+}
+
+static void kwlTraceRecord(kwlAPITraceOpcode opcode)
+{
+    kwlTraceBeginRecord(opcode);
+}
+
+static void kwlTraceRecordInt(kwlAPITraceOpcode opcode, int value)
+{
+    if (kwlTraceBeginRecord(opcode))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, value);
+    }
+}
+
+static void kwlTraceRecordIntAndInt(kwlAPITraceOpcode opcode, int firstValue, int secondValue)
+{
+    if (kwlTraceBeginRecord(opcode))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, firstValue);
+        kwlAPITraceWriter_writeInt(&traceWriter, secondValue);
+    }
+}
+
+static void kwlTraceRecordIntAndFloat(kwlAPITraceOpcode opcode, int intValue, float floatValue)
+{
+    if (kwlTraceBeginRecord(opcode))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, intValue);
+        kwlAPITraceWriter_writeFloat(&traceWriter, floatValue);
+    }
+}
+
+static void kwlTraceRecordVector(kwlAPITraceOpcode opcode, float x, float y, float z)
+{
+    if (kwlTraceBeginRecord(opcode))
+    {
+        kwlAPITraceWriter_writeFloat(&traceWriter, x);
+        kwlAPITraceWriter_writeFloat(&traceWriter, y);
+        kwlAPITraceWriter_writeFloat(&traceWriter, z);
+    }
+}
+
+static void kwlTraceRecordIntAndVector(kwlAPITraceOpcode opcode, int value, float x, float y, float z)
+{
+    if (kwlTraceBeginRecord(opcode))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, value);
+        kwlAPITraceWriter_writeFloat(&traceWriter, x);
+        kwlAPITraceWriter_writeFloat(&traceWriter, y);
+        kwlAPITraceWriter_writeFloat(&traceWriter, z);
+    }
+}
+
+static void kwlTraceRecordStringAndInt(kwlAPITraceOpcode opcode, const char* const string, int value)
+{
+    if (kwlTraceBeginRecord(opcode))
+    {
+        kwlAPITraceWriter_writeString(&traceWriter, string);
+        kwlAPITraceWriter_writeInt(&traceWriter, value);
+    }
+}
+
+static void kwlTraceRecordOneShot(kwlEventDefinitionHandle handle, int isPositional, float x, float y, float z)
+{
+    if (kwlTraceBeginRecord(KWL_TRACE_EVENT_START_ONE_SHOT))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, handle);
+        kwlAPITraceWriter_writeInt(&traceWriter, isPositional);
+        kwlAPITraceWriter_writeFloat(&traceWriter, x);
+        kwlAPITraceWriter_writeFloat(&traceWriter, y);
+        kwlAPITraceWriter_writeFloat(&traceWriter, z);
+    }
+}
+
 kwlError kwlGetError(void)
 {
     kwlError errorToReturn = error;
@@ -64,6 +235,7 @@ void kwlEventSetPitch(kwlEventHandle handle, float pitchInPercent)
         kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
+    kwlTraceRecordIntAndFloat(KWL_TRACE_EVENT_SET_PITCH, handle, pitchInPercent);
     kwlSetError(kwlEngine_eventSetPitch(engine, handle, pitchInPercent));
 }
 
@@ -75,6 +247,7 @@ void kwlEventSetGain(kwlEventHandle handle, float gain)
         return;
     }
     
+    kwlTraceRecordIntAndFloat(KWL_TRACE_EVENT_SET_GAIN, handle, gain);
     kwlSetError(kwlEngine_eventSetGain(engine, handle, gain, 0));
 }
 
@@ -86,6 +259,7 @@ void kwlEventSetLinearGain(kwlEventHandle handle, float gain)
         return;
     }
     
+    kwlTraceRecordIntAndFloat(KWL_TRACE_EVENT_SET_LINEAR_GAIN, handle, gain);
     kwlSetError(kwlEngine_eventSetGain(engine, handle, gain, 1));
 }
 
@@ -98,6 +272,7 @@ void kwlEventSetPosition(kwlEventHandle handle, float posX, float posY, float po
         return;
     }
     
+    kwlTraceRecordIntAndVector(KWL_TRACE_EVENT_SET_POSITION, handle, posX, posY, posZ);
     kwlSetError(kwlEngine_eventSetPosition(engine, handle, posX, posY, posZ));
 }
 
@@ -109,9 +284,72 @@ void kwlEventSetVelocity(kwlEventHandle handle, float velX, float velY, float ve
         return;
     }
     
+    kwlTraceRecordIntAndVector(KWL_TRACE_EVENT_SET_VELOCITY, handle, velX, velY, velZ);
     kwlSetError(kwlEngine_eventSetVelocity(engine, handle, velX, velY, velZ));
 }
 
+/*batched calls are recorded one element at a time, so traces can be replayed without them.*/
+
+void kwlEventSetPositions(const kwlEventHandle* handles, 
+                          const float* posX, const float* posY, const float* posZ, 
+                          int numEvents)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    if (isTraceRecording != 0 && handles != NULL && posX != NULL && posY != NULL && posZ != NULL)
+    {
+        for (int i = 0; i < numEvents; i++)
+        {
+            kwlTraceRecordIntAndVector(KWL_TRACE_EVENT_SET_POSITION, handles[i], posX[i], posY[i], posZ[i]);
+        }
+    }
+    kwlSetError(kwlEngine_eventsSetPositions(engine, handles, posX, posY, posZ, numEvents));
+}
+
+void kwlEventSetVelocities(const kwlEventHandle* handles, 
+                           const float* velX, const float* velY, const float* velZ, 
+                           int numEvents)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    if (isTraceRecording != 0 && handles != NULL && velX != NULL && velY != NULL && velZ != NULL)
+    {
+        for (int i = 0; i < numEvents; i++)
+        {
+            kwlTraceRecordIntAndVector(KWL_TRACE_EVENT_SET_VELOCITY, handles[i], velX[i], velY[i], velZ[i]);
+        }
+    }
+    kwlSetError(kwlEngine_eventsSetVelocities(engine, handles, velX, velY, velZ, numEvents));
+}
+
+void kwlEventSetGains(const kwlEventHandle* handles, const float* gains, int numEvents, int isLinearGain)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    isLinearGain = isLinearGain != 0;
+    if (isTraceRecording != 0 && handles != NULL && gains != NULL)
+    {
+        const kwlAPITraceOpcode opcode = isLinearGain ? KWL_TRACE_EVENT_SET_LINEAR_GAIN : KWL_TRACE_EVENT_SET_GAIN;
+        for (int i = 0; i < numEvents; i++)
+        {
+            kwlTraceRecordIntAndFloat(opcode, handles[i], gains[i]);
+        }
+    }
+    kwlSetError(kwlEngine_eventsSetGains(engine, handles, gains, numEvents, isLinearGain));
+}
+
 void kwlEventSetOrientation(kwlEventHandle handle, float directionX, float directionY, float directionZ)
 {
     if (engine == NULL)
@@ -120,6 +358,7 @@ void kwlEventSetOrientation(kwlEventHandle handle, float directionX, float direc
         return;
     }
     
+    kwlTraceRecordIntAndVector(KWL_TRACE_EVENT_SET_ORIENTATION, handle, directionX, directionY, directionZ);
     kwlSetError(kwlEngine_eventSetOrientation(engine, handle, directionX, directionY, directionZ));
 }
 
@@ -131,6 +370,7 @@ void kwlEventSetBalance(kwlEventHandle handle, float balance)
         return;
     }
     
+    kwlTraceRecordIntAndFloat(KWL_TRACE_EVENT_SET_BALANCE, handle, balance);
     kwlSetError(kwlEngine_eventSetBalance(engine, handle, balance));
 }
 
@@ -144,6 +384,7 @@ kwlEventHandle kwlEventGetHandle(const char* const eventId)
     
     kwlEventHandle handle = 0;
     kwlSetError(kwlEngine_eventGetHandle(engine, eventId, &handle));
+    kwlTraceRecordStringAndInt(KWL_TRACE_EVENT_GET_HANDLE, eventId, handle);
     return handle;
 }
 
@@ -159,6 +400,7 @@ kwlEventDefinitionHandle kwlEventDefinitionGetHandle(const char* const eventDefi
     kwlSetError(kwlEngine_eventDefinitionGetHandle(engine, 
                                                         eventDefinitionID, 
                                                         &handle));
+    kwlTraceRecordStringAndInt(KWL_TRACE_EVENT_DEFINITION_GET_HANDLE, eventDefinitionID, handle);
     return handle;
 }
 
@@ -172,6 +414,13 @@ kwlEventHandle kwlEventCreateWithFile(const char* const audioFilePath, kwlEventT
     
     kwlEventHandle handle = 0;
     kwlSetError(kwlEngine_eventCreateWithFile(engine, audioFilePath, &handle, eventType, streamFromDisk));
+    if (kwlTraceBeginRecord(KWL_TRACE_EVENT_CREATE_WITH_FILE))
+    {
+        kwlAPITraceWriter_writeString(&traceWriter, audioFilePath);
+        kwlAPITraceWriter_writeInt(&traceWriter, eventType);
+        kwlAPITraceWriter_writeInt(&traceWriter, streamFromDisk);
+        kwlAPITraceWriter_writeInt(&traceWriter, handle);
+    }
     return handle;
 }
 
@@ -185,6 +434,19 @@ kwlEventHandle kwlEventCreateWithBuffer(kwlPCMBuffer* buffer, kwlEventType event
     
     kwlEventHandle handle = 0;
     kwlSetError(kwlEngine_eventCreateWithBuffer(engine, buffer, &handle, eventType));
+    if (buffer != NULL && kwlTraceBeginRecord(KWL_TRACE_EVENT_CREATE_WITH_BUFFER))
+    {
+        /*the samples are recorded too, since the buffer is owned by the caller.*/
+        const int hasData = buffer->pcmData != NULL && buffer->numFrames > 0 && buffer->numChannels > 0;
+        kwlAPITraceWriter_writeInt(&traceWriter, hasData ? buffer->numFrames : 0);
+        kwlAPITraceWriter_writeInt(&traceWriter, hasData ? buffer->numChannels : 0);
+        if (hasData)
+        {
+            kwlAPITraceWriter_writeShorts(&traceWriter, buffer->pcmData, buffer->numFrames * buffer->numChannels);
+        }
+        kwlAPITraceWriter_writeInt(&traceWriter, eventType);
+        kwlAPITraceWriter_writeInt(&traceWriter, handle);
+    }
     return handle;
 }
 
@@ -196,6 +458,7 @@ void kwlEventRelease(kwlEventHandle handle)
         return;
     }
     
+    kwlTraceRecordInt(KWL_TRACE_EVENT_RELEASE, handle);
     kwlSetError(kwlEngine_eventRelease(engine, handle));
 }
 
@@ -207,7 +470,8 @@ void kwlEventStart(kwlEventHandle handle)
         return;
     }
     
-    kwlSetError(kwlEngine_eventStart(engine, handle, 0));
+    kwlTraceRecordInt(KWL_TRACE_EVENT_START, handle);
+    kwlSetError(kwlEngine_eventStart(engine, handle, 0, 0));
 }
 
 void kwlEventStartOneShot(kwlEventDefinitionHandle handle)
@@ -218,7 +482,8 @@ void kwlEventStartOneShot(kwlEventDefinitionHandle handle)
         return;
     }    
     
-    kwlSetError(kwlEngine_eventStartOneShot(engine, handle, 0.0f, 0.0f, 0.0f, 0, NULL, NULL));
+    kwlTraceRecordOneShot(handle, 0, 0.0f, 0.0f, 0.0f);
+    kwlSetError(kwlEngine_eventStartOneShot(engine, handle, 0.0f, 0.0f, 0.0f, 0, NULL, NULL, 0));
 }
 
 void kwlEventStartOneShotAt(kwlEventDefinitionHandle handle, float x, float y, float z)
@@ -229,7 +494,28 @@ void kwlEventStartOneShotAt(kwlEventDefinitionHandle handle, float x, float y, f
         return;
     }
     
-    kwlSetError(kwlEngine_eventStartOneShot(engine, handle, x, y, z, 1, NULL, NULL));
+    kwlTraceRecordOneShot(handle, 1, x, y, z);
+    kwlSetError(kwlEngine_eventStartOneShot(engine, handle, x, y, z, 1, NULL, NULL, 0));
+}
+
+void kwlEventStartOneShotsAt(const kwlEventDefinitionHandle* handles, 
+                             const float* x, const float* y, const float* z, 
+                             int numEvents)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    if (isTraceRecording != 0 && handles != NULL && x != NULL && y != NULL && z != NULL)
+    {
+        for (int i = 0; i < numEvents; i++)
+        {
+            kwlTraceRecordOneShot(handles[i], 1, x[i], y[i], z[i]);
+        }
+    }
+    kwlSetError(kwlEngine_eventsStartOneShotsAt(engine, handles, x, y, z, numEvents));
 }
 
 void kwlEventSetCallback(kwlEventHandle handle, kwlEventStoppedCallack callback, void* userData)
@@ -252,7 +538,8 @@ void kwlEventStartOneShotWithCallback(kwlEventDefinitionHandle eventDefinition,
         return;
     }
     
-    kwlSetError(kwlEngine_eventStartOneShot(engine, eventDefinition, 0.0f, 0.0f, 0.0f, 0, callback, userData));
+    kwlTraceRecordOneShot(eventDefinition, 0, 0.0f, 0.0f, 0.0f);
+    kwlSetError(kwlEngine_eventStartOneShot(engine, eventDefinition, 0.0f, 0.0f, 0.0f, 0, callback, userData, 0));
 }
 
 void kwlEventStartOneShotWithCallbackAt(kwlEventDefinitionHandle eventDefinition, float x, float y, float z, kwlEventStoppedCallack callback, void* userData)
@@ -263,7 +550,8 @@ void kwlEventStartOneShotWithCallbackAt(kwlEventDefinitionHandle eventDefinition
         return;
     }
     
-    kwlSetError(kwlEngine_eventStartOneShot(engine, eventDefinition, x, y, z, 1, callback, userData));
+    kwlTraceRecordOneShot(eventDefinition, 1, x, y, z);
+    kwlSetError(kwlEngine_eventStartOneShot(engine, eventDefinition, x, y, z, 1, callback, userData, 0));
     
 }
 
@@ -275,7 +563,8 @@ void kwlEventStartFade(kwlEventHandle handle, float fadeTime)
         return;
     }
     
-    kwlSetError(kwlEngine_eventStart(engine, handle, fadeTime));
+    kwlTraceRecordIntAndFloat(KWL_TRACE_EVENT_START_FADE, handle, fadeTime);
+    kwlSetError(kwlEngine_eventStart(engine, handle, fadeTime, 0));
 }
 
 void kwlEventStop(kwlEventHandle handle)
@@ -286,7 +575,8 @@ void kwlEventStop(kwlEventHandle handle)
         return;
     }
     
-    kwlSetError(kwlEngine_eventStop(engine, handle, 0));
+    kwlTraceRecordInt(KWL_TRACE_EVENT_STOP, handle);
+    kwlSetError(kwlEngine_eventStop(engine, handle, 0, 0));
 }
 
 void kwlEventStopFade(kwlEventHandle handle, float fadeTime)
@@ -297,7 +587,45 @@ void kwlEventStopFade(kwlEventHandle handle, float fadeTime)
         return;
     }
     
-    kwlSetError(kwlEngine_eventStop(engine, handle, fadeTime));
+    kwlTraceRecordIntAndFloat(KWL_TRACE_EVENT_STOP_FADE, handle, fadeTime);
+    kwlSetError(kwlEngine_eventStop(engine, handle, fadeTime, 0));
+}
+
+void kwlEventStartImmediately(kwlEventHandle handle, float fadeTime)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    /*traces are replayed one update at a time, so immediate commands are recorded as regular ones.*/
+    kwlTraceRecordIntAndFloat(KWL_TRACE_EVENT_START_FADE, handle, fadeTime);
+    kwlSetError(kwlEngine_eventStart(engine, handle, fadeTime, 1));
+}
+
+void kwlEventStopImmediately(kwlEventHandle handle, float fadeTime)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlTraceRecordIntAndFloat(KWL_TRACE_EVENT_STOP_FADE, handle, fadeTime);
+    kwlSetError(kwlEngine_eventStop(engine, handle, fadeTime, 1));
+}
+
+void kwlEventStartOneShotImmediately(kwlEventDefinitionHandle handle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlTraceRecordOneShot(handle, 0, 0.0f, 0.0f, 0.0f);
+    kwlSetError(kwlEngine_eventStartOneShot(engine, handle, 0.0f, 0.0f, 0.0f, 0, NULL, NULL, 1));
 }
 
 void kwlEventPause(kwlEventHandle handle)
@@ -308,6 +636,7 @@ void kwlEventPause(kwlEventHandle handle)
         return;
     }
     
+    kwlTraceRecordInt(KWL_TRACE_EVENT_PAUSE, handle);
     kwlSetError(kwlEngine_eventPause(engine, handle));
 }
 
@@ -319,6 +648,7 @@ void kwlEventResume(kwlEventHandle handle)
         return;
     }
     
+    kwlTraceRecordInt(KWL_TRACE_EVENT_RESUME, handle);
     kwlSetError(kwlEngine_eventResume(engine, handle));
 }
 
@@ -348,6 +678,7 @@ kwlMixBusHandle kwlMixBusGetHandle(const char* const busId)
     
     kwlMixBusHandle handle = 0;
     kwlSetError(kwlEngine_mixBusGetHandle(engine, busId, &handle));
+    kwlTraceRecordStringAndInt(KWL_TRACE_MIX_BUS_GET_HANDLE, busId, handle);
     return handle;
 }
 
@@ -359,6 +690,7 @@ void kwlMixBusSetGain(kwlMixBusHandle handle, float gain)
         return;
     }
     
+    kwlTraceRecordIntAndFloat(KWL_TRACE_MIX_BUS_SET_GAIN, handle, gain);
     kwlSetError(kwlEngine_mixBusSetGain(engine, handle, gain, 0));
 }
 
@@ -370,6 +702,7 @@ void kwlMixBusSetLinearGain(kwlMixBusHandle handle, float gain)
         return;
     }
     
+    kwlTraceRecordIntAndFloat(KWL_TRACE_MIX_BUS_SET_LINEAR_GAIN, handle, gain);
     kwlSetError(kwlEngine_mixBusSetGain(engine, handle, gain, 1));
 }
 
@@ -381,9 +714,71 @@ void kwlMixBusSetPitch(kwlMixBusHandle handle, float pitch)
         return;
     }
     
+    kwlTraceRecordIntAndFloat(KWL_TRACE_MIX_BUS_SET_PITCH, handle, pitch);
     kwlSetError(kwlEngine_mixBusSetPitch(engine, handle, pitch));
 }
 
+void kwlMixBusSetMeteringEnabled(kwlMixBusHandle handle, int enabled)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlTraceRecordIntAndInt(KWL_TRACE_MIX_BUS_SET_METERING_ENABLED, handle, enabled);
+    kwlSetError(kwlEngine_mixBusSetMeteringEnabled(engine, handle, enabled));
+}
+
+float kwlMixBusGetPeakLevel(kwlMixBusHandle handle, int channel)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0.0f;
+    }
+    
+    float peakLevel = 0.0f;
+    float rmsLevel = 0.0f;
+    kwlSetError(kwlEngine_mixBusGetLevels(engine, handle, channel, &peakLevel, &rmsLevel));
+    return peakLevel;
+}
+
+float kwlMixBusGetRMSLevel(kwlMixBusHandle handle, int channel)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0.0f;
+    }
+    
+    float peakLevel = 0.0f;
+    float rmsLevel = 0.0f;
+    kwlSetError(kwlEngine_mixBusGetLevels(engine, handle, channel, &peakLevel, &rmsLevel));
+    return rmsLevel;
+}
+
+void kwlMixBusSetFilterBatchingEnabled(kwlMixBusHandle handle, int enabled)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_mixBusSetFilterBatchingEnabled(engine, handle, enabled));
+}
+
+void kwlMixBusSetAuxSendLevel(kwlMixBusHandle handle, kwlMixBusHandle returnBusHandle, float level)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_mixBusSetAuxSendLevel(engine, handle, returnBusHandle, level));
+}
 
 kwlMixPresetHandle kwlMixPresetGetHandle(const char* const presetId)
 {
@@ -395,6 +790,7 @@ kwlMixPresetHandle kwlMixPresetGetHandle(const char* const presetId)
     
     kwlMixPresetHandle handle = 0;
     kwlSetError(kwlEngine_mixPresetGetHandle(engine, presetId, &handle));
+    kwlTraceRecordStringAndInt(KWL_TRACE_MIX_PRESET_GET_HANDLE, presetId, handle);
     return handle;
 }
 
@@ -406,6 +802,7 @@ void kwlMixPresetFadeTo(kwlMixPresetHandle presetHandle)
         return;
     }
     
+    kwlTraceRecordInt(KWL_TRACE_MIX_PRESET_FADE_TO, presetHandle);
     kwlSetError(kwlEngine_mixPresetSetActive(engine, presetHandle, 1));
 }
 
@@ -417,6 +814,7 @@ void kwlMixPresetSet(kwlMixPresetHandle presetHandle)
         return;
     }
     
+    kwlTraceRecordInt(KWL_TRACE_MIX_PRESET_SET, presetHandle);
     kwlSetError(kwlEngine_mixPresetSetActive(engine, presetHandle, 0));
 }
 
@@ -428,6 +826,7 @@ void kwlListenerSetPosition(float posX, float posY, float posZ)
         return;
     }
     
+    kwlTraceRecordVector(KWL_TRACE_LISTENER_SET_POSITION, posX, posY, posZ);
     kwlSetError(kwlEngine_setListenerPosition(engine, posX, posY, posZ));
 }
 
@@ -439,6 +838,7 @@ void kwlListenerSetVelocity(float velX, float velY, float velZ)
         return;
     }
     
+    kwlTraceRecordVector(KWL_TRACE_LISTENER_SET_VELOCITY, velX, velY, velZ);
     kwlSetError(kwlEngine_setListenerVelocity(engine, velX, velY, velZ));
 }
 
@@ -451,6 +851,16 @@ void kwlListenerSetOrientation(float directionX, float directionY, float directi
         return;
     }
     
+    if (kwlTraceBeginRecord(KWL_TRACE_LISTENER_SET_ORIENTATION))
+    {
+        kwlAPITraceWriter_writeFloat(&traceWriter, directionX);
+        kwlAPITraceWriter_writeFloat(&traceWriter, directionY);
+        kwlAPITraceWriter_writeFloat(&traceWriter, directionZ);
+        kwlAPITraceWriter_writeFloat(&traceWriter, upX);
+        kwlAPITraceWriter_writeFloat(&traceWriter, upY);
+        kwlAPITraceWriter_writeFloat(&traceWriter, upZ);
+    }
+    
     kwlSetError(kwlEngine_setListenerOrientation(engine, 
                                                       directionX, directionY, directionZ,
                                                       upX, upY, upZ));
@@ -468,6 +878,15 @@ void kwlSetDistanceAttenuationModel(kwlDistanceAttenuationModel type,
         return;
     }
     
+    if (kwlTraceBeginRecord(KWL_TRACE_SET_DISTANCE_ATTENUATION_MODEL))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, type);
+        kwlAPITraceWriter_writeInt(&traceWriter, clamp);
+        kwlAPITraceWriter_writeFloat(&traceWriter, maxDistance);
+        kwlAPITraceWriter_writeFloat(&traceWriter, rolloffFactor);
+        kwlAPITraceWriter_writeFloat(&traceWriter, referenceDistance);
+    }
+    
     kwlSetError(kwlEngine_setDistanceAttenuationModel(engine,
                                                            type, 
                                                            clamp, 
@@ -484,6 +903,12 @@ void kwlSetDopplerShiftParameters(float speedOfSound, float dopplerScale)
         return;
     }
     
+    if (kwlTraceBeginRecord(KWL_TRACE_SET_DOPPLER_SHIFT_PARAMETERS))
+    {
+        kwlAPITraceWriter_writeFloat(&traceWriter, speedOfSound);
+        kwlAPITraceWriter_writeFloat(&traceWriter, dopplerScale);
+    }
+    
     kwlSetError(kwlEngine_setDopplerShiftParameters(engine, speedOfSound, dopplerScale));
 }
 
@@ -495,6 +920,12 @@ void kwlSetConeAttenuationEnabled(int enableListenerCone, int enableEventCones)
         return;
     }
     
+    if (kwlTraceBeginRecord(KWL_TRACE_SET_CONE_ATTENUATION_ENABLED))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, enableListenerCone);
+        kwlAPITraceWriter_writeInt(&traceWriter, enableEventCones);
+    }
+    
     kwlSetError(kwlEngine_setConeAttenuationEnabled(engine, enableListenerCone, enableEventCones));
 }
 
@@ -506,6 +937,7 @@ void kwlListenerSetConeParameters(float innerConeAngle, float outerConeAngle, fl
         return;
     }
     
+    kwlTraceRecordVector(KWL_TRACE_LISTENER_SET_CONE_PARAMETERS, innerConeAngle, outerConeAngle, outerConeGain);
     kwlSetError(kwlEngine_setListenerConeParameters(engine, innerConeAngle, outerConeAngle, outerConeGain));
 }
 
@@ -517,6 +949,7 @@ void kwlMixerResume(void)
         return;
     }
     
+    kwlTraceRecord(KWL_TRACE_MIXER_RESUME);
     kwlSetError(kwlEngine_resume(engine));
 }
 
@@ -528,6 +961,7 @@ void kwlMixerPause(void)
         return;
     }
     
+    kwlTraceRecord(KWL_TRACE_MIXER_PAUSE);
     kwlSetError(kwlEngine_pause(engine));
 }
 
@@ -580,85 +1014,81 @@ void kwlLevelMeteringSetEnabled(int enabled)
         return;
     }
     
+    kwlTraceRecordInt(KWL_TRACE_LEVEL_METERING_SET_ENABLED, enabled);
     engine->mixer->isLevelMeteringEnabled.valueEngine = enabled;
 }
 
-
-void kwlUpdate(float timeStepSec)
+void kwlDitherSetEnabled(int enabled)
 {
     if (engine == NULL)
     {
         kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
-    if (timeStepSec < 0.0f)
-    {
-        kwlSetError(KWL_INVALID_PARAMETER_VALUE);
-        return;
-    }
     
-    kwlSetError(kwlEngine_update(engine, timeStepSec));
+    engine->mixer->isDitherEnabled.valueEngine = enabled != 0;
 }
 
-kwlWaveBankHandle kwlWaveBankLoad(const char* const path)
+void kwlRenderAheadSetEnabled(int enabled, int blockSize, int maxNumBlocksAhead)
 {
     if (engine == NULL)
     {
         kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return KWL_INVALID_HANDLE;
+        return;
     }
-    kwlWaveBankHandle handle = 0;
-    kwlSetError(kwlEngine_loadWaveBank(engine, path, &handle, 0));
-    return handle;
+    
+    kwlSetError(kwlEngine_setRenderAhead(engine, enabled, blockSize, maxNumBlocksAhead));
 }
 
-int kwlWaveBankIsLoaded(kwlWaveBankHandle handle)
+void kwlCPUProfilingSetEnabled(int enabled, float snapshotPeriodSec)
 {
     if (engine == NULL)
     {
         kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return 0;
+        return;
     }
     
-    int isLoaded = 0;
-    kwlSetError(kwlEngine_waveBankIsLoaded(engine, handle, &isLoaded));
-    return isLoaded;
+    kwlSetError(kwlEngine_setCPUProfilingEnabled(engine, enabled, snapshotPeriodSec));
 }
 
-int kwlWaveBankIsReferencedByPlayingEvent(kwlWaveBankHandle handle)
+void kwlCPUProfilingGetSnapshot(kwlCPUCostSnapshot* snapshot)
 {
     if (engine == NULL)
     {
+        kwlMemset(snapshot, 0, sizeof(kwlCPUCostSnapshot));
         kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return 0;
+        return;
     }
     
-    int isReferenced = 0;
-    kwlSetError(kwlEngine_waveBankIsReferencedByPlayingEvent(engine, handle, &isReferenced));
-    return isReferenced;
+    kwlSetError(kwlEngine_getCPUCostSnapshot(engine, snapshot));
 }
 
-void kwlWaveBankUnload(kwlWaveBankHandle waveBankHandle)
+void kwlGetMixerStats(kwlMixerStats* stats)
 {
     if (engine == NULL)
     {
+        kwlMemset(stats, 0, sizeof(kwlMixerStats));
         kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
-    kwlSetError(kwlEngine_requestUnloadWaveBank(engine, waveBankHandle, 0));
+    
+    kwlMixer_getStats(engine->mixer, stats);
 }
 
-void kwlWaveBankUnloadBlocking(kwlWaveBankHandle waveBankHandle)
+float kwlMixBusGetCPULoad(kwlMixBusHandle handle)
 {
     if (engine == NULL)
     {
         kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return;
+        return 0.0f;
     }
-    kwlSetError(kwlEngine_requestUnloadWaveBank(engine, waveBankHandle, 1));
+    
+    float load = 0.0f;
+    kwlSetError(kwlEngine_mixBusGetCPULoad(engine, handle, &load));
+    return load;
 }
 
-unsigned int kwlGetNumFramesMixed(void)
+float kwlEventGetCPULoad(kwlEventHandle handle)
 {
     if (engine == NULL)
     {
@@ -666,19 +1096,303 @@ unsigned int kwlGetNumFramesMixed(void)
         return 0.0f;
     }
     
-    unsigned int numFramesMixed = 0;
-    kwlSetError(kwlEngine_getNumFramesMixed(engine, &numFramesMixed));
-    return numFramesMixed;
+    float load = 0.0f;
+    kwlSetError(kwlEngine_eventGetCPULoad(engine, handle, &load));
+    return load;
 }
 
-int kwlIsEngineInitialized(void)
+float kwlDSPUnitGetCPULoad(kwlDSPUnitHandle dspUnit)
 {
-    return engine != NULL;
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0.0f;
+    }
+    
+    float load = 0.0f;
+    kwlSetError(kwlEngine_dspUnitGetCPULoad(engine, dspUnit, &load));
+    return load;
 }
 
-/** */
+
+/**
+ * Makes the API calls queued from any thread using the thread-safe command functions, 
+ * in the order in which they were queued. At most one queue's worth of commands is 
+ * executed, so that threads queueing commands continuously cannot stall the update.
+ */
+static void kwlExecuteQueuedCommands(void)
+{
+    kwlCommand command;
+    int numCommandsExecuted = 0;
+    while (numCommandsExecuted < KWL_COMMAND_QUEUE_SIZE &&
+           engine != NULL &&
+           kwlCommandQueue_removeCommand(&engine->commandQueue, &command))
+    {
+        const float* p = command.params;
+        switch (command.type)
+        {
+            case KWL_COMMAND_EVENT_START:
+                kwlEventStart(command.handle);
+                break;
+            case KWL_COMMAND_EVENT_START_FADE:
+                kwlEventStartFade(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_EVENT_STOP:
+                kwlEventStop(command.handle);
+                break;
+            case KWL_COMMAND_EVENT_STOP_FADE:
+                kwlEventStopFade(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_EVENT_PAUSE:
+                kwlEventPause(command.handle);
+                break;
+            case KWL_COMMAND_EVENT_RESUME:
+                kwlEventResume(command.handle);
+                break;
+            case KWL_COMMAND_EVENT_START_ONE_SHOT:
+                kwlEventStartOneShot(command.handle);
+                break;
+            case KWL_COMMAND_EVENT_START_ONE_SHOT_AT:
+                kwlEventStartOneShotAt(command.handle, p[0], p[1], p[2]);
+                break;
+            case KWL_COMMAND_EVENT_SET_GAIN:
+                kwlEventSetGain(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_EVENT_SET_LINEAR_GAIN:
+                kwlEventSetLinearGain(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_EVENT_SET_PITCH:
+                kwlEventSetPitch(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_EVENT_SET_BALANCE:
+                kwlEventSetBalance(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_EVENT_SET_POSITION:
+                kwlEventSetPosition(command.handle, p[0], p[1], p[2]);
+                break;
+            case KWL_COMMAND_EVENT_SET_VELOCITY:
+                kwlEventSetVelocity(command.handle, p[0], p[1], p[2]);
+                break;
+            case KWL_COMMAND_EVENT_SET_ORIENTATION:
+                kwlEventSetOrientation(command.handle, p[0], p[1], p[2]);
+                break;
+            case KWL_COMMAND_MIX_BUS_SET_GAIN:
+                kwlMixBusSetGain(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_MIX_BUS_SET_LINEAR_GAIN:
+                kwlMixBusSetLinearGain(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_MIX_BUS_SET_PITCH:
+                kwlMixBusSetPitch(command.handle, p[0]);
+                break;
+            case KWL_COMMAND_LISTENER_SET_POSITION:
+                kwlListenerSetPosition(p[0], p[1], p[2]);
+                break;
+            case KWL_COMMAND_LISTENER_SET_VELOCITY:
+                kwlListenerSetVelocity(p[0], p[1], p[2]);
+                break;
+            case KWL_COMMAND_LISTENER_SET_ORIENTATION:
+                kwlListenerSetOrientation(p[0], p[1], p[2], p[3], p[4], p[5]);
+                break;
+            default:
+                KWL_ASSERT(0 && "unknown command type");
+                break;
+        }
+        numCommandsExecuted++;
+    }
+}
+
+void kwlUpdate(float timeStepSec)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    if (timeStepSec < 0.0f)
+    {
+        kwlSetError(KWL_INVALID_PARAMETER_VALUE);
+        return;
+    }
+    
+    /*queued commands are made as regular API calls, recorded before the update.*/
+    kwlExecuteQueuedCommands();
+    
+    /*API calls made during the update, i.e from event stopped callbacks, are 
+      recorded after the update, whose record is written last and moved in front of them.*/
+    const int traceRecordPosition = isTraceRecording ? kwlAPITraceWriter_tell(&traceWriter) : 0;
+    const long long traceFrame = isTraceRecording ? kwlTraceGetFrame() : 0;
+    
+    traceUpdateDepth++;
+    kwlSetError(kwlEngine_update(engine, timeStepSec));
+    traceUpdateDepth--;
+    
+    if (isTraceRecording && traceSuspendCount == 0 && engine != NULL)
+    {
+        kwlAPITraceWriter_beginRecord(&traceWriter, 
+                                      KWL_TRACE_UPDATE, 
+                                      traceFrame, 
+                                      1);
+        kwlAPITraceWriter_writeFloat(&traceWriter, timeStepSec);
+        kwlAPITraceWriter_moveRecord(&traceWriter, traceRecordPosition);
+        if (traceUpdateDepth == 0)
+        {
+            kwlAPITraceWriter_flushIfNeeded(&traceWriter);
+        }
+    }
+}
+
+kwlWaveBankHandle kwlWaveBankLoad(const char* const path)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return KWL_INVALID_HANDLE;
+    }
+    kwlWaveBankHandle handle = 0;
+    kwlSetError(kwlEngine_loadWaveBank(engine, path, &handle, 0));
+    kwlTraceRecordStringAndInt(KWL_TRACE_WAVE_BANK_LOAD, path, handle);
+    return handle;
+}
+
+int kwlWaveBankIsLoaded(kwlWaveBankHandle handle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
+    }
+    
+    int isLoaded = 0;
+    kwlSetError(kwlEngine_waveBankIsLoaded(engine, handle, &isLoaded));
+    return isLoaded;
+}
+
+int kwlWaveBankIsReferencedByPlayingEvent(kwlWaveBankHandle handle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
+    }
+    
+    int isReferenced = 0;
+    kwlSetError(kwlEngine_waveBankIsReferencedByPlayingEvent(engine, handle, &isReferenced));
+    return isReferenced;
+}
+
+void kwlWaveBankUnload(kwlWaveBankHandle waveBankHandle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    if (kwlTraceBeginRecord(KWL_TRACE_WAVE_BANK_UNLOAD))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, waveBankHandle);
+        kwlAPITraceWriter_writeInt(&traceWriter, 0);
+    }
+    kwlSetError(kwlEngine_requestUnloadWaveBank(engine, waveBankHandle, 0));
+}
+
+void kwlWaveBankUnloadBlocking(kwlWaveBankHandle waveBankHandle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    if (kwlTraceBeginRecord(KWL_TRACE_WAVE_BANK_UNLOAD))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, waveBankHandle);
+        kwlAPITraceWriter_writeInt(&traceWriter, 1);
+    }
+    
+    /*the updates made while blocking are implied by the recorded call.*/
+    traceSuspendCount++;
+    kwlSetError(kwlEngine_requestUnloadWaveBank(engine, waveBankHandle, 1));
+    traceSuspendCount--;
+}
+
+unsigned int kwlGetNumFramesMixed(void)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0.0f;
+    }
+    
+    unsigned int numFramesMixed = 0;
+    kwlSetError(kwlEngine_getNumFramesMixed(engine, &numFramesMixed));
+    return numFramesMixed;
+}
+
+int kwlIsEngineInitialized(void)
+{
+    return engine != NULL;
+}
+
+kwlInstanceHandle kwlInstanceGetCurrent(void)
+{
+    return (kwlInstanceHandle)kwlAtomicLoadPointer((void* volatile*)&engine);
+}
+
+void kwlInstanceMakeCurrent(kwlInstanceHandle instance)
+{
+    if (instance == engine)
+    {
+        return;
+    }
+    
+    /*save the API state of the current instance...*/
+    if (engine != NULL)
+    {
+        if (engine->savedAPIState == NULL)
+        {
+            engine->savedAPIState = KWL_MALLOCANDZERO(sizeof(kwlInstanceState), "instance state");
+        }
+        
+        kwlInstanceState* state = (kwlInstanceState*)engine->savedAPIState;
+        state->error = error;
+        state->traceWriter = traceWriter;
+        state->isTraceRecording = isTraceRecording;
+        state->traceSuspendCount = traceSuspendCount;
+        state->traceUpdateDepth = traceUpdateDepth;
+    }
+    
+    /*...and restore that of the new one, which is blank for instances that have not been current before.*/
+    kwlPublishEngine(instance);
+    if (engine != NULL && engine->savedAPIState != NULL)
+    {
+        const kwlInstanceState* state = (const kwlInstanceState*)engine->savedAPIState;
+        error = state->error;
+        traceWriter = state->traceWriter;
+        isTraceRecording = state->isTraceRecording;
+        traceSuspendCount = state->traceSuspendCount;
+        traceUpdateDepth = state->traceUpdateDepth;
+    }
+    else
+    {
+        error = KWL_NO_ERROR;
+        kwlMemset(&traceWriter, 0, sizeof(kwlAPITraceWriter));
+        isTraceRecording = 0;
+        traceSuspendCount = 0;
+        traceUpdateDepth = 0;
+    }
+}
+
+/** */
 void kwlInitialize(int sampleRate, int numOutputChannels, int numInputChannels, int bufferSize)
 {
+    if (engine == NULL && kwlTraceBeginRecord(KWL_TRACE_INITIALIZE))
+    {
+        kwlAPITraceWriter_writeInt(&traceWriter, sampleRate);
+        kwlAPITraceWriter_writeInt(&traceWriter, numOutputChannels);
+        kwlAPITraceWriter_writeInt(&traceWriter, numInputChannels);
+        kwlAPITraceWriter_writeInt(&traceWriter, bufferSize);
+    }
+    
     if (engine != 0)
     {
         kwlSetError(KWL_ENGINE_ALREADY_INITIALIZED);
@@ -703,10 +1417,11 @@ void kwlInitialize(int sampleRate, int numOutputChannels, int numInputChannels,
         return;
     }
 
-    /*create the sound engine instance*/
-    engine = (kwlEngine*)KWL_MALLOC((sizeof(kwlEngine)), "kwlInitialize");
-    kwlMemset(engine, 0, sizeof(kwlEngine));
-    kwlEngine_init(engine);
+    /*create the sound engine instance, publishing it once its command queue exists*/
+    kwlEngine* newEngine = (kwlEngine*)KWL_MALLOC((sizeof(kwlEngine)), "kwlInitialize");
+    kwlMemset(newEngine, 0, sizeof(kwlEngine));
+    kwlEngine_init(newEngine);
+    kwlPublishEngine(newEngine);
     
     /*and initialise it*/
     kwlSetError(kwlEngine_initialize(engine, sampleRate, numOutputChannels, numInputChannels, bufferSize));
@@ -721,6 +1436,11 @@ void kwlEngineDataLoad(const char* const dataPath)
         return;
     }
     
+    if (kwlTraceBeginRecord(KWL_TRACE_ENGINE_DATA_LOAD))
+    {
+        kwlAPITraceWriter_writeString(&traceWriter, dataPath);
+    }
+    
     kwlSetError(kwlEngine_engineDataLoad(engine, dataPath));
 }
 
@@ -733,7 +1453,12 @@ void kwlEngineDataUnload()
         return;
     }
     
+    kwlTraceRecord(KWL_TRACE_ENGINE_DATA_UNLOAD);
+    
+    /*the updates made while blocking are implied by the recorded call.*/
+    traceSuspendCount++;
     kwlSetError(kwlEngine_unloadEngineDataBlocking(engine));
+    traceSuspendCount--;
 }
 
 /** */
@@ -759,11 +1484,23 @@ void kwlDeinitialize(void)
         return;
     }
     
+    kwlTraceRecord(KWL_TRACE_DEINITIALIZE);
+    traceSuspendCount++;
+    
     /*shut down the sound engine*/
-    kwlEngine_deinitialize(engine);
+    kwlEngine* const closingEngine = engine;
+    kwlEngine_deinitialize(closingEngine);
+    /*stop accepting commands from other threads and wait out those being added*/
+    kwlCloseCommandQueue(closingEngine);
     /*delete the sound engine instance*/
-    kwlEngine_free(engine);
-    engine = NULL;
+    if (closingEngine->savedAPIState != NULL)
+    {
+        KWL_FREE(closingEngine->savedAPIState);
+    }
+    kwlEngine_free(closingEngine);
+    
+    traceSuspendCount--;
+    kwlTraceRecordingStop();
 }
 
 /** */
@@ -775,7 +1512,7 @@ void kwlDSPUnitAttachToEvent(kwlDSPUnit* dspUnit, kwlEventHandle eventHandle)
         return;
     }
     
-    kwlSetError(kwlEngine_attachDSPUnitToEvent(engine, eventHandle, dspUnit));
+    kwlSetError(kwlEngine_attachDSPUnitToEvent(engine, eventHandle, dspUnit, KWL_SET_DSP_UNIT));
 }
 
 
@@ -787,7 +1524,7 @@ void kwlDSPUnitAttachToMixBus(kwlDSPUnit* dspUnit, kwlMixBusHandle mixBusHandle)
         return;
     }
     
-    kwlSetError(kwlEngine_attachDSPUnitToMixBus(engine, mixBusHandle, dspUnit));
+    kwlSetError(kwlEngine_attachDSPUnitToMixBus(engine, mixBusHandle, dspUnit, KWL_SET_DSP_UNIT));
 }
 
 void kwlDSPUnitAttachToInput(kwlDSPUnit* dspUnit)
@@ -798,7 +1535,7 @@ void kwlDSPUnitAttachToInput(kwlDSPUnit* dspUnit)
         return;
     }
     
-    kwlSetError(kwlEngine_attachDSPUnitToInput(engine, dspUnit));
+    kwlSetError(kwlEngine_attachDSPUnitToInput(engine, dspUnit, KWL_SET_DSP_UNIT));
 }
 
 void kwlDSPUnitAttachToOutput(kwlDSPUnit* dspUnit)
@@ -809,7 +1546,106 @@ void kwlDSPUnitAttachToOutput(kwlDSPUnit* dspUnit)
         return;
     }
     
-    kwlSetError(kwlEngine_attachDSPUnitToOutput(engine, dspUnit));
+    kwlSetError(kwlEngine_attachDSPUnitToOutput(engine, dspUnit, KWL_SET_DSP_UNIT));
+}
+
+void kwlDSPUnitAppendToEvent(kwlDSPUnit* dspUnit, kwlEventHandle eventHandle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_attachDSPUnitToEvent(engine, eventHandle, dspUnit, KWL_APPEND_DSP_UNIT));
+}
+
+void kwlDSPUnitAppendToMixBus(kwlDSPUnit* dspUnit, kwlMixBusHandle mixBusHandle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_attachDSPUnitToMixBus(engine, mixBusHandle, dspUnit, KWL_APPEND_DSP_UNIT));
+}
+
+void kwlDSPUnitAppendToInput(kwlDSPUnit* dspUnit)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_attachDSPUnitToInput(engine, dspUnit, KWL_APPEND_DSP_UNIT));
+}
+
+void kwlDSPUnitAppendToOutput(kwlDSPUnit* dspUnit)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_attachDSPUnitToOutput(engine, dspUnit, KWL_APPEND_DSP_UNIT));
+}
+
+void kwlDSPUnitRemoveFromEvent(kwlDSPUnit* dspUnit, kwlEventHandle eventHandle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_attachDSPUnitToEvent(engine, eventHandle, dspUnit, KWL_REMOVE_DSP_UNIT));
+}
+
+void kwlDSPUnitRemoveFromMixBus(kwlDSPUnit* dspUnit, kwlMixBusHandle mixBusHandle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_attachDSPUnitToMixBus(engine, mixBusHandle, dspUnit, KWL_REMOVE_DSP_UNIT));
+}
+
+void kwlDSPUnitRemoveFromInput(kwlDSPUnit* dspUnit)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_attachDSPUnitToInput(engine, dspUnit, KWL_REMOVE_DSP_UNIT));
+}
+
+void kwlDSPUnitRemoveFromOutput(kwlDSPUnit* dspUnit)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_attachDSPUnitToOutput(engine, dspUnit, KWL_REMOVE_DSP_UNIT));
+}
+
+void kwlDSPUnitSetBypassed(kwlDSPUnit* dspUnit, int bypassed)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_dspUnitSetBypassed(engine, dspUnit, bypassed));
 }
 
 int kwlIsInputEnabled(void)
@@ -845,9 +1681,62 @@ kwlDSPUnitHandle kwlDSPUnitCreateCustom(void* userdata,
     newDSPUnit->updateDSPEngineCallback = updateEngine;
     newDSPUnit->updateDSPMixerCallback = updateMixer;
     
+    /*custom units are processed whenever attached unless given a finite tail length.*/
+    newDSPUnit->tailLength.valueEngine = KWL_DSP_UNIT_INFINITE_TAIL;
+    newDSPUnit->tailLength.valueShared = KWL_DSP_UNIT_INFINITE_TAIL;
+    newDSPUnit->tailLength.valueMixer = KWL_DSP_UNIT_INFINITE_TAIL;
+    
     return newDSPUnit;
 }
 
+void kwlDSPUnitSetTailLength(kwlDSPUnitHandle dspUnit, float seconds)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_dspUnitSetTailLength(engine, dspUnit, seconds));
+}
+
+kwlDSPUnitHandle kwlDSPUnitCreateFilter(kwlFilterType type, float cutoffHz, float q, float gainDB)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return NULL;
+    }
+    
+    kwlDSPUnit* dspUnit = NULL;
+    kwlSetError(kwlEngine_createFilterDSPUnit(engine, type, cutoffHz, q, gainDB, &dspUnit));
+    return dspUnit;
+}
+
+void kwlDSPUnitSetFilterParameters(kwlDSPUnitHandle dspUnit, float cutoffHz, float q, float gainDB)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(kwlEngine_dspUnitSetFilterParameters(engine, dspUnit, cutoffHz, q, gainDB));
+}
+
+kwlDSPUnitHandle kwlDSPUnitCreateConvolution(const kwlPCMBuffer* impulseResponse, float gain)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return NULL;
+    }
+    
+    kwlDSPUnit* dspUnit = NULL;
+    kwlSetError(kwlEngine_createConvolutionDSPUnit(engine, impulseResponse, gain, &dspUnit));
+    return dspUnit;
+}
+
 kwlError kwlPCMBufferLoad(const char* const path, kwlPCMBuffer* buffer)
 {
     /** Reset input struct. */
@@ -885,3 +1774,590 @@ void kwlPCMBufferFree(kwlPCMBuffer* buffer)
     buffer->pcmData = NULL;
 }
 
+void kwlSetRandomSeed(unsigned int seed)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlTraceRecordInt(KWL_TRACE_SET_RANDOM_SEED, (int)seed);
+    engine->randomState = seed;
+}
+
+/**
+ * Queues a command to be executed at the start of the next update of an instance. 
+ * May be called from any thread.
+ */
+static kwlError kwlQueueCommand(kwlInstanceHandle instance, kwlCommandType type, int handle, 
+                                float p0, float p1, float p2, 
+                                float p3, float p4, float p5)
+{
+    kwlCommand command;
+    command.type = type;
+    command.handle = handle;
+    command.params[0] = p0;
+    command.params[1] = p1;
+    command.params[2] = p2;
+    command.params[3] = p3;
+    command.params[4] = p4;
+    command.params[5] = p5;
+    
+    /*count this thread as a producer before checking whether the instance is closed, so that 
+      kwlDeinitialize has either closed the instance already or waits until the command is added.*/
+    kwlAtomicAdd(&numCommandProducers, 1);
+    
+    kwlError result = KWL_NO_ERROR;
+    if (instance == NULL || instance->isCommandQueueClosed != 0)
+    {
+        result = KWL_ENGINE_IS_NOT_INITIALIZED;
+    }
+    else if (kwlCommandQueue_addCommand(&instance->commandQueue, &command) == 0)
+    {
+        result = KWL_MESSAGE_QUEUE_FULL;
+    }
+    
+    kwlAtomicAdd(&numCommandProducers, -1);
+    return result;
+}
+
+kwlError kwlCommandEventStart(kwlInstanceHandle instance, kwlEventHandle handle)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_START, handle, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventStartFade(kwlInstanceHandle instance, kwlEventHandle handle, float fadeTime)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_START_FADE, handle, fadeTime, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventStop(kwlInstanceHandle instance, kwlEventHandle handle)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_STOP, handle, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventStopFade(kwlInstanceHandle instance, kwlEventHandle handle, float fadeTime)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_STOP_FADE, handle, fadeTime, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventPause(kwlInstanceHandle instance, kwlEventHandle handle)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_PAUSE, handle, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventResume(kwlInstanceHandle instance, kwlEventHandle handle)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_RESUME, handle, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventStartOneShot(kwlInstanceHandle instance, kwlEventDefinitionHandle handle)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_START_ONE_SHOT, handle, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventStartOneShotAt(kwlInstanceHandle instance, kwlEventDefinitionHandle handle, float x, float y, float z)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_START_ONE_SHOT_AT, handle, x, y, z, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventSetGain(kwlInstanceHandle instance, kwlEventHandle handle, float gain)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_SET_GAIN, handle, gain, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventSetLinearGain(kwlInstanceHandle instance, kwlEventHandle handle, float gain)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_SET_LINEAR_GAIN, handle, gain, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventSetPitch(kwlInstanceHandle instance, kwlEventHandle handle, float pitch)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_SET_PITCH, handle, pitch, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventSetBalance(kwlInstanceHandle instance, kwlEventHandle handle, float balance)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_SET_BALANCE, handle, balance, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventSetPosition(kwlInstanceHandle instance, kwlEventHandle handle, float posX, float posY, float posZ)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_SET_POSITION, handle, posX, posY, posZ, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventSetVelocity(kwlInstanceHandle instance, kwlEventHandle handle, float velX, float velY, float velZ)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_SET_VELOCITY, handle, velX, velY, velZ, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandEventSetOrientation(kwlInstanceHandle instance, kwlEventHandle handle, float directionX, float directionY, float directionZ)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_EVENT_SET_ORIENTATION, handle, 
+                           directionX, directionY, directionZ, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandMixBusSetGain(kwlInstanceHandle instance, kwlMixBusHandle handle, float gain)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_MIX_BUS_SET_GAIN, handle, gain, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandMixBusSetLinearGain(kwlInstanceHandle instance, kwlMixBusHandle handle, float gain)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_MIX_BUS_SET_LINEAR_GAIN, handle, gain, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandMixBusSetPitch(kwlInstanceHandle instance, kwlMixBusHandle handle, float pitch)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_MIX_BUS_SET_PITCH, handle, pitch, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandListenerSetPosition(kwlInstanceHandle instance, float posX, float posY, float posZ)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_LISTENER_SET_POSITION, 0, posX, posY, posZ, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandListenerSetVelocity(kwlInstanceHandle instance, float velX, float velY, float velZ)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_LISTENER_SET_VELOCITY, 0, velX, velY, velZ, 0.0f, 0.0f, 0.0f);
+}
+
+kwlError kwlCommandListenerSetOrientation(kwlInstanceHandle instance,
+                                          float directionX, float directionY, float directionZ,
+                                          float upX, float upY, float upZ)
+{
+    return kwlQueueCommand(instance, KWL_COMMAND_LISTENER_SET_ORIENTATION, 0, 
+                           directionX, directionY, directionZ, upX, upY, upZ);
+}
+
+void kwlTraceRecordingStart(const char* const tracePath)
+{
+    if (engine != NULL)
+    {
+        kwlSetError(KWL_ENGINE_ALREADY_INITIALIZED);
+        return;
+    }
+    
+    kwlTraceRecordingStop();
+    
+    kwlError result = kwlAPITraceWriter_open(&traceWriter, tracePath);
+    kwlSetError(result);
+    isTraceRecording = result == KWL_NO_ERROR;
+}
+
+void kwlTraceRecordingStop(void)
+{
+    if (isTraceRecording == 0)
+    {
+        return;
+    }
+    
+    isTraceRecording = 0;
+    kwlSetError(kwlAPITraceWriter_close(&traceWriter));
+}
+
+/** The state of an ongoing trace replay. */
+typedef struct kwlTraceReplayState
+{
+    /** The trace being replayed. */
+    kwlAPITraceReader reader;
+    /** The callback used to render audio. */
+    kwlTraceRenderCallback renderCallback;
+    /** User data passed to the render callback. */
+    void* userData;
+    /** The buffer size passed to kwlInitialize, i.e the size of the chunks to render. */
+    int bufferSize;
+    /** PCM buffers created for freeform events, freed when the replay is done. */
+    kwlPCMBuffer** pcmBuffers;
+    /** The number of PCM buffers created. */
+    int numPCMBuffers;
+} kwlTraceReplayState;
+
+/**
+ * Renders audio until the mixer has rendered as many frames as it had when a
+ * recorded call was made, so the call is replayed at the same position in the output.
+ * @param state The replay state.
+ * @param frame The number of frames rendered when the call was recorded.
+ */
+static void kwlTraceReplay_renderUntil(kwlTraceReplayState* state, long long frame)
+{
+    if (engine == NULL || state->bufferSize <= 0)
+    {
+        return;
+    }
+    
+    /*the replay renders on this thread, so the mixer's own statistics can be read.*/
+    const kwlMixerStats* stats = &engine->mixer->stats;
+    while (stats->numFramesRendered < frame)
+    {
+        const long long numFramesRendered = stats->numFramesRendered;
+        int numFrames = state->bufferSize;
+        if (frame - numFramesRendered < numFrames)
+        {
+            numFrames = (int)(frame - numFramesRendered);
+        }
+        
+        state->renderCallback(numFrames, state->userData);
+        
+        if (stats->numFramesRendered == numFramesRendered)
+        {
+            /*the callback did not render anything.*/
+            break;
+        }
+    }
+}
+
+/**
+ * Checks that a handle returned during a replay matches the recorded one.
+ */
+static kwlError kwlTraceReplay_checkHandle(int handle, int recordedHandle)
+{
+    return handle == recordedHandle ? KWL_NO_ERROR : KWL_TRACE_REPLAY_MISMATCH;
+}
+
+/**
+ * Reads the arguments of a trace record and replays the corresponding API call.
+ * @param state The replay state.
+ * @param opcode The opcode of the record.
+ * @return An error code.
+ */
+static kwlError kwlTraceReplay_replayRecord(kwlTraceReplayState* state, kwlAPITraceOpcode opcode)
+{
+    kwlAPITraceReader* reader = &state->reader;
+    
+    switch (opcode)
+    {
+        case KWL_TRACE_INITIALIZE:
+        {
+            const int sampleRate = kwlAPITraceReader_readInt(reader);
+            const int numOutputChannels = kwlAPITraceReader_readInt(reader);
+            const int numInputChannels = kwlAPITraceReader_readInt(reader);
+            const int bufferSize = kwlAPITraceReader_readInt(reader);
+            if (engine == NULL && bufferSize > 0)
+            {
+                state->bufferSize = bufferSize;
+            }
+            kwlInitialize(sampleRate, numOutputChannels, numInputChannels, bufferSize);
+            break;
+        }
+        case KWL_TRACE_DEINITIALIZE:
+            kwlDeinitialize();
+            break;
+        case KWL_TRACE_UPDATE:
+            kwlUpdate(kwlAPITraceReader_readFloat(reader));
+            break;
+        case KWL_TRACE_SET_RANDOM_SEED:
+            kwlSetRandomSeed((unsigned int)kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_ENGINE_DATA_LOAD:
+            kwlEngineDataLoad(kwlAPITraceReader_readString(reader));
+            break;
+        case KWL_TRACE_ENGINE_DATA_UNLOAD:
+            kwlEngineDataUnload();
+            break;
+        case KWL_TRACE_WAVE_BANK_LOAD:
+        {
+            const char* const path = kwlAPITraceReader_readString(reader);
+            const int recordedHandle = kwlAPITraceReader_readInt(reader);
+            return kwlTraceReplay_checkHandle(kwlWaveBankLoad(path), recordedHandle);
+        }
+        case KWL_TRACE_WAVE_BANK_UNLOAD:
+        {
+            const int handle = kwlAPITraceReader_readInt(reader);
+            const int blocking = kwlAPITraceReader_readInt(reader);
+            if (blocking != 0)
+            {
+                kwlWaveBankUnloadBlocking(handle);
+            }
+            else
+            {
+                kwlWaveBankUnload(handle);
+            }
+            break;
+        }
+        case KWL_TRACE_EVENT_GET_HANDLE:
+        {
+            const char* const eventId = kwlAPITraceReader_readString(reader);
+            const int recordedHandle = kwlAPITraceReader_readInt(reader);
+            return kwlTraceReplay_checkHandle(kwlEventGetHandle(eventId), recordedHandle);
+        }
+        case KWL_TRACE_EVENT_DEFINITION_GET_HANDLE:
+        {
+            const char* const eventDefinitionId = kwlAPITraceReader_readString(reader);
+            const int recordedHandle = kwlAPITraceReader_readInt(reader);
+            return kwlTraceReplay_checkHandle(kwlEventDefinitionGetHandle(eventDefinitionId), recordedHandle);
+        }
+        case KWL_TRACE_EVENT_CREATE_WITH_FILE:
+        {
+            const char* const path = kwlAPITraceReader_readString(reader);
+            const kwlEventType eventType = (kwlEventType)kwlAPITraceReader_readInt(reader);
+            const int streamFromDisk = kwlAPITraceReader_readInt(reader);
+            const int recordedHandle = kwlAPITraceReader_readInt(reader);
+            return kwlTraceReplay_checkHandle(kwlEventCreateWithFile(path, eventType, streamFromDisk), recordedHandle);
+        }
+        case KWL_TRACE_EVENT_CREATE_WITH_BUFFER:
+        {
+            const int numFrames = kwlAPITraceReader_readInt(reader);
+            const int numChannels = kwlAPITraceReader_readInt(reader);
+            kwlInputStream* stream = &reader->stream;
+            const long long numSamples = (long long)numFrames * numChannels;
+            if (numFrames < 0 || numChannels < 0 || 
+                2 * numSamples > stream->fileSize - kwlInputStream_tell(stream))
+            {
+                return KWL_CORRUPT_BINARY_DATA;
+            }
+            
+            kwlPCMBuffer* buffer = (kwlPCMBuffer*)KWL_MALLOCANDZERO(sizeof(kwlPCMBuffer), "trace replay pcm buffer");
+            buffer->numFrames = numFrames;
+            buffer->numChannels = numChannels;
+            if (numSamples > 0)
+            {
+                buffer->pcmData = (short*)KWL_MALLOC(2 * (int)numSamples, "trace replay pcm data");
+                kwlAPITraceReader_readShorts(reader, buffer->pcmData, (int)numSamples);
+            }
+            state->pcmBuffers = (kwlPCMBuffer**)KWL_REALLOC(state->pcmBuffers, 
+                                                           (state->numPCMBuffers + 1) * sizeof(kwlPCMBuffer*), 
+                                                           "trace replay pcm buffers");
+            state->pcmBuffers[state->numPCMBuffers++] = buffer;
+            
+            const kwlEventType eventType = (kwlEventType)kwlAPITraceReader_readInt(reader);
+            const int recordedHandle = kwlAPITraceReader_readInt(reader);
+            return kwlTraceReplay_checkHandle(kwlEventCreateWithBuffer(buffer, eventType), recordedHandle);
+        }
+        case KWL_TRACE_EVENT_RELEASE:
+            kwlEventRelease(kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_EVENT_START:
+            kwlEventStart(kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_EVENT_START_FADE:
+        {
+            const int handle = kwlAPITraceReader_readInt(reader);
+            kwlEventStartFade(handle, kwlAPITraceReader_readFloat(reader));
+            break;
+        }
+        case KWL_TRACE_EVENT_START_ONE_SHOT:
+        {
+            const int handle = kwlAPITraceReader_readInt(reader);
+            const int isPositional = kwlAPITraceReader_readInt(reader);
+            const float x = kwlAPITraceReader_readFloat(reader);
+            const float y = kwlAPITraceReader_readFloat(reader);
+            const float z = kwlAPITraceReader_readFloat(reader);
+            if (isPositional)
+            {
+                kwlEventStartOneShotAt(handle, x, y, z);
+            }
+            else
+            {
+                kwlEventStartOneShot(handle);
+            }
+            break;
+        }
+        case KWL_TRACE_EVENT_STOP:
+            kwlEventStop(kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_EVENT_STOP_FADE:
+        {
+            const int handle = kwlAPITraceReader_readInt(reader);
+            kwlEventStopFade(handle, kwlAPITraceReader_readFloat(reader));
+            break;
+        }
+        case KWL_TRACE_EVENT_PAUSE:
+            kwlEventPause(kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_EVENT_RESUME:
+            kwlEventResume(kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_EVENT_SET_PITCH:
+        case KWL_TRACE_EVENT_SET_GAIN:
+        case KWL_TRACE_EVENT_SET_LINEAR_GAIN:
+        case KWL_TRACE_EVENT_SET_BALANCE:
+        case KWL_TRACE_MIX_BUS_SET_GAIN:
+        case KWL_TRACE_MIX_BUS_SET_LINEAR_GAIN:
+        case KWL_TRACE_MIX_BUS_SET_PITCH:
+        {
+            const int handle = kwlAPITraceReader_readInt(reader);
+            const float value = kwlAPITraceReader_readFloat(reader);
+            switch (opcode)
+            {
+                case KWL_TRACE_EVENT_SET_PITCH: kwlEventSetPitch(handle, value); break;
+                case KWL_TRACE_EVENT_SET_GAIN: kwlEventSetGain(handle, value); break;
+                case KWL_TRACE_EVENT_SET_LINEAR_GAIN: kwlEventSetLinearGain(handle, value); break;
+                case KWL_TRACE_EVENT_SET_BALANCE: kwlEventSetBalance(handle, value); break;
+                case KWL_TRACE_MIX_BUS_SET_GAIN: kwlMixBusSetGain(handle, value); break;
+                case KWL_TRACE_MIX_BUS_SET_LINEAR_GAIN: kwlMixBusSetLinearGain(handle, value); break;
+                default: kwlMixBusSetPitch(handle, value); break;
+            }
+            break;
+        }
+        case KWL_TRACE_EVENT_SET_POSITION:
+        case KWL_TRACE_EVENT_SET_VELOCITY:
+        case KWL_TRACE_EVENT_SET_ORIENTATION:
+        {
+            const int handle = kwlAPITraceReader_readInt(reader);
+            const float x = kwlAPITraceReader_readFloat(reader);
+            const float y = kwlAPITraceReader_readFloat(reader);
+            const float z = kwlAPITraceReader_readFloat(reader);
+            if (opcode == KWL_TRACE_EVENT_SET_POSITION)
+            {
+                kwlEventSetPosition(handle, x, y, z);
+            }
+            else if (opcode == KWL_TRACE_EVENT_SET_VELOCITY)
+            {
+                kwlEventSetVelocity(handle, x, y, z);
+            }
+            else
+            {
+                kwlEventSetOrientation(handle, x, y, z);
+            }
+            break;
+        }
+        case KWL_TRACE_MIX_BUS_GET_HANDLE:
+        {
+            const char* const busId = kwlAPITraceReader_readString(reader);
+            const int recordedHandle = kwlAPITraceReader_readInt(reader);
+            return kwlTraceReplay_checkHandle(kwlMixBusGetHandle(busId), recordedHandle);
+        }
+        case KWL_TRACE_MIX_PRESET_GET_HANDLE:
+        {
+            const char* const presetId = kwlAPITraceReader_readString(reader);
+            const int recordedHandle = kwlAPITraceReader_readInt(reader);
+            return kwlTraceReplay_checkHandle(kwlMixPresetGetHandle(presetId), recordedHandle);
+        }
+        case KWL_TRACE_MIX_PRESET_FADE_TO:
+            kwlMixPresetFadeTo(kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_MIX_PRESET_SET:
+            kwlMixPresetSet(kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_LISTENER_SET_POSITION:
+        case KWL_TRACE_LISTENER_SET_VELOCITY:
+        case KWL_TRACE_LISTENER_SET_CONE_PARAMETERS:
+        {
+            const float x = kwlAPITraceReader_readFloat(reader);
+            const float y = kwlAPITraceReader_readFloat(reader);
+            const float z = kwlAPITraceReader_readFloat(reader);
+            if (opcode == KWL_TRACE_LISTENER_SET_POSITION)
+            {
+                kwlListenerSetPosition(x, y, z);
+            }
+            else if (opcode == KWL_TRACE_LISTENER_SET_VELOCITY)
+            {
+                kwlListenerSetVelocity(x, y, z);
+            }
+            else
+            {
+                kwlListenerSetConeParameters(x, y, z);
+            }
+            break;
+        }
+        case KWL_TRACE_LISTENER_SET_ORIENTATION:
+        {
+            float values[6];
+            for (int i = 0; i < 6; i++)
+            {
+                values[i] = kwlAPITraceReader_readFloat(reader);
+            }
+            kwlListenerSetOrientation(values[0], values[1], values[2], values[3], values[4], values[5]);
+            break;
+        }
+        case KWL_TRACE_SET_DISTANCE_ATTENUATION_MODEL:
+        {
+            const kwlDistanceAttenuationModel model = (kwlDistanceAttenuationModel)kwlAPITraceReader_readInt(reader);
+            const int clamp = kwlAPITraceReader_readInt(reader);
+            const float maxDistance = kwlAPITraceReader_readFloat(reader);
+            const float rolloffFactor = kwlAPITraceReader_readFloat(reader);
+            const float referenceDistance = kwlAPITraceReader_readFloat(reader);
+            kwlSetDistanceAttenuationModel(model, clamp, maxDistance, rolloffFactor, referenceDistance);
+            break;
+        }
+        case KWL_TRACE_SET_DOPPLER_SHIFT_PARAMETERS:
+        {
+            const float speedOfSound = kwlAPITraceReader_readFloat(reader);
+            kwlSetDopplerShiftParameters(speedOfSound, kwlAPITraceReader_readFloat(reader));
+            break;
+        }
+        case KWL_TRACE_SET_CONE_ATTENUATION_ENABLED:
+        {
+            const int enableListenerCone = kwlAPITraceReader_readInt(reader);
+            kwlSetConeAttenuationEnabled(enableListenerCone, kwlAPITraceReader_readInt(reader));
+            break;
+        }
+        case KWL_TRACE_MIXER_PAUSE:
+            kwlMixerPause();
+            break;
+        case KWL_TRACE_MIXER_RESUME:
+            kwlMixerResume();
+            break;
+        case KWL_TRACE_LEVEL_METERING_SET_ENABLED:
+            kwlLevelMeteringSetEnabled(kwlAPITraceReader_readInt(reader));
+            break;
+        case KWL_TRACE_MIX_BUS_SET_METERING_ENABLED:
+        {
+            const int handle = kwlAPITraceReader_readInt(reader);
+            const int enabled = kwlAPITraceReader_readInt(reader);
+            kwlMixBusSetMeteringEnabled(handle, enabled);
+            break;
+        }
+        default:
+            return KWL_CORRUPT_BINARY_DATA;
+    }
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlTraceReplay(const char* const tracePath, kwlTraceRenderCallback renderCallback, void* userData)
+{
+    if (engine != NULL)
+    {
+        return KWL_ENGINE_ALREADY_INITIALIZED;
+    }
+    
+    kwlTraceReplayState state;
+    kwlMemset(&state, 0, sizeof(kwlTraceReplayState));
+    state.renderCallback = renderCallback;
+    state.userData = userData;
+    
+    kwlError result = kwlAPITraceReader_open(&state.reader, tracePath);
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
+    
+    kwlAPITraceOpcode opcode;
+    long long frame = 0;
+    while (result == KWL_NO_ERROR && kwlAPITraceReader_nextRecord(&state.reader, &opcode, &frame))
+    {
+        kwlTraceReplay_renderUntil(&state, frame);
+        result = kwlTraceReplay_replayRecord(&state, opcode);
+        /*errors reported by the replayed calls occurred in the recorded session too.*/
+        kwlGetError();
+    }
+    
+    if (result == KWL_NO_ERROR && state.reader.hasError)
+    {
+        result = KWL_CORRUPT_BINARY_DATA;
+    }
+    
+    /*shut down the engine if the trace ended before it was deinitialized.*/
+    if (engine != NULL)
+    {
+        kwlDeinitialize();
+        kwlGetError();
+    }
+    
+    for (int i = 0; i < state.numPCMBuffers; i++)
+    {
+        kwlPCMBufferFree(state.pcmBuffers[i]);
+        KWL_FREE(state.pcmBuffers[i]);
+    }
+    if (state.pcmBuffers != NULL)
+    {
+        KWL_FREE(state.pcmBuffers);
+    }
+    kwlAPITraceReader_close(&state.reader);
+    
+    return result;
+}
+
@@ -52,6 +52,8 @@ extern "C"
     typedef int kwlEventDefinitionHandle;
     /** A handle to a wave bank.*/
     typedef int kwlWaveBankHandle;
+    /** A handle to an engine instance.*/
+    typedef struct kwlEngine* kwlInstanceHandle;
     
     /** @} */
     
@@ -105,7 +107,7 @@ extern "C"
         KWL_ENGINE_DATA_NOT_LOADED,
         /** Indicates that the non-audio engine data is loaded, but is required not to be.*/
         KWL_ENGINE_ALREADY_LOADED,
-        /** An attempt to post a message to the mixer thread failed because the outgoing queue is full.*/
+        /** An attempt to post a message to the mixer thread or to queue a command failed because the queue is full.*/
         KWL_MESSAGE_QUEUE_FULL,
         /** The wave bank id stored in a given wave bank binary file does
          not correspond to the id of a wave bank in the engine.*/
@@ -127,6 +129,14 @@ extern "C"
         KWL_EVENT_IS_NOT_NONPOSITIONAL,
         /** The positional freeform event cannot be created from a stereo file.*/
         KWL_POSITIONAL_EVENT_MUST_BE_MONO,
+        /** An API call trace file could not be created or written.*/
+        KWL_COULD_NOT_OPEN_TRACE_FILE,
+        /** Replaying an API call trace gave a different result than when the trace was recorded.*/
+        KWL_TRACE_REPLAY_MISMATCH,
+        /** A CPU cost was queried but CPU cost profiling is not enabled. */
+        KWL_CPU_PROFILING_DISABLED,
+        /** No more DSP units can be attached to a point in the signal chain. */
+        KWL_DSP_CHAIN_IS_FULL,
     } kwlError;
     /** @} */
     
@@ -415,6 +425,82 @@ extern "C"
      */
     void kwlEventSetVelocity(kwlEventHandle handle, float velX, float velY, float velZ);
     
+    /**
+     * <p>Sets the positions in 3D space of a number of event instances. Equivalent to calling
+     * \c kwlEventSetPosition for each instance, but much cheaper for large numbers of events.
+     * The coordinates are passed as separate arrays, one per component.</p>
+     * <p>Invalid handles and non-positional events are skipped, and the error code of 
+     * the first skipped event is reported.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c numEvents is negative or any array is NULL.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if a handle does not correspond to an event instance.</li>
+     * <li>\c KWL_EVENT_IS_NOT_POSITIONAL if a handle does not correspond to a positional event.</li>
+     * </ul>
+     * </p>
+     * @param handles The handles of the events to set the positions of.
+     * @param posX The x components of the positions.
+     * @param posY The y components of the positions.
+     * @param posZ The z components of the positions.
+     * @param numEvents The number of elements in each array.
+     * @see kwlEventSetPosition
+     * @see kwlGetError
+     */
+    void kwlEventSetPositions(const kwlEventHandle* handles, 
+                              const float* posX, const float* posY, const float* posZ, 
+                              int numEvents);
+    
+    /**
+     * <p>Sets the velocities in 3D space of a number of event instances. Equivalent to calling
+     * \c kwlEventSetVelocity for each instance, but much cheaper for large numbers of events.
+     * Invalid handles and non-positional events are skipped, and the error code of 
+     * the first skipped event is reported.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c numEvents is negative or any array is NULL.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if a handle does not correspond to an event instance.</li>
+     * <li>\c KWL_EVENT_IS_NOT_POSITIONAL if a handle does not correspond to a positional event.</li>
+     * </ul>
+     * </p>
+     * @param handles The handles of the events to set the velocities of.
+     * @param velX The x components of the velocities.
+     * @param velY The y components of the velocities.
+     * @param velZ The z components of the velocities.
+     * @param numEvents The number of elements in each array.
+     * @see kwlEventSetVelocity
+     * @see kwlGetError
+     */
+    void kwlEventSetVelocities(const kwlEventHandle* handles, 
+                               const float* velX, const float* velY, const float* velZ, 
+                               int numEvents);
+    
+    /**
+     * <p>Sets the gains of a number of event instances. Equivalent to calling
+     * \c kwlEventSetGain or \c kwlEventSetLinearGain for each instance, but much cheaper 
+     * for large numbers of events. Invalid handles and negative gains are skipped, and the 
+     * error code of the first skipped event is reported.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c numEvents is negative, any array is NULL or a gain is negative.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if a handle does not correspond to an event instance.</li>
+     * </ul>
+     * </p>
+     * @param handles The handles of the events to set the gains of.
+     * @param gains The gains, interpreted like the gain of \c kwlEventSetGain or \c kwlEventSetLinearGain.
+     * @param numEvents The number of elements in each array.
+     * @param isLinearGain Non-zero if \c gains are linear gains, zero if they are logarithmic.
+     * @see kwlEventSetGain
+     * @see kwlEventSetLinearGain
+     * @see kwlGetError
+     */
+    void kwlEventSetGains(const kwlEventHandle* handles, const float* gains, int numEvents, int isLinearGain);
+    
     /**
      * <p>Sets the orientation in 3D space of a given event instance. The orientation
      * is specified as a vector in the facing, or forward, direction.</p>
@@ -517,6 +603,33 @@ extern "C"
      */
     void kwlEventStartOneShotAt(kwlEventDefinitionHandle handle, float x, float y, float z);
     
+    /**
+     * <p>Starts one-shot playback of a number of positional events at given positions.
+     * Equivalent to calling \c kwlEventStartOneShotAt for each event, but cheaper for large
+     * numbers of events. The same event definition may appear several times. Events that can't 
+     * be started are skipped, and the error code of the first skipped event is reported.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c numEvents is negative or any array is NULL.</li>
+     * <li>\c KWL_INVALID_EVENT_DEFINITION_HANDLE if a handle does not correspond to an event definition.</li>
+     * <li>\c KWL_EVENT_IS_NOT_POSITIONAL if a handle does not correspond to a positional event definition.</li>
+     * <li>\c KWL_NO_FREE_EVENT_INSTANCES if all instances of an event definition are associated with handles.</li>
+     * </ul>
+     * </p>
+     * @param handles The handles of the event definitions to start.
+     * @param x The x components of the playback positions.
+     * @param y The y components of the playback positions.
+     * @param z The z components of the playback positions.
+     * @param numEvents The number of elements in each array.
+     * @see kwlEventStartOneShotAt
+     * @see kwlGetError
+     */
+    void kwlEventStartOneShotsAt(const kwlEventDefinitionHandle* handles, 
+                                 const float* x, const float* y, const float* z, 
+                                 int numEvents);
+    
     /**
      * <p>Starts playback of a given event instance, applying a fade in with a given duration.
      * If the instance is already playing, the behaviour is defined by the retrigger mode
@@ -575,6 +688,71 @@ extern "C"
      */
     void kwlEventStopFade(kwlEventHandle handle, float fadeTime);
     
+    /**
+     * <p>Starts playback of a given event instance like \c kwlEventStartFade, but sends the 
+     * start command straight to the mixer instead of at the next call to \c kwlUpdate,
+     * so the event starts at the next rendered audio buffer. Meant for sounds triggered 
+     * by user input, like instruments and UI clicks, when the game loop runs at a low rate.
+     * Uses a small lock-free queue and never blocks the calling thread or the mixer. If the
+     * mixer has not yet processed the previous immediate commands, the command is sent at 
+     * the next call to \c kwlUpdate instead.</p>
+     * <p>Commands sent with this function may overtake commands for the same event sent with 
+     * the regular functions since the last call to \c kwlUpdate. When render-ahead is enabled,
+     * the event starts after the audio already rendered ahead.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if the provided handle does not correspond to an event instance.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c fadeTime is negative.</li>
+     * </ul>
+     * </p>
+     * @param handle An event handle corresponding to the event to start.
+     * @param fadeTime The fade in duration in seconds, or zero for no fade.
+     * @see kwlEventStartFade
+     * @see kwlEventStopImmediately
+     * @see kwlGetError
+     */
+    void kwlEventStartImmediately(kwlEventHandle handle, float fadeTime);
+    
+    /**
+     * <p>Stops or fades out a given event instance like \c kwlEventStopFade, but sends the 
+     * stop command straight to the mixer instead of at the next call to \c kwlUpdate.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if the provided handle does not correspond to an event instance.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c fadeTime is negative.</li>
+     * </ul>
+     * </p>
+     * @param handle An event handle corresponding to the event to stop.
+     * @param fadeTime The fade out duration in seconds, or zero for no fade.
+     * @see kwlEventStopFade
+     * @see kwlEventStartImmediately
+     * @see kwlGetError
+     */
+    void kwlEventStopImmediately(kwlEventHandle handle, float fadeTime);
+    
+    /**
+     * <p>Starts playback of a free event instance belonging to a given event definition 
+     * like \c kwlEventStartOneShot, but sends the start command straight to the mixer 
+     * instead of at the next call to \c kwlUpdate.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_DEFINITION_HANDLE if the provided handle does not correspond to an event definition.</li>
+     * <li>\c KWL_NO_FREE_EVENT_INSTANCES if all instances of the given event definition are associated with handles.</li>
+     * </ul>
+     * </p>
+     * @param handle An event definition handle corresponding to the event to start.
+     * @see kwlEventStartOneShot
+     * @see kwlEventStartImmediately
+     * @see kwlGetError
+     */
+    void kwlEventStartOneShotImmediately(kwlEventDefinitionHandle handle);
+    
     /**
      * <p>Pauses an event instance, suspending playback but leaving it active in the mixer.
      * If the instance is currently paused or not playing,
@@ -787,6 +965,103 @@ extern "C"
      */
     void kwlMixBusSetLinearGain(kwlMixBusHandle handle, float gain);
     
+    /**
+     * <p>Enables or disables output level metering of a given mix bus. A metered bus measures 
+     * the peak and RMS levels of its events as they are mixed into the output, i.e after the bus DSP
+     * unit and with the bus gain applied. Sub buses are not included and have to be metered separately. 
+     * The levels cover the audio mixed between two consecutive calls to \c kwlUpdate.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_MIX_BUS_HANDLE if the provided handle does not correspond to a mix bus.</li>
+     * </ul>
+     * </p>
+     * @param handle The mix bus to enable or disable metering for.
+     * @param enabled A non-zero value enables metering and a value of zero disables it.
+     * @see kwlMixBusGetPeakLevel
+     * @see kwlMixBusGetRMSLevel
+     * @see kwlGetError
+     */
+    void kwlMixBusSetMeteringEnabled(kwlMixBusHandle handle, int enabled);
+    
+    /**
+     * <p>Returns the peak level of a given channel of a metered mix bus.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_MIX_BUS_HANDLE if the provided handle does not correspond to a mix bus.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c channel is not 0 or 1.</li>
+     * <li>\c KWL_LEVEL_METERING_DISABLED if metering has not been enabled for the mix bus.</li>
+     * </ul>
+     * </p>
+     * @param handle The mix bus to get the level of.
+     * @param channel 0 for the left channel and 1 for the right channel.
+     * @return The peak absolute level, where 1 corresponds to full scale.
+     * @see kwlMixBusSetMeteringEnabled
+     * @see kwlGetError
+     */
+    float kwlMixBusGetPeakLevel(kwlMixBusHandle handle, int channel);
+    
+    /**
+     * <p>Returns the RMS level of a given channel of a metered mix bus.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_MIX_BUS_HANDLE if the provided handle does not correspond to a mix bus.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c channel is not 0 or 1.</li>
+     * <li>\c KWL_LEVEL_METERING_DISABLED if metering has not been enabled for the mix bus.</li>
+     * </ul>
+     * </p>
+     * @param handle The mix bus to get the level of.
+     * @param channel 0 for the left channel and 1 for the right channel.
+     * @return The RMS level, where 1 corresponds to a full scale square wave.
+     * @see kwlMixBusSetMeteringEnabled
+     * @see kwlGetError
+     */
+    float kwlMixBusGetRMSLevel(kwlMixBusHandle handle, int channel);
+    
+    /**
+     * <p>Enables or disables batched filtering on a given mix bus. When enabled, events on the bus
+     * with filters created using \c kwlDSPUnitCreateFilter attached are filtered several at a time,
+     * which is cheaper when many filtered voices play at once. The output is the same whether
+     * batching is enabled or not. Sub buses are not affected.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_MIX_BUS_HANDLE if the provided handle does not correspond to a mix bus.</li>
+     * </ul>
+     * </p>
+     * @param handle The mix bus to enable or disable filter batching for.
+     * @param enabled A non-zero value enables batching and a value of zero disables it.
+     * @see kwlDSPUnitCreateFilter
+     */
+    void kwlMixBusSetFilterBatchingEnabled(kwlMixBusHandle handle, int enabled);
+    
+    /**
+     * <p>Sets the level of the send from a given mix bus to a given aux return bus. Aux return buses
+     * and the sends feeding them are defined in the project data: a return bus sums the output of every
+     * event and bus sending to it and runs its DSP units once over the sum, so a single effect, 
+     * like a reverb, can serve any number of voices. Sends are taken after the DSP units and gain of the
+     * sending bus. The initial level of a send is the level given in the project data.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_MIX_BUS_HANDLE if either handle does not correspond to a mix bus.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c level is negative or if the mix bus has no send to the return bus.</li>
+     * </ul>
+     * </p>
+     * @param handle The sending mix bus.
+     * @param returnBusHandle The aux return bus fed by the send.
+     * @param level The new send level, given as a linear amplitude scale factor.
+     * @see kwlGetError
+     */
+    void kwlMixBusSetAuxSendLevel(kwlMixBusHandle handle, kwlMixBusHandle returnBusHandle, float level);
+    
     /** @} */
     
     /************************************************************************/
@@ -1293,6 +1568,53 @@ extern "C"
      */
     void kwlLevelMeteringSetEnabled(int enabled);    
     
+    /**
+     * <p>Enables or disables TPDF dither of the final output on hosts that output integer 
+     * samples, for example 16 bit output on iOS. Dither replaces the distortion of quiet 
+     * signals caused by rounding to the output bit depth with a constant, very low noise floor.
+     * Float output is never dithered. Dither is disabled by default.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * </ul>
+     * </p>
+     * @param enabled A non-zero value enables dither and a value of zero disables it.
+     * @see kwlGetError
+     */
+    void kwlDitherSetEnabled(int enabled);
+    
+    /**
+     * <p>Enables or disables render-ahead mixing. When enabled, a dedicated high priority 
+     * mixing thread renders blocks of audio ahead of the audio callback, which then only 
+     * copies rendered audio to the output. This trades latency for robustness against 
+     * scheduling hiccups and CPU spikes: the number of blocks rendered ahead grows by one 
+     * whenever the callback finds too little rendered audio and shrinks again when the 
+     * mixing thread keeps up with a block to spare. Render-ahead is disabled by default
+     * and is meant for real time hosts. </p>
+     * <p>Changes take effect gradually: the mixing thread takes over rendering after the 
+     * next audio callback, and the audio callback resumes rendering once the audio rendered 
+     * ahead has been played. The current lead time and the number of underruns are 
+     * reported by ::kwlGetMixerStats.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if render-ahead is being enabled and \c blockSize 
+     * or \c maxNumBlocksAhead is out of range.</li>
+     * </ul>
+     * </p>
+     * @param enabled A non-zero value enables render-ahead and a value of zero disables it.
+     * @param blockSize The number of frames per rendered block, between 1 and 1024. Ignored
+     * if \c enabled is zero.
+     * @param maxNumBlocksAhead The largest number of blocks to render ahead, between 1 and 64. 
+     * The lead time never exceeds \c blockSize * \c maxNumBlocksAhead frames. Ignored
+     * if \c enabled is zero.
+     * @see kwlGetMixerStats
+     * @see kwlGetError
+     */
+    void kwlRenderAheadSetEnabled(int enabled, int blockSize, int maxNumBlocksAhead);
+    
     /**
      * <p>Returns the peak level of the left output channel.</p>
      * <p>
@@ -1366,6 +1688,418 @@ extern "C"
      */
     kwlError kwlGetError(void);
     
+    /**
+     * <p>Seeds the random number generator used for instance stealing and for the random
+     * choices of complex sounds, i.e picking audio data and pitch and gain variations. Each started 
+     * event gets its own random sequence derived from this generator, so for a given seed 
+     * and sequence of API calls the choices are the same every run, regardless of mixer timing. 
+     * The generator is seeded with a fixed value when the engine is initialized.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * </ul>
+     * </p>
+     * @param seed The new seed.
+     * @see kwlGetError
+     */
+    void kwlSetRandomSeed(unsigned int seed);
+    
+    /** @} */
+    
+    /************************************************************************/
+    /**
+     * @name Thread-safe commands
+     *  Functions that can be called from any thread, for example from game logic, physics 
+     *  or streaming worker threads, while the rest of the API must be called from a single 
+     *  thread. Each function queues a call to the corresponding regular function in the lock-free 
+     *  command queue of the instance given as its first argument, without blocking the calling 
+     *  thread. The instance is passed explicitly since the current instance belongs to the thread 
+     *  making the regular API calls, and may change while commands are being queued. Get it using 
+     *  \c kwlInstanceGetCurrent and hand it to other threads. The queued calls are made at the 
+     *  start of the next call to \c kwlUpdate with the instance current, before anything else is updated, 
+     *  in the order in which they were queued. Calls queued by the same thread are therefore 
+     *  made in the order they were queued in. Errors caused by the queued calls are reported 
+     *  by \c kwlGetError on the thread calling \c kwlUpdate. These functions do not set the 
+     *  error flag. Once \c kwlDeinitialize has started, they return \c KWL_ENGINE_IS_NOT_INITIALIZED
+     *  instead of queuing anything, and \c kwlDeinitialize waits for calls that are already 
+     *  adding a command to return before freeing the queue, so the two may overlap. The instance
+     *  handle must not be used once \c kwlDeinitialize has returned.
+     */
+    /** @{ */
+    
+    /**
+     * <p>Queues a call to \c kwlEventStart.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventStart
+     */
+    kwlError kwlCommandEventStart(kwlInstanceHandle instance, kwlEventHandle handle);
+    
+    /**
+     * <p>Queues a call to \c kwlEventStartFade.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param fadeTime The fade in duration in seconds.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventStartFade
+     */
+    kwlError kwlCommandEventStartFade(kwlInstanceHandle instance, kwlEventHandle handle, float fadeTime);
+    
+    /**
+     * <p>Queues a call to \c kwlEventStop.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventStop
+     */
+    kwlError kwlCommandEventStop(kwlInstanceHandle instance, kwlEventHandle handle);
+    
+    /**
+     * <p>Queues a call to \c kwlEventStopFade.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param fadeTime The fade out duration in seconds.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventStopFade
+     */
+    kwlError kwlCommandEventStopFade(kwlInstanceHandle instance, kwlEventHandle handle, float fadeTime);
+    
+    /**
+     * <p>Queues a call to \c kwlEventPause.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventPause
+     */
+    kwlError kwlCommandEventPause(kwlInstanceHandle instance, kwlEventHandle handle);
+    
+    /**
+     * <p>Queues a call to \c kwlEventResume.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventResume
+     */
+    kwlError kwlCommandEventResume(kwlInstanceHandle instance, kwlEventHandle handle);
+    
+    /**
+     * <p>Queues a call to \c kwlEventStartOneShot.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event definition handle corresponding to the event to start.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventStartOneShot
+     */
+    kwlError kwlCommandEventStartOneShot(kwlInstanceHandle instance, kwlEventDefinitionHandle handle);
+    
+    /**
+     * <p>Queues a call to \c kwlEventStartOneShotAt.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event definition handle corresponding to the event to start.
+     * @param x The x coordinate of the event position.
+     * @param y The y coordinate of the event position.
+     * @param z The z coordinate of the event position.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventStartOneShotAt
+     */
+    kwlError kwlCommandEventStartOneShotAt(kwlInstanceHandle instance, kwlEventDefinitionHandle handle, float x, float y, float z);
+    
+    /**
+     * <p>Queues a call to \c kwlEventSetGain.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param gain The new gain in dB.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventSetGain
+     */
+    kwlError kwlCommandEventSetGain(kwlInstanceHandle instance, kwlEventHandle handle, float gain);
+    
+    /**
+     * <p>Queues a call to \c kwlEventSetLinearGain.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param gain The new linear gain.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventSetLinearGain
+     */
+    kwlError kwlCommandEventSetLinearGain(kwlInstanceHandle instance, kwlEventHandle handle, float gain);
+    
+    /**
+     * <p>Queues a call to \c kwlEventSetPitch.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param pitch The new pitch.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventSetPitch
+     */
+    kwlError kwlCommandEventSetPitch(kwlInstanceHandle instance, kwlEventHandle handle, float pitch);
+    
+    /**
+     * <p>Queues a call to \c kwlEventSetBalance.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param balance The new balance.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventSetBalance
+     */
+    kwlError kwlCommandEventSetBalance(kwlInstanceHandle instance, kwlEventHandle handle, float balance);
+    
+    /**
+     * <p>Queues a call to \c kwlEventSetPosition.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param posX The position x component.
+     * @param posY The position y component.
+     * @param posZ The position z component.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventSetPosition
+     */
+    kwlError kwlCommandEventSetPosition(kwlInstanceHandle instance, kwlEventHandle handle, float posX, float posY, float posZ);
+    
+    /**
+     * <p>Queues a call to \c kwlEventSetVelocity.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param velX The velocity x component.
+     * @param velY The velocity y component.
+     * @param velZ The velocity z component.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventSetVelocity
+     */
+    kwlError kwlCommandEventSetVelocity(kwlInstanceHandle instance, kwlEventHandle handle, float velX, float velY, float velZ);
+    
+    /**
+     * <p>Queues a call to \c kwlEventSetOrientation.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle An event handle corresponding to the event.
+     * @param directionX The direction x component.
+     * @param directionY The direction y component.
+     * @param directionZ The direction z component.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlEventSetOrientation
+     */
+    kwlError kwlCommandEventSetOrientation(kwlInstanceHandle instance, kwlEventHandle handle, float directionX, float directionY, float directionZ);
+    
+    /**
+     * <p>Queues a call to \c kwlMixBusSetGain.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle A mix bus handle corresponding to the mix bus.
+     * @param gain The new gain in dB.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlMixBusSetGain
+     */
+    kwlError kwlCommandMixBusSetGain(kwlInstanceHandle instance, kwlMixBusHandle handle, float gain);
+    
+    /**
+     * <p>Queues a call to \c kwlMixBusSetLinearGain.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle A mix bus handle corresponding to the mix bus.
+     * @param gain The new linear gain.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlMixBusSetLinearGain
+     */
+    kwlError kwlCommandMixBusSetLinearGain(kwlInstanceHandle instance, kwlMixBusHandle handle, float gain);
+    
+    /**
+     * <p>Queues a call to \c kwlMixBusSetPitch.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param handle A mix bus handle corresponding to the mix bus.
+     * @param pitch The new pitch.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlMixBusSetPitch
+     */
+    kwlError kwlCommandMixBusSetPitch(kwlInstanceHandle instance, kwlMixBusHandle handle, float pitch);
+    
+    /**
+     * <p>Queues a call to \c kwlListenerSetPosition.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param posX The position x component.
+     * @param posY The position y component.
+     * @param posZ The position z component.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlListenerSetPosition
+     */
+    kwlError kwlCommandListenerSetPosition(kwlInstanceHandle instance, float posX, float posY, float posZ);
+    
+    /**
+     * <p>Queues a call to \c kwlListenerSetVelocity.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param velX The velocity x component.
+     * @param velY The velocity y component.
+     * @param velZ The velocity z component.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlListenerSetVelocity
+     */
+    kwlError kwlCommandListenerSetVelocity(kwlInstanceHandle instance, float velX, float velY, float velZ);
+    
+    /**
+     * <p>Queues a call to \c kwlListenerSetOrientation.</p>
+     * @param instance The engine instance to queue the command for.
+     * @param directionX The direction x component.
+     * @param directionY The direction y component.
+     * @param directionZ The direction z component.
+     * @param upX The up vector x component.
+     * @param upY The up vector y component.
+     * @param upZ The up vector z component.
+     * @return \c KWL_NO_ERROR if the command was queued, \c KWL_ENGINE_IS_NOT_INITIALIZED if the 
+     * instance is NULL or is being deinitialized or \c KWL_MESSAGE_QUEUE_FULL if the command queue is full.
+     * @see kwlListenerSetOrientation
+     */
+    kwlError kwlCommandListenerSetOrientation(kwlInstanceHandle instance,
+                                              float directionX, float directionY, float directionZ,
+                                              float upX, float upY, float upZ);
+    
+    /** @} */
+    
+    /************************************************************************/
+    /**
+     * @name Engine instances
+     *  Several independent engine instances can exist in one process, each with its own engine 
+     *  data, wave banks, mixer, message queues and error flag, for example to render separate 
+     *  mixes for several clients on a server. All API functions apply to the current instance. 
+     *  The current instance is process-wide, so calls for different instances must be made from 
+     *  one thread at a time, switching the current instance between calls. Each instance is 
+     *  mixed independently though, so instances can be rendered on separate threads in parallel 
+     *  using \c kwlOfflineHost_renderInstance, or with render-ahead enabled. Wave banks loaded from 
+     *  the same file by several instances share the same sample memory. Only the offline host 
+     *  supports more than one initialized instance at a time.
+     */
+    /** @{ */
+    
+    /**
+     * <p>Gets the current engine instance, i.e the instance created by the latest call 
+     * to \c kwlInitialize or made current using \c kwlInstanceMakeCurrent.</p>
+     * @return The current instance, or NULL if no instance is current.
+     * @see kwlInstanceMakeCurrent
+     */
+    kwlInstanceHandle kwlInstanceGetCurrent(void);
+    
+    /**
+     * <p>Makes a given engine instance current, so that subsequent API calls apply to it. 
+     * Making no instance current by passing NULL allows creating another instance using 
+     * \c kwlInitialize, which makes the new instance current. \c kwlDeinitialize frees the 
+     * current instance, after which no instance is current. The error flag and any trace 
+     * being recorded belong to the instance and are kept while it is not current.
+     * Thread-safe commands are not affected by which instance is current, they take the instance
+     * to queue the command for as an argument.</p>
+     * <p>Example:</p>
+     * <pre>
+     * kwlInitialize(44100, 2, 0, 512);
+     * kwlInstanceHandle first = kwlInstanceGetCurrent();
+     * kwlInstanceMakeCurrent(NULL);
+     * kwlInitialize(44100, 2, 0, 512);
+     * kwlInstanceHandle second = kwlInstanceGetCurrent();
+     * kwlInstanceMakeCurrent(first);
+     * kwlUpdate(0.02f);
+     * </pre>
+     * @param instance The instance to make current, or NULL.
+     * @see kwlInstanceGetCurrent
+     * @see kwlInitialize
+     * @see kwlDeinitialize
+     */
+    void kwlInstanceMakeCurrent(kwlInstanceHandle instance);
+    
+    /** @} */
+    
+    /************************************************************************/
+    /**
+     * @name API call tracing
+     *  Recording of API calls to a compact binary trace that can be replayed offline, for 
+     *  reproducing and profiling real sessions. Calls are recorded along with the number of
+     *  frames rendered at the time, so that a replay renders the same amount of audio between 
+     *  API calls as the recorded session. Event stopped callbacks and DSP units 
+     *  are not recorded, but API calls made from event stopped callbacks are.
+     */
+    /** @{ */
+    
+    /**
+     * <p>Starts recording all subsequent API calls to a trace file. Recording must be started 
+     * before the engine is initialized, and ends when the engine is deinitialized or when
+     * \c kwlTraceRecordingStop is called.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_ALREADY_INITIALIZED if the Kowalski engine has already been initialized.</li>
+     * <li>\c KWL_COULD_NOT_OPEN_TRACE_FILE if the trace file could not be created.</li>
+     * </ul>
+     * </p>
+     * @param tracePath The path of the trace file to create.
+     * @see kwlTraceRecordingStop
+     * @see kwlTraceReplay
+     * @see kwlGetError
+     */
+    void kwlTraceRecordingStart(const char* const tracePath);
+    
+    /**
+     * <p>Stops any ongoing API call recording and closes the trace file.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_COULD_NOT_OPEN_TRACE_FILE if writing the trace file failed.</li>
+     * </ul>
+     * </p>
+     * @see kwlTraceRecordingStart
+     * @see kwlGetError
+     */
+    void kwlTraceRecordingStop(void);
+    
+    /**
+     * A callback used by \c kwlTraceReplay to mix audio. Implementations render the requested
+     * number of frames through the mixer, typically using an offline host that has no audio device.
+     * @param numFrames The number of frames to render.
+     * @param userData The user data passed to \c kwlTraceReplay.
+     */
+    typedef void (*kwlTraceRenderCallback)(int numFrames, void* userData);
+    
+    /**
+     * <p>Replays the API calls of a trace recorded with \c kwlTraceRecordingStart, including 
+     * initialization and deinitialization of the engine. Before each recorded call, the render 
+     * callback is invoked until the mixer has rendered as many frames as it had when the call was 
+     * recorded, in chunks of the recorded buffer size. Blocking calls are replayed as they are, so
+     * with the offline host, the buffers they render are not passed to the render callback. 
+     * Since the replay only depends on the trace, it produces bit-exact output every time, 
+     * which makes it suitable for profiling and comparing builds. Replaying a session recorded 
+     * with the offline host, rendering one recorded buffer size at a time, reproduces the 
+     * output of that session.</p>
+     * <p>Errors reported by the replayed calls are ignored, since they occurred in the
+     * recorded session as well.</p>
+     * @param tracePath The path of the trace to replay.
+     * @param renderCallback A callback that renders a given number of frames.
+     * @param userData User data passed to \c renderCallback.
+     * @return <ul>
+     * <li>\c KWL_NO_ERROR if the whole trace was replayed.</li>
+     * <li>\c KWL_ENGINE_ALREADY_INITIALIZED if the Kowalski engine is initialized.</li>
+     * <li>\c KWL_FILE_NOT_FOUND if the trace could not be opened.</li>
+     * <li>\c KWL_UNKNOWN_FILE_FORMAT if the file is not a supported API call trace.</li>
+     * <li>\c KWL_CORRUPT_BINARY_DATA if the trace is truncated or contains invalid data.</li>
+     * <li>\c KWL_TRACE_REPLAY_MISMATCH if a handle returned during the replay differs from the recorded one,
+     * for example because the engine data or wave banks changed since the trace was recorded.</li>
+     * </ul>
+     * @see kwlTraceRecordingStart
+     */
+    kwlError kwlTraceReplay(const char* const tracePath, kwlTraceRenderCallback renderCallback, void* userData);
+    
     /** @} */
     
     /************************************************************************/
@@ -1405,7 +2139,8 @@ extern "C"
     
     
     /**
-     * <p>Attaches a given DSP unit to an event instance corresponding to a given handle.</p>
+     * <p>Attaches a given DSP unit to an event instance corresponding to a given handle, replacing
+     * any DSP units already attached to the event.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
@@ -1413,7 +2148,7 @@ extern "C"
      * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE If the event handle does not correspond to an event instance.</li>
      * </ul>
      * </p>
-     * @param dspUnit The DSP unit to attach. Pass \c NULL to remove any current DSP unit.
+     * @param dspUnit The DSP unit to attach. Pass \c NULL to remove all current DSP units.
      * @param eventHandle A handle to the event to which to attach the DSP unit.
      * @see kwlDSPUnitAttachToInput
      * @see kwlDSPUnitAttachToMixBus
@@ -1422,14 +2157,15 @@ extern "C"
     void kwlDSPUnitAttachToEvent(kwlDSPUnitHandle dspUnit, kwlEventHandle eventHandle);
     
     /**
-     * <p>Attaches a given DSP unit for processing audio input (e.g from a microphone).</p>
+     * <p>Attaches a given DSP unit for processing audio input (e.g from a microphone), replacing
+     * any DSP units already attached to the input.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
      * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
      * </ul>
      * </p>
-     * @param dspUnit The DSP unit to attach. Pass \c NULL to remove any current DSP unit.
+     * @param dspUnit The DSP unit to attach. Pass \c NULL to remove all current DSP units.
      * @see kwlDSPUnitAttachToEvent
      * @see kwlDSPUnitAttachToMixBus
      * @see kwlDSPUnitAttachToOutput
@@ -1438,7 +2174,8 @@ extern "C"
     void kwlDSPUnitAttachToInput(kwlDSPUnitHandle dspUnit);
     
     /**
-     * <p>Attaches a given DSP unit to a mix bus corresponding to a given handle.</p>
+     * <p>Attaches a given DSP unit to a mix bus corresponding to a given handle, replacing
+     * any DSP units already attached to the mix bus.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
@@ -1446,7 +2183,7 @@ extern "C"
      * <li>\c KWL_INVALID_MIX_BUS_HANDLE If the mix bus handle does not correspond to a mix bus.</li>
      * </ul>
      * </p>
-     * @param dspUnit The DSP unit to attach. Pass \c NULL to remove any current DSP unit.
+     * @param dspUnit The DSP unit to attach. Pass \c NULL to remove all current DSP units.
      * @param mixBusHandle A handle to the mix bus to which to attach the DSP unit
      * @see kwlDSPUnitAttachToEvent
      * @see kwlDSPUnitAttachToInput
@@ -1457,20 +2194,126 @@ extern "C"
     /**
      * <p>Attaches a given DSP to the master output. This is a suitable entry
      * point for programmers who want to perform custom synthesis without relying
-     * on events and engine data.</p>
+     * on events and engine data. Any DSP units already attached to the output are replaced.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
      * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
      * </ul>
      * </p>
-     * @param dspUnit The DSP unit to attach. Pass \c NULL to remove any current DSP unit.
+     * @param dspUnit The DSP unit to attach. Pass \c NULL to remove all current DSP units.
      * @see kwlDSPUnitAttachToEvent
      * @see kwlDSPUnitAttachToMixBus
      * @see kwlDSPUnitAttachToInput
      */
     void kwlDSPUnitAttachToOutput(kwlDSPUnitHandle dspUnit);
     
+    /**
+     * <p>Adds a DSP unit to the end of the chain of DSP units attached to an event instance.
+     * The units of a chain process the audio in place, in the order they were added. 
+     * Chain edits are passed to the mixer thread through its message queue and take effect
+     * from the next mixed buffer after the next call to \c kwlUpdate.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE If the event handle does not correspond to an event instance.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the DSP unit is \c NULL or already attached to the event.</li>
+     * <li>\c KWL_DSP_CHAIN_IS_FULL if the event already has the maximum number of DSP units attached.</li>
+     * </ul>
+     * </p>
+     * @param dspUnit The DSP unit to add.
+     * @param eventHandle A handle to the event to add the DSP unit to.
+     * @see kwlDSPUnitRemoveFromEvent
+     * @see kwlDSPUnitSetBypassed
+     */
+    void kwlDSPUnitAppendToEvent(kwlDSPUnitHandle dspUnit, kwlEventHandle eventHandle);
+    
+    /**
+     * <p>Adds a DSP unit to the end of the chain of DSP units attached to a mix bus.
+     * Error codes are reported as for \c kwlDSPUnitAppendToEvent, with 
+     * \c KWL_INVALID_MIX_BUS_HANDLE for invalid mix bus handles.</p>
+     * @param dspUnit The DSP unit to add.
+     * @param mixBusHandle A handle to the mix bus to add the DSP unit to.
+     * @see kwlDSPUnitAppendToEvent
+     */
+    void kwlDSPUnitAppendToMixBus(kwlDSPUnitHandle dspUnit, kwlMixBusHandle mixBusHandle);
+    
+    /**
+     * <p>Adds a DSP unit to the end of the chain of DSP units processing audio input.
+     * Error codes are reported as for \c kwlDSPUnitAppendToEvent.</p>
+     * @param dspUnit The DSP unit to add.
+     * @see kwlDSPUnitAppendToEvent
+     */
+    void kwlDSPUnitAppendToInput(kwlDSPUnitHandle dspUnit);
+    
+    /**
+     * <p>Adds a DSP unit to the end of the chain of DSP units processing the master output.
+     * Error codes are reported as for \c kwlDSPUnitAppendToEvent.</p>
+     * @param dspUnit The DSP unit to add.
+     * @see kwlDSPUnitAppendToEvent
+     */
+    void kwlDSPUnitAppendToOutput(kwlDSPUnitHandle dspUnit);
+    
+    /**
+     * <p>Removes a DSP unit from the chain of DSP units attached to an event instance. The units
+     * after the removed unit move up one step in the chain.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE If the event handle does not correspond to an event instance.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the DSP unit is not attached to the event.</li>
+     * </ul>
+     * </p>
+     * @param dspUnit The DSP unit to remove.
+     * @param eventHandle A handle to the event to remove the DSP unit from.
+     * @see kwlDSPUnitAppendToEvent
+     */
+    void kwlDSPUnitRemoveFromEvent(kwlDSPUnitHandle dspUnit, kwlEventHandle eventHandle);
+    
+    /**
+     * <p>Removes a DSP unit from the chain of DSP units attached to a mix bus.
+     * Error codes are reported as for \c kwlDSPUnitRemoveFromEvent, with 
+     * \c KWL_INVALID_MIX_BUS_HANDLE for invalid mix bus handles.</p>
+     * @param dspUnit The DSP unit to remove.
+     * @param mixBusHandle A handle to the mix bus to remove the DSP unit from.
+     * @see kwlDSPUnitRemoveFromEvent
+     */
+    void kwlDSPUnitRemoveFromMixBus(kwlDSPUnitHandle dspUnit, kwlMixBusHandle mixBusHandle);
+    
+    /**
+     * <p>Removes a DSP unit from the chain of DSP units processing audio input.
+     * Error codes are reported as for \c kwlDSPUnitRemoveFromEvent.</p>
+     * @param dspUnit The DSP unit to remove.
+     * @see kwlDSPUnitRemoveFromEvent
+     */
+    void kwlDSPUnitRemoveFromInput(kwlDSPUnitHandle dspUnit);
+    
+    /**
+     * <p>Removes a DSP unit from the chain of DSP units processing the master output.
+     * Error codes are reported as for \c kwlDSPUnitRemoveFromEvent.</p>
+     * @param dspUnit The DSP unit to remove.
+     * @see kwlDSPUnitRemoveFromEvent
+     */
+    void kwlDSPUnitRemoveFromOutput(kwlDSPUnitHandle dspUnit);
+    
+    /**
+     * <p>Bypasses a DSP unit, or stops bypassing it. The DSP callback of a bypassed unit is not
+     * invoked and the audio passes through unchanged, while its update callbacks are still invoked.
+     * Bypassing applies to every point in the signal chain the unit is attached to.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the DSP unit is \c NULL.</li>
+     * </ul>
+     * </p>
+     * @param dspUnit The DSP unit to bypass.
+     * @param bypassed A non-zero value bypasses the unit and a value of zero stops bypassing it.
+     */
+    void kwlDSPUnitSetBypassed(kwlDSPUnitHandle dspUnit, int bypassed);
+    
     /**
      * <p>Creates and returns a handle to a custom DSP unit.</p>
      */
@@ -1480,8 +2323,308 @@ extern "C"
                                             kwlDSPUpdateCallback updateMixer,
                                             kwlDSPCleanupCallback cleanup);
     
+    /**
+     * <p>Sets how long a custom DSP unit keeps producing output after its input goes silent,
+     * for example the decay time of a reverb. Mix buses and the master output skip DSP units
+     * that have rung out while their input is silent, and mix buses without playing events 
+     * whose DSP units have all rung out are skipped entirely, so an idle engine costs next 
+     * to nothing. Custom units have an infinite tail by default, i.e their DSP callback is 
+     * invoked whenever they are attached. Built-in units report their tails themselves.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the DSP unit is not a custom DSP unit.</li>
+     * </ul>
+     * </p>
+     * @param dspUnit The custom DSP unit.
+     * @param seconds The tail length in seconds. Zero means that the unit produces silent output 
+     * from silent input. A negative value means an infinite tail.
+     */
+    void kwlDSPUnitSetTailLength(kwlDSPUnitHandle dspUnit, float seconds);
+    
+    /**
+     * The types of built-in filters.
+     */
+    typedef enum kwlFilterType
+    {
+        /** A first order low pass filter. The Q and gain are ignored. */
+        KWL_ONE_POLE_LOW_PASS_FILTER = 0,
+        /** A first order high pass filter. The Q and gain are ignored. */
+        KWL_ONE_POLE_HIGH_PASS_FILTER,
+        /** A second order low pass filter with a resonance given by the Q. The gain is ignored. */
+        KWL_LOW_PASS_FILTER,
+        /** A second order high pass filter with a resonance given by the Q. The gain is ignored. */
+        KWL_HIGH_PASS_FILTER,
+        /** A second order band pass filter with unit peak gain and a bandwidth given by the Q. The gain is ignored. */
+        KWL_BAND_PASS_FILTER,
+        /** A second order low shelving filter with a given gain below the cutoff. */
+        KWL_LOW_SHELF_FILTER,
+        /** A second order high shelving filter with a given gain above the cutoff. */
+        KWL_HIGH_SHELF_FILTER
+    } kwlFilterType;
+    
+    /**
+     * <p>Creates and returns a handle to a DSP unit with a built-in filter, that can be attached
+     * like any other DSP unit. Filters process mono or stereo buffers and should only be
+     * attached at one point in the signal chain. Parameter changes are smoothed to avoid clicks.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the type is unknown or the cutoff or Q is not positive.</li>
+     * </ul>
+     * </p>
+     * @param type The filter type.
+     * @param cutoffHz The cutoff frequency, or center frequency of band pass filters, in Hz.
+     * @param q The Q. 0.7071 gives a flat pass band for low and high pass filters.
+     * @param gainDB The gain in dB of shelving filters.
+     * @return A handle to the new DSP unit or \c NULL if an error occured.
+     * @see kwlDSPUnitSetFilterParameters
+     * @see kwlMixBusSetFilterBatchingEnabled
+     */
+    kwlDSPUnitHandle kwlDSPUnitCreateFilter(kwlFilterType type, float cutoffHz, float q, float gainDB);
+    
+    /**
+     * <p>Sets the parameters of a DSP unit created using \c kwlDSPUnitCreateFilter. The filter
+     * moves smoothly to the new parameters.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the DSP unit is not a built-in filter or the cutoff or Q is not positive.</li>
+     * </ul>
+     * </p>
+     * @param dspUnit The filter DSP unit.
+     * @param cutoffHz The new cutoff frequency in Hz.
+     * @param q The new Q.
+     * @param gainDB The new shelving gain in dB.
+     */
+    void kwlDSPUnitSetFilterParameters(kwlDSPUnitHandle dspUnit, float cutoffHz, float q, float gainDB);
+    
+    /**
+     * <p>Creates and returns a handle to a DSP unit that convolves its input with a given 
+     * impulse response, for example a convolution reverb on an aux return bus. The output 
+     * is the convolved signal only, delayed by 128 frames. The unit processes mono or stereo 
+     * buffers and should only be attached at one point in the signal chain. A mono impulse 
+     * response is applied to every channel and the channels of a stereo impulse response 
+     * to the corresponding buffer channels.</p>
+     * <p>The first 3968 frames of the impulse response are convolved in the mixer thread 
+     * in short partitions. The rest is convolved in long partitions by a worker thread owned 
+     * by the unit, which has 2048 frames worth of time to process each block, so impulse 
+     * responses of several seconds add little work to the mixer thread. Should the worker
+     * thread fall further behind, the mixer thread waits for it.
+     * Worker threads are stopped when the engine is deinitialized.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the impulse response is empty or has more than two channels.</li>
+     * </ul>
+     * </p>
+     * @param impulseResponse The impulse response, for example loaded using \c kwlPCMBufferLoad. 
+     * The samples are copied, so the buffer may be freed once the unit is created.
+     * @param gain A gain applied to the impulse response.
+     * @return A handle to the new DSP unit or \c NULL if an error occured.
+     */
+    kwlDSPUnitHandle kwlDSPUnitCreateConvolution(const kwlPCMBuffer* impulseResponse, float gain);
+    
     /** @} */ /*End of DSP units group*/
     
+    /************************************************************************/
+    /**
+     * @name CPU cost profiling
+     *  Measurement of the time the mixer spends on rendering, broken down per mix bus, 
+     *  event and DSP unit. Costs are accumulated by the mixer over periods of a given length and
+     *  published to the engine once per period. A load is the time spent during a period 
+     *  divided by the duration of the audio mixed during that period, so a load of 1 means
+     *  that the mixer spent as long mixing as the audio lasts.
+     */
+    /** @{ */
+    
+    /**
+     * The mixer CPU costs of a completed measurement period.
+     */
+    typedef struct kwlCPUCostSnapshot
+    {
+        /** The number of measurement periods completed since profiling was enabled. Zero if no period has completed yet.*/
+        int index;
+        /** The duration in seconds of the audio mixed during the measurement period. */
+        float duration;
+        /** The load of the entire mixer, including all mix buses, events and DSP units. */
+        float mixerLoad;
+        /** The load of the freeform events, which are not routed through any mix bus. */
+        float freeformEventsLoad;
+        /** The load of all DSP units. */
+        float dspLoad;
+        /** The load of decoding streaming events. */
+        float decoderLoad;
+        /** The number of times a decoder produced a new buffer of audio. */
+        int numDecoderRefills;
+    } kwlCPUCostSnapshot;
+    
+    /**
+     * <p>Enables or disables CPU cost profiling. Profiling is disabled by default, since
+     * reading the clock adds a small cost per event and DSP unit. When profiling is enabled,
+     * any previously published costs are discarded.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the snapshot period is negative.</li>
+     * </ul>
+     * </p>
+     * @param enabled A non-zero value enables profiling and a value of zero disables it.
+     * @param snapshotPeriodSec The length in seconds of the measurement periods, in terms of mixed audio.
+     * Zero gives the default period of half a second.
+     * @see kwlCPUProfilingGetSnapshot
+     * @see kwlGetError
+     */
+    void kwlCPUProfilingSetEnabled(int enabled, float snapshotPeriodSec);
+    
+    /**
+     * <p>Gets the mixer CPU costs of the last completed measurement period.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_CPU_PROFILING_DISABLED if CPU cost profiling has not been enabled.</li>
+     * </ul>
+     * </p>
+     * @param snapshot Receives the costs. Zeroed if an error occurs.
+     * @see kwlCPUProfilingSetEnabled
+     * @see kwlGetError
+     */
+    void kwlCPUProfilingGetSnapshot(kwlCPUCostSnapshot* snapshot);
+    
+    /**
+     * <p>Returns the load of a given mix bus during the last completed measurement period, 
+     * including its events, DSP unit and sub buses.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_MIX_BUS_HANDLE if the mix bus handle is invalid.</li>
+     * <li>\c KWL_CPU_PROFILING_DISABLED if CPU cost profiling has not been enabled.</li>
+     * </ul>
+     * </p>
+     * @param handle The mix bus to get the load of.
+     * @return The load of the mix bus.
+     * @see kwlCPUProfilingSetEnabled
+     * @see kwlGetError
+     */
+    float kwlMixBusGetCPULoad(kwlMixBusHandle handle);
+    
+    /**
+     * <p>Returns the load of a given event during the last completed measurement period, 
+     * including decoding and its DSP unit. Zero is returned for events that are not playing.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if the event handle is invalid.</li>
+     * <li>\c KWL_CPU_PROFILING_DISABLED if CPU cost profiling has not been enabled.</li>
+     * </ul>
+     * </p>
+     * @param handle The event to get the load of.
+     * @return The load of the event.
+     * @see kwlCPUProfilingSetEnabled
+     * @see kwlGetError
+     */
+    float kwlEventGetCPULoad(kwlEventHandle handle);
+    
+    /**
+     * <p>Returns the load of a given DSP unit during the last completed measurement period.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the DSP unit handle is NULL.</li>
+     * <li>\c KWL_CPU_PROFILING_DISABLED if CPU cost profiling has not been enabled.</li>
+     * </ul>
+     * </p>
+     * @param dspUnit The DSP unit to get the load of.
+     * @return The load of the DSP unit.
+     * @see kwlCPUProfilingSetEnabled
+     * @see kwlGetError
+     */
+    float kwlDSPUnitGetCPULoad(kwlDSPUnitHandle dspUnit);
+    
+    /** @} */
+    
+    /************************************************************************/
+    /**
+     * @name Mixer statistics
+     *  Counters describing the real-time health of the mixer thread, for example
+     *  how often rendering took longer than the duration of the rendered buffer. The counters
+     *  are always enabled and are published by the mixer after each rendered buffer 
+     *  without taking any locks.
+     */
+    /** @{ */
+    
+    /** The number of bins of the render time histogram in \c kwlMixerStats. */
+    #define KWL_MIXER_STATS_NUM_RENDER_TIME_BINS 9
+    
+    /**
+     * Mixer health counters, accumulated since the engine was initialized.
+     */
+    typedef struct kwlMixerStats
+    {
+        /** The number of buffers rendered by the mixer. */
+        long long numBuffersRendered;
+        /** The number of frames rendered by the mixer, including frames rendered while it is paused. */
+        long long numFramesRendered;
+        /** 
+         * A histogram of render times relative to the duration of the rendered buffer. Bin \c i 
+         * counts buffers that took between \c i / 8 and (\c i + 1) / 8 of the buffer duration to render.
+         * The last bin counts deadline misses, i.e buffers that took at least as long to render as they last.
+         */
+        int renderTimeHistogram[KWL_MIXER_STATS_NUM_RENDER_TIME_BINS];
+        /** The number of buffers that took at least as long to render as they last. */
+        int numDeadlineMisses;
+        /** The longest render time relative to the duration of the rendered buffer. */
+        float maxRenderLoad;
+        /** 
+         * The number of times the mixer skipped updating event and mix bus parameters 
+         * because the engine thread was holding the shared lock.
+         */
+        int numSkippedUpdates;
+        /** The number of times a streaming event needed audio before its decoder had finished decoding it. */
+        int numDecoderUnderruns;
+        /** The highest number of messages waiting to be processed by the mixer. */
+        int maxIncomingMessageQueueDepth;
+        /** The highest number of messages from the mixer waiting to be processed by \c kwlUpdate. */
+        int maxOutgoingMessageQueueDepth;
+        /** The size of the message queues. */
+        int messageQueueSize;
+        /** The number of events mixed into the latest rendered buffer. */
+        int numVoicesMixed;
+        /** The highest number of events mixed into a single buffer. */
+        int maxNumVoicesMixed;
+        /** 
+         * The number of host buffers that the render-ahead mixing thread had not rendered 
+         * in time and that were partly filled with silence. 
+         */
+        int numRenderAheadUnderruns;
+        /** The current render-ahead lead time in frames, or zero if render-ahead is disabled. */
+        int renderAheadLeadInFrames;
+    } kwlMixerStats;
+    
+    /**
+     * <p>Gets the current mixer statistics. This method does not block the mixer thread.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * </ul>
+     * </p>
+     * @param stats Receives the statistics. Zeroed if an error occurs.
+     * @see kwlGetError
+     */
+    void kwlGetMixerStats(kwlMixerStats* stats);
+    
+    /** @} */
+    
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
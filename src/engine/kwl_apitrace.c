@@ -0,0 +1,358 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_apitrace.h"
+#include "kwl_assert.h"
+#include "kwl_memory.h"
+
+#include <string.h>
+
+/** The maximum number of bytes of an encoded variable length quantity. */
+#define KWL_API_TRACE_MAX_VARINT_SIZE 10
+
+static void kwlAPITraceWriter_reserve(kwlAPITraceWriter* writer, int numBytes)
+{
+    if (writer->size + numBytes <= writer->capacity)
+    {
+        return;
+    }
+
+    int newCapacity = writer->capacity > 0 ? writer->capacity : KWL_API_TRACE_FLUSH_SIZE;
+    while (newCapacity < writer->size + numBytes)
+    {
+        newCapacity *= 2;
+    }
+
+    writer->buffer = KWL_REALLOC(writer->buffer, newCapacity, "api trace buffer");
+    writer->capacity = newCapacity;
+}
+
+static void kwlAPITraceWriter_writeBytes(kwlAPITraceWriter* writer, const void* bytes, int numBytes)
+{
+    kwlAPITraceWriter_reserve(writer, numBytes);
+    kwlMemcpy(&writer->buffer[writer->size], bytes, numBytes);
+    writer->size += numBytes;
+}
+
+static void kwlAPITraceWriter_writeVarint(kwlAPITraceWriter* writer, unsigned long long value)
+{
+    kwlAPITraceWriter_reserve(writer, KWL_API_TRACE_MAX_VARINT_SIZE);
+    do
+    {
+        unsigned char byte = value & 0x7f;
+        value >>= 7;
+        if (value != 0)
+        {
+            byte |= 0x80;
+        }
+        writer->buffer[writer->size++] = byte;
+    }
+    while (value != 0);
+}
+
+static void kwlAPITraceWriter_flush(kwlAPITraceWriter* writer)
+{
+    if (writer->size > 0 &&
+        fwrite(writer->buffer, 1, writer->size, writer->file) != (size_t)writer->size)
+    {
+        writer->hasError = 1;
+    }
+    writer->size = 0;
+    writer->recordStart = 0;
+}
+
+kwlError kwlAPITraceWriter_open(kwlAPITraceWriter* writer, const char* const path)
+{
+    kwlMemset(writer, 0, sizeof(kwlAPITraceWriter));
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL)
+    {
+        return KWL_COULD_NOT_OPEN_TRACE_FILE;
+    }
+
+    kwlAPITraceWriter_writeBytes(writer, KWL_API_TRACE_FILE_IDENTIFIER, KWL_API_TRACE_FILE_IDENTIFIER_LENGTH);
+    kwlAPITraceWriter_writeVarint(writer, KWL_API_TRACE_VERSION);
+    return KWL_NO_ERROR;
+}
+
+void kwlAPITraceWriter_beginRecord(kwlAPITraceWriter* writer, kwlAPITraceOpcode opcode,
+                                   long long frame, int forceFrame)
+{
+    KWL_ASSERT(opcode > 0 && opcode < KWL_TRACE_NUM_OPCODES);
+    writer->recordStart = writer->size;
+
+    const int writeFrame = forceFrame || frame != writer->frame;
+    unsigned char opcodeByte = (unsigned char)opcode | (writeFrame ? KWL_API_TRACE_FRAME_FLAG : 0);
+    kwlAPITraceWriter_writeBytes(writer, &opcodeByte, 1);
+    if (writeFrame)
+    {
+        kwlAPITraceWriter_writeVarint(writer, (unsigned long long)frame);
+        writer->frame = frame;
+    }
+}
+
+void kwlAPITraceWriter_writeInt(kwlAPITraceWriter* writer, int value)
+{
+    /*zigzag encode so that small negative values, like invalid handles, stay short.*/
+    const unsigned int zigzag = ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+    kwlAPITraceWriter_writeVarint(writer, zigzag);
+}
+
+void kwlAPITraceWriter_writeFloat(kwlAPITraceWriter* writer, float value)
+{
+    unsigned int bits;
+    kwlMemcpy(&bits, &value, 4);
+    unsigned char bytes[4] = {bits & 0xff, (bits >> 8) & 0xff, (bits >> 16) & 0xff, (bits >> 24) & 0xff};
+    kwlAPITraceWriter_writeBytes(writer, bytes, 4);
+}
+
+void kwlAPITraceWriter_writeString(kwlAPITraceWriter* writer, const char* const string)
+{
+    const int length = string == NULL ? 0 : (int)strlen(string);
+    kwlAPITraceWriter_writeVarint(writer, length);
+    kwlAPITraceWriter_writeBytes(writer, string, length);
+}
+
+void kwlAPITraceWriter_writeShorts(kwlAPITraceWriter* writer, const short* values, int numValues)
+{
+    kwlAPITraceWriter_reserve(writer, 2 * numValues);
+    for (int i = 0; i < numValues; i++)
+    {
+        const unsigned short value = (unsigned short)values[i];
+        writer->buffer[writer->size++] = value & 0xff;
+        writer->buffer[writer->size++] = value >> 8;
+    }
+}
+
+int kwlAPITraceWriter_tell(kwlAPITraceWriter* writer)
+{
+    return writer->size;
+}
+
+void kwlAPITraceWriter_moveRecord(kwlAPITraceWriter* writer, int position)
+{
+    KWL_ASSERT(position >= 0 && position <= writer->recordStart);
+    const int recordSize = writer->size - writer->recordStart;
+    const int numBytesToShift = writer->recordStart - position;
+    if (numBytesToShift == 0)
+    {
+        return;
+    }
+
+    /*rotate the record to the given position, using the free space at the end of the buffer.*/
+    kwlAPITraceWriter_reserve(writer, recordSize);
+    unsigned char* record = &writer->buffer[writer->size];
+    kwlMemcpy(record, &writer->buffer[writer->recordStart], recordSize);
+    memmove(&writer->buffer[position + recordSize], &writer->buffer[position], numBytesToShift);
+    kwlMemcpy(&writer->buffer[position], record, recordSize);
+    writer->recordStart = position;
+}
+
+void kwlAPITraceWriter_flushIfNeeded(kwlAPITraceWriter* writer)
+{
+    if (writer->size >= KWL_API_TRACE_FLUSH_SIZE)
+    {
+        kwlAPITraceWriter_flush(writer);
+    }
+}
+
+kwlError kwlAPITraceWriter_close(kwlAPITraceWriter* writer)
+{
+    kwlAPITraceWriter_flush(writer);
+    if (fclose(writer->file) != 0)
+    {
+        writer->hasError = 1;
+    }
+
+    const int hasError = writer->hasError;
+    if (writer->buffer != NULL)
+    {
+        KWL_FREE(writer->buffer);
+    }
+    kwlMemset(writer, 0, sizeof(kwlAPITraceWriter));
+
+    return hasError ? KWL_COULD_NOT_OPEN_TRACE_FILE : KWL_NO_ERROR;
+}
+
+static int kwlAPITraceReader_readByte(kwlAPITraceReader* reader)
+{
+    signed char byte = 0;
+    if (kwlInputStream_read(&reader->stream, &byte, 1) != 1)
+    {
+        reader->hasError = 1;
+        return -1;
+    }
+    return (unsigned char)byte;
+}
+
+static unsigned long long kwlAPITraceReader_readVarint(kwlAPITraceReader* reader)
+{
+    unsigned long long value = 0;
+    for (int i = 0; i < KWL_API_TRACE_MAX_VARINT_SIZE; i++)
+    {
+        const int byte = kwlAPITraceReader_readByte(reader);
+        if (byte < 0)
+        {
+            return 0;
+        }
+        value |= (unsigned long long)(byte & 0x7f) << (7 * i);
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+    }
+
+    reader->hasError = 1;
+    return 0;
+}
+
+kwlError kwlAPITraceReader_open(kwlAPITraceReader* reader, const char* const path)
+{
+    kwlMemset(reader, 0, sizeof(kwlAPITraceReader));
+    kwlError result = kwlInputStream_initWithFile(&reader->stream, path);
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
+
+    for (int i = 0; i < KWL_API_TRACE_FILE_IDENTIFIER_LENGTH; i++)
+    {
+        if (kwlAPITraceReader_readByte(reader) != (unsigned char)KWL_API_TRACE_FILE_IDENTIFIER[i])
+        {
+            kwlAPITraceReader_close(reader);
+            return KWL_UNKNOWN_FILE_FORMAT;
+        }
+    }
+
+    if (kwlAPITraceReader_readVarint(reader) != KWL_API_TRACE_VERSION || reader->hasError)
+    {
+        kwlAPITraceReader_close(reader);
+        return KWL_UNKNOWN_FILE_FORMAT;
+    }
+
+    return KWL_NO_ERROR;
+}
+
+int kwlAPITraceReader_nextRecord(kwlAPITraceReader* reader, kwlAPITraceOpcode* opcode, long long* frame)
+{
+    if (reader->hasError || kwlInputStream_isAtEndOfStream(&reader->stream))
+    {
+        return 0;
+    }
+
+    const int opcodeByte = kwlAPITraceReader_readByte(reader);
+    if (opcodeByte < 0)
+    {
+        return 0;
+    }
+
+    const int op = opcodeByte & ~KWL_API_TRACE_FRAME_FLAG;
+    if (op <= 0 || op >= KWL_TRACE_NUM_OPCODES)
+    {
+        reader->hasError = 1;
+        return 0;
+    }
+
+    if (opcodeByte & KWL_API_TRACE_FRAME_FLAG)
+    {
+        reader->frame = (long long)kwlAPITraceReader_readVarint(reader);
+    }
+
+    *opcode = (kwlAPITraceOpcode)op;
+    *frame = reader->frame;
+    return !reader->hasError;
+}
+
+int kwlAPITraceReader_readInt(kwlAPITraceReader* reader)
+{
+    const unsigned int zigzag = (unsigned int)kwlAPITraceReader_readVarint(reader);
+    return (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+}
+
+float kwlAPITraceReader_readFloat(kwlAPITraceReader* reader)
+{
+    unsigned int bits = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        const int byte = kwlAPITraceReader_readByte(reader);
+        if (byte < 0)
+        {
+            return 0.0f;
+        }
+        bits |= (unsigned int)byte << (8 * i);
+    }
+
+    float value;
+    kwlMemcpy(&value, &bits, 4);
+    return value;
+}
+
+const char* kwlAPITraceReader_readString(kwlAPITraceReader* reader)
+{
+    const unsigned long long length = kwlAPITraceReader_readVarint(reader);
+    if (reader->hasError || length > 0x7fffffff)
+    {
+        reader->hasError = 1;
+        return "";
+    }
+
+    if ((int)length + 1 > reader->stringCapacity)
+    {
+        reader->stringCapacity = (int)length + 1;
+        reader->string = KWL_REALLOC(reader->string, reader->stringCapacity, "api trace string");
+    }
+
+    if (kwlInputStream_read(&reader->stream, (signed char*)reader->string, (int)length) != (int)length)
+    {
+        reader->hasError = 1;
+        return "";
+    }
+    reader->string[length] = '\0';
+    return reader->string;
+}
+
+void kwlAPITraceReader_readShorts(kwlAPITraceReader* reader, short* values, int numValues)
+{
+    for (int i = 0; i < numValues; i++)
+    {
+        const int low = kwlAPITraceReader_readByte(reader);
+        const int high = kwlAPITraceReader_readByte(reader);
+        if (high < 0)
+        {
+            kwlMemset(&values[i], 0, (numValues - i) * sizeof(short));
+            return;
+        }
+        values[i] = (short)(unsigned short)(low | (high << 8));
+    }
+}
+
+void kwlAPITraceReader_close(kwlAPITraceReader* reader)
+{
+    kwlInputStream_close(&reader->stream);
+    if (reader->string != NULL)
+    {
+        KWL_FREE(reader->string);
+    }
+    reader->string = NULL;
+    reader->stringCapacity = 0;
+}
@@ -0,0 +1,304 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef KWL_API_TRACE_H
+#define KWL_API_TRACE_H
+
+/*! \file
+ Reading and writing of API call traces, i.e compact binary logs of calls to the
+ public API. A trace starts with \c KWL_API_TRACE_FILE_IDENTIFIER and a version
+ number, followed by one record per call. A record starts with a byte holding the
+ \c kwlAPITraceOpcode of the call. If the high bit of that byte is set, it is followed
+ by the number of frames rendered when the call was made, otherwise the frame count
+ is the same as for the previous record. The arguments of the call follow, in the
+ order of the API function parameters. Integers and frame counts are stored as
+ variable length quantities, floats by their bit patterns.
+ */
+
+#include "kowalski.h"
+#include "kwl_inputstream.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** The number of bytes in the API trace file identifier. */
+#define KWL_API_TRACE_FILE_IDENTIFIER_LENGTH 9
+
+/**
+ * The file identifier for API traces, ie the sequence of bytes
+ * that all API trace files start with.
+ */
+static const char KWL_API_TRACE_FILE_IDENTIFIER[KWL_API_TRACE_FILE_IDENTIFIER_LENGTH] =
+{
+    0xAB, 'K', 'W', 'T', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+/** 
+ * The version of the trace format written by \c kwlAPITraceWriter. Version 2 records 
+ * the number of frames rendered instead of the number of frames mixed seen by the engine.
+ */
+#define KWL_API_TRACE_VERSION 2
+
+/** The bit of the opcode byte indicating that a record includes a frame count. */
+#define KWL_API_TRACE_FRAME_FLAG 0x80
+
+/**
+ * The maximum number of buffered bytes before a trace writer flushes to disk.
+ * Writers only flush after \c kwlUpdate records.
+ */
+#define KWL_API_TRACE_FLUSH_SIZE (16 * 1024)
+
+/**
+ * Identifies the public API function a trace record corresponds to. The arguments
+ * stored for each opcode are listed in parentheses. Functions returning a handle
+ * also store the returned handle, last.
+ */
+typedef enum
+{
+    /** \c kwlInitialize (sample rate, output channels, input channels, buffer size). */
+    KWL_TRACE_INITIALIZE = 1,
+    /** \c kwlDeinitialize. */
+    KWL_TRACE_DEINITIALIZE,
+    /** \c kwlUpdate (time step). */
+    KWL_TRACE_UPDATE,
+    /** \c kwlSetRandomSeed (seed). */
+    KWL_TRACE_SET_RANDOM_SEED,
+    /** \c kwlEngineDataLoad (path). */
+    KWL_TRACE_ENGINE_DATA_LOAD,
+    /** \c kwlEngineDataUnload. */
+    KWL_TRACE_ENGINE_DATA_UNLOAD,
+    /** \c kwlWaveBankLoad (path, handle). */
+    KWL_TRACE_WAVE_BANK_LOAD,
+    /** \c kwlWaveBankUnload and \c kwlWaveBankUnloadBlocking (handle, non-zero if blocking). */
+    KWL_TRACE_WAVE_BANK_UNLOAD,
+    /** \c kwlEventGetHandle (id, handle). */
+    KWL_TRACE_EVENT_GET_HANDLE,
+    /** \c kwlEventDefinitionGetHandle (id, handle). */
+    KWL_TRACE_EVENT_DEFINITION_GET_HANDLE,
+    /** \c kwlEventCreateWithFile (path, event type, stream from disk, handle). */
+    KWL_TRACE_EVENT_CREATE_WITH_FILE,
+    /** \c kwlEventCreateWithBuffer (frames, channels, samples, event type, handle). */
+    KWL_TRACE_EVENT_CREATE_WITH_BUFFER,
+    /** \c kwlEventRelease (handle). */
+    KWL_TRACE_EVENT_RELEASE,
+    /** \c kwlEventStart (handle). */
+    KWL_TRACE_EVENT_START,
+    /** \c kwlEventStartFade (handle, fade time). */
+    KWL_TRACE_EVENT_START_FADE,
+    /**
+     * \c kwlEventStartOneShot and its variants (event definition handle, non-zero if
+     * positioned, x, y, z). Callbacks are not recorded.
+     */
+    KWL_TRACE_EVENT_START_ONE_SHOT,
+    /** \c kwlEventStop (handle). */
+    KWL_TRACE_EVENT_STOP,
+    /** \c kwlEventStopFade (handle, fade time). */
+    KWL_TRACE_EVENT_STOP_FADE,
+    /** \c kwlEventPause (handle). */
+    KWL_TRACE_EVENT_PAUSE,
+    /** \c kwlEventResume (handle). */
+    KWL_TRACE_EVENT_RESUME,
+    /** \c kwlEventSetPitch (handle, pitch). */
+    KWL_TRACE_EVENT_SET_PITCH,
+    /** \c kwlEventSetGain (handle, gain). */
+    KWL_TRACE_EVENT_SET_GAIN,
+    /** \c kwlEventSetLinearGain (handle, gain). */
+    KWL_TRACE_EVENT_SET_LINEAR_GAIN,
+    /** \c kwlEventSetBalance (handle, balance). */
+    KWL_TRACE_EVENT_SET_BALANCE,
+    /** \c kwlEventSetPosition (handle, x, y, z). */
+    KWL_TRACE_EVENT_SET_POSITION,
+    /** \c kwlEventSetVelocity (handle, x, y, z). */
+    KWL_TRACE_EVENT_SET_VELOCITY,
+    /** \c kwlEventSetOrientation (handle, x, y, z). */
+    KWL_TRACE_EVENT_SET_ORIENTATION,
+    /** \c kwlMixBusGetHandle (id, handle). */
+    KWL_TRACE_MIX_BUS_GET_HANDLE,
+    /** \c kwlMixBusSetGain (handle, gain). */
+    KWL_TRACE_MIX_BUS_SET_GAIN,
+    /** \c kwlMixBusSetLinearGain (handle, gain). */
+    KWL_TRACE_MIX_BUS_SET_LINEAR_GAIN,
+    /** \c kwlMixBusSetPitch (handle, pitch). */
+    KWL_TRACE_MIX_BUS_SET_PITCH,
+    /** \c kwlMixPresetGetHandle (id, handle). */
+    KWL_TRACE_MIX_PRESET_GET_HANDLE,
+    /** \c kwlMixPresetFadeTo (handle). */
+    KWL_TRACE_MIX_PRESET_FADE_TO,
+    /** \c kwlMixPresetSet (handle). */
+    KWL_TRACE_MIX_PRESET_SET,
+    /** \c kwlListenerSetPosition (x, y, z). */
+    KWL_TRACE_LISTENER_SET_POSITION,
+    /** \c kwlListenerSetVelocity (x, y, z). */
+    KWL_TRACE_LISTENER_SET_VELOCITY,
+    /** \c kwlListenerSetOrientation (direction x, y, z, up x, y, z). */
+    KWL_TRACE_LISTENER_SET_ORIENTATION,
+    /** \c kwlListenerSetConeParameters (inner angle, outer angle, outer gain). */
+    KWL_TRACE_LISTENER_SET_CONE_PARAMETERS,
+    /** \c kwlSetDistanceAttenuationModel (model, clamp, max distance, rolloff factor, reference distance). */
+    KWL_TRACE_SET_DISTANCE_ATTENUATION_MODEL,
+    /** \c kwlSetDopplerShiftParameters (speed of sound, doppler scale). */
+    KWL_TRACE_SET_DOPPLER_SHIFT_PARAMETERS,
+    /** \c kwlSetConeAttenuationEnabled (listener cone, event cones). */
+    KWL_TRACE_SET_CONE_ATTENUATION_ENABLED,
+    /** \c kwlMixerPause. */
+    KWL_TRACE_MIXER_PAUSE,
+    /** \c kwlMixerResume. */
+    KWL_TRACE_MIXER_RESUME,
+    /** \c kwlLevelMeteringSetEnabled (enabled). */
+    KWL_TRACE_LEVEL_METERING_SET_ENABLED,
+    /** \c kwlMixBusSetMeteringEnabled (handle, enabled). */
+    KWL_TRACE_MIX_BUS_SET_METERING_ENABLED,
+    /** One past the last valid opcode. */
+    KWL_TRACE_NUM_OPCODES
+} kwlAPITraceOpcode;
+
+/**
+ * Encodes API trace records into a growing buffer that gets flushed to a file.
+ */
+typedef struct kwlAPITraceWriter
+{
+    /** The file to write the trace to. */
+    FILE* file;
+    /** Encoded records that have not yet been written to the file. */
+    unsigned char* buffer;
+    /** The number of bytes in \c buffer. */
+    int size;
+    /** The capacity in bytes of \c buffer. */
+    int capacity;
+    /** The position in \c buffer of the most recently started record. */
+    int recordStart;
+    /** The frame count of the most recent record. */
+    long long frame;
+    /** Non-zero if writing to the file failed. */
+    int hasError;
+} kwlAPITraceWriter;
+
+/**
+ * Creates a trace file at a given path and writes the trace header.
+ * @return \c KWL_NO_ERROR on success, \c KWL_COULD_NOT_OPEN_TRACE_FILE otherwise.
+ */
+kwlError kwlAPITraceWriter_open(kwlAPITraceWriter* writer, const char* const path);
+
+/**
+ * Starts a new record. The arguments of the call are written
+ * using the other write methods.
+ * @param writer The writer.
+ * @param opcode The opcode of the record.
+ * @param frame The number of frames rendered by the mixer.
+ * @param forceFrame If non-zero, the frame count is written even if it
+ * is the same as for the previous record.
+ */
+void kwlAPITraceWriter_beginRecord(kwlAPITraceWriter* writer, kwlAPITraceOpcode opcode,
+                                   long long frame, int forceFrame);
+
+/** Writes an integer argument of the current record. */
+void kwlAPITraceWriter_writeInt(kwlAPITraceWriter* writer, int value);
+
+/** Writes a float argument of the current record, preserving its exact bit pattern. */
+void kwlAPITraceWriter_writeFloat(kwlAPITraceWriter* writer, float value);
+
+/** Writes a string argument of the current record. \c NULL is written as an empty string.*/
+void kwlAPITraceWriter_writeString(kwlAPITraceWriter* writer, const char* const string);
+
+/** Writes an array of 16 bit samples as an argument of the current record. */
+void kwlAPITraceWriter_writeShorts(kwlAPITraceWriter* writer, const short* values, int numValues);
+
+/**
+ * Returns the current write position, which can be passed to
+ * \c kwlAPITraceWriter_moveRecord.
+ */
+int kwlAPITraceWriter_tell(kwlAPITraceWriter* writer);
+
+/**
+ * Moves the current record to a given earlier position, in front of any records
+ * written after that position. Used to put records of calls made from within
+ * \c kwlUpdate, like event stopped callbacks, after the record of the update itself.
+ * The current record must have been written with \c forceFrame set.
+ */
+void kwlAPITraceWriter_moveRecord(kwlAPITraceWriter* writer, int position);
+
+/** Writes any buffered records to the trace file if the buffer is sufficiently full. */
+void kwlAPITraceWriter_flushIfNeeded(kwlAPITraceWriter* writer);
+
+/** Writes any buffered records and closes the trace file. */
+kwlError kwlAPITraceWriter_close(kwlAPITraceWriter* writer);
+
+/**
+ * Decodes API trace records.
+ */
+typedef struct kwlAPITraceReader
+{
+    /** The stream to read the trace from. */
+    kwlInputStream stream;
+    /** Holds the most recently read string argument. */
+    char* string;
+    /** The capacity in bytes of \c string. */
+    int stringCapacity;
+    /** The frame count of the most recent record. */
+    long long frame;
+    /** Non-zero if the trace ended prematurely or contains invalid data. */
+    int hasError;
+} kwlAPITraceReader;
+
+/**
+ * Opens a trace file and validates its header.
+ * @return \c KWL_NO_ERROR on success, \c KWL_FILE_NOT_FOUND if the file could not be opened,
+ * \c KWL_UNKNOWN_FILE_FORMAT if the file is not an API trace or has an unsupported version.
+ */
+kwlError kwlAPITraceReader_open(kwlAPITraceReader* reader, const char* const path);
+
+/**
+ * Reads the start of the next record.
+ * @param reader The reader.
+ * @param opcode Receives the opcode of the record.
+ * @param frame Receives the number of frames rendered when the call was recorded.
+ * @return Non-zero if a record was read, zero at the end of the trace or if the record is invalid.
+ */
+int kwlAPITraceReader_nextRecord(kwlAPITraceReader* reader, kwlAPITraceOpcode* opcode, long long* frame);
+
+/** Reads an integer argument of the current record. */
+int kwlAPITraceReader_readInt(kwlAPITraceReader* reader);
+
+/** Reads a float argument of the current record. */
+float kwlAPITraceReader_readFloat(kwlAPITraceReader* reader);
+
+/**
+ * Reads a string argument of the current record. The returned string
+ * is valid until the next call to this method.
+ */
+const char* kwlAPITraceReader_readString(kwlAPITraceReader* reader);
+
+/** Reads an array of 16 bit samples written by \c kwlAPITraceWriter_writeShorts. */
+void kwlAPITraceReader_readShorts(kwlAPITraceReader* reader, short* values, int numValues);
+
+/** Closes the trace file and releases the memory of a reader. */
+void kwlAPITraceReader_close(kwlAPITraceReader* reader);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_API_TRACE_H*/
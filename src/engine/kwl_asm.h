@@ -36,6 +36,20 @@
 #include "kwl_assert.h"
 #include "kwl_memory.h"
 #include "string.h"
+#include <math.h>
+
+/*SIMD instruction sets available to the tight loops, if any.*/
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define KWL_SSE 1
+#include <xmmintrin.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KWL_SSE2 1
+#include <emmintrin.h>
+#endif
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define KWL_NEON 1
+#include <arm_neon.h>
+#endif
 
 #ifdef __cplusplus
 extern "C"
@@ -50,6 +64,21 @@ extern "C"
         int bits;
     };
     
+    /** The largest value returned by \c kwlRandomNext. */
+#define KWL_RANDOM_MAX 0x7fff
+    
+    /**
+     * Returns a pseudo random number in the range [0, KWL_RANDOM_MAX] and advances a given
+     * generator state. Unlike rand(), the sequence only depends on the initial state, so
+     * it is reproducible and unaffected by other threads.
+     * @param state The generator state.
+     */
+    static inline int kwlRandomNext(unsigned int* state)
+    {
+        *state = *state * 1103515245u + 12345u;
+        return (int)((*state >> 16) & KWL_RANDOM_MAX);
+    }
+    
     static inline float logGainToLinGain(float input)
     {
         return input * input * input * input;
@@ -100,6 +129,33 @@ extern "C"
         }
     }
     
+    /**
+     * Reverses the byte order for all elements in a given array of 32 bit words.
+     * @param buffer The buffer to process.
+     * @param size The number of elements in the buffer to process.
+     */
+    static inline void kwlSwapEndian32(int* buffer, int size)
+    {
+        int i;
+        for (i = 0; i < size; i++)
+        {
+            unsigned int temp = (unsigned int)buffer[i];
+            buffer[i] = (int)(((temp & 0x000000ff) << 24) |
+                              ((temp & 0x0000ff00) << 8) |
+                              ((temp & 0x00ff0000) >> 8) |
+                              ((temp & 0xff000000) >> 24));
+        }
+    }
+    
+    /**
+     * Returns non-zero if the host byte order is big endian, zero otherwise.
+     */
+    static inline int kwlIsBigEndianHost()
+    {
+        const int one = 1;
+        return *((const char*)&one) == 0;
+    }
+    
     /**
      * Finds and returns the maximum absolute value in a given buffer.
      * @param buffer The buffer containing the values to check
@@ -131,6 +187,80 @@ extern "C"
         return absMax;
     }
     
+    /**
+     * Computes the peak absolute value and the sum of squares of each channel 
+     * of an interleaved buffer, four samples at a time.
+     * @param buffer The buffer to measure.
+     * @param numChannels The number of interleaved channels, 1 or 2.
+     * @param numFrames The number of frames in the buffer.
+     * @param peaks Receives the peak absolute value of each channel.
+     * @param sumsOfSquares Receives the sum of squared samples of each channel.
+     */
+    static inline void kwlGetBufferPeaksAndSumsOfSquares(const float* buffer, 
+                                                         int numChannels, 
+                                                         int numFrames,
+                                                         float* peaks,
+                                                         float* sumsOfSquares)
+    {
+        KWL_ASSERT(numChannels == 1 || numChannels == 2);
+        const int numSamples = numChannels * numFrames;
+        float laneMax[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float laneSum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        int i = 0;
+        
+#if KWL_SSE
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 absMax = _mm_setzero_ps();
+        __m128 sum = _mm_setzero_ps();
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(&buffer[i]);
+            absMax = _mm_max_ps(absMax, _mm_andnot_ps(signMask, x));
+            sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+        }
+        _mm_storeu_ps(laneMax, absMax);
+        _mm_storeu_ps(laneSum, sum);
+#elif KWL_NEON
+        float32x4_t absMax = vdupq_n_f32(0.0f);
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float32x4_t x = vld1q_f32(&buffer[i]);
+            absMax = vmaxq_f32(absMax, vabsq_f32(x));
+            sum = vmlaq_f32(sum, x, x);
+        }
+        vst1q_f32(laneMax, absMax);
+        vst1q_f32(laneSum, sum);
+#endif
+        
+        /*the remaining samples, or all of them if there is no SIMD support.*/
+        for (; i < numSamples; i++)
+        {
+            const float x = buffer[i];
+            const float absX = x < 0.0f ? -x : x;
+            if (absX > laneMax[i & 3])
+            {
+                laneMax[i & 3] = absX;
+            }
+            laneSum[i & 3] += x * x;
+        }
+        
+        /*since four is a multiple of the channel count, lane j holds samples of channel j % numChannels.*/
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            peaks[ch] = 0.0f;
+            sumsOfSquares[ch] = 0.0f;
+            for (int lane = ch; lane < 4; lane += numChannels)
+            {
+                if (laneMax[lane] > peaks[ch])
+                {
+                    peaks[ch] = laneMax[lane];
+                }
+                sumsOfSquares[ch] += laneSum[lane];
+            }
+        }
+    }
+    
     /**
      * Sets all elements of a given float buffer to zero
      * @param buffer The buffer to clear.
@@ -350,6 +480,222 @@ extern "C"
         }
     }
     
+    /** The number of independent generators of a dither state. */
+#define KWL_DITHER_NUM_LANES 4
+    
+    /**
+     * The state of a TPDF dither generator, made up of one xorshift generator per 
+     * SIMD lane so that dither can be generated four samples at a time. Sample \c i
+     * of a converted buffer is dithered using lane \c i % 4, with or without SIMD support.
+     */
+    typedef struct kwlDitherState
+    {
+        unsigned int lanes[KWL_DITHER_NUM_LANES];
+    } kwlDitherState;
+    
+    /**
+     * Seeds the generators of a dither state.
+     * @param state The state to seed.
+     * @param seed The seed.
+     */
+    static inline void kwlDitherState_init(kwlDitherState* state, unsigned int seed)
+    {
+        for (int i = 0; i < KWL_DITHER_NUM_LANES; i++)
+        {
+            /*xorshift generators never leave the zero state, so make sure no lane starts there.*/
+            state->lanes[i] = (seed + 0x9e3779b9u * (unsigned int)(i + 1)) | 1u;
+        }
+    }
+    
+    /**
+     * Scales a sample from [-1, 1] to [-scale - 1, scale], optionally adding triangular 
+     * dither of up to one LSB, and rounds it to the nearest integer.
+     * @param sample The sample, clamped to [-1, 1] before scaling.
+     * @param scale The largest integer output value.
+     * @param ditherLane The dither generator to advance, or NULL to skip dithering.
+     */
+    static inline int kwlQuantizeSample(float sample, float scale, unsigned int* ditherLane)
+    {
+        float x = sample < -1.0f ? -1.0f : (sample > 1.0f ? 1.0f : sample);
+        x *= scale;
+        if (ditherLane != NULL)
+        {
+            /*the sum of the two 16 bit halves of a random word has a triangular distribution.*/
+            unsigned int bits = *ditherLane;
+            bits ^= bits << 13;
+            bits ^= bits >> 17;
+            bits ^= bits << 5;
+            *ditherLane = bits;
+            x += (float)((int)(bits & 0xffff) + (int)(bits >> 16) - 0xffff) * (1.0f / 65536.0f);
+            x = x < -scale - 1.0f ? -scale - 1.0f : (x > scale ? scale : x);
+        }
+        return (int)lrintf(x);
+    }
+    
+#if KWL_SSE2
+    /**
+     * Quantizes four consecutive samples like \c kwlQuantizeSample.
+     * @param ditherLanes The dither generators to advance, or NULL to skip dithering.
+     */
+    static inline __m128i kwlQuantizeSamples_sse2(const float* samples, float scale, __m128i* ditherLanes)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 minusOne = _mm_set1_ps(-1.0f);
+        __m128 x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples), minusOne), one), _mm_set1_ps(scale));
+        if (ditherLanes != NULL)
+        {
+            __m128i bits = *ditherLanes;
+            bits = _mm_xor_si128(bits, _mm_slli_epi32(bits, 13));
+            bits = _mm_xor_si128(bits, _mm_srli_epi32(bits, 17));
+            bits = _mm_xor_si128(bits, _mm_slli_epi32(bits, 5));
+            *ditherLanes = bits;
+            const __m128i lowMask = _mm_set1_epi32(0xffff);
+            const __m128i sum = _mm_add_epi32(_mm_and_si128(bits, lowMask), _mm_srli_epi32(bits, 16));
+            x = _mm_add_ps(x, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(sum, lowMask)), _mm_set1_ps(1.0f / 65536.0f)));
+            x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-scale - 1.0f)), _mm_set1_ps(scale));
+        }
+        /*rounds to nearest like lrintf in the default rounding mode.*/
+        return _mm_cvtps_epi32(x);
+    }
+#elif KWL_NEON && defined(__aarch64__)
+    /**
+     * Quantizes four consecutive samples like \c kwlQuantizeSample.
+     * @param ditherLanes The dither generators to advance, or NULL to skip dithering.
+     */
+    static inline int32x4_t kwlQuantizeSamples_neon(const float* samples, float scale, uint32x4_t* ditherLanes)
+    {
+        float32x4_t x = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(samples), vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f)), scale);
+        if (ditherLanes != NULL)
+        {
+            uint32x4_t bits = *ditherLanes;
+            bits = veorq_u32(bits, vshlq_n_u32(bits, 13));
+            bits = veorq_u32(bits, vshrq_n_u32(bits, 17));
+            bits = veorq_u32(bits, vshlq_n_u32(bits, 5));
+            *ditherLanes = bits;
+            const int32x4_t sum = vreinterpretq_s32_u32(vaddq_u32(vandq_u32(bits, vdupq_n_u32(0xffff)), vshrq_n_u32(bits, 16)));
+            const float32x4_t dither = vmulq_n_f32(vcvtq_f32_s32(vsubq_s32(sum, vdupq_n_s32(0xffff))), 1.0f / 65536.0f);
+            x = vaddq_f32(x, dither);
+            x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-scale - 1.0f)), vdupq_n_f32(scale));
+        }
+        return vcvtnq_s32_f32(x);
+    }
+#endif
+    
+    /**
+     * Clamps a buffer of floats to [-1, 1] and converts it to signed 16 bit integers
+     * in a single pass, optionally applying TPDF dither.
+     * @param sourceBuffer The buffer containing the values to convert.
+     * @param targetBuffer The buffer to write converted samples to.
+     * @param size The size of the source and target buffers.
+     * @param dither The dither generator state, or NULL to convert without dither.
+     */
+    static inline void kwlFloatToInt16Clamped(const float* sourceBuffer, short* targetBuffer, int size, kwlDitherState* dither)
+    {
+        int i = 0;
+#if KWL_SSE2
+        /*separate loops with and without dither keep the dither test out of the inner loop.*/
+        if (dither != NULL)
+        {
+            __m128i lanes = _mm_loadu_si128((const __m128i*)dither->lanes);
+            for (; i + 4 <= size; i += 4)
+            {
+                const __m128i v = kwlQuantizeSamples_sse2(&sourceBuffer[i], 32767.0f, &lanes);
+                _mm_storel_epi64((__m128i*)&targetBuffer[i], _mm_packs_epi32(v, v));
+            }
+            _mm_storeu_si128((__m128i*)dither->lanes, lanes);
+        }
+        else
+        {
+            for (; i + 8 <= size; i += 8)
+            {
+                const __m128i v0 = kwlQuantizeSamples_sse2(&sourceBuffer[i], 32767.0f, NULL);
+                const __m128i v1 = kwlQuantizeSamples_sse2(&sourceBuffer[i + 4], 32767.0f, NULL);
+                _mm_storeu_si128((__m128i*)&targetBuffer[i], _mm_packs_epi32(v0, v1));
+            }
+        }
+#elif KWL_NEON && defined(__aarch64__)
+        if (dither != NULL)
+        {
+            uint32x4_t lanes = vld1q_u32(dither->lanes);
+            for (; i + 4 <= size; i += 4)
+            {
+                const int32x4_t v = kwlQuantizeSamples_neon(&sourceBuffer[i], 32767.0f, &lanes);
+                vst1_s16(&targetBuffer[i], vqmovn_s32(v));
+            }
+            vst1q_u32(dither->lanes, lanes);
+        }
+        else
+        {
+            for (; i + 4 <= size; i += 4)
+            {
+                vst1_s16(&targetBuffer[i], vqmovn_s32(kwlQuantizeSamples_neon(&sourceBuffer[i], 32767.0f, NULL)));
+            }
+        }
+#endif
+        
+        /*the remaining samples, or all of them if there is no SIMD support.*/
+        for (; i < size; i++)
+        {
+            const int v = kwlQuantizeSample(sourceBuffer[i], 32767.0f, dither != NULL ? &dither->lanes[i & 3] : NULL);
+            targetBuffer[i] = (short)(v < -32768 ? -32768 : v);
+        }
+    }
+    
+    /**
+     * Clamps a buffer of floats to [-1, 1] and converts it to packed, little endian, 
+     * signed 24 bit integers in a single pass, optionally applying TPDF dither.
+     * @param sourceBuffer The buffer containing the values to convert.
+     * @param targetBuffer The buffer to write converted samples to, three bytes per sample.
+     * @param size The number of samples to convert.
+     * @param dither The dither generator state, or NULL to convert without dither.
+     */
+    static inline void kwlFloatToInt24Clamped(const float* sourceBuffer, unsigned char* targetBuffer, int size, kwlDitherState* dither)
+    {
+        int i = 0;
+#if KWL_SSE2 || (KWL_NEON && defined(__aarch64__))
+        int quantized[4];
+#if KWL_SSE2
+        __m128i lanes = dither != NULL ? _mm_loadu_si128((const __m128i*)dither->lanes) : _mm_setzero_si128();
+#else
+        uint32x4_t lanes = dither != NULL ? vld1q_u32(dither->lanes) : vdupq_n_u32(0);
+#endif
+        for (; i + 4 <= size; i += 4)
+        {
+#if KWL_SSE2
+            _mm_storeu_si128((__m128i*)quantized, 
+                             kwlQuantizeSamples_sse2(&sourceBuffer[i], 8388607.0f, dither != NULL ? &lanes : NULL));
+#else
+            vst1q_s32(quantized, kwlQuantizeSamples_neon(&sourceBuffer[i], 8388607.0f, dither != NULL ? &lanes : NULL));
+#endif
+            for (int j = 0; j < 4; j++)
+            {
+                unsigned char* bytes = &targetBuffer[3 * (i + j)];
+                bytes[0] = (unsigned char)(quantized[j] & 0xff);
+                bytes[1] = (unsigned char)((quantized[j] >> 8) & 0xff);
+                bytes[2] = (unsigned char)((quantized[j] >> 16) & 0xff);
+            }
+        }
+        if (dither != NULL)
+        {
+#if KWL_SSE2
+            _mm_storeu_si128((__m128i*)dither->lanes, lanes);
+#else
+            vst1q_u32(dither->lanes, lanes);
+#endif
+        }
+#endif
+        
+        /*the remaining samples, or all of them if there is no SIMD support.*/
+        for (; i < size; i++)
+        {
+            const int v = kwlQuantizeSample(sourceBuffer[i], 8388607.0f, dither != NULL ? &dither->lanes[i & 3] : NULL);
+            unsigned char* bytes = &targetBuffer[3 * i];
+            bytes[0] = (unsigned char)(v & 0xff);
+            bytes[1] = (unsigned char)((v >> 8) & 0xff);
+            bytes[2] = (unsigned char)((v >> 16) & 0xff);
+        }
+    }
+    
     static inline void kwlUInt8ToInt16(char* sourceBuffer,
                                        int sourceBufferSizeInBytes,
                                        short* targetBuffer)
@@ -463,6 +809,23 @@ extern "C"
     static inline void kwlClampBuffer(float* buffer, int size)
     {
         int i = 0;
+#if KWL_SSE
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 minusOne = _mm_set1_ps(-1.0f);
+        for (; i + 4 <= size; i += 4)
+        {
+            _mm_storeu_ps(&buffer[i], _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&buffer[i]), minusOne), one));
+        }
+#elif KWL_NEON
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t minusOne = vdupq_n_f32(-1.0f);
+        for (; i + 4 <= size; i += 4)
+        {
+            vst1q_f32(&buffer[i], vminq_f32(vmaxq_f32(vld1q_f32(&buffer[i]), minusOne), one));
+        }
+#endif
+        
+        /*the remaining samples, or all of them if there is no SIMD support.*/
         while (i < size)
         {
             float val = buffer[i];
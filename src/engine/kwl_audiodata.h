@@ -86,6 +86,8 @@ extern "C"
         int numFrames;
         /** The number of channels of the audio. Only used for PCM data. */
         int numChannels;
+        /** The sample rate in Hz as given by the source file, or 0 if unknown. */
+        int sampleRate;
         /** The total number of bytes of loaded audio data. A value of 0 indicates that no data is loaded. */
         int numBytes;
         /** */
@@ -75,6 +75,37 @@ kwlError kwlLoadAudioFile(const char* path, kwlAudioData* audioData, kwlAudioDat
     return error;
 }
 
+kwlError kwlLoadAudioFileFromBuffer(void* fileData, int fileSize, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
+{
+    typedef kwlError (*kwlAudioFileStreamLoader)(kwlInputStream*, kwlAudioData*, kwlAudioDataLoadingMode);
+    const kwlAudioFileStreamLoader loaders[] = {kwlLoadAIFFFromStream,
+                                                kwlLoadAUFromStream,
+                                                kwlLoadWAVFromStream,
+                                                kwlLoadOggVorbisFromStream};
+    
+    kwlError error = KWL_UNKNOWN_FILE_FORMAT;
+    for (int i = 0; i < (int)(sizeof(loaders) / sizeof(loaders[0])); i++)
+    {
+        kwlInputStream stream;
+        kwlInputStream_initWithBuffer(&stream, fileData, 0, fileSize);
+        error = loaders[i](&stream, audioData, mode);
+        kwlInputStream_close(&stream);
+        if (error == KWL_NO_ERROR)
+        {
+            return error;
+        }
+    }
+    
+    audioData->encoding = KWL_ENCODING_UNKNOWN;
+    if (mode == KWL_LOAD_ENTIRE_FILE)
+    {
+        audioData->bytes = KWL_MALLOC(fileSize, "entire file buffer");
+        kwlMemcpy(audioData->bytes, fileData, fileSize);
+        audioData->numBytes = fileSize;
+    }
+    return error;
+}
+
 kwlError kwlLoadAIFF(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
 {
     /* see http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/AIFF/Docs/AIFF-1.3.pdf */
@@ -96,6 +127,24 @@ kwlError kwlLoadAIFF(const char* path, kwlAudioData* audioData, kwlAudioDataLoad
     return result;
 }
 
+/**
+ * Reads an 80 bit IEEE 754 extended precision big endian number, as used for
+ * the sample rate in AIFF files, and returns its integer part.
+ */
+static int kwlReadExtendedBEAsInt(kwlInputStream* stream)
+{
+    const int exponent = (kwlInputStream_readShortBE(stream) & 0x7fff) - 16383;
+    const unsigned int mantissa = (unsigned int)kwlInputStream_readIntBE(stream);
+    /*the low 32 bits of the mantissa only hold the fractional part for any sane sample rate.*/
+    kwlInputStream_readIntBE(stream);
+    
+    if (exponent < 0 || exponent > 30)
+    {
+        return 0;
+    }
+    return (int)(mantissa >> (31 - exponent));
+}
+
 kwlError kwlLoadAIFFFromStream(kwlInputStream* stream, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
 {
     kwlMemset(audioData, 0, sizeof(kwlAudioData));
@@ -147,8 +196,8 @@ kwlError kwlLoadAIFFFromStream(kwlInputStream* stream, kwlAudioData* audioData,
             numChannels = kwlInputStream_readShortBE(stream);
             numFrames = kwlInputStream_readIntBE(stream);
             sampleSize = kwlInputStream_readShortBE(stream);
-            /*Ignore the the sample rate for now, so skip those 10 bits.*/
-            kwlInputStream_skip(stream, chunkSize - (2 + 4 + 2));
+            audioData->sampleRate = kwlReadExtendedBEAsInt(stream);
+            kwlInputStream_skip(stream, chunkSize - (2 + 4 + 2 + 10));
             commonChunkFound = 1;
             
             int unsupportedSampleSize = sampleSize != 8 &&
@@ -177,13 +226,20 @@ kwlError kwlLoadAIFFFromStream(kwlInputStream* stream, kwlAudioData* audioData,
             unsigned int offset = kwlInputStream_readIntBE(stream);
             /*unsigned int blockSize = */kwlInputStream_readIntBE(stream);
             KWL_ASSERT(offset >= 0);
+            /*the chunk size includes the offset and block size fields and the offset bytes.*/
+            dataSizeInBytes -= 8 + offset;
+            kwlInputStream_skip(stream, offset);
             
             if (mode == KWL_CONVERT_TO_INT16_OR_FAIL)
             {
-                kwlInputStream_skip(stream, offset);
                 readSamples = KWL_MALLOC(dataSizeInBytes, "aiff audio data");
                 kwlInputStream_read(stream, (signed char*)readSamples, dataSizeInBytes);
             }
+            else
+            {
+                /*keep parsing in case the common chunk comes after the sound data.*/
+                kwlInputStream_skip(stream, dataSizeInBytes);
+            }
             
             dataChunkFound = 1;
         }
@@ -319,6 +375,7 @@ static kwlError kwlLoadWAVFromStreamWithOptionalIMA4Params(kwlInputStream* strea
     short audioFormat = 0;
     short bitsPerSample = 0;
     kwlAudioEncoding sourceEncoding = KWL_ENCODING_UNKNOWN;
+    int factNumFrames = -1;
     
     while (!fmtChunkFound || !dataChunkFound)
     {
@@ -334,6 +391,7 @@ static kwlError kwlLoadWAVFromStreamWithOptionalIMA4Params(kwlInputStream* strea
             audioFormat = kwlInputStream_readShortLE(stream);
             numChannels = kwlInputStream_readShortLE(stream);
             const int sampleRate = kwlInputStream_readIntLE(stream);
+            audioData->sampleRate = sampleRate;
             const int  byteRate = kwlInputStream_readIntLE(stream);
             nBlockAlign = kwlInputStream_readShortLE(stream);
             if (nBlockAlignOut != NULL)
@@ -459,6 +517,14 @@ static kwlError kwlLoadWAVFromStreamWithOptionalIMA4Params(kwlInputStream* strea
             kwlInputStream_skip(stream, chunkSize); //TODO: remove?
             dataChunkFound = 1;
         }
+        else if (c1 == 'f' && c2 == 'a' && c3 == 'c' && c4 =='t')
+        {
+            /*the fact chunk holds the number of frames, which block based formats need
+              since the last block may be padded.*/
+            const int chunkSize = kwlInputStream_readIntLE(stream);
+            factNumFrames = kwlInputStream_readIntLE(stream);
+            kwlInputStream_skip(stream, chunkSize - 4);
+        }
         else
         {
             //printf("skipping %c%c%c%c chunk\n", c1, c2, c3, c4);
@@ -467,6 +533,13 @@ static kwlError kwlLoadWAVFromStreamWithOptionalIMA4Params(kwlInputStream* strea
         }
     }
     
+    if (sourceEncoding == KWL_ENCODING_IMA_ADPCM &&
+        factNumFrames >= 0 &&
+        factNumFrames < audioData->numFrames)
+    {
+        audioData->numFrames = factNumFrames;
+    }
+    
     if (mode == KWL_LOAD_ENTIRE_FILE)
     {
         int fileSize = -1;
@@ -613,6 +686,7 @@ kwlError kwlLoadAUFromStream(kwlInputStream* stream, kwlAudioData* audioData, kw
     
     audioData->numFrames = numSamples / numChannels;
     audioData->numChannels = numChannels;
+    audioData->sampleRate = sampleRate;
     audioData->numBytes = numSamples * 2;
     audioData->bytes = finalSamples;
     audioData->isLoaded = mode != KWL_SKIP_AUDIO_DATA ? 1 : 0;
@@ -622,15 +696,24 @@ kwlError kwlLoadAUFromStream(kwlInputStream* stream, kwlAudioData* audioData, kw
 
 kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
 {
-    kwlMemset(audioData, 0, sizeof(kwlAudioData));
-    
     kwlInputStream stream;
     kwlInputStream_initWithFile(&stream, path);
     if (stream.file == NULL)
     {
+        kwlMemset(audioData, 0, sizeof(kwlAudioData));
         return KWL_FILE_NOT_FOUND;
     }
     
+    kwlError result = kwlLoadOggVorbisFromStream(&stream, audioData, mode);
+    kwlInputStream_close(&stream);
+    
+    return result;
+}
+
+kwlError kwlLoadOggVorbisFromStream(kwlInputStream* stream, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
+{
+    kwlMemset(audioData, 0, sizeof(kwlAudioData));
+    
     int numChannels = 0;
     float sampleRate = 0;
     int bitsPerSample = 0;
@@ -638,29 +721,28 @@ kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDat
     //read ogg header
     {
         //capture pattern (4 bytes)
-        const char cp1 = kwlInputStream_readChar(&stream);
-        const char cp2 = kwlInputStream_readChar(&stream);
-        const char cp3 = kwlInputStream_readChar(&stream);
-        const char cp4 = kwlInputStream_readChar(&stream);
+        const char cp1 = kwlInputStream_readChar(stream);
+        const char cp2 = kwlInputStream_readChar(stream);
+        const char cp3 = kwlInputStream_readChar(stream);
+        const char cp4 = kwlInputStream_readChar(stream);
         
         int isOgg = cp1 == 'O' && cp2 == 'g' && cp3 == 'g' && cp4 == 'S';
         
         if (!isOgg)
         {
-            kwlInputStream_close(&stream);
             return KWL_UNKNOWN_FILE_FORMAT;
         }
         
-        char version = kwlInputStream_readChar(&stream);
-        char headerTyper = kwlInputStream_readChar(&stream);
-        /*long granulePosition*/ kwlInputStream_readIntLE(&stream); kwlInputStream_readIntLE(&stream);
-        int serialNumber = kwlInputStream_readIntLE(&stream);
-        int pageSequenceNumber = kwlInputStream_readIntLE(&stream);
-        int checkSum = kwlInputStream_readIntLE(&stream);
-        char numPageSegments = kwlInputStream_readChar(&stream);
+        char version = kwlInputStream_readChar(stream);
+        char headerTyper = kwlInputStream_readChar(stream);
+        /*long granulePosition*/ kwlInputStream_readIntLE(stream); kwlInputStream_readIntLE(stream);
+        int serialNumber = kwlInputStream_readIntLE(stream);
+        int pageSequenceNumber = kwlInputStream_readIntLE(stream);
+        int checkSum = kwlInputStream_readIntLE(stream);
+        char numPageSegments = kwlInputStream_readChar(stream);
         for (int i = 0; i < numPageSegments; i++)
         {
-            kwlInputStream_readChar(&stream);
+            kwlInputStream_readChar(stream);
         }
         //byte[] segmentTable = new byte[numPageSegments];
         //dis.read(segmentTable);
@@ -669,32 +751,33 @@ kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDat
     //read vorbis header
     {
         //packet type should be 1 for identification header
-        const char packetType = kwlInputStream_readChar(&stream);
+        const char packetType = kwlInputStream_readChar(stream);
         
         int isVorbis =
-        kwlInputStream_readChar(&stream) == 'v' &&
-        kwlInputStream_readChar(&stream) == 'o' &&
-        kwlInputStream_readChar(&stream) == 'r' &&
-        kwlInputStream_readChar(&stream) == 'b' &&
-        kwlInputStream_readChar(&stream) == 'i' &&
-        kwlInputStream_readChar(&stream) == 's';
+        kwlInputStream_readChar(stream) == 'v' &&
+        kwlInputStream_readChar(stream) == 'o' &&
+        kwlInputStream_readChar(stream) == 'r' &&
+        kwlInputStream_readChar(stream) == 'b' &&
+        kwlInputStream_readChar(stream) == 'i' &&
+        kwlInputStream_readChar(stream) == 's';
         
         if (!isVorbis)
         {
             return KWL_UNKNOWN_FILE_FORMAT;
         }
         
-        int vorbisVersion = kwlInputStream_readIntLE(&stream);
-        numChannels = kwlInputStream_readChar(&stream);
-        sampleRate = kwlInputStream_readIntLE(&stream);
-        int maxBitRate = kwlInputStream_readIntLE(&stream);
-        int minBitRate = kwlInputStream_readIntLE(&stream);
-        int nominalBitRate = kwlInputStream_readIntLE(&stream);
+        int vorbisVersion = kwlInputStream_readIntLE(stream);
+        numChannels = kwlInputStream_readChar(stream);
+        sampleRate = kwlInputStream_readIntLE(stream);
+        int maxBitRate = kwlInputStream_readIntLE(stream);
+        int minBitRate = kwlInputStream_readIntLE(stream);
+        int nominalBitRate = kwlInputStream_readIntLE(stream);
         //etc
     }
     
     audioData->encoding = KWL_ENCODING_VORBIS;
     audioData->numChannels = numChannels;
+    audioData->sampleRate = (int)sampleRate;
     audioData->numFrames = 0;
     
     if (mode == KWL_SKIP_AUDIO_DATA)
@@ -707,12 +790,9 @@ kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDat
     }
     else if (mode == KWL_LOAD_ENTIRE_FILE)
     {
-        audioData->bytes = kwlAllocateBufferWithEntireStream(&stream, &audioData->numBytes);
+        audioData->bytes = kwlAllocateBufferWithEntireStream(stream, &audioData->numBytes);
     }
     
-    kwlInputStream_close(&stream);
-    
-    
     return KWL_NO_ERROR;
 }
 
@@ -109,6 +109,13 @@ kwlError kwlLoadAUFromStream(kwlInputStream* stream, kwlAudioData* audioData, kw
  * @param audioData A kwlAudioData struct to load the file into.
  */
 kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
+
+/**
+ * Loads vorbis data from an input stream providing OGG data.
+ * @param stream The stream to load from.
+ * @param audioData A kwlAudioData struct to load the file into.
+ */
+kwlError kwlLoadOggVorbisFromStream(kwlInputStream* stream, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
     
 /** 
  * Loads audio data from a given audio file.
@@ -116,6 +123,15 @@ kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDat
  * @param audioData A kwlAudioData struct to load the file into.
  */
 kwlError kwlLoadAudioFile(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
+
+/** 
+ * Loads audio data from the contents of an audio file already in memory. Calling this once per
+ * loading mode avoids reading the file from disk more than once.
+ * @param fileData The contents of the audio file. Not retained or freed.
+ * @param fileSize The size of \c fileData in bytes.
+ * @param audioData A kwlAudioData struct to load the file into.
+ */
+kwlError kwlLoadAudioFileFromBuffer(void* fileData, int fileSize, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
     
 short* kwlConvertBufferTo16BitSigned(char* inBuffer, 
                                      int inBufferSizeInBytes,
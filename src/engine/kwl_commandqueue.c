@@ -0,0 +1,98 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_commandqueue.h"
+#include "kwl_synchronization.h"
+
+void kwlCommandQueue_init(kwlCommandQueue* queue)
+{
+    queue->slots = (kwlCommandQueueSlot*)KWL_MALLOC(KWL_COMMAND_QUEUE_SIZE * sizeof(kwlCommandQueueSlot), "command queue");
+    
+    unsigned int i;
+    for (i = 0; i < KWL_COMMAND_QUEUE_SIZE; i++)
+    {
+        queue->slots[i].sequence = i;
+    }
+    
+    queue->numCommandsAdded = 0;
+    queue->numCommandsRemoved = 0;
+}
+
+void kwlCommandQueue_free(kwlCommandQueue* queue)
+{
+    KWL_FREE(queue->slots);
+    kwlMemset(queue, 0, sizeof(kwlCommandQueue));
+}
+
+int kwlCommandQueue_addCommand(kwlCommandQueue* queue, const kwlCommand* command)
+{
+    kwlCommandQueueSlot* slot = NULL;
+    unsigned int position = queue->numCommandsAdded;
+    
+    /*claim the slot at the current position, retrying if another producer got there first.*/
+    for (;;)
+    {
+        slot = &queue->slots[position & (KWL_COMMAND_QUEUE_SIZE - 1)];
+        const int difference = (int)(slot->sequence - position);
+        if (difference == 0)
+        {
+            if (kwlAtomicCompareAndSwap(&queue->numCommandsAdded, position, position + 1))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            /*the slot still holds a command from the previous lap, i.e the queue is full.*/
+            return 0;
+        }
+        
+        position = queue->numCommandsAdded;
+    }
+    
+    slot->command = *command;
+    
+    /*publish the command only once it has been written.*/
+    kwlMemoryBarrier();
+    slot->sequence = position + 1;
+    return 1;
+}
+
+int kwlCommandQueue_removeCommand(kwlCommandQueue* queue, kwlCommand* command)
+{
+    const unsigned int position = queue->numCommandsRemoved;
+    kwlCommandQueueSlot* slot = &queue->slots[position & (KWL_COMMAND_QUEUE_SIZE - 1)];
+    if (slot->sequence != position + 1)
+    {
+        return 0;
+    }
+    
+    kwlMemoryBarrier();
+    *command = slot->command;
+    
+    /*hand the slot back to the producers only once the command has been copied.*/
+    kwlMemoryBarrier();
+    slot->sequence = position + KWL_COMMAND_QUEUE_SIZE;
+    queue->numCommandsRemoved = position + 1;
+    return 1;
+}
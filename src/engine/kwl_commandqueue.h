@@ -0,0 +1,173 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef KWL_COMMAND_QUEUE_H
+#define KWL_COMMAND_QUEUE_H
+
+#include "kwl_memory.h"
+#include "kwl_assert.h"
+
+/*! \file */ 
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** 
+ * The number of commands that can be pending in the command queue between two
+ * engine updates. Must be a power of two.
+ */
+#define KWL_COMMAND_QUEUE_SIZE 1024
+    
+/** The maximum number of float parameters of a command. */
+#define KWL_COMMAND_MAX_NUM_PARAMS 6
+
+/**
+ * An enumeration of the types of commands that can be submitted from any thread
+ * and are executed on the engine thread at the next engine update.
+ */
+typedef enum
+{
+    /** Starts an event. */
+    KWL_COMMAND_EVENT_START = 0,
+    /** Starts an event, fading in over the time given by the first parameter. */
+    KWL_COMMAND_EVENT_START_FADE,
+    /** Stops an event. */
+    KWL_COMMAND_EVENT_STOP,
+    /** Stops an event, fading out over the time given by the first parameter. */
+    KWL_COMMAND_EVENT_STOP_FADE,
+    /** Pauses an event. */
+    KWL_COMMAND_EVENT_PAUSE,
+    /** Resumes a paused event. */
+    KWL_COMMAND_EVENT_RESUME,
+    /** Starts a one-shot event from the event definition given by the handle. */
+    KWL_COMMAND_EVENT_START_ONE_SHOT,
+    /** Starts a one-shot event at the position given by the first three parameters. */
+    KWL_COMMAND_EVENT_START_ONE_SHOT_AT,
+    /** Sets the gain of an event, in dB. */
+    KWL_COMMAND_EVENT_SET_GAIN,
+    /** Sets the linear gain of an event. */
+    KWL_COMMAND_EVENT_SET_LINEAR_GAIN,
+    /** Sets the pitch of an event. */
+    KWL_COMMAND_EVENT_SET_PITCH,
+    /** Sets the balance of an event. */
+    KWL_COMMAND_EVENT_SET_BALANCE,
+    /** Sets the position of an event. */
+    KWL_COMMAND_EVENT_SET_POSITION,
+    /** Sets the velocity of an event. */
+    KWL_COMMAND_EVENT_SET_VELOCITY,
+    /** Sets the orientation of an event. */
+    KWL_COMMAND_EVENT_SET_ORIENTATION,
+    /** Sets the gain of a mix bus, in dB. */
+    KWL_COMMAND_MIX_BUS_SET_GAIN,
+    /** Sets the linear gain of a mix bus. */
+    KWL_COMMAND_MIX_BUS_SET_LINEAR_GAIN,
+    /** Sets the pitch of a mix bus. */
+    KWL_COMMAND_MIX_BUS_SET_PITCH,
+    /** Sets the position of the listener. */
+    KWL_COMMAND_LISTENER_SET_POSITION,
+    /** Sets the velocity of the listener. */
+    KWL_COMMAND_LISTENER_SET_VELOCITY,
+    /** Sets the orientation of the listener, given as a direction followed by an up vector. */
+    KWL_COMMAND_LISTENER_SET_ORIENTATION
+    
+} kwlCommandType;
+
+/**
+ * A command in a command queue.
+ */
+typedef struct
+{
+    /** The command type.*/
+    kwlCommandType type;
+    /** The handle of the event, event definition or mix bus the command applies to, if any.*/
+    int handle;
+    /** The parameters of the command.*/
+    float params[KWL_COMMAND_MAX_NUM_PARAMS];
+} kwlCommand;
+    
+/**
+ * A slot in a command queue.
+ */
+typedef struct
+{
+    /** 
+     * Equals the position of the slot in the queue when the slot is free for a producer to claim,
+     * and that position plus one once the command of the slot has been written.
+     */
+    volatile unsigned int sequence;
+    /** The command stored in the slot.*/
+    kwlCommand command;
+} kwlCommandQueueSlot;
+
+/**
+ * A lock-free, fixed size queue of commands that any number of threads can add commands to
+ * and a single consumer thread removes commands from, in the order they were added.
+ */
+typedef struct
+{
+    /** The slots of the queue.*/
+    kwlCommandQueueSlot* slots;
+    /** The total number of commands added. Claimed by producers using compare-and-swap.*/
+    volatile unsigned int numCommandsAdded;
+    /** The total number of commands removed. Only accessed by the consumer.*/
+    unsigned int numCommandsRemoved;
+} kwlCommandQueue;
+
+/**
+ * Initializes a command queue.
+ * @param queue The queue to initialize.
+ */
+void kwlCommandQueue_init(kwlCommandQueue* queue);
+
+/**
+ * Frees the memory associated with a command queue. Any pending commands are discarded.
+ * @param queue The queue to free.
+ */
+void kwlCommandQueue_free(kwlCommandQueue* queue);
+
+/** 
+ * Adds a command to a command queue. May be called from any thread.
+ * @param queue The queue to add the command to.
+ * @param command The command to add.
+ * @return A non zero integer if the command was successfully added or zero if the queue is full.
+ */
+int kwlCommandQueue_addCommand(kwlCommandQueue* queue, const kwlCommand* command);
+
+/** 
+ * Removes the oldest command from a command queue. Must only be called from the consumer thread.
+ * Commands are removed in the order in which their producers claimed their slots, so commands 
+ * added by the same thread are removed in the order they were added.
+ * @param queue The queue to remove the command from.
+ * @param command Receives the removed command.
+ * @return A non zero integer if a command was removed or zero if there is no command 
+ * to remove, which is also the case while the oldest command is still being written.
+ */
+int kwlCommandQueue_removeCommand(kwlCommandQueue* queue, kwlCommand* command);
+    
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+        
+#endif /*KWL_COMMAND_QUEUE_H*/
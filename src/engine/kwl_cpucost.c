@@ -0,0 +1,73 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_cpucost.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__APPLE__)
+    #include <mach/mach_time.h>
+#else
+    #include <time.h>
+#endif
+
+long long kwlCPUCost_getTicks(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return ticks.QuadPart;
+#elif defined(__APPLE__)
+    return (long long)mach_absolute_time();
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (long long)time.tv_sec * 1000000000LL + time.tv_nsec;
+#endif
+}
+
+long long kwlCPUCost_getTicksPerSecond(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return frequency.QuadPart;
+#elif defined(__APPLE__)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return 1000000000LL * timebase.denom / timebase.numer;
+#else
+    return 1000000000LL;
+#endif
+}
+
+float kwlCPUCost_getLoad(long long numTicks, long long numFrames, float sampleRate)
+{
+    if (numFrames <= 0 || sampleRate <= 0.0f)
+    {
+        return 0.0f;
+    }
+    
+    const double budget = (double)numFrames / sampleRate * (double)kwlCPUCost_getTicksPerSecond();
+    return (float)(numTicks / budget);
+}
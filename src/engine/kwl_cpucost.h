@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef KWL_CPU_COST_H
+#define KWL_CPU_COST_H
+
+/*! \file */ 
+
+#include "kwl_synchronization.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** The default duration in seconds of the periods that CPU costs are measured over. */
+#define KWL_DEFAULT_CPU_PROFILING_PERIOD_SEC 0.5f
+
+/**
+ * CPU cost totals of the mixer, in clock ticks. The mixer thread accumulates
+ * the \c valueMixer fields during a measurement period and publishes them at the 
+ * end of the period.
+ */
+typedef struct kwlMixerCPUCost
+{
+    /** The time spent rendering output buffers. */
+    kwlSharedLongLong renderTicks;
+    /** The time spent in DSP unit callbacks. */
+    kwlSharedLongLong dspTicks;
+    /** The time spent refilling the buffers of streaming events. */
+    kwlSharedLongLong decoderTicks;
+    /** The number of buffer refills of streaming events. */
+    kwlSharedLongLong numDecoderRefills;
+    /** The number of frames rendered. */
+    kwlSharedLongLong numFrames;
+} kwlMixerCPUCost;
+
+/** Returns the current value of a high resolution monotonic clock. */
+long long kwlCPUCost_getTicks(void);
+
+/** Returns the number of clock ticks per second. */
+long long kwlCPUCost_getTicksPerSecond(void);
+
+/** 
+ * Converts a number of clock ticks spent rendering a number of frames to a
+ * fraction of the real time budget, i.e the duration of the frames. 
+ */
+float kwlCPUCost_getLoad(long long numTicks, long long numFrames, float sampleRate);
+
+/** 
+ * Moves the ticks accumulated by the mixer thread to the shared value, or discards them if
+ * \c publish is zero. Must be called from the mixer thread with the engine/mixer lock held.
+ */
+static inline void kwlCPUCost_publish(kwlSharedLongLong* cost, int publish)
+{
+    if (publish != 0)
+    {
+        cost->valueShared = cost->valueMixer;
+    }
+    cost->valueMixer = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_CPU_COST_H*/
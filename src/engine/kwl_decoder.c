@@ -210,7 +210,8 @@ int kwlDecoder_decodeNewBufferForEvent(kwlDecoder* decoder, kwlEventInstance* ev
 {
     if (decoder->isDecoding)
     {
-        printf("still decoding, missed buffer!\n");
+        /*keep playing the current buffer. the miss is reported through the mixer stats.*/
+        decoder->numUnderruns++;
         return 0;
     }
 
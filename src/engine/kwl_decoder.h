@@ -47,6 +47,11 @@ typedef struct kwlDecoder
     char* semaphoreName[256];
     /** */
     int isDecoding;
+    /** 
+     * The number of times a new buffer was requested before the previous one was decoded.
+     * Only accessed from the mixer thread.
+     */
+    int numUnderruns;
     /** An input stream providing the decoder with data.*/
     kwlInputStream audioDataStream;
     /** A buffer of the most recently decoded samples (interleaved, 16 bit).*/
@@ -172,8 +172,18 @@ int kwlDecodeBufferIMAADPCM(kwlDecoder* decoder)
         }
     }
     
+    /*only output the frames given by the fact chunk, dropping the padding of the last block.*/
+    int numFramesInBlock = 8 * nDataWordsPerChannel;
+    const int numFramesLeft = codecData->adpcmDataDescription.numFrames - codecData->numFramesDecoded;
+    if (numFramesInBlock > numFramesLeft)
+    {
+        numFramesInBlock = numFramesLeft > 0 ? numFramesLeft : 0;
+    }
+    codecData->numFramesDecoded += numFramesInBlock;
+    
     /* Loop if requested. */
-    int isLastBlock = codecData->currentByte >= codecData->dataSize ? 1 : 0;
+    int isLastBlock = codecData->currentByte >= codecData->dataSize ||
+                      codecData->numFramesDecoded >= codecData->adpcmDataDescription.numFrames ? 1 : 0;
     if (isLastBlock != 0 &&
         decoder->loop)
     {
@@ -197,8 +207,8 @@ int kwlDecodeBufferIMAADPCM(kwlDecoder* decoder)
         //printf("minZeroFrameIdx %d\n", minZeroFrameIdx);
     }
     
-    /*2 for 2 bytes per 16 bit output sample, 8 for 8 samples per data word.*/
-    decoder->currentDecodedBufferSizeInBytes = 2 * 8 * nDataWordsPerChannel * numChannels;
+    /*2 for 2 bytes per 16 bit output sample.*/
+    decoder->currentDecodedBufferSizeInBytes = 2 * numFramesInBlock * numChannels;
     return isLastBlock;
 }
 
@@ -206,6 +216,7 @@ int kwlRewindDecoderIMAADPCM(kwlDecoder* decoder)
 {
     kwlIMAADPCMCodecData* codecData = (kwlIMAADPCMCodecData*)decoder->codecData;
     codecData->currentByte = 0;
+    codecData->numFramesDecoded = 0;
     kwlInputStream_seek(&decoder->audioDataStream, codecData->firstDataBlockByte, SEEK_SET);
     return 1;
 }
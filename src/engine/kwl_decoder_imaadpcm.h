@@ -50,6 +50,11 @@ typedef struct kwlIMAADPCMCodecData
     int currentByte;
     /** A buffer containing the current encoded datablock. */
     unsigned char* currentDatablock;
+    /** 
+     * The number of frames output since the start of the data. Decoding stops after 
+     * \c adpcmDataDescription.numFrames frames, since the last block may be padded.
+     */
+    int numFramesDecoded;
     
 } kwlIMAADPCMCodecData;
     
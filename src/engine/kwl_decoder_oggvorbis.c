@@ -28,6 +28,106 @@ freely, subject to the following restrictions:
 
 #include "kwl_assert.h"
 
+#include <stdlib.h>
+
+/**
+ * Returns the integer value of a given comment of an ogg vorbis stream, 
+ * or -1 if the stream has no such comment.
+ */
+static ogg_int64_t kwlOggVorbisDecoder_getCommentValue(OggVorbis_File* file, const char* tag)
+{
+    vorbis_comment* comment = ov_comment(file, -1);
+    char* value = comment != NULL ? vorbis_comment_query(comment, (char*)tag, 0) : NULL;
+    return value != NULL ? strtoll(value, NULL, 10) : -1;
+}
+
+/**
+ * Sets up the looping region of a looping decoder and allocates the buffer 
+ * holding a copy of the start of it. The region spans the whole stream unless
+ * the stream has LOOPSTART and LOOPEND or LOOPLENGTH comments, given in frames. 
+ * Streams of unknown length are left to kwlRewindDecoderOggVorbis.
+ */
+static void kwlOggVorbisDecoder_initLoopRegion(kwlDecoder* decoder)
+{
+    kwlOggVorbisDecoderData* data = (kwlOggVorbisDecoderData*)decoder->codecData;
+    ogg_int64_t numFrames = ov_pcm_total(&data->oggVorbisFile, -1);
+    if (numFrames <= 0)
+    {
+        return;
+    }
+    
+    ogg_int64_t loopStart = kwlOggVorbisDecoder_getCommentValue(&data->oggVorbisFile, "LOOPSTART");
+    ogg_int64_t loopEnd = kwlOggVorbisDecoder_getCommentValue(&data->oggVorbisFile, "LOOPEND");
+    ogg_int64_t loopLength = kwlOggVorbisDecoder_getCommentValue(&data->oggVorbisFile, "LOOPLENGTH");
+    
+    if (loopStart < 0)
+    {
+        loopStart = 0;
+    }
+    if (loopEnd < 0 && loopLength > 0)
+    {
+        loopEnd = loopStart + loopLength;
+    }
+    if (loopEnd < 0 || loopEnd > numFrames)
+    {
+        loopEnd = numFrames;
+    }
+    if (loopStart >= loopEnd)
+    {
+        /*invalid loop points, loop the whole stream.*/
+        loopStart = 0;
+        loopEnd = numFrames;
+    }
+    
+    /*keep one buffer's worth of frames from the start of the region.*/
+    ogg_int64_t bufferSize = decoder->maxDecodedBufferSize / (2 * decoder->numChannels);
+    if (bufferSize > loopEnd - loopStart)
+    {
+        bufferSize = loopEnd - loopStart;
+    }
+    
+    data->loopStart = loopStart;
+    data->loopEnd = loopEnd;
+    data->loopStartBufferSize = (int)bufferSize;
+    data->loopStartBufferPosition = data->loopStartBufferSize;
+    data->loopStartBuffer = 
+        (short*)KWL_MALLOC(sizeof(short) * decoder->numChannels * data->loopStartBufferSize, 
+                           "ogg vorbis loop start buffer");
+}
+
+/**
+ * Copies any decoded frames belonging to the start of the looping region to the 
+ * loop start buffer. Called with frames starting at the current frame position.
+ */
+static void kwlOggVorbisDecoder_captureLoopStart(kwlDecoder* decoder, const short* frames, int numFrames)
+{
+    kwlOggVorbisDecoderData* data = (kwlOggVorbisDecoderData*)decoder->codecData;
+    ogg_int64_t first = data->framePosition > data->loopStart ? data->framePosition : data->loopStart;
+    ogg_int64_t last = data->framePosition + numFrames;
+    if (last > data->loopStart + data->loopStartBufferSize)
+    {
+        last = data->loopStart + data->loopStartBufferSize;
+    }
+    
+    if (first < last)
+    {
+        kwlMemcpy(&data->loopStartBuffer[(first - data->loopStart) * decoder->numChannels], 
+                  &frames[(first - data->framePosition) * decoder->numChannels], 
+                  sizeof(short) * decoder->numChannels * (size_t)(last - first));
+    }
+}
+
+/**
+ * Continues playback from the copy of the start of the looping region. If the region
+ * extends past the copy, the stream is repositioned once the copy has been played.
+ */
+static void kwlOggVorbisDecoder_wrap(kwlOggVorbisDecoderData* data)
+{
+    data->loopStartBufferPosition = 0;
+    data->framePosition = data->loopStart + data->loopStartBufferSize;
+    data->loopSeekPending = data->framePosition < data->loopEnd;
+}
+
 kwlError kwlInitDecoderOggVorbis(kwlDecoder* decoder)
 {
     /*Allocate decoder data.*/
@@ -67,7 +167,10 @@ kwlError kwlInitDecoderOggVorbis(kwlDecoder* decoder)
     
     decoder->maxDecodedBufferSize = KWL_OGG_NUM_BUFFERED_FRAMES; //TODO: really frames?
     
-    
+    if (decoder->loop != 0)
+    {
+        kwlOggVorbisDecoder_initLoopRegion(decoder);
+    }
     
     return KWL_NO_ERROR;
 }
@@ -77,6 +180,10 @@ void kwlDeinitDecoderOggVorbis(kwlDecoder* decoder)
     kwlOggVorbisDecoderData* data = (kwlOggVorbisDecoderData*)decoder->codecData;
     OggVorbis_File* file = &data->oggVorbisFile;
     ov_clear(file);
+    if (data->loopStartBuffer != NULL)
+    {
+        KWL_FREE(data->loopStartBuffer);
+    }
     KWL_FREE(decoder->codecData);
 }
 
@@ -90,19 +197,72 @@ int kwlDecodeBufferOggVorbis(kwlDecoder* decoder)
     /*TODO: sort out bytes vs frames!
      ...and fill it with new samples*/
     //printf("kwlDecodeBufferOggVorbis\n");
+    const int frameSize = 2 * decoder->numChannels;
     while (decoder->currentDecodedBufferSizeInBytes < decoder->maxDecodedBufferSize)
     {
         int currentSection;
         /*dont request more bytes than we need to fill the current output buffer.*/
         int bytesToRead = decoder->maxDecodedBufferSize - decoder->currentDecodedBufferSizeInBytes;
+        short* output = &decoder->currentDecodedBuffer[decoder->currentDecodedBufferSizeInBytes >> 1];
+        
+        if (data->loopStartBufferPosition < data->loopStartBufferSize)
+        {
+            /*just passed the loop boundary, play back the copy of the loop start.*/
+            int numFrames = data->loopStartBufferSize - data->loopStartBufferPosition;
+            if (numFrames > bytesToRead / frameSize)
+            {
+                numFrames = bytesToRead / frameSize;
+            }
+            KWL_ASSERT(numFrames > 0);
+            kwlMemcpy(output, 
+                      &data->loopStartBuffer[data->loopStartBufferPosition * decoder->numChannels], 
+                      numFrames * frameSize);
+            data->loopStartBufferPosition += numFrames;
+            decoder->currentDecodedBufferSizeInBytes += numFrames * frameSize;
+            continue;
+        }
+        
+        if (data->loopSeekPending != 0)
+        {
+            /*resume decoding after the copied frames. this happens once the wrapped 
+              buffer is filled, not at the loop boundary.*/
+            data->loopSeekPending = 0;
+            if (ov_pcm_seek(&data->oggVorbisFile, data->framePosition) != 0)
+            {
+                KWL_ASSERT(0 && "failed to seek in looping ogg vorbis stream");
+                decoder->loop = 0;
+                return 1;
+            }
+        }
+        
+        if (data->loopStartBuffer != NULL)
+        {
+            /*stop at the end of the looping region.*/
+            ogg_int64_t numFramesLeft = data->loopEnd - data->framePosition;
+            if (numFramesLeft <= 0)
+            {
+                kwlOggVorbisDecoder_wrap(data);
+                continue;
+            }
+            else if (numFramesLeft * frameSize < bytesToRead)
+            {
+                bytesToRead = (int)numFramesLeft * frameSize;
+            }
+        }
+        
         int numReadBytes = ov_read(&data->oggVorbisFile, 
-                                   (char*)(&decoder->currentDecodedBuffer[decoder->currentDecodedBufferSizeInBytes >> 1]), 
+                                   (char*)output, 
                                    bytesToRead, 
                                    &currentSection);
-        decoder->currentDecodedBufferSizeInBytes += numReadBytes;
         /*printf("decoder->currentDecodedBufferSizeInBytes %d\n", decoder->currentDecodedBufferSizeInBytes);*/
         if (numReadBytes == 0)
         {
+            if (data->loopStartBuffer != NULL)
+            {
+                /*the stream ended before the reported end of the looping region.*/
+                kwlOggVorbisDecoder_wrap(data);
+                continue;
+            }
             /*end of file reached, signal that the stream has been fully decoded.*/
             return 1;
         }
@@ -111,6 +271,13 @@ int kwlDecodeBufferOggVorbis(kwlDecoder* decoder)
             KWL_ASSERT(0 && "error reading ogg vorbis stream ");
             return 1; /*TODO: handle diffrently?*/
         }
+        
+        decoder->currentDecodedBufferSizeInBytes += numReadBytes;
+        if (data->loopStartBuffer != NULL)
+        {
+            kwlOggVorbisDecoder_captureLoopStart(decoder, output, numReadBytes / frameSize);
+        }
+        data->framePosition += numReadBytes / frameSize;
     }
     
     /*if we made it here, a new buffer was decoded without problems and without reaching the
@@ -148,9 +315,17 @@ long ovTellCallback(void *datasource)
 int kwlRewindDecoderOggVorbis(kwlDecoder* decoder)
 {
     kwlOggVorbisDecoderData* data = (kwlOggVorbisDecoderData*)decoder->codecData;
+    if (data->loopStartBuffer != NULL)
+    {
+        /*no need to seek, continue from the copy of the loop start.*/
+        kwlOggVorbisDecoder_wrap(data);
+        return 1;
+    }
+    
     int result = ov_pcm_seek(&data->oggVorbisFile, 0);
     if (result == 0)
     {
+        data->framePosition = 0;
         return 1;
     }
     else
@@ -48,6 +48,37 @@ typedef struct
 {
     /** The Ogg Vorbis file providing encoded data.*/
     OggVorbis_File oggVorbisFile;
+    /** The index of the next frame ov_read returns.*/
+    ogg_int64_t framePosition;
+    /** 
+     * The first frame of the looping region of a looping decoder. Taken from the 
+     * LOOPSTART comment of the stream if present, zero otherwise.
+     */
+    ogg_int64_t loopStart;
+    /** 
+     * The frame following the looping region of a looping decoder. Taken from the 
+     * LOOPEND or LOOPLENGTH comments of the stream if present, the length of the 
+     * stream otherwise.
+     */
+    ogg_int64_t loopEnd;
+    /** 
+     * A copy of the first decoded frames of the looping region (interleaved, 16 bit), 
+     * played back at the loop boundary so that the wrap does not wait for a seek. 
+     * Captured during the first pass through the looping region. NULL for non-looping decoders.
+     */
+    short* loopStartBuffer;
+    /** The number of frames in \c loopStartBuffer.*/
+    int loopStartBufferSize;
+    /** 
+     * The index of the next frame to play from \c loopStartBuffer. Equal to 
+     * \c loopStartBufferSize unless the loop boundary was just passed.
+     */
+    int loopStartBufferPosition;
+    /** 
+     * Non-zero if the stream has to be repositioned to the end of the frames in 
+     * \c loopStartBuffer once they have been played.
+     */
+    int loopSeekPending;
 } kwlOggVorbisDecoderData;
 
 /** 
@@ -105,6 +136,11 @@ int ovCloseCallback(void *datasource);
  */
 long ovTellCallback(void *datasource);
 
+/** 
+ * Rewinds a given ogg vorbis decoder to the start of its looping region.
+ * @param decoder The decoder to rewind.
+ * @return Non-zero on success, zero otherwise.
+ */
 int kwlRewindDecoderOggVorbis(kwlDecoder* decoder);
     
 #ifdef __cplusplus
@@ -0,0 +1,196 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_dspchain.h"
+#include "kwl_assert.h"
+
+static void kwlDSPChain_sendMessage(kwlMessageQueue* toMixerQueue, 
+                                    kwlMessageType type, 
+                                    kwlDSPChain* chain, 
+                                    kwlDSPUnit* dspUnit, 
+                                    int index)
+{
+    int result = kwlMessageQueue_addMessageWithSecondaryData(toMixerQueue, type, chain, dspUnit, (float)index);
+    KWL_ASSERT(result != 0 && "engine: outgoing message queue exhausted");
+}
+
+void kwlDSPChain_set(kwlDSPChain* chain, kwlDSPUnit* dspUnit, kwlMessageQueue* toMixerQueue)
+{
+    const int numUnits = dspUnit != NULL ? 1 : 0;
+    if (chain->numUnits_engine == numUnits && (numUnits == 0 || chain->units_engine[0] == dspUnit))
+    {
+        return;
+    }
+    
+    chain->numUnits_engine = 0;
+    kwlDSPChain_sendMessage(toMixerQueue, KWL_DSP_CHAIN_CLEAR, chain, NULL, 0);
+    if (dspUnit != NULL)
+    {
+        kwlDSPChain_append(chain, dspUnit, toMixerQueue);
+    }
+}
+
+kwlError kwlDSPChain_append(kwlDSPChain* chain, kwlDSPUnit* dspUnit, kwlMessageQueue* toMixerQueue)
+{
+    if (dspUnit == NULL)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    for (int i = 0; i < chain->numUnits_engine; i++)
+    {
+        if (chain->units_engine[i] == dspUnit)
+        {
+            return KWL_INVALID_PARAMETER_VALUE;
+        }
+    }
+    
+    if (chain->numUnits_engine == KWL_MAX_NUM_DSP_UNITS_PER_CHAIN)
+    {
+        return KWL_DSP_CHAIN_IS_FULL;
+    }
+    
+    const int index = chain->numUnits_engine;
+    chain->units_engine[index] = dspUnit;
+    chain->numUnits_engine++;
+    kwlDSPChain_sendMessage(toMixerQueue, KWL_DSP_CHAIN_INSERT, chain, dspUnit, index);
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlDSPChain_remove(kwlDSPChain* chain, kwlDSPUnit* dspUnit, kwlMessageQueue* toMixerQueue)
+{
+    for (int i = 0; i < chain->numUnits_engine; i++)
+    {
+        if (chain->units_engine[i] == dspUnit)
+        {
+            for (int j = i + 1; j < chain->numUnits_engine; j++)
+            {
+                chain->units_engine[j - 1] = chain->units_engine[j];
+            }
+            chain->numUnits_engine--;
+            kwlDSPChain_sendMessage(toMixerQueue, KWL_DSP_CHAIN_REMOVE, chain, dspUnit, i);
+            return KWL_NO_ERROR;
+        }
+    }
+    
+    return KWL_INVALID_PARAMETER_VALUE;
+}
+
+kwlError kwlDSPChain_edit(kwlDSPChain* chain, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit, kwlMessageQueue* toMixerQueue)
+{
+    switch (edit)
+    {
+        case KWL_SET_DSP_UNIT:
+            kwlDSPChain_set(chain, dspUnit, toMixerQueue);
+            return KWL_NO_ERROR;
+        case KWL_APPEND_DSP_UNIT:
+            return kwlDSPChain_append(chain, dspUnit, toMixerQueue);
+        case KWL_REMOVE_DSP_UNIT:
+            return kwlDSPChain_remove(chain, dspUnit, toMixerQueue);
+        default:
+            KWL_ASSERT(0 && "unknown DSP chain edit");
+            return KWL_INVALID_PARAMETER_VALUE;
+    }
+}
+
+void kwlDSPChain_updateEngine(kwlDSPChain* chain)
+{
+    for (int i = 0; i < chain->numUnits_engine; i++)
+    {
+        kwlDSPUnit* dspUnit = chain->units_engine[i];
+        dspUnit->tailLength.valueShared = dspUnit->tailLength.valueEngine;
+        if (dspUnit->updateDSPEngineCallback != NULL)
+        {
+            dspUnit->updateDSPEngineCallback(dspUnit->data);
+        }
+    }
+}
+
+void kwlDSPChain_updateCPUCosts(kwlDSPChain* chain)
+{
+    for (int i = 0; i < chain->numUnits_engine; i++)
+    {
+        kwlDSPUnit* dspUnit = chain->units_engine[i];
+        dspUnit->cpuTicks.valueEngine = dspUnit->cpuTicks.valueShared;
+    }
+}
+
+void kwlDSPChain_processMessage(const kwlMessage* message)
+{
+    kwlDSPChain* chain = (kwlDSPChain*)message->data;
+    const int index = (int)message->param;
+    
+    if (message->type == KWL_DSP_CHAIN_INSERT)
+    {
+        KWL_ASSERT(index >= 0 && index <= chain->numUnits_mixer && 
+                   chain->numUnits_mixer < KWL_MAX_NUM_DSP_UNITS_PER_CHAIN);
+        for (int i = chain->numUnits_mixer; i > index; i--)
+        {
+            chain->units_mixer[i] = chain->units_mixer[i - 1];
+        }
+        chain->units_mixer[index] = (kwlDSPUnit*)message->secondaryData;
+        chain->numUnits_mixer++;
+    }
+    else if (message->type == KWL_DSP_CHAIN_REMOVE)
+    {
+        KWL_ASSERT(index >= 0 && index < chain->numUnits_mixer);
+        KWL_ASSERT(chain->units_mixer[index] == message->secondaryData);
+        for (int i = index + 1; i < chain->numUnits_mixer; i++)
+        {
+            chain->units_mixer[i - 1] = chain->units_mixer[i];
+        }
+        chain->numUnits_mixer--;
+    }
+    else
+    {
+        KWL_ASSERT(message->type == KWL_DSP_CHAIN_CLEAR);
+        chain->numUnits_mixer = 0;
+    }
+}
+
+void kwlDSPChain_updateMixer(kwlDSPChain* chain)
+{
+    for (int i = 0; i < chain->numUnits_mixer; i++)
+    {
+        kwlDSPUnit* dspUnit = chain->units_mixer[i];
+        dspUnit->tailLength.valueMixer = dspUnit->tailLength.valueShared;
+        if (dspUnit->updateDSPMixerCallback != NULL)
+        {
+            dspUnit->updateDSPMixerCallback(dspUnit->data);
+        }
+    }
+}
+
+void kwlDSPChain_publishCPUCosts(kwlDSPChain* chain, int publish)
+{
+    for (int i = 0; i < chain->numUnits_mixer; i++)
+    {
+        kwlDSPUnit* dspUnit = chain->units_mixer[i];
+        /*a DSP unit may be attached to more than one chain, so only publish the ticks once.*/
+        if (dspUnit->cpuTicks.valueMixer != 0 || publish == 0)
+        {
+            kwlCPUCost_publish(&dspUnit->cpuTicks, publish);
+        }
+    }
+}
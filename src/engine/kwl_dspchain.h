@@ -0,0 +1,211 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef KWL_DSP_CHAIN_H
+#define KWL_DSP_CHAIN_H
+
+/*! \file */ 
+
+#include "kowalski.h"
+#include "kwl_cpucost.h"
+#include "kwl_dspunit.h"
+#include "kwl_messagequeue.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** The maximum number of DSP units attached to a single point in the signal chain. */
+#define KWL_MAX_NUM_DSP_UNITS_PER_CHAIN 8
+
+/**
+ * The ways a DSP chain can be edited from the API.
+ */
+typedef enum kwlDSPChainEdit
+{
+    /** Replace all units of the chain with a given unit, or none if the unit is NULL.*/
+    KWL_SET_DSP_UNIT = 0,
+    /** Add a unit to the end of the chain.*/
+    KWL_APPEND_DSP_UNIT,
+    /** Remove a unit from the chain.*/
+    KWL_REMOVE_DSP_UNIT
+} kwlDSPChainEdit;
+
+/**
+ * An ordered list of DSP units that the audio at a point in the signal chain is 
+ * processed by, in place. The engine and mixer threads have separate copies of the list.
+ * The engine thread edits its copy and sends the same edits to the mixer thread 
+ * through the message queue, so editing a chain does not require the engine/mixer lock.
+ */
+typedef struct kwlDSPChain
+{
+    //engine only
+    /** The units of the chain, as seen by the engine thread.*/
+    kwlDSPUnit* units_engine[KWL_MAX_NUM_DSP_UNITS_PER_CHAIN];
+    /** The number of units of the chain, as seen by the engine thread.*/
+    int numUnits_engine;
+    
+    //mixer only
+    /** The units of the chain, as seen by the mixer thread.*/
+    kwlDSPUnit* units_mixer[KWL_MAX_NUM_DSP_UNITS_PER_CHAIN];
+    /** The number of units of the chain, as seen by the mixer thread.*/
+    int numUnits_mixer;
+} kwlDSPChain;
+
+/** 
+ * Replaces the units of a chain with a single unit, or removes all units if \c dspUnit 
+ * is NULL. Must be called from the engine thread.
+ */
+void kwlDSPChain_set(kwlDSPChain* chain, kwlDSPUnit* dspUnit, kwlMessageQueue* toMixerQueue);
+
+/** 
+ * Adds a unit to the end of a chain. Must be called from the engine thread.
+ * @return \c KWL_DSP_CHAIN_IS_FULL if the chain has no room for another unit, 
+ * \c KWL_INVALID_PARAMETER_VALUE if the unit is NULL or already in the chain.
+ */
+kwlError kwlDSPChain_append(kwlDSPChain* chain, kwlDSPUnit* dspUnit, kwlMessageQueue* toMixerQueue);
+
+/** 
+ * Removes a unit from a chain. Must be called from the engine thread.
+ * @return \c KWL_INVALID_PARAMETER_VALUE if the unit is not in the chain.
+ */
+kwlError kwlDSPChain_remove(kwlDSPChain* chain, kwlDSPUnit* dspUnit, kwlMessageQueue* toMixerQueue);
+
+/** Edits a chain using one of the functions above. Must be called from the engine thread. */
+kwlError kwlDSPChain_edit(kwlDSPChain* chain, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit, kwlMessageQueue* toMixerQueue);
+
+/** Invokes the engine update callbacks of the units of a chain. Must be called from the engine thread. */
+void kwlDSPChain_updateEngine(kwlDSPChain* chain);
+
+/** Copies the published CPU costs of the units of a chain to the engine thread. */
+void kwlDSPChain_updateCPUCosts(kwlDSPChain* chain);
+
+/** 
+ * Applies a chain edit sent from the engine thread, i.e a message of type \c KWL_DSP_CHAIN_INSERT,
+ * \c KWL_DSP_CHAIN_REMOVE or \c KWL_DSP_CHAIN_CLEAR. Must be called from the mixer thread.
+ */
+void kwlDSPChain_processMessage(const kwlMessage* message);
+
+/** 
+ * Invokes the mixer update callbacks of the units of a chain. Must be called from the mixer 
+ * thread with the engine/mixer lock held.
+ */
+void kwlDSPChain_updateMixer(kwlDSPChain* chain);
+
+/** 
+ * Publishes or discards the CPU costs of the units of a chain. Must be called from the
+ * mixer thread with the engine/mixer lock held.
+ */
+void kwlDSPChain_publishCPUCosts(kwlDSPChain* chain, int publish);
+
+/** Returns the only unit of a chain, or NULL if the chain is empty or has more than one unit. */
+static inline kwlDSPUnit* kwlDSPChain_getSingleUnit(const kwlDSPChain* chain)
+{
+    return chain->numUnits_mixer == 1 ? chain->units_mixer[0] : NULL;
+}
+
+/**
+ * Feeds a buffer through the units of a chain in order, skipping bypassed units. 
+ * Must be called from the mixer thread.
+ */
+static inline void kwlDSPChain_process(kwlDSPChain* chain, 
+                                       float* buffer, 
+                                       int numChannels, 
+                                       int numFrames, 
+                                       kwlMixerCPUCost* cpuCost)
+{
+    for (int i = 0; i < chain->numUnits_mixer; i++)
+    {
+        kwlDSPUnit* dspUnit = chain->units_mixer[i];
+        if (dspUnit->isBypassed == 0)
+        {
+            kwlDSPUnit_process(dspUnit, buffer, numChannels, numFrames, cpuCost);
+        }
+    }
+}
+
+/**
+ * Returns non-zero if any unbypassed unit of a given chain is still ringing out, i.e if the
+ * chain may produce output from silent input. Must be called from the mixer thread.
+ */
+static inline int kwlDSPChain_isRinging(const kwlDSPChain* chain)
+{
+    for (int i = 0; i < chain->numUnits_mixer; i++)
+    {
+        const kwlDSPUnit* dspUnit = chain->units_mixer[i];
+        if (dspUnit->isBypassed == 0 && kwlDSPUnit_isRinging(dspUnit))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Like \c kwlDSPChain_process, but skips units that have rung out while their input is
+ * silent and keeps track of the tails of the units. Must be called from the mixer thread.
+ * @param chain The chain.
+ * @param buffer The buffer to process.
+ * @param numChannels The number of channels of the buffer.
+ * @param numFrames The number of frames of the buffer.
+ * @param isInputSilent Non-zero if the buffer is known to contain only zeros.
+ * @param cpuCost The CPU cost totals to update, or NULL if CPU profiling is disabled.
+ * @return Non-zero if the buffer is still known to contain only zeros.
+ */
+static inline int kwlDSPChain_processWithTails(kwlDSPChain* chain, 
+                                               float* buffer, 
+                                               int numChannels, 
+                                               int numFrames, 
+                                               int isInputSilent,
+                                               kwlMixerCPUCost* cpuCost)
+{
+    int isSilent = isInputSilent;
+    for (int i = 0; i < chain->numUnits_mixer; i++)
+    {
+        kwlDSPUnit* dspUnit = chain->units_mixer[i];
+        if (dspUnit->isBypassed != 0 || (isSilent != 0 && kwlDSPUnit_isRinging(dspUnit) == 0))
+        {
+            continue;
+        }
+        
+        if (isSilent == 0)
+        {
+            dspUnit->tailFramesLeft = dspUnit->tailLength.valueMixer;
+        }
+        else if (dspUnit->tailFramesLeft > 0)
+        {
+            dspUnit->tailFramesLeft = numFrames < dspUnit->tailFramesLeft ? dspUnit->tailFramesLeft - numFrames : 0;
+        }
+        
+        kwlDSPUnit_process(dspUnit, buffer, numChannels, numFrames, cpuCost);
+        isSilent = 0;
+    }
+    return isSilent;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_DSP_CHAIN_H*/
@@ -0,0 +1,349 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_dspconvolution.h"
+#include "kwl_asm.h"
+#include "kwl_assert.h"
+#include "kwl_memory.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Splits a range of frames of an impulse response into partitions and precomputes
+ * their spectra.
+ */
+static void kwlConvolutionSegment_init(kwlConvolutionSegment* segment,
+                                       const kwlPCMBuffer* impulseResponse,
+                                       float gain,
+                                       int firstFrame,
+                                       int numFrames,
+                                       int blockSize)
+{
+    const int fftSize = 2 * blockSize;
+    const int numChannels = impulseResponse->numChannels;
+    
+    segment->blockSize = blockSize;
+    segment->numPartitions = (numFrames + blockSize - 1) / blockSize;
+    segment->numImpulseResponseChannels = numChannels;
+    segment->latestInputSpectrum = 0;
+    kwlFFT_init(&segment->fft, fftSize);
+    
+    const int spectraSize = segment->numPartitions * fftSize;
+    segment->impulseResponseSpectra = (float*)KWL_MALLOC(numChannels * spectraSize * sizeof(float), 
+                                                         "convolution impulse response spectra");
+    segment->inputSpectra = (float*)KWL_MALLOCANDZERO(KWL_CONVOLUTION_MAX_NUM_CHANNELS * spectraSize * sizeof(float), 
+                                                      "convolution input spectra");
+    segment->inputHistory = (float*)KWL_MALLOCANDZERO(KWL_CONVOLUTION_MAX_NUM_CHANNELS * fftSize * sizeof(float), 
+                                                      "convolution input history");
+    segment->outputSpectrum = (float*)KWL_MALLOC(fftSize * sizeof(float), "convolution output spectrum");
+    segment->outputScratch = (float*)KWL_MALLOC(fftSize * sizeof(float), "convolution output scratch");
+    
+    /*zero pad the partitions to the FFT size. the scale also compensates for the unnormalized inverse FFT.*/
+    const float scale = gain / (32768.0f * fftSize);
+    float* partition = segment->outputScratch;
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        for (int p = 0; p < segment->numPartitions; p++)
+        {
+            kwlMemset(partition, 0, fftSize * sizeof(float));
+            for (int i = 0; i < blockSize && p * blockSize + i < numFrames; i++)
+            {
+                const int frame = firstFrame + p * blockSize + i;
+                partition[i] = scale * impulseResponse->pcmData[frame * numChannels + ch];
+            }
+            kwlFFT_forward(&segment->fft, partition, &segment->impulseResponseSpectra[ch * spectraSize + p * fftSize]);
+        }
+    }
+}
+
+static void kwlConvolutionSegment_free(kwlConvolutionSegment* segment)
+{
+    kwlFFT_free(&segment->fft);
+    KWL_FREE(segment->impulseResponseSpectra);
+    KWL_FREE(segment->inputSpectra);
+    KWL_FREE(segment->inputHistory);
+    KWL_FREE(segment->outputSpectrum);
+    KWL_FREE(segment->outputScratch);
+}
+
+/**
+ * Convolves one block of input frames per channel, producing one block of output frames per channel.
+ * A mono impulse response is applied to every channel.
+ */
+static void kwlConvolutionSegment_process(kwlConvolutionSegment* segment, 
+                                          const float* input, 
+                                          float* output,
+                                          int numChannels)
+{
+    const int blockSize = segment->blockSize;
+    const int fftSize = 2 * blockSize;
+    const int numPartitions = segment->numPartitions;
+    const int spectraSize = numPartitions * fftSize;
+    
+    segment->latestInputSpectrum = (segment->latestInputSpectrum + 1) % numPartitions;
+    
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        /*transform the two latest input blocks, replacing the oldest spectrum in the ring.*/
+        float* history = &segment->inputHistory[ch * fftSize];
+        memmove(history, &history[blockSize], blockSize * sizeof(float));
+        kwlMemcpy(&history[blockSize], &input[ch * blockSize], blockSize * sizeof(float));
+        
+        float* inputSpectra = &segment->inputSpectra[ch * spectraSize];
+        kwlFFT_forward(&segment->fft, history, &inputSpectra[segment->latestInputSpectrum * fftSize]);
+        
+        /*multiply the input spectra by the partition spectra, the latest input by the first partition.*/
+        const int irChannel = ch < segment->numImpulseResponseChannels ? ch : 0;
+        const float* impulseResponseSpectra = &segment->impulseResponseSpectra[irChannel * spectraSize];
+        kwlMemset(segment->outputSpectrum, 0, fftSize * sizeof(float));
+        int inputIndex = segment->latestInputSpectrum;
+        for (int p = 0; p < numPartitions; p++)
+        {
+            kwlFFT_multiplyAccumulate(&segment->fft, 
+                                      &inputSpectra[inputIndex * fftSize], 
+                                      &impulseResponseSpectra[p * fftSize], 
+                                      segment->outputSpectrum);
+            inputIndex = inputIndex == 0 ? numPartitions - 1 : inputIndex - 1;
+        }
+        
+        /*the first half of the inverse transform is circularly convolved and discarded.*/
+        kwlFFT_inverse(&segment->fft, segment->outputSpectrum, segment->outputScratch);
+        kwlMemcpy(&output[ch * blockSize], &segment->outputScratch[blockSize], blockSize * sizeof(float));
+    }
+}
+
+static void* kwlDSPConvolution_tailLoop(void* data)
+{
+    kwlDSPConvolution* convolution = (kwlDSPConvolution*)data;
+    
+    while (1)
+    {
+        kwlSemaphoreWait(convolution->jobSemaphore);
+        
+        if (convolution->threadJoinRequested != 0)
+        {
+            return NULL;
+        }
+        
+        kwlConvolutionSegment_process(&convolution->tail, 
+                                      convolution->jobInput, 
+                                      convolution->jobOutput, 
+                                      convolution->jobNumChannels);
+        kwlMemoryBarrier();
+        kwlSemaphorePost(convolution->doneSemaphore);
+    }
+    
+    return NULL;
+}
+
+/**
+ * Convolves a completed head block and, once a tail block worth of input has been collected, 
+ * hands it to the worker thread. The tail block handed over last time is collected
+ * at the same time, exactly when its output is first needed.
+ */
+static void kwlDSPConvolution_processBlock(kwlDSPConvolution* convolution, int numChannels)
+{
+    const int headBlockSize = KWL_CONVOLUTION_HEAD_BLOCK_SIZE;
+    const int tailBlockSize = KWL_CONVOLUTION_TAIL_BLOCK_SIZE;
+    
+    kwlConvolutionSegment_process(&convolution->head, convolution->headInput, convolution->headOutput, numChannels);
+    
+    if (convolution->hasBlockInput != 0)
+    {
+        convolution->numSilentFrames = 0;
+        convolution->hasBlockInput = 0;
+    }
+    else if (convolution->numSilentFrames < convolution->ringOutLength)
+    {
+        convolution->numSilentFrames += headBlockSize;
+    }
+    
+    if (convolution->hasTail == 0)
+    {
+        return;
+    }
+    
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        kwlMemcpy(&convolution->tailInput[ch * tailBlockSize + convolution->tailInputPosition],
+                  &convolution->headInput[ch * headBlockSize],
+                  headBlockSize * sizeof(float));
+    }
+    convolution->tailInputPosition += headBlockSize;
+    
+    if (convolution->tailInputPosition == tailBlockSize)
+    {
+        if (convolution->isTailJobPending != 0)
+        {
+            /*only blocks if the worker thread has fallen behind.*/
+            kwlSemaphoreWait(convolution->doneSemaphore);
+            kwlMemoryBarrier();
+            float* finishedOutput = convolution->jobOutput;
+            convolution->jobOutput = convolution->tailOutput;
+            convolution->tailOutput = finishedOutput;
+        }
+        
+        float* collectedInput = convolution->tailInput;
+        convolution->tailInput = convolution->jobInput;
+        convolution->jobInput = collectedInput;
+        convolution->jobNumChannels = numChannels;
+        convolution->isTailJobPending = 1;
+        kwlMemoryBarrier();
+        kwlSemaphorePost(convolution->jobSemaphore);
+        
+        convolution->tailInputPosition = 0;
+        convolution->tailOutputPosition = 0;
+    }
+    
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        kwlMixFloatBuffer(&convolution->tailOutput[ch * tailBlockSize + convolution->tailOutputPosition],
+                          &convolution->headOutput[ch * headBlockSize],
+                          headBlockSize);
+    }
+    convolution->tailOutputPosition += headBlockSize;
+}
+
+static void kwlDSPConvolution_process(float* buffer, int numChannels, int numFrames, void* data)
+{
+    kwlDSPConvolution* convolution = (kwlDSPConvolution*)data;
+    KWL_ASSERT(numChannels > 0 && numChannels <= KWL_CONVOLUTION_MAX_NUM_CHANNELS);
+    
+    const int headBlockSize = KWL_CONVOLUTION_HEAD_BLOCK_SIZE;
+    int frame = 0;
+    while (frame < numFrames)
+    {
+        /*swap input frames for output frames of the previous block until the current block is complete.*/
+        const int framesLeftInBlock = headBlockSize - convolution->headPosition;
+        const int numFramesToCopy = numFrames - frame < framesLeftInBlock ? numFrames - frame : framesLeftInBlock;
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            float* input = &convolution->headInput[ch * headBlockSize + convolution->headPosition];
+            const float* output = &convolution->headOutput[ch * headBlockSize + convolution->headPosition];
+            float* samples = &buffer[frame * numChannels + ch];
+            int hasInput = 0;
+            for (int i = 0; i < numFramesToCopy; i++)
+            {
+                input[i] = samples[i * numChannels];
+                hasInput |= input[i] != 0.0f;
+                samples[i * numChannels] = output[i];
+            }
+            convolution->hasBlockInput |= hasInput;
+        }
+        
+        frame += numFramesToCopy;
+        convolution->headPosition += numFramesToCopy;
+        if (convolution->headPosition == headBlockSize)
+        {
+            kwlDSPConvolution_processBlock(convolution, numChannels);
+            convolution->headPosition = 0;
+        }
+    }
+}
+
+/**
+ * A convolution rings until the last block with non-zero input has passed
+ * through the head latency, the tail latency and the impulse response.
+ */
+static int kwlDSPConvolution_isRinging(void* data)
+{
+    const kwlDSPConvolution* convolution = (const kwlDSPConvolution*)data;
+    return convolution->hasBlockInput != 0 || convolution->numSilentFrames < convolution->ringOutLength;
+}
+
+kwlDSPUnit* kwlDSPConvolution_createDSPUnit(const kwlPCMBuffer* impulseResponse, float gain)
+{
+    kwlDSPConvolution* convolution = (kwlDSPConvolution*)KWL_MALLOCANDZERO(sizeof(kwlDSPConvolution), 
+                                                                           "DSP convolution");
+    
+    const int maxNumChannels = KWL_CONVOLUTION_MAX_NUM_CHANNELS;
+    const int headLength = impulseResponse->numFrames < KWL_CONVOLUTION_HEAD_LENGTH ? 
+                           impulseResponse->numFrames : KWL_CONVOLUTION_HEAD_LENGTH;
+    kwlConvolutionSegment_init(&convolution->head, impulseResponse, gain, 0, headLength, 
+                               KWL_CONVOLUTION_HEAD_BLOCK_SIZE);
+    convolution->ringOutLength = impulseResponse->numFrames + 2 * KWL_CONVOLUTION_HEAD_BLOCK_SIZE + 
+                                 2 * KWL_CONVOLUTION_TAIL_BLOCK_SIZE;
+    convolution->numSilentFrames = convolution->ringOutLength;
+    convolution->headInput = (float*)KWL_MALLOCANDZERO(maxNumChannels * KWL_CONVOLUTION_HEAD_BLOCK_SIZE * sizeof(float), 
+                                                       "convolution head input");
+    convolution->headOutput = (float*)KWL_MALLOCANDZERO(maxNumChannels * KWL_CONVOLUTION_HEAD_BLOCK_SIZE * sizeof(float), 
+                                                        "convolution head output");
+    
+    if (impulseResponse->numFrames > KWL_CONVOLUTION_HEAD_LENGTH)
+    {
+        convolution->hasTail = 1;
+        kwlConvolutionSegment_init(&convolution->tail, impulseResponse, gain, KWL_CONVOLUTION_HEAD_LENGTH,
+                                   impulseResponse->numFrames - KWL_CONVOLUTION_HEAD_LENGTH, 
+                                   KWL_CONVOLUTION_TAIL_BLOCK_SIZE);
+        
+        const int tailBufferSize = maxNumChannels * KWL_CONVOLUTION_TAIL_BLOCK_SIZE * sizeof(float);
+        convolution->tailInput = (float*)KWL_MALLOCANDZERO(tailBufferSize, "convolution tail input");
+        convolution->tailOutput = (float*)KWL_MALLOCANDZERO(tailBufferSize, "convolution tail output");
+        convolution->jobInput = (float*)KWL_MALLOCANDZERO(tailBufferSize, "convolution job input");
+        convolution->jobOutput = (float*)KWL_MALLOCANDZERO(tailBufferSize, "convolution job output");
+        
+        /*create semaphores with unique names based on the address of the convolution.*/
+        sprintf(convolution->jobSemaphoreName, "convjob%p", (void*)convolution);
+        sprintf(convolution->doneSemaphoreName, "convdone%p", (void*)convolution);
+        convolution->jobSemaphore = kwlSemaphoreOpen(convolution->jobSemaphoreName);
+        convolution->doneSemaphore = kwlSemaphoreOpen(convolution->doneSemaphoreName);
+        
+        kwlThreadCreate(&convolution->tailThread, kwlDSPConvolution_tailLoop, convolution);
+    }
+    
+    kwlDSPUnit* dspUnit = (kwlDSPUnit*)KWL_MALLOCANDZERO(sizeof(kwlDSPUnit), "convolution DSP unit");
+    dspUnit->type = KWL_CONVOLUTION_DSP_UNIT;
+    dspUnit->data = convolution;
+    dspUnit->dspCallback = kwlDSPConvolution_process;
+    dspUnit->tailCallback = kwlDSPConvolution_isRinging;
+    convolution->dspUnit = dspUnit;
+    
+    return dspUnit;
+}
+
+void kwlDSPConvolution_free(kwlDSPConvolution* convolution)
+{
+    if (convolution->hasTail != 0)
+    {
+        convolution->threadJoinRequested = 1;
+        kwlSemaphorePost(convolution->jobSemaphore);
+        kwlThreadJoin(&convolution->tailThread);
+        
+        kwlSemaphoreDestroy(convolution->jobSemaphore, convolution->jobSemaphoreName);
+        kwlSemaphoreDestroy(convolution->doneSemaphore, convolution->doneSemaphoreName);
+        
+        kwlConvolutionSegment_free(&convolution->tail);
+        KWL_FREE(convolution->tailInput);
+        KWL_FREE(convolution->tailOutput);
+        KWL_FREE(convolution->jobInput);
+        KWL_FREE(convolution->jobOutput);
+    }
+    
+    kwlConvolutionSegment_free(&convolution->head);
+    KWL_FREE(convolution->headInput);
+    KWL_FREE(convolution->headOutput);
+    
+    KWL_FREE(convolution->dspUnit);
+    KWL_FREE(convolution);
+}
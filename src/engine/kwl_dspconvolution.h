@@ -0,0 +1,169 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef KWL_DSP_CONVOLUTION_H
+#define KWL_DSP_CONVOLUTION_H
+
+/*! \file */ 
+
+#include "kowalski.h"
+#include "kwl_dspunit.h"
+#include "kwl_fft.h"
+#include "kwl_synchronization.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** 
+ * The partition size in frames of the head of the impulse response, which is convolved 
+ * in the mixer thread. This is also the latency of the convolution.
+ */
+#define KWL_CONVOLUTION_HEAD_BLOCK_SIZE 128
+    
+/** 
+ * The partition size in frames of the tail of the impulse response, which is convolved 
+ * in a worker thread. A multiple of the head block size.
+ */
+#define KWL_CONVOLUTION_TAIL_BLOCK_SIZE 2048
+
+/** 
+ * The number of impulse response frames in the head. The tail starts late enough 
+ * for the worker thread to have one tail block worth of time to convolve each tail block.
+ */
+#define KWL_CONVOLUTION_HEAD_LENGTH (2 * KWL_CONVOLUTION_TAIL_BLOCK_SIZE - KWL_CONVOLUTION_HEAD_BLOCK_SIZE)
+    
+/** The maximum number of channels of convolved buffers and impulse responses. */
+#define KWL_CONVOLUTION_MAX_NUM_CHANNELS 2
+
+/**
+ * A part of an impulse response split into partitions of equal size and convolved 
+ * block by block using overlap-save and a frequency domain delay line.
+ * All buffers hold the channels one after the other.
+ */
+typedef struct kwlConvolutionSegment
+{
+    /** The partition size in frames. */
+    int blockSize;
+    /** The number of partitions. */
+    int numPartitions;
+    /** The number of impulse response channels. */
+    int numImpulseResponseChannels;
+    /** An FFT of twice the partition size. */
+    kwlFFT fft;
+    /** The spectra of the impulse response partitions, scaled to compensate for the unnormalized inverse FFT. */
+    float* impulseResponseSpectra;
+    /** A ring of the spectra of the most recent input blocks, one per partition. */
+    float* inputSpectra;
+    /** The index of the spectrum of the latest input block in the ring.*/
+    int latestInputSpectrum;
+    /** The two latest input blocks of each channel. */
+    float* inputHistory;
+    /** The accumulated spectrum of the output block. */
+    float* outputSpectrum;
+    /** The output block before discarding its circularly convolved first half. */
+    float* outputScratch;
+} kwlConvolutionSegment;
+
+/**
+ * A built-in convolution DSP unit. The head of the impulse response is convolved 
+ * with short partitions in the mixer thread and the tail, if any, with long partitions
+ * in a worker thread.
+ */
+typedef struct kwlDSPConvolution
+{
+    /** The head of the impulse response. */
+    kwlConvolutionSegment head;
+    /** The tail of the impulse response. Only used if \c hasTail is non-zero. */
+    kwlConvolutionSegment tail;
+    /** Non-zero if the impulse response is longer than \c KWL_CONVOLUTION_HEAD_LENGTH. */
+    int hasTail;
+    
+    //mixer only
+    /** The input of the current head block. */
+    float* headInput;
+    /** The output of the last head block, played while the current head block is collected. */
+    float* headOutput;
+    /** The number of frames collected of the current head block. */
+    int headPosition;
+    /** Non-zero if the current head block has any non-zero input. */
+    int hasBlockInput;
+    /** The number of frames of silent input since the last head block with non-zero input. */
+    int numSilentFrames;
+    /** The number of frames of silent input after which the output is silent. */
+    int ringOutLength;
+    /** The input collected for the next tail block. */
+    float* tailInput;
+    /** The number of frames collected for the next tail block. */
+    int tailInputPosition;
+    /** The output of the last finished tail block. */
+    float* tailOutput;
+    /** The number of frames of the last finished tail block played so far. */
+    int tailOutputPosition;
+    /** Non-zero if a tail block has been handed to the worker thread and not yet collected. */
+    int isTailJobPending;
+    
+    //shared between the mixer and the worker thread, handed over using the semaphores
+    /** The input of the tail block being convolved by the worker thread. */
+    float* jobInput;
+    /** The output of the tail block being convolved by the worker thread. */
+    float* jobOutput;
+    /** The number of channels of the tail block being convolved by the worker thread. */
+    int jobNumChannels;
+    /** Non-zero if the worker thread should exit. */
+    volatile int threadJoinRequested;
+    /** The worker thread. */
+    kwlThread tailThread;
+    /** Posted by the mixer thread when a tail block is ready to be convolved. */
+    kwlSemaphore* jobSemaphore;
+    /** Posted by the worker thread when a tail block has been convolved. */
+    kwlSemaphore* doneSemaphore;
+    /** The unique name of the job semaphore.*/
+    char jobSemaphoreName[64];
+    /** The unique name of the done semaphore.*/
+    char doneSemaphoreName[64];
+    
+    /** The DSP unit owning this convolution. */
+    kwlDSPUnit* dspUnit;
+    /** The next convolution created by the engine, so it can shut down the worker threads. */
+    struct kwlDSPConvolution* next;
+} kwlDSPConvolution;
+
+/** 
+ * Creates a DSP unit convolving its input with a given impulse response. 
+ * The impulse response is assumed to be valid and is copied and scaled by \c gain.
+ */
+kwlDSPUnit* kwlDSPConvolution_createDSPUnit(const kwlPCMBuffer* impulseResponse, float gain);
+
+/** 
+ * Stops the worker thread of a convolution and frees it along with its DSP unit. 
+ * Must not be called while the mixer may process the unit.
+ */
+void kwlDSPConvolution_free(kwlDSPConvolution* convolution);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_DSP_CONVOLUTION_H*/
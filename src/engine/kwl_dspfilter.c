@@ -0,0 +1,377 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_dspfilter.h"
+#include "kwl_asm.h"
+#include "kwl_assert.h"
+#include "kwl_memory.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/** The lowest cutoff frequency in Hz. */
+#define KWL_FILTER_MIN_CUTOFF 10.0f
+
+/** The highest cutoff frequency, as a fraction of the sample rate. */
+#define KWL_FILTER_MAX_RELATIVE_CUTOFF 0.45f
+
+/** Smoothed parameters closer to their targets than this are snapped to the targets. */
+#define KWL_FILTER_SMOOTHING_EPSILON 1e-3f
+
+static void kwlDSPFilter_computeCoefficients(kwlDSPFilter* filter)
+{
+    float cutoff = powf(2.0f, filter->currentLogCutoff);
+    if (cutoff < KWL_FILTER_MIN_CUTOFF)
+    {
+        cutoff = KWL_FILTER_MIN_CUTOFF;
+    }
+    else if (cutoff > KWL_FILTER_MAX_RELATIVE_CUTOFF * filter->sampleRate)
+    {
+        cutoff = KWL_FILTER_MAX_RELATIVE_CUTOFF * filter->sampleRate;
+    }
+    
+    const double w0 = 2.0 * M_PI * cutoff / filter->sampleRate;
+    const double cosW0 = cos(w0);
+    const double alpha = sin(w0) / (2.0 * filter->currentQ);
+    const double a = pow(10.0, filter->currentGainDB / 40.0);
+    const double twoSqrtAAlpha = 2.0 * sqrt(a) * alpha;
+    
+    /*first order filters, then the biquads of the audio EQ cookbook.*/
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+    switch (filter->type)
+    {
+        case KWL_ONE_POLE_LOW_PASS_FILTER:
+        {
+            const double g = 1.0 - exp(-w0);
+            b0 = g;
+            a1 = g - 1.0;
+            break;
+        }
+        case KWL_ONE_POLE_HIGH_PASS_FILTER:
+        {
+            const double k = tan(w0 / 2.0);
+            b0 = 1.0 / (1.0 + k);
+            b1 = -b0;
+            a1 = (k - 1.0) / (k + 1.0);
+            break;
+        }
+        case KWL_LOW_PASS_FILTER:
+            b0 = (1.0 - cosW0) / 2.0;
+            b1 = 1.0 - cosW0;
+            b2 = b0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha;
+            break;
+        case KWL_HIGH_PASS_FILTER:
+            b0 = (1.0 + cosW0) / 2.0;
+            b1 = -(1.0 + cosW0);
+            b2 = b0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha;
+            break;
+        case KWL_BAND_PASS_FILTER:
+            b0 = alpha;
+            b2 = -alpha;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosW0;
+            a2 = 1.0 - alpha;
+            break;
+        case KWL_LOW_SHELF_FILTER:
+            b0 = a * ((a + 1.0) - (a - 1.0) * cosW0 + twoSqrtAAlpha);
+            b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cosW0);
+            b2 = a * ((a + 1.0) - (a - 1.0) * cosW0 - twoSqrtAAlpha);
+            a0 = (a + 1.0) + (a - 1.0) * cosW0 + twoSqrtAAlpha;
+            a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cosW0);
+            a2 = (a + 1.0) + (a - 1.0) * cosW0 - twoSqrtAAlpha;
+            break;
+        case KWL_HIGH_SHELF_FILTER:
+            b0 = a * ((a + 1.0) + (a - 1.0) * cosW0 + twoSqrtAAlpha);
+            b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cosW0);
+            b2 = a * ((a + 1.0) + (a - 1.0) * cosW0 - twoSqrtAAlpha);
+            a0 = (a + 1.0) - (a - 1.0) * cosW0 + twoSqrtAAlpha;
+            a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cosW0);
+            a2 = (a + 1.0) - (a - 1.0) * cosW0 - twoSqrtAAlpha;
+            break;
+        default:
+            KWL_ASSERT(0 && "unknown filter type");
+            b0 = 1.0;
+            break;
+    }
+    
+    filter->coefficients.b0 = (float)(b0 / a0);
+    filter->coefficients.b1 = (float)(b1 / a0);
+    filter->coefficients.b2 = (float)(b2 / a0);
+    filter->coefficients.a1 = (float)(a1 / a0);
+    filter->coefficients.a2 = (float)(a2 / a0);
+}
+
+/** 
+ * Moves the smoothed parameters of a filter towards their targets by a given number of frames 
+ * and updates the coefficients accordingly.
+ */
+static void kwlDSPFilter_advanceSmoothing(kwlDSPFilter* filter, int numFrames)
+{
+    if (filter->isSmoothing == 0)
+    {
+        return;
+    }
+    
+    const float targetLogCutoff = log2f(filter->cutoff.valueMixer);
+    const float targetQ = filter->q.valueMixer;
+    const float targetGainDB = filter->gainDB.valueMixer;
+    
+    const float k = expf(-numFrames / (KWL_FILTER_SMOOTHING_TIME_SEC * filter->sampleRate));
+    filter->currentLogCutoff = targetLogCutoff + k * (filter->currentLogCutoff - targetLogCutoff);
+    filter->currentQ = targetQ + k * (filter->currentQ - targetQ);
+    filter->currentGainDB = targetGainDB + k * (filter->currentGainDB - targetGainDB);
+    
+    if (fabsf(filter->currentLogCutoff - targetLogCutoff) < KWL_FILTER_SMOOTHING_EPSILON &&
+        fabsf(filter->currentQ - targetQ) < KWL_FILTER_SMOOTHING_EPSILON &&
+        fabsf(filter->currentGainDB - targetGainDB) < KWL_FILTER_SMOOTHING_EPSILON)
+    {
+        filter->currentLogCutoff = targetLogCutoff;
+        filter->currentQ = targetQ;
+        filter->currentGainDB = targetGainDB;
+        filter->isSmoothing = 0;
+    }
+    
+    kwlDSPFilter_computeCoefficients(filter);
+}
+
+static inline float kwlDSPFilter_flushDenormal(float value)
+{
+    return fabsf(value) < KWL_FILTER_DENORMAL_THRESHOLD ? 0.0f : value;
+}
+
+void kwlDSPFilter_processLanes(kwlDSPFilterLane* lanes, int numLanes, int numFrames)
+{
+    KWL_ASSERT(numLanes > 0 && numLanes <= KWL_FILTER_NUM_LANES);
+    
+    for (int blockStart = 0; blockStart < numFrames; blockStart += KWL_FILTER_BLOCK_SIZE)
+    {
+        const int blockSize = numFrames - blockStart < KWL_FILTER_BLOCK_SIZE ? 
+                              numFrames - blockStart : KWL_FILTER_BLOCK_SIZE;
+        
+        /*advance the smoothing of each filter once, using its first channel.*/
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            if (lanes[lane].channel == 0)
+            {
+                kwlDSPFilter_advanceSmoothing(lanes[lane].filter, blockSize);
+            }
+        }
+        
+        /*gather the coefficients and states of the lanes. unused lanes filter silence.*/
+        float b0[KWL_FILTER_NUM_LANES] = {0.0f};
+        float b1[KWL_FILTER_NUM_LANES] = {0.0f};
+        float b2[KWL_FILTER_NUM_LANES] = {0.0f};
+        float a1[KWL_FILTER_NUM_LANES] = {0.0f};
+        float a2[KWL_FILTER_NUM_LANES] = {0.0f};
+        float z1[KWL_FILTER_NUM_LANES] = {0.0f};
+        float z2[KWL_FILTER_NUM_LANES] = {0.0f};
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            const kwlDSPFilter* filter = lanes[lane].filter;
+            const int ch = lanes[lane].channel;
+            b0[lane] = filter->coefficients.b0;
+            b1[lane] = filter->coefficients.b1;
+            b2[lane] = filter->coefficients.b2;
+            a1[lane] = filter->coefficients.a1;
+            a2[lane] = filter->coefficients.a2;
+            z1[lane] = filter->z1[ch];
+            z2[lane] = filter->z2[ch];
+        }
+        
+#if KWL_SSE || KWL_NEON
+        float x[KWL_FILTER_NUM_LANES] = {0.0f};
+#if KWL_SSE
+        const __m128 vb0 = _mm_loadu_ps(b0);
+        const __m128 vb1 = _mm_loadu_ps(b1);
+        const __m128 vb2 = _mm_loadu_ps(b2);
+        const __m128 va1 = _mm_loadu_ps(a1);
+        const __m128 va2 = _mm_loadu_ps(a2);
+        __m128 vz1 = _mm_loadu_ps(z1);
+        __m128 vz2 = _mm_loadu_ps(z2);
+#else
+        const float32x4_t vb0 = vld1q_f32(b0);
+        const float32x4_t vb1 = vld1q_f32(b1);
+        const float32x4_t vb2 = vld1q_f32(b2);
+        const float32x4_t va1 = vld1q_f32(a1);
+        const float32x4_t va2 = vld1q_f32(a2);
+        float32x4_t vz1 = vld1q_f32(z1);
+        float32x4_t vz2 = vld1q_f32(z2);
+#endif
+        for (int frame = blockStart; frame < blockStart + blockSize; frame++)
+        {
+            for (int lane = 0; lane < numLanes; lane++)
+            {
+                x[lane] = lanes[lane].samples[frame * lanes[lane].stride];
+            }
+#if KWL_SSE
+            const __m128 vx = _mm_loadu_ps(x);
+            const __m128 vy = _mm_add_ps(_mm_mul_ps(vb0, vx), vz1);
+            vz1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vb1, vx), _mm_mul_ps(va1, vy)), vz2);
+            vz2 = _mm_sub_ps(_mm_mul_ps(vb2, vx), _mm_mul_ps(va2, vy));
+            _mm_storeu_ps(x, vy);
+#else
+            const float32x4_t vx = vld1q_f32(x);
+            const float32x4_t vy = vmlaq_f32(vz1, vb0, vx);
+            vz1 = vaddq_f32(vmlsq_f32(vmulq_f32(vb1, vx), va1, vy), vz2);
+            vz2 = vmlsq_f32(vmulq_f32(vb2, vx), va2, vy);
+            vst1q_f32(x, vy);
+#endif
+            for (int lane = 0; lane < numLanes; lane++)
+            {
+                lanes[lane].samples[frame * lanes[lane].stride] = x[lane];
+            }
+        }
+#if KWL_SSE
+        _mm_storeu_ps(z1, vz1);
+        _mm_storeu_ps(z2, vz2);
+#else
+        vst1q_f32(z1, vz1);
+        vst1q_f32(z2, vz2);
+#endif
+#else
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            float* samples = lanes[lane].samples;
+            const int stride = lanes[lane].stride;
+            for (int frame = blockStart; frame < blockStart + blockSize; frame++)
+            {
+                const float x = samples[frame * stride];
+                const float y = b0[lane] * x + z1[lane];
+                z1[lane] = b1[lane] * x - a1[lane] * y + z2[lane];
+                z2[lane] = b2[lane] * x - a2[lane] * y;
+                samples[frame * stride] = y;
+            }
+        }
+#endif
+        
+        /*store the states, flushing decaying states to zero before they become denormal.*/
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            kwlDSPFilter* filter = lanes[lane].filter;
+            const int ch = lanes[lane].channel;
+            filter->z1[ch] = kwlDSPFilter_flushDenormal(z1[lane]);
+            filter->z2[ch] = kwlDSPFilter_flushDenormal(z2[lane]);
+        }
+    }
+}
+
+static void kwlDSPFilter_process(float* buffer, int numChannels, int numFrames, void* data)
+{
+    kwlDSPFilter* filter = (kwlDSPFilter*)data;
+    KWL_ASSERT(numChannels == 1 || numChannels == 2);
+    
+    /*process interleaved channels in parallel.*/
+    kwlDSPFilterLane lanes[2];
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        lanes[ch].filter = filter;
+        lanes[ch].channel = ch;
+        lanes[ch].samples = &buffer[ch];
+        lanes[ch].stride = numChannels;
+    }
+    
+    kwlDSPFilter_processLanes(lanes, numChannels, numFrames);
+}
+
+static void kwlDSPFilter_updateEngine(void* data)
+{
+    kwlDSPFilter* filter = (kwlDSPFilter*)data;
+    filter->cutoff.valueShared = filter->cutoff.valueEngine;
+    filter->q.valueShared = filter->q.valueEngine;
+    filter->gainDB.valueShared = filter->gainDB.valueEngine;
+}
+
+static void kwlDSPFilter_updateMixer(void* data)
+{
+    kwlDSPFilter* filter = (kwlDSPFilter*)data;
+    if (filter->cutoff.valueMixer != filter->cutoff.valueShared ||
+        filter->q.valueMixer != filter->q.valueShared ||
+        filter->gainDB.valueMixer != filter->gainDB.valueShared)
+    {
+        filter->cutoff.valueMixer = filter->cutoff.valueShared;
+        filter->q.valueMixer = filter->q.valueShared;
+        filter->gainDB.valueMixer = filter->gainDB.valueShared;
+        filter->isSmoothing = 1;
+    }
+}
+
+/**
+ * A filter rings until its state has decayed to zero, which happens in finite time 
+ * since the state is flushed to zero once it falls below the denormal range.
+ */
+static int kwlDSPFilter_isRinging(void* data)
+{
+    const kwlDSPFilter* filter = (const kwlDSPFilter*)data;
+    return filter->z1[0] != 0.0f || filter->z1[1] != 0.0f || 
+           filter->z2[0] != 0.0f || filter->z2[1] != 0.0f;
+}
+
+kwlDSPUnit* kwlDSPFilter_createDSPUnit(kwlFilterType type, float sampleRate, float cutoff, float q, float gainDB)
+{
+    kwlDSPFilter* filter = (kwlDSPFilter*)KWL_MALLOC(sizeof(kwlDSPFilter), "DSP filter");
+    kwlMemset(filter, 0, sizeof(kwlDSPFilter));
+    
+    filter->type = type;
+    filter->sampleRate = sampleRate;
+    filter->cutoff.valueEngine = filter->cutoff.valueShared = filter->cutoff.valueMixer = cutoff;
+    filter->q.valueEngine = filter->q.valueShared = filter->q.valueMixer = q;
+    filter->gainDB.valueEngine = filter->gainDB.valueShared = filter->gainDB.valueMixer = gainDB;
+    
+    /*start at the initial parameters instead of smoothing towards them.*/
+    filter->currentLogCutoff = log2f(cutoff);
+    filter->currentQ = q;
+    filter->currentGainDB = gainDB;
+    kwlDSPFilter_computeCoefficients(filter);
+    
+    kwlDSPUnit* dspUnit = (kwlDSPUnit*)KWL_MALLOC(sizeof(kwlDSPUnit), "filter DSP unit");
+    kwlMemset(dspUnit, 0, sizeof(kwlDSPUnit));
+    dspUnit->type = KWL_FILTER_DSP_UNIT;
+    dspUnit->data = filter;
+    dspUnit->dspCallback = kwlDSPFilter_process;
+    dspUnit->updateDSPEngineCallback = kwlDSPFilter_updateEngine;
+    dspUnit->updateDSPMixerCallback = kwlDSPFilter_updateMixer;
+    dspUnit->tailCallback = kwlDSPFilter_isRinging;
+    
+    return dspUnit;
+}
+
+int kwlDSPFilter_isFilter(const kwlDSPUnit* dspUnit)
+{
+    return dspUnit != NULL && dspUnit->type == KWL_FILTER_DSP_UNIT;
+}
+
+void kwlDSPFilter_setParameters(kwlDSPFilter* filter, float cutoff, float q, float gainDB)
+{
+    filter->cutoff.valueEngine = cutoff;
+    filter->q.valueEngine = q;
+    filter->gainDB.valueEngine = gainDB;
+}
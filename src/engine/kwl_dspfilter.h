@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef KWL_DSP_FILTER_H
+#define KWL_DSP_FILTER_H
+
+/*! \file */ 
+
+#include "kowalski.h"
+#include "kwl_dspunit.h"
+#include "kwl_synchronization.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** The number of filter channels processed in parallel, i.e the width of a SIMD register. */
+#define KWL_FILTER_NUM_LANES 4
+    
+/** The number of frames between recomputations of the coefficients of a filter with changing parameters. */
+#define KWL_FILTER_BLOCK_SIZE 32
+
+/** The time constant in seconds of the smoothing applied to filter parameter changes. */
+#define KWL_FILTER_SMOOTHING_TIME_SEC 0.01f
+    
+/** Filter states with smaller magnitudes than this are flushed to zero to avoid denormals. */
+#define KWL_FILTER_DENORMAL_THRESHOLD 1e-15f
+
+/** 
+ * The coefficients of a biquad filter, normalized so that a0 is 1. First order 
+ * filters are biquads with zero b2 and a2.
+ */
+typedef struct kwlFilterCoefficients
+{
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+} kwlFilterCoefficients;
+
+/**
+ * A built-in filter, processed as a transposed direct form II biquad.
+ */
+typedef struct kwlDSPFilter
+{
+    //engine -> mixer
+    /** The target cutoff or center frequency in Hz.*/
+    kwlSharedFloat cutoff;
+    /** The target Q, i.e the resonance or bandwidth.*/
+    kwlSharedFloat q;
+    /** The target gain in dB of shelving filters.*/
+    kwlSharedFloat gainDB;
+    
+    /** The filter type.*/
+    kwlFilterType type;
+    /** The sample rate in Hz.*/
+    float sampleRate;
+    
+    //mixer only
+    /** The base 2 logarithm of the smoothed cutoff frequency.*/
+    float currentLogCutoff;
+    /** The smoothed Q.*/
+    float currentQ;
+    /** The smoothed shelving gain.*/
+    float currentGainDB;
+    /** Non-zero while the smoothed parameters have not reached their targets.*/
+    int isSmoothing;
+    /** The coefficients corresponding to the smoothed parameters.*/
+    kwlFilterCoefficients coefficients;
+    /** The filter state of the left and right channels.*/
+    float z1[2];
+    /** The filter state of the left and right channels.*/
+    float z2[2];
+} kwlDSPFilter;
+
+/**
+ * A channel of a filter and the interleaved samples it processes.
+ */
+typedef struct kwlDSPFilterLane
+{
+    /** The filter.*/
+    kwlDSPFilter* filter;
+    /** The filter channel, 0 or 1.*/
+    int channel;
+    /** The first sample of the channel.*/
+    float* samples;
+    /** The distance between consecutive samples of the channel.*/
+    int stride;
+} kwlDSPFilterLane;
+
+/** 
+ * Creates a DSP unit with a built-in filter. The parameters are assumed to be valid.
+ */
+kwlDSPUnit* kwlDSPFilter_createDSPUnit(kwlFilterType type, float sampleRate, float cutoff, float q, float gainDB);
+
+/** Returns non-zero if the given DSP unit is a built-in filter, zero otherwise. */
+int kwlDSPFilter_isFilter(const kwlDSPUnit* dspUnit);
+
+/** Sets the target parameters of a filter. Must be called from the engine thread. */
+void kwlDSPFilter_setParameters(kwlDSPFilter* filter, float cutoff, float q, float gainDB);
+
+/**
+ * Processes up to \c KWL_FILTER_NUM_LANES filter channels in parallel. The lanes may 
+ * belong to different filters but each filter channel must occur at most once.
+ * Must be called from the mixer thread.
+ * @param lanes The lanes to process.
+ * @param numLanes The number of lanes, between 1 and \c KWL_FILTER_NUM_LANES.
+ * @param numFrames The number of frames to process.
+ */
+void kwlDSPFilter_processLanes(kwlDSPFilterLane* lanes, int numLanes, int numFrames);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_DSP_FILTER_H*/
@@ -27,6 +27,7 @@ freely, subject to the following restrictions:
 /*! \file */ 
 
 #include "kowalski.h"
+#include "kwl_cpucost.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -39,9 +40,21 @@ extern "C"
 typedef enum kwlDSPUnitType
 {
     /** A user defined DSP unit.*/
-    KWL_CUSTOM_DSP_UNIT = 0
+    KWL_CUSTOM_DSP_UNIT = 0,
+    /** A built-in filter. The user data is a \c kwlDSPFilter. */
+    KWL_FILTER_DSP_UNIT,
+    /** A built-in convolution. The user data is a \c kwlDSPConvolution. */
+    KWL_CONVOLUTION_DSP_UNIT
 } kwlDSPUnitType;
 
+/** The tail length of DSP units that are assumed to never ring out, i.e to be processed whenever attached. */
+#define KWL_DSP_UNIT_INFINITE_TAIL -1
+
+/**
+ * Returns non-zero while a built-in DSP unit may still produce output from earlier input.
+ */
+typedef int (*kwlDSPTailCallback)(void* data);
+
 /**
  * A DSP unit that can be attached to a point in the signal chain.
  */
@@ -72,8 +85,58 @@ typedef struct kwlDSPUnit
      * Perform as little work as possible in this callback. 
      */        
     kwlDSPUpdateCallback updateDSPEngineCallback;
+    /** The time spent in the DSP callback, in clock ticks. Only measured when CPU profiling is enabled. */
+    kwlSharedLongLong cpuTicks;
+    /** Non-zero if the DSP callback should be skipped. Only accessed from the mixer thread. */
+    char isBypassed;
+    /** 
+     * Reports whether a built-in DSP unit is still ringing out. If NULL, the unit is 
+     * assumed to ring for \c tailLength frames after its input goes silent.
+     */
+    kwlDSPTailCallback tailCallback;
+    /** The number of frames a unit without a tail callback rings out, or \c KWL_DSP_UNIT_INFINITE_TAIL. */
+    kwlSharedInt tailLength;
+    /** The number of frames left until a unit without a tail callback has rung out. Only accessed from the mixer thread. */
+    int tailFramesLeft;
     
 } kwlDSPUnit;
+
+/**
+ * Feeds a buffer through a DSP unit, measuring the time spent in the 
+ * DSP callback if \c cpuCost is not NULL.
+ */
+static inline void kwlDSPUnit_process(kwlDSPUnit* dspUnit, 
+                                      float* buffer, 
+                                      int numChannels, 
+                                      int numFrames, 
+                                      kwlMixerCPUCost* cpuCost)
+{
+    if (cpuCost == NULL)
+    {
+        (*dspUnit->dspCallback)(buffer, numChannels, numFrames, dspUnit->data);
+        return;
+    }
+    
+    const long long start = kwlCPUCost_getTicks();
+    (*dspUnit->dspCallback)(buffer, numChannels, numFrames, dspUnit->data);
+    const long long numTicks = kwlCPUCost_getTicks() - start;
+    dspUnit->cpuTicks.valueMixer += numTicks;
+    cpuCost->dspTicks.valueMixer += numTicks;
+}
+
+/**
+ * Returns non-zero if a DSP unit may produce output even if its input has been silent
+ * since it was last processed. Must be called from the mixer thread.
+ */
+static inline int kwlDSPUnit_isRinging(const kwlDSPUnit* dspUnit)
+{
+    if (dspUnit->tailCallback != NULL)
+    {
+        return (*dspUnit->tailCallback)(dspUnit->data);
+    }
+    
+    return dspUnit->tailLength.valueMixer == KWL_DSP_UNIT_INFINITE_TAIL || dspUnit->tailFramesLeft > 0;
+}
     
     
 #ifdef __cplusplus
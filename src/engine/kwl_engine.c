@@ -26,12 +26,15 @@ freely, subject to the following restrictions:
 #include "kwl_audiofileutil.h"
 #include "kwl_synchronization.h"
 #include "kwl_decoder.h"
+#include "kwl_dspconvolution.h"
+#include "kwl_dspfilter.h"
 #include "kwl_eventinstance.h"
 #include "kwl_eventdefinition.h"
 #include "kwl_memory.h"
 #include "kwl_messagequeue.h"
 #include "kwl_positionalaudiolistener.h"
 #include "kwl_mixer.h"
+#include "kwl_renderahead.h"
 #include "kwl_sounddefinition.h"
 #include "kwl_engine.h"
 #include "kwl_wavebank.h"
@@ -153,6 +156,8 @@ void kwlEngine_init(kwlEngine* engine)
     kwlMessageQueue_init(&engine->wavebankLoadingQueue);
     kwlMessageQueue_init(&engine->wavebankLoadingQueueShared);
     
+    kwlCommandQueue_init(&engine->commandQueue);
+    
     /*create the software mixer*/
     engine->mixer = kwlMixer_new();
     engine->mixer->engine = engine;
@@ -160,12 +165,10 @@ void kwlEngine_init(kwlEngine* engine)
     /*init positional audio listener and settings */
     kwlPositionalAudioListener_setDefaults(&engine->listener);
     kwlPositionalAudioSettings_setDefaults(&engine->positionalAudioSettings);
+    engine->isListenerDirty = 1;
     
-    engine->engineData.isLoaded = 0;
+    kwlMemset(&engine->engineData, 0, sizeof(kwlEngineData));
     engine->playingEventList = NULL;
-    engine->engineData.numMixBuses = 0;
-    engine->engineData.mixBuses = NULL;    
-    engine->engineData.masterBus = NULL;
     
     engine->freeformEventArraySize = 0;
     engine->freeformEvents = NULL;
@@ -181,6 +184,8 @@ void kwlEngine_init(kwlEngine* engine)
     
     //set up wavebank loading mutex
     kwlMutexLockInit(&engine->wavebankLoadingMutexLock);
+    
+    engine->randomState = KWL_DEFAULT_RANDOM_SEED;
 }
 
 void kwlEngine_free(kwlEngine* engine)
@@ -191,7 +196,29 @@ void kwlEngine_free(kwlEngine* engine)
     kwlMessageQueue_free(&engine->toMixerQueueShared);
     kwlMessageQueue_free(&engine->fromMixerQueue);
     
+    kwlCommandQueue_free(&engine->commandQueue);
+    
     KWL_FREE(engine->decoders);
+    
+    /*the host callback is shut down at this point, so the render-ahead mixing thread can be 
+      stopped without waiting for the callback to detach it. this must happen before the
+      convolutions it may be rendering are freed.*/
+    if (engine->renderAhead != NULL)
+    {
+        engine->mixer->renderAhead = NULL;
+        kwlRenderAhead_free(engine->renderAhead);
+        engine->renderAhead = NULL;
+    }
+    
+    /*the mixer is shut down at this point, so the convolution worker threads can be stopped.*/
+    kwlDSPConvolution* convolution = engine->convolutions;
+    while (convolution != NULL)
+    {
+        kwlDSPConvolution* next = convolution->next;
+        kwlDSPConvolution_free(convolution);
+        convolution = next;
+    }
+    engine->convolutions = NULL;
 }
 
 kwlError kwlEngine_loadWaveBank(kwlEngine* engine, 
@@ -339,11 +366,11 @@ kwlError kwlEngine_requestUnloadWaveBank(kwlEngine* engine, kwlWaveBankHandle ha
     
     if (blockUntilUnloaded != 0)
     {
-        //TODO: do this in a better way. this will cause a freeze if the audio thread is not running
         /*If a blocking unload was requested, wait for the wavebank to get unloaded before
          returning.*/
         while (waveBankToUnload->isLoaded != 0)
         {
+            kwlEngine_hostSpecificWaitForMixer(engine);
             kwlUpdate(0);
         }
     }
@@ -541,7 +568,7 @@ kwlError kwlEngine_eventRelease(kwlEngine* engine, kwlEventHandle handle)
         /*TODO: reset other stuff here?*/
         eventToRelease->userGain = 1.0f;
         eventToRelease->userPitch = 1.0f;
-        eventToRelease->dspUnit.valueEngine = NULL;
+        kwlDSPChain_set(&eventToRelease->dspChain, NULL, &engine->toMixerQueue);
         eventToRelease->isAssociatedWithHandle = 0;
     }
     
@@ -630,6 +657,86 @@ kwlError kwlEngine_mixBusSetPitch(kwlEngine* engine, kwlMixBusHandle handle, flo
     return KWL_NO_ERROR;
 }
 
+kwlError kwlEngine_mixBusSetMeteringEnabled(kwlEngine* engine, kwlMixBusHandle handle, int enabled)
+{
+    kwlMixBus* const mixBus = kwlEngine_getMixBusFromHandle(engine, handle);
+    if (mixBus == NULL)
+    {
+        return KWL_INVALID_MIX_BUS_HANDLE;
+    }
+    
+    mixBus->isMeteringEnabled.valueEngine = enabled != 0;
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_mixBusGetLevels(kwlEngine* engine, kwlMixBusHandle handle, int channel, float* peakLevel, float* rmsLevel)
+{
+    *peakLevel = 0.0f;
+    *rmsLevel = 0.0f;
+    
+    kwlMixBus* const mixBus = kwlEngine_getMixBusFromHandle(engine, handle);
+    if (mixBus == NULL)
+    {
+        return KWL_INVALID_MIX_BUS_HANDLE;
+    }
+    if (channel < 0 || channel > 1)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    if (mixBus->isMeteringEnabled.valueEngine == 0)
+    {
+        return KWL_LEVEL_METERING_DISABLED;
+    }
+    
+    *peakLevel = mixBus->peakLevel[channel].valueEngine;
+    *rmsLevel = mixBus->rmsLevel[channel].valueEngine;
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_mixBusSetFilterBatchingEnabled(kwlEngine* engine, kwlMixBusHandle handle, int enabled)
+{
+    kwlMixBus* const mixBus = kwlEngine_getMixBusFromHandle(engine, handle);
+    if (mixBus == NULL)
+    {
+        return KWL_INVALID_MIX_BUS_HANDLE;
+    }
+    
+    mixBus->isFilterBatchingEnabled.valueEngine = enabled != 0;
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_mixBusSetAuxSendLevel(kwlEngine* engine, 
+                                         kwlMixBusHandle handle, 
+                                         kwlMixBusHandle returnBusHandle, 
+                                         float level)
+{
+    kwlMixBus* const mixBus = kwlEngine_getMixBusFromHandle(engine, handle);
+    kwlMixBus* const returnBus = kwlEngine_getMixBusFromHandle(engine, returnBusHandle);
+    if (mixBus == NULL || returnBus == NULL)
+    {
+        return KWL_INVALID_MIX_BUS_HANDLE;
+    }
+    if (level < 0.0f)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    for (int i = 0; i < mixBus->numAuxSends; i++)
+    {
+        if (mixBus->auxSends[i].returnBus == returnBus)
+        {
+            mixBus->auxSends[i].level.valueEngine = level;
+            return KWL_NO_ERROR;
+        }
+    }
+    
+    /*sends are defined in the project data and can not be added at runtime.*/
+    return KWL_INVALID_PARAMETER_VALUE;
+}
+
 kwlError kwlEngine_mixPresetGetHandle(kwlEngine* engine, const char* const presetId, kwlMixBusHandle* handle)
 {
     int i;
@@ -666,6 +773,10 @@ kwlError kwlEngine_mixPresetSetActive(kwlEngine* engine, kwlMixPresetHandle hand
         }
     }
     
+    /*fade using the authored fade time of the new target preset*/
+    engine->engineData.mixPresetFadeTime = engine->engineData.mixPresets[handle].fadeTime;
+    engine->engineData.mixPresetBlendRequested = 1;
+    
     return KWL_NO_ERROR;
 }
 
@@ -675,6 +786,7 @@ kwlError kwlEngine_setListenerPosition(kwlEngine* engine, float posX, float posY
     engine->listener.positionX = posX;
     engine->listener.positionY = posY;
     engine->listener.positionZ = posZ;
+    engine->isListenerDirty = 1;
     return KWL_NO_ERROR;
 }
 
@@ -683,6 +795,7 @@ kwlError kwlEngine_setListenerVelocity(kwlEngine* engine, float velX, float velY
     engine->listener.velocityX = velX;
     engine->listener.velocityY = velY;
     engine->listener.velocityZ = velZ;
+    engine->isListenerDirty = 1;
     return KWL_NO_ERROR;
 }
 
@@ -711,6 +824,7 @@ kwlError kwlEngine_setListenerOrientation(kwlEngine* engine, float dirX, float d
                               engine->listener.directionX * engine->listener.upZ;
     engine->listener.rightZ = engine->listener.directionX * engine->listener.upY -
                               engine->listener.directionY * engine->listener.upX;
+    engine->isListenerDirty = 1;
     
     return KWL_NO_ERROR;    
 }
@@ -739,6 +853,7 @@ kwlError kwlEngine_setDistanceAttenuationModel(kwlEngine* engine,
     engine->positionalAudioSettings.referenceDistance = referenceDistance;
     engine->positionalAudioSettings.rolloffFactor = rolloffFactor;
     engine->positionalAudioSettings.referenceDistance = referenceDistance;
+    engine->isListenerDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -756,6 +871,7 @@ kwlError kwlEngine_setDopplerShiftParameters(kwlEngine* engine, float speedOfSou
     
     engine->positionalAudioSettings.speedOfSound = speedOfSound;
     engine->positionalAudioSettings.dopplerScale = dopplerScale;
+    engine->isListenerDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -764,6 +880,7 @@ kwlError kwlEngine_setConeAttenuationEnabled(kwlEngine* engine, int listenerCone
 {
     engine->positionalAudioSettings.isEventConeAttenuationEnabled = eventCones;
     engine->positionalAudioSettings.isListenerConeAttenuationEnabled = listenerCone;
+    engine->isListenerDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -797,6 +914,7 @@ kwlError kwlEngine_setListenerConeParameters(kwlEngine* engine,
     engine->listener.outerConeGain = outerGain;
     engine->listener.innerConeCosAngle = cosInner;
     engine->listener.outerConeCosAngle = cosOuter;
+    engine->isListenerDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -851,92 +969,86 @@ float kwlEngine_getDistanceGain(kwlEngine* engine, float distanceInv)
 
 void kwlEngine_updateMixPresets(kwlEngine* engine, float timeStepSec)
 {
-    /*TODO: read from project data?*/
-    engine->engineData.mixPresetFadeTime = 1.0f;
+    kwlEngineData* data = &engine->engineData;
+    
+    /*nothing to do unless the preset weights changed since the last blend.*/
+    if (data->mixPresetBlendRequested == 0)
+    {
+        return;
+    }
     
     /*update mix preset weights towards the target values*/
-    float dWeight = engine->engineData.mixPresetFadeTime > 0.0f ? timeStepSec / engine->engineData.mixPresetFadeTime : 1.0f;
+    const float dWeight = data->mixPresetFadeTime > 0.0f ? timeStepSec / data->mixPresetFadeTime : 1.0f;
+    int isFading = 0;
     int i;
-    for (i = 0; i < engine->engineData.numMixPresets; i++)
+    for (i = 0; i < data->numMixPresets; i++)
     {
-        kwlMixPreset* preseti = &engine->engineData.mixPresets[i];
-        //printf("updating %s to weight ", preseti->id);
+        kwlMixPreset* preseti = &data->mixPresets[i];
         
-        float delta = preseti->weight < preseti->targetWeight ? dWeight : - dWeight;
         if (preseti->weight != preseti->targetWeight)
         {
+            float delta = preseti->weight < preseti->targetWeight ? dWeight : - dWeight;
             preseti->weight += delta;
-            if (preseti->weight < 0)
+            
+            /*don't overshoot the target weight*/
+            if ((delta > 0.0f && preseti->weight > preseti->targetWeight) ||
+                (delta < 0.0f && preseti->weight < preseti->targetWeight))
             {
-                preseti->weight = 0;
+                preseti->weight = preseti->targetWeight;
             }
-            else if (preseti->weight > 1)
+            
+            if (preseti->weight != preseti->targetWeight)
             {
-                preseti->weight = 1;
+                isFading = 1;
             }
         }
-        //printf("%f by %f\n", preseti->weight, delta);
-    }
-    
-    if (0)
-    {
-        for (i = 0; i < engine->engineData.numMixPresets; i++)
-        {
-            kwlMixPreset* preseti = &engine->engineData.mixPresets[i];
-            
-            printf("%s weight %f        ", preseti->id, preseti->weight);
-        }
-        printf("\n");
     }
     
     /* Blend mix preset parameter sets.  
-       First reset all mix bus parameters...*/
-    int mixBusIndex;
-    for (mixBusIndex = 0; mixBusIndex < engine->engineData.numMixBuses; mixBusIndex++)
-    {
-        engine->engineData.mixBuses[mixBusIndex].mixPresetGainLeft = 0.0f;
-        engine->engineData.mixBuses[mixBusIndex].mixPresetGainRight = 0.0f;
-        engine->engineData.mixBuses[mixBusIndex].mixPresetPitch = 0.0f;
-    }
-    
-    /*...then accumulate the values from each mix preset.*/
-    float debugWeightSum[7] = {0, 0, 0, 0, 0, 0, 0};
+       First reset the accumulation buffers...*/
+    const int numMixBuses = data->numMixBuses;
+    float* const gainLeft = data->mixPresetBlendGainLeft;
+    float* const gainRight = data->mixPresetBlendGainRight;
+    float* const pitch = data->mixPresetBlendPitch;
+    kwlMemset(gainLeft, 0, numMixBuses * sizeof(float));
+    kwlMemset(gainRight, 0, numMixBuses * sizeof(float));
+    kwlMemset(pitch, 0, numMixBuses * sizeof(float));
+    
+    /*...then accumulate the weighted values from each contributing mix preset...*/
     int j;
-    for (j = 0; j < engine->engineData.numMixPresets; j++)
+    for (j = 0; j < data->numMixPresets; j++)
     {
-        float presetweight = engine->engineData.mixPresets[j].weight;
-        for (int paramSetIndex = 0; paramSetIndex < engine->engineData.numMixBuses; paramSetIndex++)
+        const kwlMixPreset* presetj = &data->mixPresets[j];
+        const float presetWeight = presetj->weight;
+        if (presetWeight == 0.0f)
         {
-            kwlMixBusParameters* params = &engine->engineData.mixPresets[j].parameterSets[paramSetIndex];
-            int busIndex = params->mixBusIndex;
-            KWL_ASSERT(busIndex < engine->engineData.numMixBuses && busIndex >= 0);
-            engine->engineData.mixBuses[busIndex].mixPresetGainLeft += params->logGainLeft * presetweight;
-            engine->engineData.mixBuses[busIndex].mixPresetGainRight += params->logGainRight * presetweight;
-            engine->engineData.mixBuses[busIndex].mixPresetPitch += params->pitch * presetweight;
-            debugWeightSum[busIndex] += presetweight;
+            continue;
+        }
+        
+        const float* const presetGainLeft = presetj->logGainLeft;
+        const float* const presetGainRight = presetj->logGainRight;
+        const float* const presetPitch = presetj->pitch;
+        int busIndex;
+        for (busIndex = 0; busIndex < numMixBuses; busIndex++)
+        {
+            gainLeft[busIndex] += presetGainLeft[busIndex] * presetWeight;
+            gainRight[busIndex] += presetGainRight[busIndex] * presetWeight;
+            pitch[busIndex] += presetPitch[busIndex] * presetWeight;
         }
     }
-    /*
-    printf("debug weight sums: ");
-    for (int b = 0; b < 7; b++)sfsdf
-    {
-        df
-        printf("%f, ", debugWeightSum[b]);
-    }
-    printf("\n");*/
     
-    /*Finally, convert from adjusted gain to linear gain.*/
-    for (mixBusIndex = 0; mixBusIndex < engine->engineData.numMixBuses; mixBusIndex++)
+    /*...and finally convert from adjusted gain to linear gain.*/
+    int mixBusIndex;
+    for (mixBusIndex = 0; mixBusIndex < numMixBuses; mixBusIndex++)
     {
-        engine->engineData.mixBuses[mixBusIndex].mixPresetGainLeft = 
-            logGainToLinGain(engine->engineData.mixBuses[mixBusIndex].mixPresetGainLeft);
-        engine->engineData.mixBuses[mixBusIndex].mixPresetGainRight = 
-            logGainToLinGain(engine->engineData.mixBuses[mixBusIndex].mixPresetGainRight);
-        
-        /*printf("setting gain of bus %s to %f\n", 
-               engine->mixBuses[mixBusIndex].id,
-               engine->mixBuses[mixBusIndex].mixPresetGainLeft);*/
+        kwlMixBus* bus = &data->mixBuses[mixBusIndex];
+        bus->mixPresetGainLeft = logGainToLinGain(gainLeft[mixBusIndex]);
+        bus->mixPresetGainRight = logGainToLinGain(gainRight[mixBusIndex]);
+        bus->mixPresetPitch = pitch[mixBusIndex];
     }
+    
+    /*keep blending on subsequent updates only while a fade is in progress.*/
+    data->mixPresetBlendRequested = isFading;
 }
 
 float kwlEngine_getConeGain(kwlEngine* engine, float cosAngle, float cosInner, float cosOuter, float outerGain)
@@ -962,9 +1074,12 @@ float kwlEngine_getConeGain(kwlEngine* engine, float cosAngle, float cosInner, f
     return coneGain;
 }
 
-void kwlEngine_updateEvents(kwlEngine* engine)
+/** 
+ * Recalculates the gain and pitch of an event instance from its definition, its user 
+ * parameters and, for positional events, the listener.
+ */
+static void kwlEngine_updateEventParameters(kwlEngine* engine, kwlEventInstance* event)
 {
-    /*cache some listener variables*/
     const float posXListener = engine->listener.positionX;
     const float posYListener = engine->listener.positionY;
     const float posZListener = engine->listener.positionZ;
@@ -992,134 +1107,205 @@ void kwlEngine_updateEvents(kwlEngine* engine)
     const int isDirectionalListener = engine->positionalAudioSettings.isListenerConeAttenuationEnabled &&
                                       engine->listener.outerConeGain != 1.0f; 
     
-    /*recalculate positional gain and pitch of currently playing events*/
-    kwlEventInstance* eventList = engine->playingEventList;
-    while (eventList != NULL)
-    {   
-        kwlEventDefinition* definition = eventList->definition_engine;
-        if (definition->isPositional)
+    kwlEventDefinition* definition = event->definition_engine;
+    if (definition->isPositional)
+    {
+        /*compute a a normalized vector from the listener to the event*/
+        float dx = posXListener - event->positionX;
+        float dy = posYListener - event->positionY;
+        float dz = posZListener - event->positionZ;
+        const float distInv = kwlFastInverseSqrt(dx * dx + dy * dy + dz * dz);
+        dx *= distInv;
+        dy *= distInv;
+        dz *= distInv;
+        
+        const float distanceAttenuation = kwlEngine_getDistanceGain(engine, distInv);
+        
+        /*pan. TODO: equal enery pan?*/
+        float dot = -dx * rightXListener +
+                    -dy * rightYListener +
+                    -dz * rightZListener;
+        float panLeft = 0.2f + (-dot > 0 ? -dot : 0);
+        float panRight = 0.2f + (-dot < 0 ? dot : 0);
+        
+        /*cone attenuation*/
+        int isDirectionalEvent = definition->outerConeGain != 1.0f;
+        float coneGain = 1.0f;
+        if (isDirectionalEvent && eventConesEnabled)
         {
-            /*compute a a normalized vector from the listener to the event*/
-            float dx = posXListener - eventList->positionX;
-            float dy = posYListener - eventList->positionY;
-            float dz = posZListener - eventList->positionZ;
-            const float distInv = kwlFastInverseSqrt(dx * dx + dy * dy + dz * dz);
-            dx *= distInv;
-            dy *= distInv;
-            dz *= distInv;
-            
-            const float distanceAttenuation = kwlEngine_getDistanceGain(engine, distInv);
-            
-            /*pan. TODO: equal enery pan?*/
-            float dot = -dx * rightXListener +
-                        -dy * rightYListener +
-                        -dz * rightZListener;
-            float panLeft = 0.2f + (-dot > 0 ? -dot : 0);
-            float panRight = 0.2f + (-dot < 0 ? dot : 0);
-            
-            /*cone attenuation*/
-            int isDirectionalEvent = definition->outerConeGain != 1.0f;
-            float coneGain = 1.0f;
-            if (isDirectionalEvent && eventConesEnabled)
-            {
-                const float cosInner = definition->innerConeCosAngle;
-                const float cosOuter = definition->outerConeCosAngle;
-                const float outerGain = definition->outerConeGain;
-                
-                /*There are three ange intervals to consider:
-                 - 0-inner cone angle: apply unit gain.
-                 - inner cone angle - outer cone angle: 
-                   interpolate between unit gain and outer cone gain
-                 - outer cone angle - 180: apply outer cone gain
-                 */
-                float dotProd = eventList->directionX * dx +
-                                eventList->directionY * dy +
-                                eventList->directionZ * dz;
-                
-                coneGain = kwlEngine_getConeGain(engine, dotProd, cosInner, cosOuter, outerGain);
-            }
-            
-            if (isDirectionalListener)
-            {
-                float dotProd = -dirXListener * dx +
-                                -dirYListener * dy +
-                                -dirZListener * dz;
-                
-                float listenerConeGain = 
-                                kwlEngine_getConeGain(engine, 
-                                                           dotProd, 
-                                                           cosInnerListener, 
-                                                           cosOuterListener, 
-                                                           outerGainListener);
-                coneGain *= listenerConeGain;
-            }
-            
-            /*doppler shift:
-             project velocities onto the unit vector 
-             pointing from the listener to the event*/
-            float vListener = velXListener * dx +    
-                              velYListener * dy + 
-                              velZListener * dz;
-            float vEvent = eventList->velocityX * dx +    
-            eventList->velocityY * dy + 
-            eventList->velocityZ * dz;
+            const float cosInner = definition->innerConeCosAngle;
+            const float cosOuter = definition->outerConeCosAngle;
+            const float outerGain = definition->outerConeGain;
             
-            float dopplerShift = (1 - dopplerScale) + dopplerScale * (speedOfSound - vListener) / (speedOfSound - vEvent);
-            if (dopplerShift < 0)
-            {
-                dopplerShift = 0.0001f;/*TODO: handle this properly*/
-            }
+            /*There are three ange intervals to consider:
+             - 0-inner cone angle: apply unit gain.
+             - inner cone angle - outer cone angle: 
+               interpolate between unit gain and outer cone gain
+             - outer cone angle - 180: apply outer cone gain
+             */
+            float dotProd = event->directionX * dx +
+                            event->directionY * dy +
+                            event->directionZ * dz;
             
-            float positionalGainLeft = coneGain * distanceAttenuation * panLeft;
-            float positionalGainRight = coneGain * distanceAttenuation * panRight;
-
-            eventList->gainLeft.valueEngine = 
-                eventList->definition_engine->gain * eventList->userGain * positionalGainLeft;
-            eventList->gainRight.valueEngine = 
-                eventList->definition_engine->gain * eventList->userGain * positionalGainRight;
-            eventList->pitch.valueEngine = 
-                eventList->definition_engine->pitch * eventList->userPitch * dopplerShift;
+            coneGain = kwlEngine_getConeGain(engine, dotProd, cosInner, cosOuter, outerGain);
         }
-        else 
+        
+        if (isDirectionalListener)
         {
-            float balanceGainLeft = 1 - eventList->balance;
-            float balanceGainRight = 1 + eventList->balance;
+            float dotProd = -dirXListener * dx +
+                            -dirYListener * dy +
+                            -dirZListener * dz;
             
-            eventList->gainLeft.valueEngine = 
-                eventList->definition_engine->gain * eventList->userGain * balanceGainLeft;
-            eventList->gainRight.valueEngine = 
-                eventList->definition_engine->gain * eventList->userGain * balanceGainRight;
-            eventList->pitch.valueEngine = 
-                eventList->definition_engine->pitch * eventList->userPitch;
+            float listenerConeGain = 
+                            kwlEngine_getConeGain(engine, 
+                                                       dotProd, 
+                                                       cosInnerListener, 
+                                                       cosOuterListener, 
+                                                       outerGainListener);
+            coneGain *= listenerConeGain;
+        }
+        
+        /*doppler shift:
+         project velocities onto the unit vector 
+         pointing from the listener to the event*/
+        float vListener = velXListener * dx +    
+                          velYListener * dy + 
+                          velZListener * dz;
+        float vEvent = event->velocityX * dx +    
+        event->velocityY * dy + 
+        event->velocityZ * dz;
+        
+        float dopplerShift = (1 - dopplerScale) + dopplerScale * (speedOfSound - vListener) / (speedOfSound - vEvent);
+        if (dopplerShift < 0)
+        {
+            dopplerShift = 0.0001f;/*TODO: handle this properly*/
+        }
+        
+        float positionalGainLeft = coneGain * distanceAttenuation * panLeft;
+        float positionalGainRight = coneGain * distanceAttenuation * panRight;
+
+        event->gainLeft.valueEngine = 
+            event->definition_engine->gain * event->userGain * positionalGainLeft;
+        event->gainRight.valueEngine = 
+            event->definition_engine->gain * event->userGain * positionalGainRight;
+        event->pitch.valueEngine = 
+            event->definition_engine->pitch * event->userPitch * dopplerShift;
+    }
+    else 
+    {
+        float balanceGainLeft = 1 - event->balance;
+        float balanceGainRight = 1 + event->balance;
+        
+        event->gainLeft.valueEngine = 
+            event->definition_engine->gain * event->userGain * balanceGainLeft;
+        event->gainRight.valueEngine = 
+            event->definition_engine->gain * event->userGain * balanceGainRight;
+        event->pitch.valueEngine = 
+            event->definition_engine->pitch * event->userPitch;
+    }
+}
+
+void kwlEngine_updateEvents(kwlEngine* engine)
+{
+    const int isListenerDirty = engine->isListenerDirty;
+    
+    /*recalculate positional gain and pitch of currently playing events whose inputs changed*/
+    kwlEventInstance* eventList = engine->playingEventList;
+    while (eventList != NULL)
+    {   
+        if (eventList->definition_engine->isPositional && isListenerDirty)
+        {
+            eventList->isDirty = 1;
         }
         
-        if (eventList->dspUnit.valueMixer != NULL)
+        if (eventList->isDirty != 0)
         {
-            kwlDSPUnit* dspUnit = (kwlDSPUnit*)eventList->dspUnit.valueMixer;
-            dspUnit->updateDSPEngineCallback(dspUnit->data);
+            kwlEngine_updateEventParameters(engine, eventList);
         }
         
+        kwlDSPChain_updateEngine(&eventList->dspChain);
+        
         eventList = eventList->nextEvent_engine;
     }
+    
+    engine->isListenerDirty = 0;
 }
 
 
-kwlError kwlEngine_update(kwlEngine* engine, float timeStepSec)
+/** 
+ * Copies the CPU costs published by the mixer to the engine thread, if a new
+ * measurement period has been completed. Must be called with the engine/mixer lock held.
+ */
+static void kwlEngine_updateCPUCosts(kwlEngine* engine)
 {
-    kwlEngine_updateEvents(engine);        
-    kwlEngine_updateMixPresets(engine, timeStepSec);
-        
-    kwlDSPUnit* inputDspUnit = (kwlDSPUnit*)engine->mixer->inputDSPUnit.valueEngine;
-    if (inputDspUnit != NULL && inputDspUnit->updateDSPEngineCallback != NULL)
+    kwlMixer* mixer = engine->mixer;
+    if (mixer->numCPUCostSnapshots.valueShared == mixer->numCPUCostSnapshots.valueEngine)
+    {
+        return;
+    }
+    mixer->numCPUCostSnapshots.valueEngine = mixer->numCPUCostSnapshots.valueShared;
+    
+    kwlMixerCPUCost* cpuCost = &mixer->cpuCost;
+    cpuCost->renderTicks.valueEngine = cpuCost->renderTicks.valueShared;
+    cpuCost->dspTicks.valueEngine = cpuCost->dspTicks.valueShared;
+    cpuCost->decoderTicks.valueEngine = cpuCost->decoderTicks.valueShared;
+    cpuCost->numDecoderRefills.valueEngine = cpuCost->numDecoderRefills.valueShared;
+    cpuCost->numFrames.valueEngine = cpuCost->numFrames.valueShared;
+    
+    mixer->freeformEventsBus.cpuTicks.valueEngine = mixer->freeformEventsBus.cpuTicks.valueShared;
+    for (int i = 0; i < engine->engineData.numMixBuses; i++)
+    {
+        kwlMixBus* bus = &engine->engineData.mixBuses[i];
+        bus->cpuTicks.valueEngine = bus->cpuTicks.valueShared;
+        kwlDSPChain_updateCPUCosts(&bus->dspChain);
+    }
+    
+    kwlEventInstance* event = engine->playingEventList;
+    while (event != NULL)
+    {
+        event->cpuTicks.valueEngine = event->cpuTicks.valueShared;
+        kwlDSPChain_updateCPUCosts(&event->dspChain);
+        event = event->nextEvent_engine;
+    }
+    
+    kwlDSPChain_updateCPUCosts(&mixer->inputDSPChain);
+    kwlDSPChain_updateCPUCosts(&mixer->outputDSPChain);
+}
+
+/** 
+ * Frees a render-ahead that the host callback has detached and attaches a new one 
+ * if render-ahead is enabled and none is attached.
+ */
+static void kwlEngine_updateRenderAhead(kwlEngine* engine)
+{
+    kwlRenderAhead* renderAhead = engine->renderAhead;
+    if (renderAhead != NULL && renderAhead->isDetached)
     {
-        inputDspUnit->updateDSPEngineCallback(inputDspUnit->data);
+        kwlRenderAhead_free(renderAhead);
+        renderAhead = NULL;
+        engine->renderAhead = NULL;
     }
     
-    kwlDSPUnit* outputDspUnit = (kwlDSPUnit*)engine->mixer->outputDSPUnit.valueEngine;
-    if (outputDspUnit != NULL && outputDspUnit->updateDSPEngineCallback != NULL)
+    if (renderAhead == NULL && engine->renderAheadBlockSize > 0)
     {
-        outputDspUnit->updateDSPEngineCallback(outputDspUnit->data);
+        renderAhead = kwlRenderAhead_new(engine->mixer, 
+                                         engine->renderAheadBlockSize, 
+                                         engine->renderAheadMaxNumBlocks);
+        engine->renderAhead = renderAhead;
+        /*make sure the render-ahead is fully initialized before the host callback sees it.*/
+        kwlMemoryBarrier();
+        engine->mixer->renderAhead = renderAhead;
     }
+}
+
+kwlError kwlEngine_update(kwlEngine* engine, float timeStepSec)
+{
+    kwlEngine_updateRenderAhead(engine);
+    kwlEngine_updateEvents(engine);        
+    kwlEngine_updateMixPresets(engine, timeStepSec);
+        
+    kwlDSPChain_updateEngine(&engine->mixer->inputDSPChain);
+    kwlDSPChain_updateEngine(&engine->mixer->outputDSPChain);
     
     /*************************************************************************
       The following section of code manipulates variables that are accessed from 
@@ -1135,14 +1321,17 @@ kwlError kwlEngine_update(kwlEngine* engine, float timeStepSec)
     /*copy any pending messages from the mixer*/
     kwlMessageQueue_flushTo(&engine->mixer->toEngineQueueShared, &engine->fromMixerQueue);
     
-    /*update the mixer parameters of currently playing events */
+    /*publish the mixer parameters of currently playing events that changed since the last update*/
     kwlEventInstance* eventList = engine->playingEventList;
     while (eventList != NULL)
     {
-        eventList->gainLeft.valueShared = eventList->gainLeft.valueEngine;
-        eventList->gainRight.valueShared = eventList->gainRight.valueEngine;
-        eventList->pitch.valueShared = eventList->pitch.valueEngine;
-        eventList->dspUnit.valueShared = eventList->dspUnit.valueEngine;
+        if (eventList->isDirty != 0)
+        {
+            eventList->gainLeft.valueShared = eventList->gainLeft.valueEngine;
+            eventList->gainRight.valueShared = eventList->gainRight.valueEngine;
+            eventList->pitch.valueShared = eventList->pitch.valueEngine;
+            eventList->isDirty = 0;
+        }
         
         eventList = eventList->nextEvent_engine;
     }
@@ -1155,17 +1344,24 @@ kwlError kwlEngine_update(kwlEngine* engine, float timeStepSec)
         busi->totalGainLeft.valueShared = busi->mixPresetGainLeft * busi->userGainLeft;
         busi->totalGainRight.valueShared = busi->mixPresetGainRight * busi->userGainRight;
         busi->totalPitch.valueShared = busi->mixPresetPitch * busi->userPitch;
-        busi->dspUnit.valueShared = busi->dspUnit.valueEngine;
+        busi->isMeteringEnabled.valueShared = busi->isMeteringEnabled.valueEngine;
+        busi->isFilterBatchingEnabled.valueShared = busi->isFilterBatchingEnabled.valueEngine;
+        kwlDSPChain_updateEngine(&busi->dspChain);
+        for (int j = 0; j < busi->numAuxSends; j++)
+        {
+            busi->auxSends[j].level.valueShared = busi->auxSends[j].level.valueEngine;
+        }
+        for (int ch = 0; ch < 2; ch++)
+        {
+            busi->peakLevel[ch].valueEngine = busi->peakLevel[ch].valueShared;
+            busi->rmsLevel[ch].valueEngine = busi->rmsLevel[ch].valueShared;
+        }
     }
     
-    engine->mixer->inputDSPUnit.valueShared = 
-        engine->mixer->inputDSPUnit.valueEngine; 
-    
-    engine->mixer->outputDSPUnit.valueShared = 
-        engine->mixer->outputDSPUnit.valueEngine; 
-    
     engine->mixer->isLevelMeteringEnabled.valueShared = 
         engine->mixer->isLevelMeteringEnabled.valueEngine;
+    engine->mixer->isDitherEnabled.valueShared = 
+        engine->mixer->isDitherEnabled.valueEngine;
     
     engine->mixer->latestBufferAbsPeakLeft.valueEngine = 
         engine->mixer->latestBufferAbsPeakLeft.valueShared;
@@ -1177,6 +1373,12 @@ kwlError kwlEngine_update(kwlEngine* engine, float timeStepSec)
     
     engine->mixer->numFramesMixed.valueEngine = engine->mixer->numFramesMixed.valueShared;
     
+    engine->mixer->isCPUProfilingEnabled.valueShared = 
+        engine->mixer->isCPUProfilingEnabled.valueEngine;
+    engine->mixer->cpuProfilingPeriodInFrames.valueShared = 
+        engine->mixer->cpuProfilingPeriodInFrames.valueEngine;
+    kwlEngine_updateCPUCosts(engine);
+    
     /**************************************************************************
      done manipulating shared data. release the lock
      **************************************************************************/
@@ -1253,9 +1455,30 @@ kwlError kwlEngine_pause(kwlEngine* engine)
     return KWL_NO_ERROR;
 }
 
+/** 
+ * Sends an event message to the mixer, either through the message queue that is flushed 
+ * at the next update or straight through the immediate message queue. Falls back to the
+ * regular queue if the immediate queue is full.
+ */
+static int kwlEngine_sendEventMessage(kwlEngine* engine, 
+                                      kwlMessageType type, 
+                                      kwlEventInstance* event, 
+                                      float param, 
+                                      int immediately)
+{
+    if (immediately != 0 &&
+        kwlImmediateMessageQueue_addMessageWithParam(&engine->mixer->immediateQueue, type, event, param) != 0)
+    {
+        return 1;
+    }
+    
+    return kwlMessageQueue_addMessageWithParam(&engine->toMixerQueue, type, event, param);
+}
+
 kwlError kwlEngine_startEventInstance(kwlEngine* engine, 
                                            kwlEventInstance* eventToPlay, 
-                                           float fadeInTimeSec)
+                                           float fadeInTimeSec,
+                                           int immediately)
 {
     /* If the event is not playing. */
     if (eventToPlay->isPlaying == 0)
@@ -1292,13 +1515,32 @@ kwlError kwlEngine_startEventInstance(kwlEngine* engine,
             }
         }
             
-        /*mark the event as playing and send a start message to the mixer.*/
+        /*mark the event as playing and send a start message to the mixer.
+          the mixer parameters of the event are published along with the message.
+          the event gets its own random sequence, so the choices the mixer makes for
+          it don't depend on what other events are playing.*/
+        eventToPlay->randomState = (kwlRandomNext(&engine->randomState) << 15) | kwlRandomNext(&engine->randomState);
         eventToPlay->isPlaying = 1;
+        eventToPlay->isDirty = 1;
         kwlEngine_addEventToPlayingList(engine, eventToPlay);
-        int result = kwlMessageQueue_addMessageWithParam(&engine->toMixerQueue, 
-                                                         KWL_EVENT_START, 
-                                                         eventToPlay, 
-                                                         fadeInTimeSec);
+        
+        if (immediately != 0)
+        {
+            /*the mixer will start the event before the next update publishes its parameters, 
+              so publish them now. the mixer copies them when it handles the start message,
+              but an instance that is being restarted may still be in a mixer event list
+              where kwlMixer_update reads them, so write them under the lock like 
+              kwlEngine_update does. the mixer only ever tries the lock, so this can't
+              stall the audio thread.*/
+            kwlEngine_updateEventParameters(engine, eventToPlay);
+            kwlMutexLockAcquire(&engine->mixerEngineMutexLock);
+            eventToPlay->gainLeft.valueShared = eventToPlay->gainLeft.valueEngine;
+            eventToPlay->gainRight.valueShared = eventToPlay->gainRight.valueEngine;
+            eventToPlay->pitch.valueShared = eventToPlay->pitch.valueEngine;
+            kwlMutexLockRelease(&engine->mixerEngineMutexLock);
+        }
+        
+        int result = kwlEngine_sendEventMessage(engine, KWL_EVENT_START, eventToPlay, fadeInTimeSec, immediately);
         
         if (result == 0)
         {
@@ -1314,11 +1556,9 @@ kwlError kwlEngine_startEventInstance(kwlEngine* engine,
         
         /*mark the event as playing and send a retrigger message to the mixer.*/
         eventToPlay->isPlaying = 1;
+        eventToPlay->isDirty = 1;
         //kwlEngine_addEventToPlayingList(engine, eventToPlay);
-        int result = kwlMessageQueue_addMessageWithParam(&engine->toMixerQueue, 
-                                                         KWL_EVENT_RETRIGGER, 
-                                                         eventToPlay, 
-                                                         fadeInTimeSec);
+        int result = kwlEngine_sendEventMessage(engine, KWL_EVENT_RETRIGGER, eventToPlay, fadeInTimeSec, immediately);
         
         if (result == 0)
         {
@@ -1329,7 +1569,7 @@ kwlError kwlEngine_startEventInstance(kwlEngine* engine,
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_eventStart(kwlEngine* engine, const int handle, float fadeInTimeSec)
+kwlError kwlEngine_eventStart(kwlEngine* engine, const int handle, float fadeInTimeSec, int immediately)
 {
     kwlEventInstance* eventToPlay = kwlEngine_getEventFromHandle(engine, handle);
     
@@ -1343,7 +1583,7 @@ kwlError kwlEngine_eventStart(kwlEngine* engine, const int handle, float fadeInT
         return KWL_INVALID_PARAMETER_VALUE;
     }
     
-    return kwlEngine_startEventInstance(engine, eventToPlay, fadeInTimeSec);
+    return kwlEngine_startEventInstance(engine, eventToPlay, fadeInTimeSec, immediately);
     
 }
 
@@ -1352,7 +1592,8 @@ kwlError kwlEngine_eventStartOneShot(kwlEngine* engine,
                                      float x, float y, float z,
                                      int startAtPosition,
                                      kwlEventStoppedCallack stoppedCallback,
-                                     void* stoppedCallbackUserData)
+                                     void* stoppedCallbackUserData,
+                                     int immediately)
 {
     /* Check handle*/
     if (handle == KWL_INVALID_HANDLE ||
@@ -1416,7 +1657,7 @@ kwlError kwlEngine_eventStartOneShot(kwlEngine* engine,
         else if (stealingMode == KWL_STEAL_RANDOM)
         {
             /*Steal a randomly selected instance.*/
-            int stealIndex = rand() % numStealableInstances;
+            int stealIndex = kwlRandomNext(&engine->randomState) % numStealableInstances;
             int stealableIndex = 0;
 
             for (i = 0; i < instanceCount; i++)
@@ -1477,7 +1718,7 @@ kwlError kwlEngine_eventStartOneShot(kwlEngine* engine,
     instanceToStart->stoppedCallback = stoppedCallback;
     instanceToStart->stoppedCallbackUserData = stoppedCallbackUserData;
     
-    return kwlEngine_startEventInstance(engine, instanceToStart, 0.0f);
+    return kwlEngine_startEventInstance(engine, instanceToStart, 0.0f, immediately);
 }
 
 kwlError kwlEngine_eventSetStoppedCallback(kwlEngine* engine, const int handle, 
@@ -1502,7 +1743,7 @@ kwlError kwlEngine_eventSetStoppedCallback(kwlEngine* engine, const int handle,
 }
 
 /** */
-kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutTimeSec)
+kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutTimeSec, int immediately)
 {
     kwlEventInstance* eventToStop = kwlEngine_getEventFromHandle(engine, handle);
     if (eventToStop == NULL)
@@ -1515,7 +1756,7 @@ kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutT
         return KWL_INVALID_PARAMETER_VALUE;
     }
     
-    int result = kwlMessageQueue_addMessageWithParam(&engine->toMixerQueue, KWL_EVENT_STOP, eventToStop, fadeOutTimeSec);
+    int result = kwlEngine_sendEventMessage(engine, KWL_EVENT_STOP, eventToStop, fadeOutTimeSec, immediately);
     if (result == 0)
     {
         return KWL_MESSAGE_QUEUE_FULL;
@@ -1588,6 +1829,7 @@ kwlError kwlEngine_eventSetPitch(kwlEngine* engine, kwlEventHandle eventHandle,
     }
     
     event->userPitch = pitch;
+    event->isDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -1608,6 +1850,7 @@ kwlError kwlEngine_eventSetPosition(kwlEngine* engine, kwlEventHandle handle, fl
     event->positionX = posX;
     event->positionY = posY;
     event->positionZ = posZ;
+    event->isDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -1635,6 +1878,7 @@ kwlError kwlEngine_eventSetOrientation(kwlEngine* engine, kwlEventHandle handle,
     event->directionX = directionX / length;
     event->directionY = directionY / length;
     event->directionZ = directionZ / length;
+    event->isDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -1655,6 +1899,7 @@ kwlError kwlEngine_eventSetVelocity(kwlEngine* engine, kwlEventHandle handle, fl
     event->velocityX = velX;
     event->velocityY = velY;
     event->velocityZ = velZ;
+    event->isDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -1678,6 +1923,7 @@ kwlError kwlEngine_eventSetBalance(kwlEngine* engine, kwlEventHandle handle, flo
     }
     
     event->balance = balance;
+    event->isDirty = 1;
     
     return KWL_NO_ERROR;
 }
@@ -1696,11 +1942,125 @@ kwlError kwlEngine_eventSetGain(kwlEngine* engine, kwlEventHandle eventHandle, f
     }
     
     event->userGain = isLinearGain == 1 ? gain : logGainToLinGain(gain);
+    event->isDirty = 1;
     
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_attachDSPUnitToEvent(kwlEngine* engine, kwlEventHandle eventHandle, kwlDSPUnit* dspUnit)
+/**
+ * Sets the position or the velocity of a number of positional events, 
+ * skipping invalid handles and non-positional events.
+ * @return The error of the first skipped event, if any.
+ */
+static kwlError kwlEngine_eventsSetVectors(kwlEngine* engine, 
+                                           const kwlEventHandle* handles, 
+                                           const float* x, 
+                                           const float* y, 
+                                           const float* z, 
+                                           int numEvents,
+                                           int setVelocities)
+{
+    if (numEvents < 0 ||
+        (numEvents > 0 && (handles == NULL || x == NULL || y == NULL || z == NULL)))
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    kwlError result = KWL_NO_ERROR;
+    for (int i = 0; i < numEvents; i++)
+    {
+        kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handles[i]);
+        if (event == NULL || event->definition_engine->isPositional == 0)
+        {
+            if (result == KWL_NO_ERROR)
+            {
+                result = event == NULL ? KWL_INVALID_EVENT_INSTANCE_HANDLE : KWL_EVENT_IS_NOT_POSITIONAL;
+            }
+            continue;
+        }
+        
+        if (setVelocities != 0)
+        {
+            event->velocityX = x[i];
+            event->velocityY = y[i];
+            event->velocityZ = z[i];
+        }
+        else
+        {
+            event->positionX = x[i];
+            event->positionY = y[i];
+            event->positionZ = z[i];
+        }
+        event->isDirty = 1;
+    }
+    
+    return result;
+}
+
+kwlError kwlEngine_eventsSetPositions(kwlEngine* engine, const kwlEventHandle* handles, 
+                                      const float* posX, const float* posY, const float* posZ, int numEvents)
+{
+    return kwlEngine_eventsSetVectors(engine, handles, posX, posY, posZ, numEvents, 0);
+}
+
+kwlError kwlEngine_eventsSetVelocities(kwlEngine* engine, const kwlEventHandle* handles, 
+                                       const float* velX, const float* velY, const float* velZ, int numEvents)
+{
+    return kwlEngine_eventsSetVectors(engine, handles, velX, velY, velZ, numEvents, 1);
+}
+
+kwlError kwlEngine_eventsSetGains(kwlEngine* engine, const kwlEventHandle* handles, 
+                                  const float* gains, int numEvents, int isLinearGain)
+{
+    if (numEvents < 0 ||
+        (numEvents > 0 && (handles == NULL || gains == NULL)))
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    kwlError result = KWL_NO_ERROR;
+    for (int i = 0; i < numEvents; i++)
+    {
+        kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handles[i]);
+        if (event == NULL || gains[i] < 0.0f)
+        {
+            if (result == KWL_NO_ERROR)
+            {
+                result = event == NULL ? KWL_INVALID_EVENT_INSTANCE_HANDLE : KWL_INVALID_PARAMETER_VALUE;
+            }
+            continue;
+        }
+        
+        event->userGain = isLinearGain == 1 ? gains[i] : logGainToLinGain(gains[i]);
+        event->isDirty = 1;
+    }
+    
+    return result;
+}
+
+kwlError kwlEngine_eventsStartOneShotsAt(kwlEngine* engine, const kwlEventDefinitionHandle* handles, 
+                                         const float* x, const float* y, const float* z, int numEvents)
+{
+    if (numEvents < 0 ||
+        (numEvents > 0 && (handles == NULL || x == NULL || y == NULL || z == NULL)))
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    kwlError result = KWL_NO_ERROR;
+    for (int i = 0; i < numEvents; i++)
+    {
+        kwlError startResult = kwlEngine_eventStartOneShot(engine, handles[i], x[i], y[i], z[i], 1, NULL, NULL, 0);
+        if (result == KWL_NO_ERROR)
+        {
+            result = startResult;
+        }
+    }
+    
+    return result;
+}
+
+kwlError kwlEngine_attachDSPUnitToEvent(kwlEngine* engine, kwlEventHandle eventHandle, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit)
 {
     kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, eventHandle);
     if (event == NULL)
@@ -1708,12 +2068,10 @@ kwlError kwlEngine_attachDSPUnitToEvent(kwlEngine* engine, kwlEventHandle eventH
         return KWL_INVALID_EVENT_INSTANCE_HANDLE;
     }
     
-    event->dspUnit.valueEngine = dspUnit;
-    
-    return KWL_NO_ERROR;
+    return kwlDSPChain_edit(&event->dspChain, dspUnit, edit, &engine->toMixerQueue);
 }
 
-kwlError kwlEngine_attachDSPUnitToMixBus(kwlEngine* engine, kwlMixBusHandle mixBusHandle, kwlDSPUnit* dspUnit)
+kwlError kwlEngine_attachDSPUnitToMixBus(kwlEngine* engine, kwlMixBusHandle mixBusHandle, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit)
 {
     kwlMixBus* bus = kwlEngine_getMixBusFromHandle(engine, mixBusHandle);
     if (bus == NULL)
@@ -1721,23 +2079,34 @@ kwlError kwlEngine_attachDSPUnitToMixBus(kwlEngine* engine, kwlMixBusHandle mixB
         return KWL_INVALID_MIX_BUS_HANDLE;
     }
     
-    bus->dspUnit.valueEngine = dspUnit;
-    
-    return KWL_NO_ERROR;
+    return kwlDSPChain_edit(&bus->dspChain, dspUnit, edit, &engine->toMixerQueue);
 }
 
-kwlError kwlEngine_attachDSPUnitToInput(kwlEngine* engine, kwlDSPUnit* dspUnit)
+kwlError kwlEngine_attachDSPUnitToInput(kwlEngine* engine, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit)
 {
-    engine->mixer->inputDSPUnit.valueEngine = dspUnit;
-    return KWL_NO_ERROR;
+    return kwlDSPChain_edit(&engine->mixer->inputDSPChain, dspUnit, edit, &engine->toMixerQueue);
 }
 
-kwlError kwlEngine_attachDSPUnitToOutput(kwlEngine* engine, kwlDSPUnit* dspUnit)
+kwlError kwlEngine_attachDSPUnitToOutput(kwlEngine* engine, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit)
 {
-    engine->mixer->outputDSPUnit.valueEngine = dspUnit;
-    return KWL_NO_ERROR;
+    return kwlDSPChain_edit(&engine->mixer->outputDSPChain, dspUnit, edit, &engine->toMixerQueue);
 }
 
+kwlError kwlEngine_dspUnitSetBypassed(kwlEngine* engine, kwlDSPUnit* dspUnit, int bypassed)
+{
+    if (dspUnit == NULL)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    int result = kwlMessageQueue_addMessageWithParam(&engine->toMixerQueue, 
+                                                     KWL_DSP_UNIT_SET_BYPASSED, 
+                                                     dspUnit, 
+                                                     bypassed != 0 ? 1.0f : 0.0f);
+    KWL_ASSERT(result != 0 && "engine: outgoing message queue exhausted");
+    
+    return KWL_NO_ERROR;
+}
 
 void debugPrintEventList(kwlEventInstance* event)
 {
@@ -1860,8 +2229,25 @@ void kwlEngine_removeEventFromPlayingList(kwlEngine* engine, kwlEventInstance* e
 
 kwlError kwlEngine_loadEngineData(kwlEngine* engine, kwlInputStream* stream)
 {
-    return kwlEngineData_load(&engine->engineData, stream);
-
+    kwlError result = kwlEngineData_load(&engine->engineData, stream);
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
+    
+    /*allocate the send buffers of the aux return buses, now that the number of output channels is known.*/
+    for (int i = 0; i < engine->engineData.numMixBuses; i++)
+    {
+        kwlMixBus* bus = &engine->engineData.mixBuses[i];
+        if (bus->isAuxReturn != 0)
+        {
+            bus->auxReturnBuffer = 
+                (float*)KWL_MALLOCANDZERO(sizeof(float) * KWL_TEMP_BUFFER_SIZE_IN_FRAMES * engine->mixer->numOutChannels,
+                                          "aux return buffer");
+        }
+    }
+    
+    return KWL_NO_ERROR;
 }
 
 /** */
@@ -1876,6 +2262,9 @@ kwlError kwlEngine_initialize(kwlEngine* engine,
     engine->mixer->numOutChannels = numOutChannels;
     engine->mixer->numInChannels = numInChannels;
     engine->isInputEnabled = numInChannels > 0 ? 1 : 0;
+    engine->bufferSize = bufferSize;
+    engine->mixer->cpuProfilingPeriodInFrames.valueEngine = 
+        (int)(KWL_DEFAULT_CPU_PROFILING_PERIOD_SEC * sampleRate);
     
     kwlMixer_allocateTempBuffers(engine->mixer);
     
@@ -1925,7 +2314,7 @@ kwlError kwlEngine_engineDataLoad(kwlEngine* engine, const char* const dataFile)
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_unloadEngineDataBlocking(kwlEngine* engine)
+kwlError kwlEngine_engineDataUnload(kwlEngine* engine)
 {
     if (engine->engineData.isLoaded == 0)
     {
@@ -1939,12 +2328,27 @@ kwlError kwlEngine_unloadEngineDataBlocking(kwlEngine* engine)
       that triggers the actual unloading.*/
     int result = kwlMessageQueue_addMessage(&engine->toMixerQueue, KWL_PREPARE_ENGINE_DATA_UNLOAD, NULL);
     //printf("posted KWL_PREPARE_ENGINE_DATA_UNLOAD\n");
-    KWL_ASSERT(result != 0);
+    if (result == 0)
+    {
+        return KWL_MESSAGE_QUEUE_FULL;
+    }
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_unloadEngineDataBlocking(kwlEngine* engine)
+{
+    kwlError result = kwlEngine_engineDataUnload(engine);
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
     
     /*Block until the engine data has been unloaded.*/
     while (engine->engineData.isLoaded != 0)
     {
         /*printf("waiting for mixer to stop data driven events and clear mix buses\n");*/
+        kwlEngine_hostSpecificWaitForMixer(engine);
         kwlUpdate(0);
     }
     
@@ -1988,6 +2392,196 @@ kwlError kwlEngine_hasClipped(kwlEngine* engine, int* hasClipped)
     return KWL_NO_ERROR;
 }
 
+kwlError kwlEngine_setCPUProfilingEnabled(kwlEngine* engine, int enabled, float periodSec)
+{
+    if (periodSec < 0.0f)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    kwlMixer* mixer = engine->mixer;
+    if (periodSec == 0.0f)
+    {
+        periodSec = KWL_DEFAULT_CPU_PROFILING_PERIOD_SEC;
+    }
+    int periodInFrames = (int)(periodSec * mixer->sampleRate);
+    mixer->cpuProfilingPeriodInFrames.valueEngine = periodInFrames > 0 ? periodInFrames : 1;
+    mixer->isCPUProfilingEnabled.valueEngine = enabled != 0;
+    
+    return KWL_NO_ERROR;
+}
+
+/** Returns the load of a number of clock ticks spent during the last CPU cost measurement period.*/
+static float kwlEngine_getCPULoad(kwlEngine* engine, long long numTicks)
+{
+    kwlMixer* mixer = engine->mixer;
+    return kwlCPUCost_getLoad(numTicks, mixer->cpuCost.numFrames.valueEngine, mixer->sampleRate);
+}
+
+kwlError kwlEngine_getCPUCostSnapshot(kwlEngine* engine, kwlCPUCostSnapshot* snapshot)
+{
+    kwlMemset(snapshot, 0, sizeof(kwlCPUCostSnapshot));
+    
+    kwlMixer* mixer = engine->mixer;
+    if (mixer->isCPUProfilingEnabled.valueEngine == 0)
+    {
+        return KWL_CPU_PROFILING_DISABLED;
+    }
+    
+    const kwlMixerCPUCost* cpuCost = &mixer->cpuCost;
+    snapshot->index = mixer->numCPUCostSnapshots.valueEngine;
+    snapshot->duration = cpuCost->numFrames.valueEngine / mixer->sampleRate;
+    snapshot->mixerLoad = kwlEngine_getCPULoad(engine, cpuCost->renderTicks.valueEngine);
+    snapshot->freeformEventsLoad = kwlEngine_getCPULoad(engine, mixer->freeformEventsBus.cpuTicks.valueEngine);
+    snapshot->dspLoad = kwlEngine_getCPULoad(engine, cpuCost->dspTicks.valueEngine);
+    snapshot->decoderLoad = kwlEngine_getCPULoad(engine, cpuCost->decoderTicks.valueEngine);
+    snapshot->numDecoderRefills = (int)cpuCost->numDecoderRefills.valueEngine;
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_mixBusGetCPULoad(kwlEngine* engine, kwlMixBusHandle handle, float* load)
+{
+    *load = 0.0f;
+    
+    kwlMixBus* mixBus = kwlEngine_getMixBusFromHandle(engine, handle);
+    if (mixBus == NULL)
+    {
+        return KWL_INVALID_MIX_BUS_HANDLE;
+    }
+    if (engine->mixer->isCPUProfilingEnabled.valueEngine == 0)
+    {
+        return KWL_CPU_PROFILING_DISABLED;
+    }
+    
+    *load = kwlEngine_getCPULoad(engine, mixBus->cpuTicks.valueEngine);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_eventGetCPULoad(kwlEngine* engine, kwlEventHandle handle, float* load)
+{
+    *load = 0.0f;
+    
+    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
+    if (event == NULL)
+    {
+        return KWL_INVALID_EVENT_INSTANCE_HANDLE;
+    }
+    if (engine->mixer->isCPUProfilingEnabled.valueEngine == 0)
+    {
+        return KWL_CPU_PROFILING_DISABLED;
+    }
+    
+    /*the costs of events are only updated while they are playing.*/
+    if (event->isPlaying != 0)
+    {
+        *load = kwlEngine_getCPULoad(engine, event->cpuTicks.valueEngine);
+    }
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_dspUnitGetCPULoad(kwlEngine* engine, kwlDSPUnit* dspUnit, float* load)
+{
+    *load = 0.0f;
+    
+    if (dspUnit == NULL)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    if (engine->mixer->isCPUProfilingEnabled.valueEngine == 0)
+    {
+        return KWL_CPU_PROFILING_DISABLED;
+    }
+    
+    *load = kwlEngine_getCPULoad(engine, dspUnit->cpuTicks.valueEngine);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_createFilterDSPUnit(kwlEngine* engine, kwlFilterType type, float cutoff, float q, float gainDB, kwlDSPUnit** dspUnit)
+{
+    *dspUnit = NULL;
+    
+    if (type < KWL_ONE_POLE_LOW_PASS_FILTER || type > KWL_HIGH_SHELF_FILTER ||
+        !(cutoff > 0.0f) || !(q > 0.0f))
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    *dspUnit = kwlDSPFilter_createDSPUnit(type, engine->mixer->sampleRate, cutoff, q, gainDB);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_dspUnitSetFilterParameters(kwlEngine* engine, kwlDSPUnit* dspUnit, float cutoff, float q, float gainDB)
+{
+    if (kwlDSPFilter_isFilter(dspUnit) == 0 || !(cutoff > 0.0f) || !(q > 0.0f))
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    kwlDSPFilter_setParameters((kwlDSPFilter*)dspUnit->data, cutoff, q, gainDB);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_createConvolutionDSPUnit(kwlEngine* engine, const kwlPCMBuffer* impulseResponse, float gain, kwlDSPUnit** dspUnit)
+{
+    *dspUnit = NULL;
+    
+    if (impulseResponse == NULL || impulseResponse->pcmData == NULL || impulseResponse->numFrames <= 0 ||
+        impulseResponse->numChannels < 1 || impulseResponse->numChannels > KWL_CONVOLUTION_MAX_NUM_CHANNELS)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    *dspUnit = kwlDSPConvolution_createDSPUnit(impulseResponse, gain);
+    kwlDSPConvolution* convolution = (kwlDSPConvolution*)(*dspUnit)->data;
+    convolution->next = engine->convolutions;
+    engine->convolutions = convolution;
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_dspUnitSetTailLength(kwlEngine* engine, kwlDSPUnit* dspUnit, float seconds)
+{
+    /*built-in units report their tails themselves.*/
+    if (dspUnit == NULL || dspUnit->type != KWL_CUSTOM_DSP_UNIT)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    dspUnit->tailLength.valueEngine = seconds < 0.0f ? KWL_DSP_UNIT_INFINITE_TAIL :
+                                      (int)(seconds * engine->mixer->sampleRate + 0.5f);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_setRenderAhead(kwlEngine* engine, int enabled, int blockSize, int maxNumBlocksAhead)
+{
+    if (enabled == 0)
+    {
+        blockSize = 0;
+        maxNumBlocksAhead = 0;
+    }
+    else if (blockSize < 1 || blockSize > KWL_TEMP_BUFFER_SIZE_IN_FRAMES ||
+             maxNumBlocksAhead < 1 || maxNumBlocksAhead > KWL_RENDER_AHEAD_MAX_NUM_BLOCKS)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    engine->renderAheadBlockSize = blockSize;
+    engine->renderAheadMaxNumBlocks = maxNumBlocksAhead;
+    
+    /*a render-ahead with the wrong configuration keeps playing until the host callback 
+      detaches it. kwlEngine_update then replaces it.*/
+    kwlRenderAhead* renderAhead = engine->renderAhead;
+    if (renderAhead != NULL && 
+        (renderAhead->blockSize != blockSize || renderAhead->maxNumBlocksAhead != maxNumBlocksAhead))
+    {
+        kwlRenderAhead_requestStop(renderAhead);
+    }
+    
+    kwlEngine_updateRenderAhead(engine);
+    
+    return KWL_NO_ERROR;
+}
+
 kwlError kwlEngine_getOutLevels(kwlEngine* engine, float* leftLevel, float* rightLevel)
 {    
     if (engine->mixer->isLevelMeteringEnabled.valueEngine == 0)  
@@ -27,6 +27,7 @@ freely, subject to the following restrictions:
 
 #include "kowalski.h"
 #include "kwl_audiodata.h"
+#include "kwl_commandqueue.h"
 #include "kwl_enginedata.h"
 #include "kwl_dspunit.h"
 #include "kwl_eventinstance.h"
@@ -44,6 +45,9 @@ extern "C"
 {
 #endif /* __cplusplus */
     
+/** The random seed used unless \c kwlSetRandomSeed is called. */
+#define KWL_DEFAULT_RANDOM_SEED 1
+    
 /** 
  * A struct representing the singleton Kowalski sound engine. 
  */
@@ -74,6 +78,18 @@ typedef struct kwlEngine
     kwlMessageQueue wavebankLoadingQueueShared;
     kwlMessageQueue wavebankLoadingQueue;
     
+    /** 
+     * A lock-free queue of commands submitted from any thread, which are executed 
+     * in submission order at the start of the next engine update.
+     */
+    kwlCommandQueue commandQueue;
+    
+    /** 
+     * Set once the engine is being deinitialized. Producers check it before adding to 
+     * \c commandQueue so no command is added after the queue has been drained of producers.
+     */
+    volatile unsigned int isCommandQueueClosed;
+    
     /** A struct containing information about the current 3D audio listener. */
     kwlPositionalAudioListener listener;
     
@@ -90,6 +106,27 @@ typedef struct kwlEngine
     /** */
     struct kwlDecoder* decoders;
     
+    /** A linked list of the built-in convolution DSP units created, whose worker threads are stopped when the engine is freed. */
+    struct kwlDSPConvolution* convolutions;
+    
+    /** 
+     * The render-ahead attached to the mixer, or NULL. A render-ahead that has been asked 
+     * to stop stays here until the host callback has detached it.
+     */
+    struct kwlRenderAhead* renderAhead;
+    /** The block size of the requested render-ahead, or zero if render-ahead is disabled. */
+    int renderAheadBlockSize;
+    /** The maximum number of blocks ahead of the requested render-ahead. */
+    int renderAheadMaxNumBlocks;
+    
+    /** The buffer size passed to \c kwlInitialize. */
+    int bufferSize;
+    /** 
+     * Non-zero while the offline host renders the mixer. Lets the engine thread render 
+     * while blocking without racing a thread rendering through \c kwlOfflineHost_render.
+     */
+    volatile unsigned int isOfflineHostRendering;
+    
     /** 
      * A linked list of currently playing events, ie events for which a 'start event' message has been sent and
      * an 'event stopped' message has not yet been received. 
@@ -99,8 +136,26 @@ typedef struct kwlEngine
     /** A collection of positional audio parameters.*/
     kwlPositionalAudioSettings positionalAudioSettings;
     
+    /** 
+     * Non-zero if the listener or the positional audio settings have changed since the 
+     * last engine update, in which case all playing positional events need to be updated.
+     */
+    char isListenerDirty;
+    
     /** The currently loaded engine data.*/
     kwlEngineData engineData;
+    
+    /** 
+     * The state of the random number generator used for instance stealing and 
+     * for seeding the random sequences of started events.
+     */
+    unsigned int randomState;
+    
+    /** 
+     * The API state of the engine, i.e its error flag and trace recording state, saved 
+     * while another engine instance is current. NULL until the engine stops being current.
+     */
+    void* savedAPIState;
 
 } kwlEngine; 
     
@@ -135,14 +190,20 @@ kwlError kwlEngine_eventRelease(kwlEngine* engine, kwlEventHandle handle);
 /** */
 kwlError kwlEngine_unloadFreeformEvent(kwlEngine* engine, struct kwlEventInstance* event);
 
-/** */
-kwlError kwlEngine_eventStart(kwlEngine* engine, const int handle, float fadeInTimeSec);
+/** 
+ * Starts an event instance. If \c immediately is non-zero, the start message is sent straight 
+ * to the mixer instead of at the next update.
+ */
+kwlError kwlEngine_eventStart(kwlEngine* engine, const int handle, float fadeInTimeSec, int immediately);
     
 /** */
-kwlError kwlEngine_startEventInstance(kwlEngine* engine, struct kwlEventInstance* event, float fadeInTimeSec);
+kwlError kwlEngine_startEventInstance(kwlEngine* engine, struct kwlEventInstance* event, float fadeInTimeSec, int immediately);
     
-/** */
-kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutTimeSec);
+/** 
+ * Stops an event instance. If \c immediately is non-zero, the stop message is sent straight 
+ * to the mixer instead of at the next update.
+ */
+kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutTimeSec, int immediately);
 
 /** */
 kwlError kwlEngine_eventStartOneShot(kwlEngine* engine, 
@@ -150,7 +211,8 @@ kwlError kwlEngine_eventStartOneShot(kwlEngine* engine,
                                           float x, float y, float z, 
                                           int startAtPosition,
                                           kwlEventStoppedCallack stoppedCallback,
-                                          void* stoppedCallbackUserData);
+                                          void* stoppedCallbackUserData,
+                                          int immediately);
 
 kwlError kwlEngine_eventSetStoppedCallback(kwlEngine* engine, const int handle, 
                                                 kwlEventStoppedCallack stoppedCallback,
@@ -182,6 +244,34 @@ kwlError kwlEngine_eventSetBalance(kwlEngine* engine, kwlEventHandle handle, flo
     
 /** */
 kwlError kwlEngine_eventSetGain(kwlEngine* engine, kwlEventHandle eventHandle, float gain, int isLinearGain);
+
+/** 
+ * Sets the positions of a number of events. Invalid handles and non-positional events 
+ * are skipped and the error of the first one is returned.
+ */
+kwlError kwlEngine_eventsSetPositions(kwlEngine* engine, const kwlEventHandle* handles, 
+                                      const float* posX, const float* posY, const float* posZ, int numEvents);
+
+/** 
+ * Sets the velocities of a number of events. Invalid handles and non-positional events 
+ * are skipped and the error of the first one is returned.
+ */
+kwlError kwlEngine_eventsSetVelocities(kwlEngine* engine, const kwlEventHandle* handles, 
+                                       const float* velX, const float* velY, const float* velZ, int numEvents);
+
+/** 
+ * Sets the gains of a number of events. Invalid handles and negative gains 
+ * are skipped and the error of the first one is returned.
+ */
+kwlError kwlEngine_eventsSetGains(kwlEngine* engine, const kwlEventHandle* handles, 
+                                  const float* gains, int numEvents, int isLinearGain);
+
+/** 
+ * Starts one-shot instances of a number of event definitions at given positions. Failed starts
+ * are skipped and the error of the first one is returned.
+ */
+kwlError kwlEngine_eventsStartOneShotsAt(kwlEngine* engine, const kwlEventDefinitionHandle* handles, 
+                                         const float* x, const float* y, const float* z, int numEvents);
     
 /** Adds a given event to the linked list of currently playing events. */
 void kwlEngine_addEventToPlayingList(kwlEngine* engine, struct kwlEventInstance* eventToAdd);
@@ -207,10 +297,12 @@ float kwlEngine_getConeGain(kwlEngine* engine, float cosAngle, float cosInner, f
 /***********************************************************************
  * DSP units
  ***********************************************************************/    
-kwlError kwlEngine_attachDSPUnitToEvent(kwlEngine* engine, kwlEventHandle eventHandle, kwlDSPUnit* dspUnit);
-kwlError kwlEngine_attachDSPUnitToMixBus(kwlEngine* engine, kwlMixBusHandle mixBusHandle, kwlDSPUnit* dspUnit);
-kwlError kwlEngine_attachDSPUnitToInput(kwlEngine* engine, kwlDSPUnit* dspUnit);
-kwlError kwlEngine_attachDSPUnitToOutput(kwlEngine* engine, kwlDSPUnit* dspUnit);
+kwlError kwlEngine_attachDSPUnitToEvent(kwlEngine* engine, kwlEventHandle eventHandle, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit);
+kwlError kwlEngine_attachDSPUnitToMixBus(kwlEngine* engine, kwlMixBusHandle mixBusHandle, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit);
+kwlError kwlEngine_attachDSPUnitToInput(kwlEngine* engine, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit);
+kwlError kwlEngine_attachDSPUnitToOutput(kwlEngine* engine, kwlDSPUnit* dspUnit, kwlDSPChainEdit edit);
+/** Bypasses a DSP unit wherever it is attached, or stops bypassing it. */
+kwlError kwlEngine_dspUnitSetBypassed(kwlEngine* engine, kwlDSPUnit* dspUnit, int bypassed);
 /***********************************************************************
  * Mix buses/presets
  ***********************************************************************/    
@@ -226,6 +318,21 @@ kwlError kwlEngine_mixBusSetGain(kwlEngine* engine, kwlMixBusHandle handle, floa
 /** */
 kwlError kwlEngine_mixBusSetPitch(kwlEngine* engine, kwlMixBusHandle handle, float pitch);
 
+/** Enables or disables output level metering of a given mix bus. */
+kwlError kwlEngine_mixBusSetMeteringEnabled(kwlEngine* engine, kwlMixBusHandle handle, int enabled);
+
+/** Gets the peak and RMS levels of a given channel of a mix bus. */
+kwlError kwlEngine_mixBusGetLevels(kwlEngine* engine, kwlMixBusHandle handle, int channel, float* peakLevel, float* rmsLevel);
+
+/** Enables or disables batched processing of the built-in event filters of a given mix bus. */
+kwlError kwlEngine_mixBusSetFilterBatchingEnabled(kwlEngine* engine, kwlMixBusHandle handle, int enabled);
+
+/** Sets the level of the send from a given mix bus to a given aux return bus. */
+kwlError kwlEngine_mixBusSetAuxSendLevel(kwlEngine* engine, 
+                                         kwlMixBusHandle handle, 
+                                         kwlMixBusHandle returnBusHandle, 
+                                         float level);
+
 /** */
 kwlError kwlEngine_mixPresetGetHandle(kwlEngine* engine, const char* const busId, kwlMixBusHandle* handle);
     
@@ -291,10 +398,13 @@ kwlError kwlEngine_isLoaded(kwlEngine* engine, int* ret);
 /** */
 kwlError kwlEngine_engineDataLoad(kwlEngine* engine, const char* const dataFile);
     
-/** */
+/** 
+ * Requests the mixer to stop all data driven events, after which the engine data
+ * is unloaded by a subsequent update. Does not block.
+ */
 kwlError kwlEngine_engineDataUnload(kwlEngine* engine);
 
-/** */
+/** Unloads the engine data, updating the engine until the mixer has released it. */
 kwlError kwlEngine_unloadEngineDataBlocking(kwlEngine* engine);
     
 /** Releases all loaded audio and engine data and shuts down the underlying sound system. */
@@ -332,6 +442,39 @@ kwlError kwlEngine_getOutLevels(kwlEngine* engine, float* leftLevel, float* righ
     
 /** */
 kwlError kwlEngine_hasClipped(kwlEngine* engine, int* hasClipped);
+
+/** Enables or disables CPU cost profiling, measuring costs over periods of a given length. */
+kwlError kwlEngine_setCPUProfilingEnabled(kwlEngine* engine, int enabled, float periodSec);
+
+/** Gets the mixer CPU costs of the last completed measurement period. */
+kwlError kwlEngine_getCPUCostSnapshot(kwlEngine* engine, kwlCPUCostSnapshot* snapshot);
+
+/** Gets the CPU load of a mix bus and its sub buses during the last completed measurement period. */
+kwlError kwlEngine_mixBusGetCPULoad(kwlEngine* engine, kwlMixBusHandle handle, float* load);
+
+/** Gets the CPU load of an event during the last completed measurement period. */
+kwlError kwlEngine_eventGetCPULoad(kwlEngine* engine, kwlEventHandle handle, float* load);
+
+/** Gets the CPU load of a DSP unit during the last completed measurement period. */
+kwlError kwlEngine_dspUnitGetCPULoad(kwlEngine* engine, kwlDSPUnit* dspUnit, float* load);
+
+/** Creates a DSP unit with a built-in filter running at the mixer sample rate. */
+kwlError kwlEngine_createFilterDSPUnit(kwlEngine* engine, kwlFilterType type, float cutoff, float q, float gainDB, kwlDSPUnit** dspUnit);
+
+/** Sets the target parameters of a DSP unit with a built-in filter. */
+kwlError kwlEngine_dspUnitSetFilterParameters(kwlEngine* engine, kwlDSPUnit* dspUnit, float cutoff, float q, float gainDB);
+
+/** Creates a DSP unit with a built-in convolution and adds it to the list of convolutions of the engine. */
+kwlError kwlEngine_createConvolutionDSPUnit(kwlEngine* engine, const kwlPCMBuffer* impulseResponse, float gain, kwlDSPUnit** dspUnit);
+
+/** Sets the tail length of a custom DSP unit. A negative length means an infinite tail. */
+kwlError kwlEngine_dspUnitSetTailLength(kwlEngine* engine, kwlDSPUnit* dspUnit, float seconds);
+
+/** 
+ * Requests render-ahead mixing with a given configuration, or no render-ahead if \c enabled is zero. 
+ * A running render-ahead with a different configuration is replaced once the host callback has detached it.
+ */
+kwlError kwlEngine_setRenderAhead(kwlEngine* engine, int enabled, int blockSize, int maxNumBlocksAhead);
     
 /***********************************************************************
  * Engine methods to be implemented per target host.
@@ -346,6 +489,13 @@ kwlError kwlEngine_hostSpecificInitialize(kwlEngine* engine, int sampleRate, int
  * Performs host specific deinitialization of the underlying sound system.
  */
 kwlError kwlEngine_hostSpecificDeinitialize(kwlEngine* engine);
+
+/** 
+ * Called repeatedly while the engine thread blocks until the mixer has handled a request, 
+ * e.g when unloading engine data or a wave bank. Hosts that mix on an audio thread do 
+ * nothing, hosts that only mix on demand render a buffer so the wait ends.
+ */
+void kwlEngine_hostSpecificWaitForMixer(kwlEngine* engine);
     
 #ifdef __cplusplus
 }
@@ -24,11 +24,14 @@
 #include <math.h>
 #include <string.h>
 
+#include "kwl_asm.h"
 #include "kwl_assert.h"
 #include "kwl_enginedata.h"
 #include "kwl_memory.h"
 #include "kwl_sounddefinition.h"
 
+static kwlError kwlEngineData_loadPackedFromStream(kwlEngineData* data, kwlInputStream* stream);
+
 kwlError kwlEngineData_load(kwlEngineData* data, kwlInputStream* stream)
 {
     if (data->isLoaded)
@@ -37,14 +40,20 @@ kwlError kwlEngineData_load(kwlEngineData* data, kwlInputStream* stream)
     }
     
     /*check file identifier*/
-    int i;
-    for (i = 0; i < KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH; i++)
+    char identifier[KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH];
+    const int identifierLength = KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH;
+    if (kwlInputStream_read(stream, (signed char*)identifier, identifierLength) != identifierLength)
     {
-        const char identifierChari = kwlInputStream_readChar(stream);
-        if (identifierChari != KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER[i])
-        {
-            return KWL_UNKNOWN_FILE_FORMAT;
-        }
+        return KWL_UNKNOWN_FILE_FORMAT;
+    }
+    
+    if (memcmp(identifier, KWL_PACKED_ENGINE_DATA_BINARY_FILE_IDENTIFIER, identifierLength) == 0)
+    {
+        return kwlEngineData_loadPackedFromStream(data, stream);
+    }
+    else if (memcmp(identifier, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER, identifierLength) != 0)
+    {
+        return KWL_UNKNOWN_FILE_FORMAT;
     }
     
     /*Load chunks*/
@@ -64,6 +73,500 @@ kwlError kwlEngineData_load(kwlEngineData* data, kwlInputStream* stream)
     return KWL_NO_ERROR;
 }
 
+/**
+ * Reads the remainder of a packed engine data binary, assuming the file identifier 
+ * has already been read, and sets up engine data from it.
+ */
+static kwlError kwlEngineData_loadPackedFromStream(kwlEngineData* data, kwlInputStream* stream)
+{
+    /*read the rest of the header to find out the file size...*/
+    kwlPackedEngineDataHeader header;
+    const int identifierLength = KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH;
+    const int headerRestSize = sizeof(kwlPackedEngineDataHeader) - identifierLength;
+    kwlMemcpy(header.identifier, KWL_PACKED_ENGINE_DATA_BINARY_FILE_IDENTIFIER, identifierLength);
+    if (kwlInputStream_read(stream, (signed char*)&header + identifierLength, headerRestSize) != headerRestSize)
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
+    
+    int fileSize = header.fileSize;
+    if (kwlIsBigEndianHost())
+    {
+        kwlSwapEndian32(&fileSize, 1);
+    }
+    
+    if (fileSize < (int)sizeof(kwlPackedEngineDataHeader))
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
+    
+    /*...then read the remaining data in one go.*/
+    char* buffer = (char*)KWL_MALLOC(fileSize, "packed engine data");
+    kwlMemcpy(buffer, &header, sizeof(kwlPackedEngineDataHeader));
+    const int remainingSize = fileSize - sizeof(kwlPackedEngineDataHeader);
+    if (remainingSize > 0 &&
+        kwlInputStream_read(stream, (signed char*)buffer + sizeof(kwlPackedEngineDataHeader), remainingSize) != remainingSize)
+    {
+        KWL_FREE(buffer);
+        return KWL_CORRUPT_BINARY_DATA;
+    }
+    
+    kwlError result = kwlEngineData_loadPacked(data, buffer, fileSize);
+    if (result != KWL_NO_ERROR)
+    {
+        KWL_FREE(buffer);
+    }
+    
+    return result;
+}
+
+/** Returns non-zero if a section of \c count elements of a given size fits in the range [start, end).*/
+static int kwlEngineData_isPackedSectionValid(int offset, int count, int elementSize, int start, int end)
+{
+    if (offset < start || count < 0 || (offset & 3) != 0)
+    {
+        return 0;
+    }
+    
+    return (long long)offset + (long long)count * elementSize <= end;
+}
+
+/** Returns non-zero if a given index range [first, first + count) lies within [0, size).*/
+static int kwlEngineData_isPackedRangeValid(int first, int count, int size)
+{
+    return first >= 0 && count >= 0 && (long long)first + count <= size;
+}
+
+/** 
+ * Returns non-zero if a range of packed aux sends is valid, i.e if it lies within the aux send array
+ * and all sends have non-negative levels and feed aux return buses.
+ */
+static int kwlEngineData_isPackedAuxSendRangeValid(const kwlPackedAuxSend* auxSends,
+                                                   int first,
+                                                   int count,
+                                                   int numAuxSends,
+                                                   const kwlPackedMixBus* mixBuses,
+                                                   int numMixBuses)
+{
+    if (!kwlEngineData_isPackedRangeValid(first, count, numAuxSends))
+    {
+        return 0;
+    }
+    
+    for (int i = first; i < first + count; i++)
+    {
+        const int returnBusIndex = auxSends[i].returnBusIndex;
+        if (returnBusIndex < 0 || returnBusIndex >= numMixBuses ||
+            mixBuses[returnBusIndex].isAuxReturn == 0 ||
+            !(auxSends[i].level >= 0.0f))
+        {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+/** Points a range of runtime aux sends to their return buses and sets their initial levels.*/
+static void kwlEngineData_initPackedAuxSends(kwlEngineData* data, const kwlPackedAuxSend* packedAuxSends, int first, int count)
+{
+    for (int i = first; i < first + count; i++)
+    {
+        kwlAuxSend* send = &data->packedAuxSends[i];
+        send->returnBus = &data->mixBuses[packedAuxSends[i].returnBusIndex];
+        send->level.valueEngine = packedAuxSends[i].level;
+        send->level.valueShared = packedAuxSends[i].level;
+        send->level.valueMixer = packedAuxSends[i].level;
+    }
+}
+
+kwlError kwlEngineData_loadPacked(kwlEngineData* data, void* buffer, int size)
+{
+    char* const base = (char*)buffer;
+    kwlPackedEngineDataHeader* header = (kwlPackedEngineDataHeader*)buffer;
+    
+    /*
+     * Validate the header and convert all 32 bit words to host byte order.
+     */
+    if (size < (int)sizeof(kwlPackedEngineDataHeader) ||
+        memcmp(header->identifier, 
+               KWL_PACKED_ENGINE_DATA_BINARY_FILE_IDENTIFIER, 
+               KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH) != 0)
+    {
+        return KWL_UNKNOWN_FILE_FORMAT;
+    }
+    
+    const int isBigEndianHost = kwlIsBigEndianHost();
+    const int headerWordsOffset = sizeof(header->identifier);
+    const int numHeaderWords = (sizeof(kwlPackedEngineDataHeader) - headerWordsOffset) / 4;
+    if (isBigEndianHost)
+    {
+        kwlSwapEndian32((int*)(base + headerWordsOffset), numHeaderWords);
+    }
+    
+    if (header->version != KWL_PACKED_ENGINE_DATA_VERSION)
+    {
+        return KWL_UNKNOWN_FILE_FORMAT;
+    }
+    
+    const int stringsOffset = header->stringsOffset;
+    const int stringsSize = header->stringsSize;
+    const int wordsStart = sizeof(kwlPackedEngineDataHeader);
+    if (header->fileSize > size ||
+        !kwlEngineData_isPackedSectionValid(stringsOffset, stringsSize, 1, wordsStart, header->fileSize) ||
+        !kwlEngineData_isPackedSectionValid(header->mixBusesOffset, header->numMixBuses, 
+                                            sizeof(kwlPackedMixBus), wordsStart, stringsOffset) ||
+        !kwlEngineData_isPackedSectionValid(header->mixPresetsOffset, header->numMixPresets,
+                                            sizeof(kwlPackedMixPreset), wordsStart, stringsOffset) ||
+        !kwlEngineData_isPackedSectionValid(header->waveBanksOffset, header->numWaveBanks,
+                                            sizeof(kwlPackedWaveBank), wordsStart, stringsOffset) ||
+        !kwlEngineData_isPackedSectionValid(header->audioDataEntriesOffset, header->numAudioDataEntries,
+                                            sizeof(kwlPackedAudioData), wordsStart, stringsOffset) ||
+        !kwlEngineData_isPackedSectionValid(header->soundDefinitionsOffset, header->numSoundDefinitions,
+                                            sizeof(kwlPackedSoundDefinition), wordsStart, stringsOffset) ||
+        !kwlEngineData_isPackedSectionValid(header->eventDefinitionsOffset, header->numEventDefinitions,
+                                            sizeof(kwlPackedEventDefinition), wordsStart, stringsOffset) ||
+        !kwlEngineData_isPackedSectionValid(header->auxSendsOffset, header->numAuxSends,
+                                            sizeof(kwlPackedAuxSend), wordsStart, stringsOffset) ||
+        !kwlEngineData_isPackedSectionValid(header->indicesOffset, header->numIndices, 
+                                            sizeof(int), wordsStart, stringsOffset) ||
+        !kwlEngineData_isPackedSectionValid(header->mixPresetParametersOffset, header->numMixPresetParameters,
+                                            sizeof(float), wordsStart, stringsOffset) ||
+        header->numMixBuses <= 0 ||
+        header->numMixPresets <= 0 ||
+        header->numMixPresetParameters != 3 * header->numMixBuses * header->numMixPresets ||
+        stringsSize <= 0 ||
+        base[stringsOffset + stringsSize - 1] != '\0')
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
+    
+    if (isBigEndianHost)
+    {
+        kwlSwapEndian32((int*)(base + wordsStart), (stringsOffset - wordsStart) / 4);
+    }
+    
+    const char* const strings = base + stringsOffset;
+    const kwlPackedMixBus* packedMixBuses = (kwlPackedMixBus*)(base + header->mixBusesOffset);
+    const kwlPackedMixPreset* packedMixPresets = (kwlPackedMixPreset*)(base + header->mixPresetsOffset);
+    const kwlPackedWaveBank* packedWaveBanks = (kwlPackedWaveBank*)(base + header->waveBanksOffset);
+    const kwlPackedAudioData* packedAudioData = (kwlPackedAudioData*)(base + header->audioDataEntriesOffset);
+    const kwlPackedSoundDefinition* packedSounds = 
+        (kwlPackedSoundDefinition*)(base + header->soundDefinitionsOffset);
+    const kwlPackedEventDefinition* packedEvents = 
+        (kwlPackedEventDefinition*)(base + header->eventDefinitionsOffset);
+    const kwlPackedAuxSend* packedAuxSends = (kwlPackedAuxSend*)(base + header->auxSendsOffset);
+    const int* indices = (int*)(base + header->indicesOffset);
+    float* mixPresetParameters = (float*)(base + header->mixPresetParametersOffset);
+    
+    const int numMixBuses = header->numMixBuses;
+    const int numMixPresets = header->numMixPresets;
+    const int numWaveBanks = header->numWaveBanks;
+    const int numAudioDataEntries = header->numAudioDataEntries;
+    const int numSoundDefinitions = header->numSoundDefinitions;
+    const int numEventDefinitions = header->numEventDefinitions;
+    const int numIndices = header->numIndices;
+    const int numAuxSends = header->numAuxSends;
+    
+    /*
+     * Validate all cross references before touching the engine data, so that 
+     * nothing needs to be rolled back on failure.
+     */
+    int i;
+    int j;
+    int numMasterBuses = 0;
+    for (i = 0; i < numMixBuses; i++)
+    {
+        const kwlPackedMixBus* bus = &packedMixBuses[i];
+        if (bus->idOffset < 0 || bus->idOffset >= stringsSize ||
+            !kwlEngineData_isPackedRangeValid(bus->firstSubBusIndex, bus->numSubBuses, numIndices))
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+        for (j = 0; j < bus->numSubBuses; j++)
+        {
+            const int subBusIndex = indices[bus->firstSubBusIndex + j];
+            if (subBusIndex < 0 || subBusIndex >= numMixBuses)
+            {
+                return KWL_CORRUPT_BINARY_DATA;
+            }
+        }
+        
+        /*return buses are leaf buses that don't send, so that they can be rendered last in any order.*/
+        const int isMaster = strcmp(&strings[bus->idOffset], "master") == 0;
+        if ((bus->isAuxReturn != 0 && (isMaster || bus->numSubBuses > 0 || bus->numAuxSends != 0)) ||
+            !kwlEngineData_isPackedAuxSendRangeValid(packedAuxSends, bus->firstAuxSend, bus->numAuxSends,
+                                                     numAuxSends, packedMixBuses, numMixBuses))
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+        if (isMaster)
+        {
+            numMasterBuses++;
+        }
+    }
+    
+    int defaultPresetIndex = -1;
+    for (i = 0; i < numMixPresets; i++)
+    {
+        const kwlPackedMixPreset* preset = &packedMixPresets[i];
+        if (preset->idOffset < 0 || preset->idOffset >= stringsSize ||
+            preset->fadeTime < 0.0f ||
+            !kwlEngineData_isPackedRangeValid(preset->firstParameterIndex, 
+                                              3 * numMixBuses, 
+                                              header->numMixPresetParameters) ||
+            (preset->isDefault != 0 && defaultPresetIndex >= 0))
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+        if (preset->isDefault != 0)
+        {
+            defaultPresetIndex = i;
+        }
+    }
+    
+    for (i = 0; i < numWaveBanks; i++)
+    {
+        const kwlPackedWaveBank* waveBank = &packedWaveBanks[i];
+        if (waveBank->idOffset < 0 || waveBank->idOffset >= stringsSize ||
+            !kwlEngineData_isPackedRangeValid(waveBank->firstAudioDataEntry, 
+                                              waveBank->numAudioDataEntries, 
+                                              numAudioDataEntries))
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+    }
+    
+    for (i = 0; i < numAudioDataEntries; i++)
+    {
+        if (packedAudioData[i].filePathOffset < 0 || packedAudioData[i].filePathOffset >= stringsSize)
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+    }
+    
+    for (i = 0; i < numSoundDefinitions; i++)
+    {
+        const kwlPackedSoundDefinition* sound = &packedSounds[i];
+        if (!kwlEngineData_isPackedRangeValid(sound->firstAudioDataEntryIndex, 
+                                              sound->numAudioDataEntries, 
+                                              numIndices))
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+        for (j = 0; j < sound->numAudioDataEntries; j++)
+        {
+            const int audioDataIndex = indices[sound->firstAudioDataEntryIndex + j];
+            if (audioDataIndex < 0 || audioDataIndex >= numAudioDataEntries)
+            {
+                return KWL_CORRUPT_BINARY_DATA;
+            }
+        }
+    }
+    
+    for (i = 0; i < numEventDefinitions; i++)
+    {
+        const kwlPackedEventDefinition* event = &packedEvents[i];
+        if (event->idOffset < 0 || event->idOffset >= stringsSize ||
+            event->instanceCount < -1 ||
+            event->mixBusIndex < 0 || event->mixBusIndex >= numMixBuses ||
+            event->soundIndex < -1 || event->soundIndex >= numSoundDefinitions ||
+            event->streamAudioDataEntry < -1 || event->streamAudioDataEntry >= numAudioDataEntries ||
+            !kwlEngineData_isPackedRangeValid(event->firstReferencedWaveBankIndex, 
+                                              event->numReferencedWaveBanks, 
+                                              numIndices) ||
+            (event->numAuxSends != 0 && packedMixBuses[event->mixBusIndex].isAuxReturn != 0) ||
+            !kwlEngineData_isPackedAuxSendRangeValid(packedAuxSends, event->firstAuxSend, event->numAuxSends,
+                                                     numAuxSends, packedMixBuses, numMixBuses))
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+        for (j = 0; j < event->numReferencedWaveBanks; j++)
+        {
+            const int waveBankIndex = indices[event->firstReferencedWaveBankIndex + j];
+            if (waveBankIndex < 0 || waveBankIndex >= numWaveBanks)
+            {
+                return KWL_CORRUPT_BINARY_DATA;
+            }
+        }
+    }
+    
+    if (numMasterBuses != 1 || defaultPresetIndex < 0)
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
+    
+    /*
+     * The data is valid. Allocate the runtime structures and point them into the buffer.
+     */
+    data->packedData = buffer;
+    data->packedPointerPool = (void**)KWL_MALLOCANDZERO((numIndices > 0 ? numIndices : 1) * sizeof(void*), 
+                                                        "packed engine data pointer pool");
+    data->packedAuxSends = (kwlAuxSend*)KWL_MALLOCANDZERO((numAuxSends > 0 ? numAuxSends : 1) * sizeof(kwlAuxSend), 
+                                                          "packed aux sends");
+    
+    /*mix buses*/
+    data->numMixBuses = numMixBuses;
+    data->mixBuses = (kwlMixBus*)KWL_MALLOCANDZERO(numMixBuses * sizeof(kwlMixBus), "packed mix buses");
+    for (i = 0; i < numMixBuses; i++)
+    {
+        const kwlPackedMixBus* packedBus = &packedMixBuses[i];
+        kwlMixBus* const mixBusi = &data->mixBuses[i];
+        kwlMixBus_init(mixBusi);
+        mixBusi->id = (char*)&strings[packedBus->idOffset];
+        if (strcmp(mixBusi->id, "master") == 0)
+        {
+            data->masterBus = mixBusi;
+            data->masterBus->isMaster = 1;
+        }
+        
+        mixBusi->numSubBuses = packedBus->numSubBuses;
+        mixBusi->subBuses = NULL;
+        if (packedBus->numSubBuses > 0)
+        {
+            mixBusi->subBuses = (kwlMixBus**)&data->packedPointerPool[packedBus->firstSubBusIndex];
+            for (j = 0; j < packedBus->numSubBuses; j++)
+            {
+                mixBusi->subBuses[j] = &data->mixBuses[indices[packedBus->firstSubBusIndex + j]];
+            }
+        }
+        
+        mixBusi->isAuxReturn = packedBus->isAuxReturn != 0;
+        mixBusi->numAuxSends = packedBus->numAuxSends;
+        mixBusi->auxSends = &data->packedAuxSends[packedBus->firstAuxSend];
+    }
+    for (i = 0; i < numMixBuses; i++)
+    {
+        kwlEngineData_initPackedAuxSends(data, packedAuxSends, packedMixBuses[i].firstAuxSend, packedMixBuses[i].numAuxSends);
+    }
+    
+    /*mix presets*/
+    data->numMixPresets = numMixPresets;
+    data->mixPresets = (kwlMixPreset*)KWL_MALLOCANDZERO(numMixPresets * sizeof(kwlMixPreset), "packed mix presets");
+    for (i = 0; i < numMixPresets; i++)
+    {
+        const kwlPackedMixPreset* packedPreset = &packedMixPresets[i];
+        kwlMixPreset* preseti = &data->mixPresets[i];
+        float* parameters = &mixPresetParameters[packedPreset->firstParameterIndex];
+        preseti->id = (char*)&strings[packedPreset->idOffset];
+        preseti->numParameterSets = numMixBuses;
+        preseti->logGainLeft = parameters;
+        preseti->logGainRight = parameters + numMixBuses;
+        preseti->pitch = parameters + 2 * numMixBuses;
+        preseti->fadeTime = packedPreset->fadeTime;
+        preseti->weight = preseti->targetWeight = (i == defaultPresetIndex ? 1.0f : 0.0f);
+    }
+    data->mixPresetFadeTime = data->mixPresets[defaultPresetIndex].fadeTime;
+    data->mixPresetBlendGainLeft = (float*)KWL_MALLOC(sizeof(float) * numMixBuses, "packed mix preset blending");
+    data->mixPresetBlendGainRight = (float*)KWL_MALLOC(sizeof(float) * numMixBuses, "packed mix preset blending");
+    data->mixPresetBlendPitch = (float*)KWL_MALLOC(sizeof(float) * numMixBuses, "packed mix preset blending");
+    data->mixPresetBlendRequested = 1;
+    
+    /*wave banks and audio data entries*/
+    data->totalNumAudioDataEntries = numAudioDataEntries;
+    data->audioDataEntries = 
+        (kwlAudioData*)KWL_MALLOCANDZERO((numAudioDataEntries > 0 ? numAudioDataEntries : 1) * sizeof(kwlAudioData), 
+                                         "packed audio data entries");
+    data->numWaveBanks = numWaveBanks;
+    data->waveBanks = 
+        (kwlWaveBank*)KWL_MALLOCANDZERO((numWaveBanks > 0 ? numWaveBanks : 1) * sizeof(kwlWaveBank), 
+                                        "packed wave banks");
+    for (i = 0; i < numAudioDataEntries; i++)
+    {
+        data->audioDataEntries[i].filePath = &strings[packedAudioData[i].filePathOffset];
+    }
+    for (i = 0; i < numWaveBanks; i++)
+    {
+        const kwlPackedWaveBank* packedWaveBank = &packedWaveBanks[i];
+        kwlWaveBank* waveBanki = &data->waveBanks[i];
+        waveBanki->id = &strings[packedWaveBank->idOffset];
+        waveBanki->numAudioDataEntries = packedWaveBank->numAudioDataEntries;
+        waveBanki->audioDataItems = &data->audioDataEntries[packedWaveBank->firstAudioDataEntry];
+        for (j = 0; j < packedWaveBank->numAudioDataEntries; j++)
+        {
+            waveBanki->audioDataItems[j].waveBank = waveBanki;
+        }
+    }
+    
+    /*sounds*/
+    data->numSoundDefinitions = numSoundDefinitions;
+    data->sounds = 
+        (kwlSoundDefinition*)KWL_MALLOCANDZERO((numSoundDefinitions > 0 ? numSoundDefinitions : 1) * sizeof(kwlSoundDefinition), 
+                                               "packed sound definitions");
+    for (i = 0; i < numSoundDefinitions; i++)
+    {
+        const kwlPackedSoundDefinition* packedSound = &packedSounds[i];
+        kwlSoundDefinition* soundi = &data->sounds[i];
+        kwlSoundDefinition_init(soundi);
+        soundi->playbackCount = packedSound->playbackCount;
+        soundi->deferStop = packedSound->deferStop;
+        soundi->gain = packedSound->gain;
+        soundi->gainVariation = packedSound->gainVariation;
+        soundi->pitch = packedSound->pitch;
+        soundi->pitchVariation = packedSound->pitchVariation;
+        soundi->playbackMode = (kwlSoundPlaybackMode)packedSound->playbackMode;
+        soundi->numAudioDataEntries = packedSound->numAudioDataEntries;
+        soundi->audioDataEntries = (kwlAudioData**)&data->packedPointerPool[packedSound->firstAudioDataEntryIndex];
+        for (j = 0; j < packedSound->numAudioDataEntries; j++)
+        {
+            soundi->audioDataEntries[j] = &data->audioDataEntries[indices[packedSound->firstAudioDataEntryIndex + j]];
+        }
+    }
+    
+    /*events*/
+    data->numEventDefinitions = numEventDefinitions;
+    data->events = 
+        (kwlEventInstance**)KWL_MALLOCANDZERO((numEventDefinitions > 0 ? numEventDefinitions : 1) * sizeof(kwlEventInstance*), 
+                                              "packed events");
+    data->eventDefinitions = 
+        (kwlEventDefinition*)KWL_MALLOCANDZERO((numEventDefinitions > 0 ? numEventDefinitions : 1) * sizeof(kwlEventDefinition), 
+                                               "packed event definitions");
+    const float degToRad = 0.0174532925199433f;
+    for (i = 0; i < numEventDefinitions; i++)
+    {
+        const kwlPackedEventDefinition* packedEvent = &packedEvents[i];
+        kwlEventDefinition* definitioni = &data->eventDefinitions[i];
+        definitioni->id = (char*)&strings[packedEvent->idOffset];
+        definitioni->instanceCount = packedEvent->instanceCount;
+        definitioni->gain = packedEvent->gain;
+        definitioni->pitch = packedEvent->pitch;
+        definitioni->innerConeCosAngle = cosf(degToRad * packedEvent->innerConeAngleDeg / 2.0f);
+        definitioni->outerConeCosAngle = cosf(degToRad * packedEvent->outerConeAngleDeg / 2.0f);
+        definitioni->outerConeGain = packedEvent->outerConeGain;
+        definitioni->mixBus = &data->mixBuses[packedEvent->mixBusIndex];
+        definitioni->isPositional = packedEvent->isPositional;
+        definitioni->sound = packedEvent->soundIndex < 0 ? NULL : &data->sounds[packedEvent->soundIndex];
+        definitioni->retriggerMode = (kwlEventRetriggerMode)packedEvent->retriggerMode;
+        definitioni->streamAudioData = packedEvent->streamAudioDataEntry < 0 ? 
+                                       NULL : &data->audioDataEntries[packedEvent->streamAudioDataEntry];
+        definitioni->loopIfStreaming = packedEvent->loopIfStreaming;
+        definitioni->numReferencedWaveBanks = packedEvent->numReferencedWaveBanks;
+        definitioni->referencedWaveBanks = (kwlWaveBank**)&data->packedPointerPool[packedEvent->firstReferencedWaveBankIndex];
+        for (j = 0; j < packedEvent->numReferencedWaveBanks; j++)
+        {
+            definitioni->referencedWaveBanks[j] = &data->waveBanks[indices[packedEvent->firstReferencedWaveBankIndex + j]];
+        }
+        definitioni->numAuxSends = packedEvent->numAuxSends;
+        definitioni->auxSends = &data->packedAuxSends[packedEvent->firstAuxSend];
+        kwlEngineData_initPackedAuxSends(data, packedAuxSends, packedEvent->firstAuxSend, packedEvent->numAuxSends);
+        
+        const int numInstancesToAllocate = packedEvent->instanceCount < 1 ? 1 : packedEvent->instanceCount;
+        data->events[i] = (kwlEventInstance*)KWL_MALLOC(numInstancesToAllocate * sizeof(kwlEventInstance),
+                                                        "packed event instances");
+        kwlEventInstance_init(&data->events[i][0]);
+        data->events[i][0].definition_engine = definitioni;
+        data->events[i][0].definition_mixer = definitioni;
+        for (j = 1; j < numInstancesToAllocate; j++)
+        {
+            kwlMemcpy(&data->events[i][j], &data->events[i][0], sizeof(kwlEventInstance));
+        }
+    }
+    
+    data->isLoaded = 1;
+    
+    return KWL_NO_ERROR;
+}
+
 void kwlEngineData_unload(kwlEngineData* data)
 {
     /* Unload any wave banks*/
@@ -80,12 +583,53 @@ void kwlEngineData_unload(kwlEngineData* data)
     kwlEngineData_freeMixBusData(data);
     kwlEngineData_freeWaveBankData(data);
     
+    /*Free the packed data image, if any, now that nothing points into it.*/
+    if (data->packedData != NULL)
+    {
+        KWL_FREE(data->packedData);
+        KWL_FREE(data->packedPointerPool);
+        KWL_FREE(data->packedAuxSends);
+        data->packedData = NULL;
+        data->packedPointerPool = NULL;
+        data->packedAuxSends = NULL;
+    }
+    
     data->isLoaded = 0;
 }
 
+/** 
+ * Reads a list of aux sends, stored as a count followed by return bus index and level pairs, 
+ * from a chunked engine data binary. The mix buses must be loaded.
+ */
+static kwlAuxSend* kwlEngineData_readAuxSends(kwlEngineData* data, kwlInputStream* stream, int* numAuxSends)
+{
+    *numAuxSends = kwlInputStream_readIntBE(stream);
+    KWL_ASSERT(*numAuxSends >= 0 && *numAuxSends <= data->numMixBuses);
+    if (*numAuxSends == 0)
+    {
+        return NULL;
+    }
+    
+    kwlAuxSend* auxSends = (kwlAuxSend*)KWL_MALLOCANDZERO(*numAuxSends * sizeof(kwlAuxSend), "aux sends");
+    for (int i = 0; i < *numAuxSends; i++)
+    {
+        const int returnBusIndex = kwlInputStream_readIntBE(stream);
+        KWL_ASSERT(returnBusIndex >= 0 && returnBusIndex < data->numMixBuses);
+        const float level = kwlInputStream_readFloatBE(stream);
+        KWL_ASSERT(level >= 0.0f);
+        auxSends[i].returnBus = &data->mixBuses[returnBusIndex];
+        auxSends[i].level.valueEngine = level;
+        auxSends[i].level.valueShared = level;
+        auxSends[i].level.valueMixer = level;
+    }
+    
+    return auxSends;
+}
+
 kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlInputStream* stream)
 {
-    kwlInputStream_seekToEngineDataChunk(stream, KWL_MIX_BUSES_CHUNK_ID);
+    const int chunkSize = kwlInputStream_seekToEngineDataChunk(stream, KWL_MIX_BUSES_CHUNK_ID);
+    const int chunkStart = kwlInputStream_tell(stream);
     KWL_ASSERT(data->mixBuses == NULL);
     
     /*allocate memory for the mix bus data*/
@@ -132,6 +676,32 @@ kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlInputStream* strea
     
     KWL_ASSERT(data->masterBus != NULL);
     
+    /*
+     * Aux return flags and sends are stored as an optional trailing section, 
+     * so that engine data built before aux sends were introduced still loads.
+     */
+    if (kwlInputStream_tell(stream) - chunkStart < chunkSize)
+    {
+        for (i = 0; i < numMixBuses; i++)
+        {
+            data->mixBuses[i].isAuxReturn = kwlInputStream_readIntBE(stream) != 0;
+            data->mixBuses[i].auxSends = kwlEngineData_readAuxSends(data, stream, &data->mixBuses[i].numAuxSends);
+        }
+        
+        for (i = 0; i < numMixBuses; i++)
+        {
+            kwlMixBus* const mixBusi = &data->mixBuses[i];
+            KWL_ASSERT((mixBusi->isAuxReturn == 0 || 
+                       (mixBusi->isMaster == 0 && mixBusi->numSubBuses == 0 && mixBusi->numAuxSends == 0)) &&
+                       "aux return buses must be non-master leaf buses without sends");
+            int j;
+            for (j = 0; j < mixBusi->numAuxSends; j++)
+            {
+                KWL_ASSERT(mixBusi->auxSends[j].returnBus->isAuxReturn != 0);
+            }
+        }
+    }
+    
     return KWL_NO_ERROR;
 }
 
@@ -146,11 +716,22 @@ void kwlEngineData_freeMixBusData(kwlEngineData* data)
     const int numMixBuses = data->numMixBuses;
     int i;
     for (i = 0; i < numMixBuses; i++)
+    {
+        if (data->mixBuses[i].auxReturnBuffer != NULL)
+        {
+            KWL_FREE(data->mixBuses[i].auxReturnBuffer);
+        }
+    }
+    for (i = 0; i < numMixBuses && data->packedData == NULL; i++)
     {
         if (data->mixBuses[i].subBuses != NULL)
         {
             KWL_FREE(data->mixBuses[i].subBuses);
         }
+        if (data->mixBuses[i].auxSends != NULL)
+        {
+            KWL_FREE(data->mixBuses[i].auxSends);
+        }
         KWL_FREE(data->mixBuses[i].id);
     }
     
@@ -165,7 +746,8 @@ void kwlEngineData_freeMixBusData(kwlEngineData* data)
 
 kwlError kwlEngineData_loadMixPresetData(kwlEngineData* data, kwlInputStream* stream)
 {
-    kwlInputStream_seekToEngineDataChunk(stream, KWL_MIX_PRESETS_CHUNK_ID);
+    const int chunkSize = kwlInputStream_seekToEngineDataChunk(stream, KWL_MIX_PRESETS_CHUNK_ID);
+    const int chunkStart = kwlInputStream_tell(stream);
     KWL_ASSERT(data->mixBuses != 0); /*needed for mix bus lookup per param set*/
     
     /*allocate memory for the mix preset data*/
@@ -181,38 +763,68 @@ kwlError kwlEngineData_loadMixPresetData(kwlEngineData* data, kwlInputStream* st
     int i;
     for (i = 0; i < numMixPresets; i++)
     {
-        data->mixPresets[i].id = kwlInputStream_readASCIIString(stream);
+        kwlMixPreset* preseti = &data->mixPresets[i];
+        preseti->id = kwlInputStream_readASCIIString(stream);
+        preseti->fadeTime = KWL_DEFAULT_MIX_PRESET_FADE_TIME;
         const int isDefault = kwlInputStream_readIntBE(stream);
         if (isDefault != 0)
         {
             KWL_ASSERT(defaultPresetIndex == -1 && "multiple default presets found");
             defaultPresetIndex = i;
-            data->mixPresets[i].weight = 1.0f;
-            data->mixPresets[i].targetWeight = 1.0f;
+            preseti->weight = 1.0f;
+            preseti->targetWeight = 1.0f;
         }
         else
         {
-            data->mixPresets[i].weight = 0.0f;
-            data->mixPresets[i].targetWeight = 0.0f;
+            preseti->weight = 0.0f;
+            preseti->targetWeight = 0.0f;
         }
         
-        data->mixPresets[i].numParameterSets = numParameterSets;
-        data->mixPresets[i].parameterSets =
-        (kwlMixBusParameters*)KWL_MALLOC(sizeof(kwlMixBusParameters) * numParameterSets,
-                                         "kwlEngineData_loadMixPresetData");
+        /*parameter sets are stored in mix bus index order, regardless of the order in the file.*/
+        preseti->numParameterSets = numParameterSets;
+        preseti->logGainLeft = (float*)KWL_MALLOC(sizeof(float) * numParameterSets, 
+                                                  "kwlEngineData_loadMixPresetData");
+        preseti->logGainRight = (float*)KWL_MALLOC(sizeof(float) * numParameterSets, 
+                                                   "kwlEngineData_loadMixPresetData");
+        preseti->pitch = (float*)KWL_MALLOC(sizeof(float) * numParameterSets, 
+                                            "kwlEngineData_loadMixPresetData");
         int j;
         for (j = 0; j < numParameterSets; j++)
         {
             const int mixBusIndex = kwlInputStream_readIntBE(stream);
             KWL_ASSERT(mixBusIndex >= 0 &&  mixBusIndex < numParameterSets);
-            data->mixPresets[i].parameterSets[j].mixBusIndex = mixBusIndex;
-            data->mixPresets[i].parameterSets[j].logGainLeft = kwlInputStream_readFloatBE(stream);
-            data->mixPresets[i].parameterSets[j].logGainRight = kwlInputStream_readFloatBE(stream);
-            data->mixPresets[i].parameterSets[j].pitch = kwlInputStream_readFloatBE(stream);
+            preseti->logGainLeft[mixBusIndex] = kwlInputStream_readFloatBE(stream);
+            preseti->logGainRight[mixBusIndex] = kwlInputStream_readFloatBE(stream);
+            preseti->pitch[mixBusIndex] = kwlInputStream_readFloatBE(stream);
         }
     }
     KWL_ASSERT(defaultPresetIndex >= 0);
     
+    /*
+     * Fade times are stored as an optional trailing array, one float per preset, 
+     * so that engine data built before fade times were authored still loads.
+     */
+    if (kwlInputStream_tell(stream) - chunkStart < chunkSize)
+    {
+        for (i = 0; i < numMixPresets; i++)
+        {
+            const float fadeTime = kwlInputStream_readFloatBE(stream);
+            KWL_ASSERT(fadeTime >= 0.0f);
+            data->mixPresets[i].fadeTime = fadeTime;
+        }
+    }
+    
+    data->mixPresetFadeTime = data->mixPresets[defaultPresetIndex].fadeTime;
+    
+    /*allocate blending scratch buffers and request an initial blend.*/
+    data->mixPresetBlendGainLeft = (float*)KWL_MALLOC(sizeof(float) * numParameterSets,
+                                                      "kwlEngineData_loadMixPresetData");
+    data->mixPresetBlendGainRight = (float*)KWL_MALLOC(sizeof(float) * numParameterSets,
+                                                       "kwlEngineData_loadMixPresetData");
+    data->mixPresetBlendPitch = (float*)KWL_MALLOC(sizeof(float) * numParameterSets,
+                                                   "kwlEngineData_loadMixPresetData");
+    data->mixPresetBlendRequested = 1;
+    
     return KWL_NO_ERROR;
 }
 
@@ -227,16 +839,27 @@ void kwlEngineData_freeMixPresetData(kwlEngineData* data)
     
     /*free any memory allocated per mix preset*/
     int i;
-    for (i = 0; i < numMixPresets; i++)
+    for (i = 0; i < numMixPresets && data->packedData == NULL; i++)
     {
         KWL_FREE(data->mixPresets[i].id);
-        KWL_FREE(data->mixPresets[i].parameterSets);
+        KWL_FREE(data->mixPresets[i].logGainLeft);
+        KWL_FREE(data->mixPresets[i].logGainRight);
+        KWL_FREE(data->mixPresets[i].pitch);
     }
     
     /*free the mix preset array*/
     KWL_FREE(data->mixPresets);
     data->mixPresets = NULL;
     data->numMixPresets = 0;
+    
+    /*free blending scratch buffers*/
+    KWL_FREE(data->mixPresetBlendGainLeft);
+    KWL_FREE(data->mixPresetBlendGainRight);
+    KWL_FREE(data->mixPresetBlendPitch);
+    data->mixPresetBlendGainLeft = NULL;
+    data->mixPresetBlendGainRight = NULL;
+    data->mixPresetBlendPitch = NULL;
+    data->mixPresetBlendRequested = 0;
 }
 
 kwlError kwlEngineData_loadWaveBankData(kwlEngineData* data, kwlInputStream* stream)
@@ -285,7 +908,7 @@ void kwlEngineData_freeWaveBankData(kwlEngineData* data)
     {
         const int numWaveBanks = data->numWaveBanks;
         int i;
-        for (i = 0; i < numWaveBanks; i++)
+        for (i = 0; i < numWaveBanks && data->packedData == NULL; i++)
         {
             KWL_FREE((void*)data->waveBanks[i].id);
         }
@@ -297,7 +920,7 @@ void kwlEngineData_freeWaveBankData(kwlEngineData* data)
     {
         const int numAudioDataEntries = data->totalNumAudioDataEntries;
         int i;
-        for (i = 0; i < numAudioDataEntries; i++)
+        for (i = 0; i < numAudioDataEntries && data->packedData == NULL; i++)
         {
             KWL_FREE((void*)data->audioDataEntries[i].filePath);
         }
@@ -362,7 +985,7 @@ void kwlEngineData_freeSoundData(kwlEngineData* data)
     }
     
     int i;
-    for (i = 0; i < data->numSoundDefinitions; i++)
+    for (i = 0; i < data->numSoundDefinitions && data->packedData == NULL; i++)
     {
         KWL_FREE(data->sounds[i].audioDataEntries);
     }
@@ -374,7 +997,8 @@ void kwlEngineData_freeSoundData(kwlEngineData* data)
 
 kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlInputStream* stream)
 {
-    kwlInputStream_seekToEngineDataChunk(stream, KWL_EVENTS_CHUNK_ID);
+    const int chunkSize = kwlInputStream_seekToEngineDataChunk(stream, KWL_EVENTS_CHUNK_ID);
+    const int chunkStart = kwlInputStream_tell(stream);
     KWL_ASSERT(data->sounds != NULL);
     KWL_ASSERT(data->events == NULL);
     KWL_ASSERT(data->eventDefinitions == NULL);
@@ -480,6 +1104,23 @@ kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlInputStream* stream
         }
     }
     
+    /*aux sends are stored as an optional trailing section, like the mix bus aux sends.*/
+    if (kwlInputStream_tell(stream) - chunkStart < chunkSize)
+    {
+        for (int i = 0; i < numEventDefinitions; i++)
+        {
+            kwlEventDefinition* definitioni = &data->eventDefinitions[i];
+            definitioni->auxSends = kwlEngineData_readAuxSends(data, stream, &definitioni->numAuxSends);
+            KWL_ASSERT((definitioni->numAuxSends == 0 || definitioni->mixBus->isAuxReturn == 0) &&
+                       "events in aux return buses can not have sends");
+            int j;
+            for (j = 0; j < definitioni->numAuxSends; j++)
+            {
+                KWL_ASSERT(definitioni->auxSends[j].returnBus->isAuxReturn != 0);
+            }
+        }
+    }
+    
     return KWL_NO_ERROR;
     
 }
@@ -499,8 +1140,15 @@ void kwlEngineData_freeEventData(kwlEngineData* data)
     {
         kwlEventDefinition* defi = &data->eventDefinitions[i];
         KWL_FREE(data->events[i]);
-        KWL_FREE(defi->referencedWaveBanks);
-        KWL_FREE(defi->id);
+        if (data->packedData == NULL)
+        {
+            KWL_FREE(defi->referencedWaveBanks);
+            KWL_FREE(defi->id);
+            if (defi->auxSends != NULL)
+            {
+                KWL_FREE(defi->auxSends);
+            }
+        }
     }
     
     KWL_FREE(data->events);
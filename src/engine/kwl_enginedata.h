@@ -52,6 +52,9 @@ struct kwlWaveBank;
 /** The ID of the mix preset data chunk in an engine data binary file. */
 #define KWL_MIX_PRESETS_CHUNK_ID 0x7270786d
     
+/** The default number of seconds it takes to fade to a mix preset, used for data without authored fade times. */
+#define KWL_DEFAULT_MIX_PRESET_FADE_TIME 1.0f
+    
 /** The ID of the wave bank data chunk in an engine data binary file. */
 #define KWL_WAVE_BANKS_CHUNK_ID 0x736b6277
     
@@ -64,6 +67,160 @@ static const char KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER[KWL_ENGINE_DATA_BINARY_
     0xAB, 'K', 'W', 'L', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
 };
     
+
+/** 
+ * The file identifier for packed engine data binaries, i.e the sequence of bytes
+ * that all packed engine data binary files start with.
+ * @see kwlPackedEngineDataHeader
+ */
+static const char KWL_PACKED_ENGINE_DATA_BINARY_FILE_IDENTIFIER[KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH] =
+{
+    0xAB, 'K', 'W', 'P', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+    
+/** The current version of the packed engine data binary layout.*/
+#define KWL_PACKED_ENGINE_DATA_VERSION 2
+    
+/**
+ * <p>The header of a packed engine data binary. Packed engine data is a 
+ * relocatable, little endian image that is loaded with a single bulk read followed
+ * by pointer fixup, as opposed to the chunked format that is parsed field by field.</p>
+ * <p>All offsets are byte offsets from the start of the file, except string offsets 
+ * which are relative to the start of the string blob. All sections except the 
+ * string blob consist of 32 bit words only, so the entire range between the end of 
+ * the file identifier and the start of the string blob can be byte swapped word by word 
+ * on big endian hosts. Each unique id or path is stored once in the string blob, 
+ * as a null terminated string.</p>
+ * <p>Section order: header, mix buses, mix presets, wave banks, audio data entries,
+ * sounds, event definitions, aux sends, indices, mix preset parameters, strings.</p>
+ */
+typedef struct kwlPackedEngineDataHeader
+{
+    /** \c KWL_PACKED_ENGINE_DATA_BINARY_FILE_IDENTIFIER followed by three zero bytes.*/
+    char identifier[12];
+    /** The layout version, see \c KWL_PACKED_ENGINE_DATA_VERSION.*/
+    int version;
+    /** The total size of the file in bytes.*/
+    int fileSize;
+    int numMixBuses;
+    int mixBusesOffset;
+    int numMixPresets;
+    int mixPresetsOffset;
+    int numWaveBanks;
+    int waveBanksOffset;
+    int numAudioDataEntries;
+    int audioDataEntriesOffset;
+    int numSoundDefinitions;
+    int soundDefinitionsOffset;
+    int numEventDefinitions;
+    int eventDefinitionsOffset;
+    /** The number of aux sends referenced by mix buses and event definitions.*/
+    int numAuxSends;
+    int auxSendsOffset;
+    /** The number of entries in the shared array of int32 indices referenced by other records.*/
+    int numIndices;
+    int indicesOffset;
+    /** The number of float32 mix preset parameters, 3 per mix bus and preset.*/
+    int numMixPresetParameters;
+    int mixPresetParametersOffset;
+    int stringsSize;
+    int stringsOffset;
+} kwlPackedEngineDataHeader;
+
+/** A mix bus record in a packed engine data binary.*/
+typedef struct kwlPackedMixBus
+{
+    int idOffset;
+    int numSubBuses;
+    /** The index into the index array of the first sub bus index.*/
+    int firstSubBusIndex;
+    /** Non-zero if this is an aux return bus.*/
+    int isAuxReturn;
+    int numAuxSends;
+    /** The index into the aux send array of the first aux send of the bus.*/
+    int firstAuxSend;
+} kwlPackedMixBus;
+
+/** An aux send record in a packed engine data binary.*/
+typedef struct kwlPackedAuxSend
+{
+    /** The index of the aux return bus fed by the send.*/
+    int returnBusIndex;
+    float level;
+} kwlPackedAuxSend;
+
+/** 
+ * A mix preset record in a packed engine data binary. The parameters
+ * are stored as three arrays (left gain, right gain, pitch) of one float per mix bus,
+ * in mix bus index order.
+ */
+typedef struct kwlPackedMixPreset
+{
+    int idOffset;
+    int isDefault;
+    float fadeTime;
+    /** The index into the mix preset parameter array of the first parameter.*/
+    int firstParameterIndex;
+} kwlPackedMixPreset;
+
+/** A wave bank record in a packed engine data binary.*/
+typedef struct kwlPackedWaveBank
+{
+    int idOffset;
+    int numAudioDataEntries;
+    /** The index of the first audio data entry of the wave bank.*/
+    int firstAudioDataEntry;
+} kwlPackedWaveBank;
+
+/** An audio data entry record in a packed engine data binary.*/
+typedef struct kwlPackedAudioData
+{
+    int filePathOffset;
+} kwlPackedAudioData;
+
+/** 
+ * A sound definition record in a packed engine data binary. Audio data entries
+ * are referenced by their index in the audio data entry array.
+ */
+typedef struct kwlPackedSoundDefinition
+{
+    int playbackCount;
+    int deferStop;
+    float gain;
+    float gainVariation;
+    float pitch;
+    float pitchVariation;
+    int playbackMode;
+    int numAudioDataEntries;
+    /** The index into the index array of the first audio data entry index.*/
+    int firstAudioDataEntryIndex;
+} kwlPackedSoundDefinition;
+
+/** An event definition record in a packed engine data binary.*/
+typedef struct kwlPackedEventDefinition
+{
+    int idOffset;
+    int instanceCount;
+    float gain;
+    float pitch;
+    float innerConeAngleDeg;
+    float outerConeAngleDeg;
+    float outerConeGain;
+    int mixBusIndex;
+    int isPositional;
+    /** The index of the sound of the event, or -1 for streaming events.*/
+    int soundIndex;
+    int retriggerMode;
+    /** The index of the audio data entry to stream, or -1 for non-streaming events.*/
+    int streamAudioDataEntry;
+    int loopIfStreaming;
+    int numReferencedWaveBanks;
+    /** The index into the index array of the first referenced wave bank index.*/
+    int firstReferencedWaveBankIndex;
+    int numAuxSends;
+    /** The index into the aux send array of the first aux send of the event.*/
+    int firstAuxSend;
+} kwlPackedEventDefinition;
     
 /**
  * A struct containing engine data loaded from a binary file.
@@ -87,8 +244,17 @@ typedef struct kwlEngineData
     int numMixPresets;
     /** An array of mix presets. */
     kwlMixPreset* mixPresets;
-    /** The number of seconds it takes to fade between mix presets.*/
+    /** The number of seconds it takes to fade to the currently active mix preset.*/
     float mixPresetFadeTime;
+    /** 
+     * Non-zero if the mix preset weights have changed since the last blend, 
+     * i.e if the mix preset parameters of the mix buses need to be recomputed.
+     */
+    int mixPresetBlendRequested;
+    /** Scratch buffers used when blending mix presets, \c numMixBuses floats each.*/
+    float* mixPresetBlendGainLeft;
+    float* mixPresetBlendGainRight;
+    float* mixPresetBlendPitch;
     
     /** The total number of audio data entries. */
     int totalNumAudioDataEntries;
@@ -107,6 +273,20 @@ typedef struct kwlEngineData
     /** An array of sound definitions. */
     struct kwlSoundDefinition* sounds;
     
+    /** 
+     * The image of the packed engine data binary this data was loaded from, 
+     * or NULL if it was loaded from a chunked binary. Ids, paths and mix preset
+     * parameters point into this buffer when it is not NULL.
+     */
+    void* packedData;
+    /** 
+     * A pool of pointers that sub bus, sound audio data and referenced wave bank arrays
+     * point into when loading packed data. NULL otherwise.
+     */
+    void** packedPointerPool;
+    /** The aux sends of all mix buses and event definitions when loading packed data. NULL otherwise.*/
+    kwlAuxSend* packedAuxSends;
+    
 } kwlEngineData;
 
 /** */
@@ -115,6 +295,16 @@ kwlError kwlEngineData_load(kwlEngineData* data, kwlInputStream* stream);
 /** */
 void kwlEngineData_unload(kwlEngineData* data);
     
+/** 
+ * Sets up engine data from the image of a packed engine data binary. On success, 
+ * the engine data takes ownership of \c buffer.
+ * @param data The engine data to set up.
+ * @param buffer The packed engine data binary image, allocated with \c KWL_MALLOC.
+ * @param size The size in bytes of \c buffer.
+ * @return \c KWL_CORRUPT_BINARY_DATA if the image is malformed, \c KWL_NO_ERROR otherwise.
+ */
+kwlError kwlEngineData_loadPacked(kwlEngineData* data, void* buffer, int size);
+    
 /** */
 kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlInputStream* stream);
 
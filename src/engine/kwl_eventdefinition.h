@@ -99,6 +99,10 @@ typedef struct kwlEventDefinition
      * stop before unloading a given wavebank. Accessed from the mixer thread.
      */
     kwlWaveBank** referencedWaveBanks;
+    /** The number of aux sends of the event output.*/
+    int numAuxSends;
+    /** The sends of the event output, after the event gain, to aux return buses. Accessed from the mixer thread.*/
+    struct kwlAuxSend* auxSends;
 } kwlEventDefinition;
 
 void kwlEventDefinition_init(kwlEventDefinition* eventDefinition);
@@ -63,6 +63,7 @@ void kwlEventInstance_init(kwlEventInstance* event)
     event->fadeGain = 1.0f;
     event->soundPitch = 1.0f;
     event->playbackState = KWL_STOPPED;
+    event->isDirty = 1;
 }
 
 void kwlEventInstance_start(kwlEventInstance* event)
@@ -251,12 +252,16 @@ int kwlEventInstance_getNumRemainingOutFrames(kwlEventInstance* event, float pit
     }
 }
 
-int kwlEventInstance_render(kwlEventInstance* event, 
-                    float* outBuffer,
-                    const int numOutChannels,
-                    const int numFrames,
-                    const float accumulatedBusPitch)
+int kwlEventInstance_renderSource(kwlEventInstance* event, 
+                                  float* outBuffer,
+                                  const int numOutChannels,
+                                  const int numFrames,
+                                  const float accumulatedBusPitch,
+                                  kwlMixerCPUCost* cpuCost,
+                                  int* needsPostProcessing)
 {
+    *needsPostProcessing = 0;
+    
     /* initial playback logic checks */
     {
         if (event->playbackState == KWL_STOP_AND_UNLOAD_REQUESTED)
@@ -432,7 +437,13 @@ int kwlEventInstance_render(kwlEventInstance* event,
             else if (event->decoder != NULL)
             {
                 /*decode the next buffer*/
+                const long long decodingStart = cpuCost != NULL ? kwlCPUCost_getTicks() : 0;
                 donePlaying = kwlDecoder_decodeNewBufferForEvent(event->decoder, event);
+                if (cpuCost != NULL)
+                {
+                    cpuCost->decoderTicks.valueMixer += kwlCPUCost_getTicks() - decodingStart;
+                    cpuCost->numDecoderRefills.valueMixer++;
+                }
             }
             else
             {
@@ -462,16 +473,15 @@ int kwlEventInstance_render(kwlEventInstance* event,
         }
     }
     
-    /*Feed final event output through the event DSP unit, if any.*/
-    kwlDSPUnit* dspUnit = (kwlDSPUnit*)event->dspUnit.valueMixer;
-    if (dspUnit != NULL)
-    {
-        (*dspUnit->dspCallback)(outBuffer,
-                                numOutChannels,
-                                numFrames, 
-                                dspUnit->data);
-    }
-    
+    *needsPostProcessing = 1;
+    return donePlaying;
+}
+
+void kwlEventInstance_applyGain(kwlEventInstance* event,
+                                float* outBuffer,
+                                const int numOutChannels,
+                                const int numFrames)
+{
     /* Apply per buffer gain with ramps if necessary*/
     {
         float effectiveGain[2] = 
@@ -495,6 +505,32 @@ int kwlEventInstance_render(kwlEventInstance* event,
         event->prevEffectiveGain[0] = effectiveGain[0];
         event->prevEffectiveGain[1] = effectiveGain[1];
     }
+}
+
+int kwlEventInstance_render(kwlEventInstance* event, 
+                    float* outBuffer,
+                    const int numOutChannels,
+                    const int numFrames,
+                    const float accumulatedBusPitch,
+                    kwlMixerCPUCost* cpuCost)
+{
+    int needsPostProcessing = 0;
+    const int donePlaying = kwlEventInstance_renderSource(event, 
+                                                          outBuffer, 
+                                                          numOutChannels, 
+                                                          numFrames, 
+                                                          accumulatedBusPitch, 
+                                                          cpuCost, 
+                                                          &needsPostProcessing);
+    if (needsPostProcessing == 0)
+    {
+        return donePlaying;
+    }
+    
+    /*Feed final event output through the event DSP units, if any.*/
+    kwlDSPChain_process(&event->dspChain, outBuffer, numOutChannels, numFrames, cpuCost);
+    
+    kwlEventInstance_applyGain(event, outBuffer, numOutChannels, numFrames);
     
     return donePlaying;
 }
@@ -26,7 +26,9 @@ freely, subject to the following restrictions:
 
 /*! \file */ 
 
+#include "kwl_cpucost.h"
 #include "kwl_decoder.h"
+#include "kwl_dspchain.h"
 #include "kwl_eventdefinition.h"
 #include "kwl_synchronization.h"
 #include "kwl_sounddefinition.h"
@@ -74,8 +76,15 @@ typedef struct kwlEventInstance
     kwlSharedFloat gainRight;
     /** The effective pitch value. */
     kwlSharedFloat pitch;
-    /** The DSP unit that the output of this event is fed through. Ignored if NULL.*/
-    kwlSharedVoidPointer dspUnit;
+    /** The DSP units that the output of this event is fed through.*/
+    kwlDSPChain dspChain;
+    
+    //mixer->engine
+    /** 
+     * The time spent rendering this event, including decoding and DSP, in clock ticks. 
+     * Only measured when CPU profiling is enabled.
+     */
+    kwlSharedLongLong cpuTicks;
 
     
     
@@ -133,6 +142,11 @@ typedef struct kwlEventInstance
     kwlEventPlaybackState playbackState;
     /** Non-zero if the event is currently playing, zero otherwise. Accessed only from the engine thread.*/
     char isPlaying;
+    /** 
+     * Non-zero if any parameter affecting the effective gain or pitch of the event has
+     * changed since the last engine update. Accessed only from the engine thread.
+     */
+    char isDirty;
         
     /** The buffer that the event is currently getting its audio from.*/
     short* currentPCMBuffer;
@@ -161,6 +175,11 @@ typedef struct kwlEventInstance
     kwlEventStoppedCallack stoppedCallback;
     /** A pointer to pass to the event stopped callback.*/
     void* stoppedCallbackUserData;
+    /** 
+     * The state of the random number generator used for picking audio data and pitch and
+     * gain variations. Seeded by the engine when the event is started.
+     */
+    unsigned int randomState;
     
 } kwlEventInstance;
 
@@ -201,14 +220,41 @@ void kwlEventInstance_releaseFreeformEvent(kwlEventInstance* event);
  */
 int kwlEventInstance_getNumRemainingOutFrames(kwlEventInstance* event, float pitch);    
 
+/**
+ * Renders the next buffer of an event without applying the event DSP unit and gain. 
+ * @param cpuCost The CPU cost totals to add decoding costs to, or NULL if
+ * CPU profiling is disabled.
+ * @param needsPostProcessing Set to non-zero if the buffer was rendered and should be 
+ * fed through the event DSP units and \c kwlEventInstance_applyGain, or to zero if 
+ * the event is paused or stopped before producing any output.
+ * @return Non-zero if the event finished playing, zero otherwise.
+ */
+int kwlEventInstance_renderSource(kwlEventInstance* event, 
+                                  float* outBuffer,
+                                  const int numOutChannels,
+                                  const int numFrames,
+                                  float accumulatedBusPitch,
+                                  kwlMixerCPUCost* cpuCost,
+                                  int* needsPostProcessing);
+
+/** Applies the gain of an event, ramping from the gain of the previous buffer. */
+void kwlEventInstance_applyGain(kwlEventInstance* event,
+                                float* outBuffer,
+                                const int numOutChannels,
+                                const int numFrames);
+
 /** 
- * 
+ * Renders the next buffer of an event.
+ * @param cpuCost The CPU cost totals to add decoding and DSP costs to, or NULL if
+ * CPU profiling is disabled.
+ * @return Non-zero if the event finished playing, zero otherwise.
  */
 int kwlEventInstance_render(kwlEventInstance* event, 
                     float* outBuffer,
                     const int numOutChannels,
                     const int numFrames,
-                    float accumulatedBusPitch);
+                    float accumulatedBusPitch,
+                    kwlMixerCPUCost* cpuCost);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,248 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_fft.h"
+#include "kwl_asm.h"
+#include "kwl_assert.h"
+#include "kwl_memory.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void kwlFFT_init(kwlFFT* fft, int size)
+{
+    KWL_ASSERT(size >= 4 && (size & (size - 1)) == 0 && "FFT size must be a power of two");
+    
+    const int m = size / 2;
+    fft->size = size;
+    fft->halfSize = m;
+    fft->bitReversal = (int*)KWL_MALLOC(m * sizeof(int), "FFT bit reversal table");
+    fft->twiddles = (float*)KWL_MALLOC(2 * m * sizeof(float), "FFT twiddles");
+    fft->realTwiddles = (float*)KWL_MALLOC(2 * (m / 2 + 1) * sizeof(float), "FFT real twiddles");
+    fft->scratch = (float*)KWL_MALLOCANDZERO(size * sizeof(float), "FFT scratch");
+    
+    int numBits = 0;
+    while ((1 << numBits) < m)
+    {
+        numBits++;
+    }
+    for (int i = 0; i < m; i++)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < numBits; bit++)
+        {
+            reversed |= ((i >> bit) & 1) << (numBits - 1 - bit);
+        }
+        fft->bitReversal[i] = reversed;
+    }
+    
+    /*the twiddles of each stage are stored after the ones of the previous, shorter stage.*/
+    float* twiddle = fft->twiddles;
+    for (int length = 2; length <= m; length *= 2)
+    {
+        for (int k = 0; k < length / 2; k++)
+        {
+            const double angle = -2.0 * M_PI * k / length;
+            *twiddle++ = (float)cos(angle);
+            *twiddle++ = (float)sin(angle);
+        }
+    }
+    
+    for (int k = 0; k <= m / 2; k++)
+    {
+        const double angle = -2.0 * M_PI * k / size;
+        fft->realTwiddles[2 * k] = (float)cos(angle);
+        fft->realTwiddles[2 * k + 1] = (float)sin(angle);
+    }
+}
+
+void kwlFFT_free(kwlFFT* fft)
+{
+    KWL_FREE(fft->bitReversal);
+    KWL_FREE(fft->twiddles);
+    KWL_FREE(fft->realTwiddles);
+    KWL_FREE(fft->scratch);
+    kwlMemset(fft, 0, sizeof(kwlFFT));
+}
+
+/** 
+ * An in-place radix 2 decimation in time FFT of N/2 interleaved complex samples. 
+ * The inverse transform is unnormalized.
+ */
+static void kwlFFT_transformComplex(const kwlFFT* fft, float* data, int inverse)
+{
+    const int m = fft->halfSize;
+    for (int i = 0; i < m; i++)
+    {
+        const int j = fft->bitReversal[i];
+        if (j > i)
+        {
+            const float re = data[2 * i];
+            const float im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+    
+    const float sign = inverse ? -1.0f : 1.0f;
+    const float* twiddles = fft->twiddles;
+    for (int length = 2; length <= m; length *= 2)
+    {
+        const int half = length / 2;
+        for (int start = 0; start < m; start += length)
+        {
+            float* a = &data[2 * start];
+            float* b = &data[2 * (start + half)];
+            for (int k = 0; k < half; k++)
+            {
+                const float wr = twiddles[2 * k];
+                const float wi = sign * twiddles[2 * k + 1];
+                const float tr = wr * b[2 * k] - wi * b[2 * k + 1];
+                const float ti = wr * b[2 * k + 1] + wi * b[2 * k];
+                b[2 * k] = a[2 * k] - tr;
+                b[2 * k + 1] = a[2 * k + 1] - ti;
+                a[2 * k] += tr;
+                a[2 * k + 1] += ti;
+            }
+        }
+        twiddles += 2 * half;
+    }
+}
+
+void kwlFFT_forward(kwlFFT* fft, const float* input, float* spectrum)
+{
+    const int m = fft->halfSize;
+    float* z = fft->scratch;
+    
+    /*even and odd samples become the real and imaginary parts of a half size complex signal.*/
+    kwlMemcpy(z, input, fft->size * sizeof(float));
+    kwlFFT_transformComplex(fft, z, 0);
+    
+    float* re = spectrum;
+    float* im = &spectrum[m];
+    re[0] = z[0] + z[1];
+    im[0] = z[0] - z[1];
+    
+    /*separate the spectra of the even and odd samples and combine them into bins k and N/2 - k.*/
+    for (int k = 1; k <= m / 2; k++)
+    {
+        const int mk = m - k;
+        const float er = 0.5f * (z[2 * k] + z[2 * mk]);
+        const float ei = 0.5f * (z[2 * k + 1] - z[2 * mk + 1]);
+        const float odr = 0.5f * (z[2 * k + 1] + z[2 * mk + 1]);
+        const float odi = -0.5f * (z[2 * k] - z[2 * mk]);
+        const float wr = fft->realTwiddles[2 * k];
+        const float wi = fft->realTwiddles[2 * k + 1];
+        const float tr = wr * odr - wi * odi;
+        const float ti = wr * odi + wi * odr;
+        re[k] = er + tr;
+        im[k] = ei + ti;
+        re[mk] = er - tr;
+        im[mk] = ti - ei;
+    }
+}
+
+void kwlFFT_inverse(kwlFFT* fft, const float* spectrum, float* output)
+{
+    const int m = fft->halfSize;
+    float* z = fft->scratch;
+    const float* re = spectrum;
+    const float* im = &spectrum[m];
+    
+    z[0] = re[0] + im[0];
+    z[1] = re[0] - im[0];
+    
+    /*recombine bins k and N/2 - k into the spectrum of the half size complex signal.*/
+    for (int k = 1; k <= m / 2; k++)
+    {
+        const int mk = m - k;
+        const float er = re[k] + re[mk];
+        const float ei = im[k] - im[mk];
+        const float dr = re[k] - re[mk];
+        const float di = im[k] + im[mk];
+        const float wr = fft->realTwiddles[2 * k];
+        const float wi = fft->realTwiddles[2 * k + 1];
+        const float odr = wr * dr + wi * di;
+        const float odi = wr * di - wi * dr;
+        z[2 * k] = er - odi;
+        z[2 * k + 1] = ei + odr;
+        z[2 * mk] = er + odi;
+        z[2 * mk + 1] = odr - ei;
+    }
+    
+    kwlFFT_transformComplex(fft, z, 1);
+    kwlMemcpy(output, z, fft->size * sizeof(float));
+}
+
+void kwlFFT_multiplyAccumulate(const kwlFFT* fft, const float* a, const float* b, float* sum)
+{
+    const int m = fft->halfSize;
+    const float* ar = a;
+    const float* ai = &a[m];
+    const float* br = b;
+    const float* bi = &b[m];
+    float* sr = sum;
+    float* si = &sum[m];
+    
+    /*bins 0 and N/2 are real and packed into the first complex bin.*/
+    const float dc = sr[0] + ar[0] * br[0];
+    const float nyquist = si[0] + ai[0] * bi[0];
+    
+    int i = 0;
+#if KWL_SSE
+    for (; i + 4 <= m; i += 4)
+    {
+        const __m128 var = _mm_loadu_ps(&ar[i]);
+        const __m128 vai = _mm_loadu_ps(&ai[i]);
+        const __m128 vbr = _mm_loadu_ps(&br[i]);
+        const __m128 vbi = _mm_loadu_ps(&bi[i]);
+        const __m128 re = _mm_sub_ps(_mm_mul_ps(var, vbr), _mm_mul_ps(vai, vbi));
+        const __m128 im = _mm_add_ps(_mm_mul_ps(var, vbi), _mm_mul_ps(vai, vbr));
+        _mm_storeu_ps(&sr[i], _mm_add_ps(_mm_loadu_ps(&sr[i]), re));
+        _mm_storeu_ps(&si[i], _mm_add_ps(_mm_loadu_ps(&si[i]), im));
+    }
+#elif KWL_NEON
+    for (; i + 4 <= m; i += 4)
+    {
+        const float32x4_t var = vld1q_f32(&ar[i]);
+        const float32x4_t vai = vld1q_f32(&ai[i]);
+        const float32x4_t vbr = vld1q_f32(&br[i]);
+        const float32x4_t vbi = vld1q_f32(&bi[i]);
+        vst1q_f32(&sr[i], vmlsq_f32(vmlaq_f32(vld1q_f32(&sr[i]), var, vbr), vai, vbi));
+        vst1q_f32(&si[i], vmlaq_f32(vmlaq_f32(vld1q_f32(&si[i]), var, vbi), vai, vbr));
+    }
+#endif
+    for (; i < m; i++)
+    {
+        sr[i] += ar[i] * br[i] - ai[i] * bi[i];
+        si[i] += ar[i] * bi[i] + ai[i] * br[i];
+    }
+    
+    sr[0] = dc;
+    si[0] = nyquist;
+}
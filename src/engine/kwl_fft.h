@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef KWL_FFT_H
+#define KWL_FFT_H
+
+/*! \file */ 
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * Precomputed tables for real valued FFTs of a given power of two size N. 
+ * A real signal of N samples is transformed as a complex signal of N/2 samples,
+ * with twiddle factors stored stage by stage so that every butterfly pass 
+ * reads its twiddles sequentially.
+ * <p>
+ * Spectra are stored in split format as N/2 real parts followed by N/2 imaginary 
+ * parts. Bins 0 and N/2 are both real, so the real part of bin N/2 is stored in 
+ * place of the imaginary part of bin 0.
+ */
+typedef struct kwlFFT
+{
+    /** The number of real samples N. */
+    int size;
+    /** The number of complex samples N/2. */
+    int halfSize;
+    /** The bit reversal permutation of the complex samples. */
+    int* bitReversal;
+    /** Interleaved complex twiddle factors of all butterfly stages. */
+    float* twiddles;
+    /** Interleaved complex twiddle factors used to split the complex transform into a real one. */
+    float* realTwiddles;
+    /** N floats of scratch space holding interleaved complex samples. */
+    float* scratch;
+} kwlFFT;
+
+/**
+ * Initializes the tables for FFTs of a given size.
+ * @param fft The FFT to initialize.
+ * @param size The number of real samples, a power of two of at least 4.
+ */
+void kwlFFT_init(kwlFFT* fft, int size);
+
+/** Frees the tables of an FFT. */
+void kwlFFT_free(kwlFFT* fft);
+
+/**
+ * Computes the spectrum of N real samples.
+ * @param fft The FFT to use.
+ * @param input N real samples.
+ * @param spectrum N floats receiving the spectrum in split format.
+ */
+void kwlFFT_forward(kwlFFT* fft, const float* input, float* spectrum);
+
+/**
+ * Computes the unnormalized inverse of \c kwlFFT_forward, i.e N times the original samples.
+ * @param fft The FFT to use.
+ * @param spectrum N floats holding a spectrum in split format.
+ * @param output N floats receiving the real samples.
+ */
+void kwlFFT_inverse(kwlFFT* fft, const float* spectrum, float* output);
+
+/**
+ * Multiplies two spectra bin by bin and adds the products to a third one.
+ * @param fft The FFT the spectra were computed with.
+ * @param a A spectrum in split format.
+ * @param b A spectrum in split format.
+ * @param sum The spectrum to add the products to.
+ */
+void kwlFFT_multiplyAccumulate(const kwlFFT* fft, const float* a, const float* b, float* sum);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_FFT_H*/
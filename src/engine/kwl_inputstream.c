@@ -29,6 +29,9 @@ freely, subject to the following restrictions:
 #ifdef _WIN32
 #include <stdlib.h>
 #include <fcntl.h>
+#else
+#include <errno.h>
+#include <unistd.h>
 #endif
 
 void kwlInputStream_free(kwlInputStream* stream)
@@ -44,6 +47,12 @@ void kwlInputStream_init(kwlInputStream* stream)
     stream->offset = 0;
     stream->readPos = 0;
     stream->buffer = NULL;
+    stream->fileSize = 0;
+    stream->readAheadAllocation = NULL;
+    stream->readAheadBuffer = NULL;
+    stream->readAheadCapacity = 0;
+    stream->readAheadStart = 0;
+    stream->readAheadLength = 0;
 }
 
 FILE* kwlInputStream_openFile(kwlInputStream* stream, const char* const path)
@@ -57,22 +66,84 @@ FILE* kwlInputStream_openFile(kwlInputStream* stream, const char* const path)
 #endif
 }
 
+/**
+ * Reads a number of bytes from a given position in the file of a stream, without
+ * going through the stdio buffer or the file position.
+ */
+static int kwlInputStream_readFileAt(kwlInputStream* const stream, char* data, int position, int length)
+{
+#ifdef _WIN32
+    if (fseek(stream->file, position, SEEK_SET) != 0)
+    {
+        return 0;
+    }
+    return (int)fread(data, 1, length, stream->file);
+#else
+    const int fd = fileno(stream->file);
+    int totalBytesRead = 0;
+    while (totalBytesRead < length)
+    {
+        const ssize_t bytesRead = pread(fd, &data[totalBytesRead], length - totalBytesRead, position + totalBytesRead);
+        if (bytesRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (bytesRead <= 0)
+        {
+            break;
+        }
+        totalBytesRead += (int)bytesRead;
+    }
+    return totalBytesRead;
+#endif
+}
+
+/**
+ * Returns the file position of the end of a file based stream.
+ */
+static int kwlInputStream_getFileEndPos(kwlInputStream* const stream)
+{
+    return stream->size < 0 ? stream->fileSize : stream->offset + stream->size;
+}
+
+/**
+ * Opens the file of a file based stream and sets up the read-ahead buffer.
+ */
+static kwlError kwlInputStream_initFileStream(kwlInputStream* const stream, const char* const path)
+{
+    stream->file = kwlInputStream_openFile(stream, path);
+    if (stream->file == NULL)
+    {
+        return KWL_FILE_NOT_FOUND;
+    }
+    
+    /*all reads go through kwlInputStream_readFileAt, so stdio buffering would only add a copy*/
+    setvbuf(stream->file, NULL, _IONBF, 0);
+    
+    fseek(stream->file, 0, SEEK_END);
+    stream->fileSize = (int)ftell(stream->file);
+    fseek(stream->file, 0, SEEK_SET);
+    
+    kwlInputStream_setReadAheadBufferSize(stream, KWL_INPUT_STREAM_READ_AHEAD_BUFFER_SIZE);
+    
+    return KWL_NO_ERROR;
+}
+
 /** */
 kwlError kwlInputStream_initWithFile(kwlInputStream* const stream, const char* const path)
 {
     kwlInputStream_init(stream);
     
-    stream->file = kwlInputStream_openFile(stream, path);
-    if (stream->file == NULL)
+    kwlError result = kwlInputStream_initFileStream(stream, path);
+    if (result != KWL_NO_ERROR)
     {
-        return KWL_FILE_NOT_FOUND;
+        return result;
     }
     
     stream->size = -1; /*negative size signals that the size is unknown*/
     stream->offset = 0;
     stream->readPos = 0;
     stream->buffer = NULL;
-    fseek(stream->file, stream->offset, SEEK_SET);
      
     return KWL_NO_ERROR;
 }
@@ -83,21 +154,48 @@ kwlError kwlInputStream_initWithFileRegion(kwlInputStream* const stream, const c
     KWL_ASSERT(size > 0);
     KWL_ASSERT(offset >= 0);
     
-    stream->file = kwlInputStream_openFile(stream, path);
-    if (stream->file == NULL)
+    kwlError result = kwlInputStream_initFileStream(stream, path);
+    if (result != KWL_NO_ERROR)
     {
-        return KWL_FILE_NOT_FOUND;
+        return result;
     }
     
     stream->size = size;
     stream->offset = offset;
     stream->readPos = offset;
     stream->buffer = NULL;
-    fseek(stream->file, stream->offset, SEEK_SET);
 
     return KWL_NO_ERROR;
 }
 
+void kwlInputStream_setReadAheadBufferSize(kwlInputStream* const stream, int size)
+{
+    KWL_ASSERT(size >= 0);
+    if (stream->file == NULL || size == stream->readAheadCapacity)
+    {
+        return;
+    }
+    
+    if (stream->readAheadAllocation != NULL)
+    {
+        KWL_FREE(stream->readAheadAllocation);
+    }
+    
+    stream->readAheadAllocation = NULL;
+    stream->readAheadBuffer = NULL;
+    stream->readAheadCapacity = 0;
+    stream->readAheadStart = 0;
+    stream->readAheadLength = 0;
+    
+    if (size > 0)
+    {
+        const size_t alignmentMask = KWL_INPUT_STREAM_READ_AHEAD_MEMORY_ALIGNMENT - 1;
+        stream->readAheadAllocation = (char*)KWL_MALLOC(size + alignmentMask, "input stream read-ahead buffer");
+        stream->readAheadBuffer = (char*)(((size_t)stream->readAheadAllocation + alignmentMask) & ~alignmentMask);
+        stream->readAheadCapacity = size;
+    }
+}
+
 void kwlInputStream_initWithBuffer(kwlInputStream* const stream, void* buffer, int offset, int size)
 {
     kwlInputStream_init(stream);
@@ -115,9 +213,12 @@ void kwlInputStream_skip(kwlInputStream* const stream, size_t size)
 {
     if (stream->file != NULL && stream->buffer == NULL)
     {
-        KWL_ASSERT(stream->file != NULL);
-        fseek(stream->file, size, SEEK_CUR);
-        stream->readPos = ftell(stream->file);
+        const int endPos = kwlInputStream_getFileEndPos(stream);
+        stream->readPos += size;
+        if (stream->readPos > endPos)
+        {
+            stream->readPos = endPos;
+        }
     }
     else if (stream->file == NULL && stream->buffer != NULL)
     {
@@ -139,7 +240,7 @@ void kwlInputStream_reset(kwlInputStream* const stream)
 {
     if (stream->file != NULL && stream->buffer == NULL)
     {
-        fseek(stream->file, stream->offset, SEEK_SET);
+        stream->readPos = stream->offset;
     }
     else if (stream->file == NULL && stream->buffer != NULL)
     {
@@ -156,14 +257,7 @@ int kwlInputStream_isAtEndOfStream(kwlInputStream* const stream)
 {
     if (stream->file != NULL && stream->buffer == NULL)
     {
-        if (stream->size < 0)
-        {
-            return feof(stream->file);
-        }
-        else 
-        {
-            return stream->readPos >= stream->offset + stream->size;
-        }
+        return stream->readPos >= kwlInputStream_getFileEndPos(stream);
     }
     else if (stream->file == NULL && stream->buffer != NULL)
     {
@@ -180,7 +274,7 @@ int kwlInputStream_tell(kwlInputStream* const stream)
 {
     if (stream->file != NULL && stream->buffer == NULL)
     {
-        return ftell(stream->file) - stream->offset;
+        return stream->readPos - stream->offset;
     }
     else if (stream->file == NULL && stream->buffer != NULL)
     {
@@ -198,34 +292,31 @@ int kwlInputStream_seek(kwlInputStream* const stream, long pos, int p)
 {
     if (stream->file != NULL && stream->buffer == NULL)
     {
+        /*file positions are tracked by the stream, so seeking never touches the file.*/
+        long newPos = 0;
         if (p == SEEK_SET)
         {
-            stream->readPos = stream->offset + pos;
-            return fseek(stream->file, stream->offset + pos, p);
+            newPos = stream->offset + pos;
         }
         else if (p == SEEK_CUR)
         {
-            return fseek(stream->file, pos, p);
+            newPos = stream->readPos + pos;
         }
         else if (p == SEEK_END)
         {
-            if (stream->size < 0)
-            {
-                /*if the size is unknown, assume we're getting data from a file*/
-                fseek(stream->file, pos, p);
-            }
-            else
-            {
-                /*if we're getting data from file region, first go to the end of the region...*/
-                fseek(stream->file, stream->offset + stream->size, SEEK_SET);
-                /*then seek relative to the current position (ie the end).*/
-                fseek(stream->file, pos, SEEK_CUR);
-            }
+            newPos = kwlInputStream_getFileEndPos(stream) + pos;
         }        
         else
         {
             KWL_ASSERT(0);
+            return -1;
         }
+        
+        if (newPos < stream->offset)
+        {
+            return -1;
+        }
+        stream->readPos = (int)newPos;
     }
     else if (stream->file == NULL && stream->buffer != NULL)
     {
@@ -260,25 +351,86 @@ int kwlInputStream_seek(kwlInputStream* const stream, long pos, int p)
     return 0;
 }
 
-int kwlInputStream_read(kwlInputStream* const stream, signed char* data, int length)
+/**
+ * Reads bytes from a file based stream, serving small reads from the read-ahead 
+ * buffer and passing large reads straight to the file.
+ */
+static int kwlInputStream_readFromFile(kwlInputStream* const stream, char* data, int length)
 {
-    if (stream->file != NULL && stream->buffer == NULL)
+    int bytesToRead = kwlInputStream_getFileEndPos(stream) - stream->readPos;
+    if (bytesToRead > length)
     {
-        int bytesToRead = length;
-        
-        /*Don't read past the end of streams with a known size*/
-        if (stream->readPos + length > stream->offset + stream->size && 
-            stream->size > 0)
+        bytesToRead = length;
+    }
+    if (bytesToRead <= 0)
+    {
+        return 0;
+    }
+    
+    int bytesRead = 0;
+    
+    /*copy whatever part of the request is already buffered*/
+    const int bufferEnd = stream->readAheadStart + stream->readAheadLength;
+    if (stream->readPos >= stream->readAheadStart && stream->readPos < bufferEnd)
+    {
+        int numBufferedBytes = bufferEnd - stream->readPos;
+        if (numBufferedBytes > bytesToRead)
         {
-            bytesToRead = stream->offset + stream->size - stream->readPos;
-            KWL_ASSERT(bytesToRead >= 0);
+            numBufferedBytes = bytesToRead;
         }
-        
-        /* File based stream.*/
-        int bytesRead = fread(data, 1, bytesToRead, stream->file);
-        stream->readPos += bytesRead;
+        kwlMemcpy(data, &stream->readAheadBuffer[stream->readPos - stream->readAheadStart], numBufferedBytes);
+        stream->readPos += numBufferedBytes;
+        bytesRead += numBufferedBytes;
+    }
+    
+    const int bytesLeft = bytesToRead - bytesRead;
+    if (bytesLeft == 0)
+    {
         return bytesRead;
     }
+    
+    if (bytesLeft >= stream->readAheadCapacity)
+    {
+        /*bulk read, bypass the read-ahead buffer*/
+        const int n = kwlInputStream_readFileAt(stream, &data[bytesRead], stream->readPos, bytesLeft);
+        stream->readPos += n;
+        return bytesRead + n;
+    }
+    
+    /*refill the read-ahead buffer from an aligned file position, if the request still fits*/
+    int fillStart = stream->readPos & ~(KWL_INPUT_STREAM_READ_AHEAD_FILE_ALIGNMENT - 1);
+    if (stream->readPos - fillStart + bytesLeft > stream->readAheadCapacity)
+    {
+        fillStart = stream->readPos;
+    }
+    stream->readAheadStart = fillStart;
+    stream->readAheadLength = kwlInputStream_readFileAt(stream, 
+                                                        stream->readAheadBuffer, 
+                                                        fillStart, 
+                                                        stream->readAheadCapacity);
+    
+    int numAvailableBytes = fillStart + stream->readAheadLength - stream->readPos;
+    if (numAvailableBytes > bytesLeft)
+    {
+        numAvailableBytes = bytesLeft;
+    }
+    if (numAvailableBytes > 0)
+    {
+        kwlMemcpy(&data[bytesRead], &stream->readAheadBuffer[stream->readPos - fillStart], numAvailableBytes);
+        stream->readPos += numAvailableBytes;
+        bytesRead += numAvailableBytes;
+    }
+    
+    return bytesRead;
+}
+
+int kwlInputStream_read(kwlInputStream* const stream, signed char* data, int length)
+{
+    if (stream->file != NULL && stream->buffer == NULL)
+    {
+        /* File based stream.*/
+        return kwlInputStream_readFromFile(stream, (char*)data, length);
+    }
     else if (stream->file == NULL && stream->buffer != NULL)
     {
         /* Buffer based stream.*/
@@ -392,12 +544,8 @@ char* kwlInputStream_readASCIIString(kwlInputStream* const stream)
     
     char* returnString = (char*)KWL_MALLOC((stringLength + 1) * sizeof(char), "kwlInputStream_readASCIIString");
     kwlMemset(returnString, 0, (stringLength + 1) * sizeof(char));
-    int i;
-    for (i = 0; i < stringLength; i++)
-    {
-        returnString[i] = kwlInputStream_readChar(stream);
-        /*printf("char %d: %c", i, returnString[i]);*/
-    }
+    const int bytesRead = kwlInputStream_read(stream, (signed char*)returnString, stringLength);
+    KWL_ASSERT(bytesRead == stringLength);
     returnString[stringLength] = '\0';
     
     return returnString;
@@ -410,6 +558,15 @@ void kwlInputStream_close(kwlInputStream* const stream)
     {
         fclose(stream->file);
     }
+    if (stream->readAheadAllocation != NULL)
+    {
+        KWL_FREE(stream->readAheadAllocation);
+    }
+    stream->readAheadAllocation = NULL;
+    stream->readAheadBuffer = NULL;
+    stream->readAheadCapacity = 0;
+    stream->readAheadStart = 0;
+    stream->readAheadLength = 0;
     stream->size = 0;
     stream->offset = 0;
     stream->readPos = 0;
@@ -34,6 +34,16 @@ extern "C"
 {
 #endif /* __cplusplus */
     
+/** The default size in bytes of the read-ahead buffer of file based input streams. */
+#define KWL_INPUT_STREAM_READ_AHEAD_BUFFER_SIZE (32 * 1024)
+/** 
+ * The alignment in bytes of the file positions read-ahead buffer refills start at. 
+ * Must be a power of two.
+ */
+#define KWL_INPUT_STREAM_READ_AHEAD_FILE_ALIGNMENT 4096
+/** The alignment in bytes of read-ahead buffer memory. Must be a power of two. */
+#define KWL_INPUT_STREAM_READ_AHEAD_MEMORY_ALIGNMENT 64
+    
     /**
      * A struct representing an input stream, getting its data from
      * either a file or a buffer.
@@ -53,6 +63,18 @@ extern "C"
         int offset;
         /** The current byte position, relative to the start of the underlying data. */
         int readPos;
+        /** The size in bytes of the underlying file, determined when the file is opened. */
+        int fileSize;
+        /** The memory block holding the read-ahead buffer (NULL if file reads are not buffered). */
+        char* readAheadAllocation;
+        /** The aligned start of the read-ahead buffer, within \c readAheadAllocation. */
+        char* readAheadBuffer;
+        /** The size in bytes of the read-ahead buffer. */
+        int readAheadCapacity;
+        /** The file position of the first byte in the read-ahead buffer. */
+        int readAheadStart;
+        /** The number of valid bytes in the read-ahead buffer. */
+        int readAheadLength;
     } kwlInputStream;
     
     void kwlInputStream_init(kwlInputStream* stream);
@@ -94,6 +116,16 @@ extern "C"
      */
     kwlError kwlInputStream_initWithFile(kwlInputStream* const stream, const char* const path);
     
+    /**
+     * Sets the size of the read-ahead buffer of a file based input stream. File streams
+     * get a buffer of \c KWL_INPUT_STREAM_READ_AHEAD_BUFFER_SIZE bytes when initialized. Small reads
+     * are served from the buffer and reads larger than the buffer go straight to the file.
+     * Has no effect on buffer based streams.
+     * @param stream The input stream to set the read-ahead buffer size of.
+     * @param size The buffer size in bytes. Zero disables read-ahead.
+     */
+    void kwlInputStream_setReadAheadBufferSize(kwlInputStream* const stream, int size);
+    
     /**
      * Closes a stream and disposes of the underlying file, if any. Any memory buffer associated with the
      * stream is NOT freed.
@@ -124,12 +156,18 @@ extern "C"
     int kwlInputStream_isAtEndOfStream(kwlInputStream* const stream);
     
     /**
-     *
+     * Returns the current read position of a given stream.
+     * @param stream The input stream to get the read position of.
+     * @return The read position in bytes.
      */
     int kwlInputStream_tell(kwlInputStream* const stream);
     
     /**
-     *
+     * Moves the read position of a given stream. For file streams, this does not touch the file.
+     * @param stream The input stream to move the read position of.
+     * @param pos The byte offset to move to, relative to \c p.
+     * @param p \c SEEK_SET, \c SEEK_CUR or \c SEEK_END.
+     * @return Zero on success and -1 if the resulting position is invalid.
      */
     int kwlInputStream_seek(kwlInputStream* const stream, long pos, int p);
     
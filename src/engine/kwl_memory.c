@@ -24,6 +24,7 @@ freely, subject to the following restrictions:
 #include "kwl_memory.h"
 
 #include "kwl_assert.h"
+#include "kwl_synchronization.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -63,6 +64,26 @@ void kwlFree(void* pointer)
 int liveBytes = 0;
 int totalBytes = 0;
 
+/** 
+ * A spin lock protecting the allocation table and the byte counts, non-zero when held.
+ * Engine instances, the mixer and loading threads may allocate concurrently.
+ */
+static volatile unsigned int debugAllocationLock = 0;
+
+static void kwlDebugLockAllocations(void)
+{
+    while (kwlAtomicCompareAndSwap(&debugAllocationLock, 0, 1) == 0)
+    {
+        /*the lock is only held for the table bookkeeping of a single allocation, so just spin.*/
+    }
+}
+
+static void kwlDebugUnlockAllocations(void)
+{
+    /*release through an atomic operation so the bookkeeping is visible before the lock is*/
+    kwlAtomicCompareAndSwap(&debugAllocationLock, 1, 0);
+}
+
 void* kwlDebugMallocAndZero(size_t size, const char* const tag)
 {
     void* ptr = kwlDebugMalloc(size, tag);
@@ -77,7 +98,9 @@ void* kwlDebugRealloc(void* ptr, size_t size, const char* const tag)
         return kwlDebugMalloc(size, tag);
     }
     
-    /*find a free slot in the allocation table*/
+    kwlDebugLockAllocations();
+    
+    /*find the slot of the pointer in the allocation table*/
     int allocationSlotIndex = -1;
     for (int i = 0; i < KWL_DEBUG_ALLOCATION_TABLE_SIZE; i++)
     {
@@ -109,6 +132,7 @@ void* kwlDebugRealloc(void* ptr, size_t size, const char* const tag)
     liveBytes += delta;
     totalBytes += delta;
     
+    kwlDebugUnlockAllocations();
     return newPtr;
 }
 
@@ -119,6 +143,8 @@ void* kwlDebugMalloc(size_t size, const char* const tag)
         return NULL;
     }
     
+    kwlDebugLockAllocations();
+    
     /*find a free slot in the allocation table*/
     int allocationSlotIndex = -1;
     for (int i = 0; i < KWL_DEBUG_ALLOCATION_TABLE_SIZE; i++)
@@ -150,6 +176,7 @@ void* kwlDebugMalloc(size_t size, const char* const tag)
     liveBytes += size;
     totalBytes += size;
     /*printf("malloc: live bytes = %d\n", liveBytes);*/
+    kwlDebugUnlockAllocations();
     /*return a pointer to the allocated block*/
     return ptr;
 }
@@ -161,6 +188,8 @@ void kwlDebugFree(void* pointer)
         return;
     }
     
+    kwlDebugLockAllocations();
+    
     /*record the deletion*/
     int allocationSlotIndex = -1;
     for (int i = 0; i < KWL_DEBUG_ALLOCATION_TABLE_SIZE; i++)
@@ -187,6 +216,8 @@ void kwlDebugFree(void* pointer)
     /*printf("free: live bytes = %d\n", liveBytes);*/
     /*free the memory block*/
     free(pointer);
+    
+    kwlDebugUnlockAllocations();
 }
 
 int kwlDebugGetLiveBytes(void)
@@ -23,6 +23,7 @@ freely, subject to the following restrictions:
 
 #include <string.h>
 #include "kwl_messagequeue.h"
+#include "kwl_synchronization.h"
 
 void kwlMessageQueue_init(kwlMessageQueue* queue)
 {
@@ -60,6 +61,15 @@ int kwlMessageQueue_addMessage(kwlMessageQueue* queue, kwlMessageType type, void
 }
 
 int kwlMessageQueue_addMessageWithParam(kwlMessageQueue* queue, kwlMessageType type, void* data, float param)
+{
+    return kwlMessageQueue_addMessageWithSecondaryData(queue, type, data, NULL, param);
+}
+
+int kwlMessageQueue_addMessageWithSecondaryData(kwlMessageQueue* queue, 
+                                                kwlMessageType type, 
+                                                void* data, 
+                                                void* secondaryData, 
+                                                float param)
 {
     if (queue->numMessages >= queue->maxQueueSize)
     {
@@ -70,6 +80,49 @@ int kwlMessageQueue_addMessageWithParam(kwlMessageQueue* queue, kwlMessageType t
     queue->messages[queue->numMessages].type = type;
     queue->messages[queue->numMessages].data = data;
     queue->messages[queue->numMessages].param = param;
+    queue->messages[queue->numMessages].secondaryData = secondaryData;
     queue->numMessages++;
     return 1;
 }
+
+int kwlImmediateMessageQueue_addMessageWithParam(kwlImmediateMessageQueue* queue, 
+                                                 kwlMessageType type, 
+                                                 void* data, 
+                                                 float param)
+{
+    const unsigned int numMessagesAdded = queue->numMessagesAdded;
+    if (numMessagesAdded - queue->numMessagesRemoved >= KWL_IMMEDIATE_MESSAGE_QUEUE_SIZE)
+    {
+        return 0;
+    }
+    
+    /*don't overwrite the slot before the consumer is done copying it, see kwlImmediateMessageQueue_removeMessage.*/
+    kwlMemoryBarrier();
+    kwlMessage* message = &queue->messages[numMessagesAdded & (KWL_IMMEDIATE_MESSAGE_QUEUE_SIZE - 1)];
+    message->type = type;
+    message->data = data;
+    message->param = param;
+    message->secondaryData = NULL;
+    
+    /*publish the message only once it has been written.*/
+    kwlMemoryBarrier();
+    queue->numMessagesAdded = numMessagesAdded + 1;
+    return 1;
+}
+
+int kwlImmediateMessageQueue_removeMessage(kwlImmediateMessageQueue* queue, kwlMessage* message)
+{
+    const unsigned int numMessagesRemoved = queue->numMessagesRemoved;
+    if (queue->numMessagesAdded == numMessagesRemoved)
+    {
+        return 0;
+    }
+    
+    kwlMemoryBarrier();
+    *message = queue->messages[numMessagesRemoved & (KWL_IMMEDIATE_MESSAGE_QUEUE_SIZE - 1)];
+    
+    /*hand the slot back to the producer only once the message has been copied.*/
+    kwlMemoryBarrier();
+    queue->numMessagesRemoved = numMessagesRemoved + 1;
+    return 1;
+}
@@ -40,6 +40,13 @@ extern "C"
  */
 #define KWL_MESSAGE_QUEUE_SIZE 500
 
+/** 
+ * The size of the lock-free queue used for sending messages from the engine 
+ * thread to the mixer thread without waiting for the next engine update.
+ * Must be a power of two.
+ */
+#define KWL_IMMEDIATE_MESSAGE_QUEUE_SIZE 64
+
 /**
  * An enumeration of valid types for messages sent between the mixer and engine threads.
  */
@@ -72,7 +79,15 @@ typedef enum
     /** Sent from the mixer to the engine thread indicating that it's safe to unload engine data.*/
     KWL_UNLOAD_ENGINE_DATA,
     /** Sent from the engine to notify the mixer that a new mix bus hierarchy has been loaded.*/
-    KWL_SET_MASTER_BUS
+    KWL_SET_MASTER_BUS,
+    /** Sent from the engine to insert the DSP unit in the secondary data into a DSP chain at the index given by the parameter.*/
+    KWL_DSP_CHAIN_INSERT,
+    /** Sent from the engine to remove the DSP unit at the index given by the parameter from a DSP chain.*/
+    KWL_DSP_CHAIN_REMOVE,
+    /** Sent from the engine to remove all DSP units from a DSP chain.*/
+    KWL_DSP_CHAIN_CLEAR,
+    /** Sent from the engine to bypass a DSP unit if the parameter is non-zero, or stop bypassing it otherwise.*/
+    KWL_DSP_UNIT_SET_BYPASSED
      
 } kwlMessageType;
 
@@ -87,6 +102,8 @@ typedef struct
     void* data;
     /** An optional parameter assocaited with the message.*/
     float param;
+    /** Optional additional data associated with the message.*/
+    void* secondaryData;
 } kwlMessage;
 
 /**
@@ -103,6 +120,20 @@ typedef struct
     int numMessages;
 } kwlMessageQueue;
 
+/**
+ * A lock-free, fixed size ring of messages with a single producer thread and a single
+ * consumer thread. Used for messages that bypass the engine update.
+ */
+typedef struct
+{
+    /** The messages of the ring.*/
+    kwlMessage messages[KWL_IMMEDIATE_MESSAGE_QUEUE_SIZE];
+    /** The total number of messages added. Only written by the producer.*/
+    volatile unsigned int numMessagesAdded;
+    /** The total number of messages removed. Only written by the consumer.*/
+    volatile unsigned int numMessagesRemoved;
+} kwlImmediateMessageQueue;
+
 /**
  * Initializes a message queue.
  * @param The queue to initialize.
@@ -128,6 +159,29 @@ void kwlMessageQueue_flushTo(kwlMessageQueue* srcQueue, kwlMessageQueue* destQue
 int kwlMessageQueue_addMessage(kwlMessageQueue* queue, kwlMessageType type, void* data);
     
 int kwlMessageQueue_addMessageWithParam(kwlMessageQueue* queue, kwlMessageType type, void* data, float param);
+
+/** Adds a message with two data pointers and a parameter to a given queue. */
+int kwlMessageQueue_addMessageWithSecondaryData(kwlMessageQueue* queue, 
+                                                kwlMessageType type, 
+                                                void* data, 
+                                                void* secondaryData, 
+                                                float param);
+
+/** 
+ * Adds a message to a lock-free message queue. Must only be called from the producer thread. 
+ * @return A non zero integer if the message was successfully added or zero if the queue is full.
+ */
+int kwlImmediateMessageQueue_addMessageWithParam(kwlImmediateMessageQueue* queue, 
+                                                 kwlMessageType type, 
+                                                 void* data, 
+                                                 float param);
+
+/** 
+ * Removes the oldest message from a lock-free message queue. Must only be called from the consumer thread. 
+ * @param message Receives the removed message.
+ * @return A non zero integer if a message was removed or zero if the queue is empty.
+ */
+int kwlImmediateMessageQueue_removeMessage(kwlImmediateMessageQueue* queue, kwlMessage* message);
     
 #ifdef __cplusplus
 }
@@ -22,6 +22,7 @@ freely, subject to the following restrictions:
 */
 
 #include "kwl_asm.h"
+#include "kwl_dspfilter.h"
 #include "kwl_eventinstance.h"
 #include "kwl_memory.h"
 #include "kwl_mixbus.h"
@@ -90,6 +91,9 @@ void kwlMixBus_addEvent(kwlMixBus* bus, kwlEventInstance* event)
     */
     
     KWL_ASSERT(event->nextEvent_mixer == NULL && "event to add already has event(s) attached to it");
+    
+    /*don't attribute the cost of a previous playback to the event.*/
+    event->cpuTicks.valueMixer = 0;
         
     kwlEventInstance* eventi = bus->eventList;
     if (eventi == NULL)
@@ -153,53 +157,304 @@ void kwlMixBus_removeEvent(kwlMixBus* bus, kwlEventInstance* event)
 }
 
 
-void kwlMixBus_render(kwlMixBus* mixBus, 
-                      void* mixerVoid, //TODO: made this a void* to get things to compile. should be kwlMixer*
-                      int numOutChannels,
-                      int numFrames, 
-                      float* busScratchBuffer,
-                      float* eventScratchBuffer,
-                      float* outBuffer,
-                      float accumulatedPitch,
-                      float accumulatedGainLeft,
-                      float accumulatedGainRight)
+/** Accumulates the levels of the bus scratch buffer, with the bus gain applied. */
+static void kwlMixBus_meter(kwlMixBus* mixBus,
+                            const float* busScratchBuffer,
+                            int numOutChannels,
+                            int numFrames,
+                            int hasEvents,
+                            float gainLeft,
+                            float gainRight)
+{
+    if (hasEvents != 0)
+    {
+        float peaks[2];
+        float sumsOfSquares[2];
+        kwlGetBufferPeaksAndSumsOfSquares(busScratchBuffer, numOutChannels, numFrames, peaks, sumsOfSquares);
+        
+        for (int ch = 0; ch < 2; ch++)
+        {
+            /*mono output is reported as identical left and right levels.*/
+            const int srcCh = ch < numOutChannels ? ch : 0;
+            const float gain = fabsf(ch == 0 ? gainLeft : gainRight);
+            const float peak = gain * peaks[srcCh];
+            if (peak > mixBus->peakLevel[ch].valueMixer)
+            {
+                mixBus->peakLevel[ch].valueMixer = peak;
+            }
+            mixBus->meterSumOfSquares[ch] += gain * gain * sumsOfSquares[srcCh];
+        }
+    }
+    
+    mixBus->meterNumFrames += numFrames;
+}
+
+void kwlMixBus_publishLevels(kwlMixBus* mixBus)
+{
+    for (int ch = 0; ch < 2; ch++)
+    {
+        mixBus->peakLevel[ch].valueShared = mixBus->peakLevel[ch].valueMixer;
+        mixBus->rmsLevel[ch].valueShared = mixBus->meterNumFrames > 0 ? 
+            sqrtf(mixBus->meterSumOfSquares[ch] / mixBus->meterNumFrames) : 0.0f;
+        
+        mixBus->peakLevel[ch].valueMixer = 0.0f;
+        mixBus->meterSumOfSquares[ch] = 0.0f;
+    }
+    mixBus->meterNumFrames = 0;
+}
+
+void kwlMixBus_mixAuxSends(kwlAuxSend* auxSends,
+                           int numAuxSends,
+                           float* buffer,
+                           int numOutChannels,
+                           int numFrames,
+                           float gainLeft,
+                           float gainRight)
+{
+    for (int i = 0; i < numAuxSends; i++)
+    {
+        kwlAuxSend* send = &auxSends[i];
+        const float level = send->level.valueMixer;
+        if (level == 0.0f)
+        {
+            continue;
+        }
+        
+        for (int ch = 0; ch < numOutChannels; ch++)
+        {
+            kwlMixFloatBufferWithGain(buffer, 
+                                      send->returnBus->auxReturnBuffer, 
+                                      numOutChannels * numFrames, 
+                                      ch, 
+                                      numOutChannels, 
+                                      level * (ch == 0 ? gainLeft : gainRight));
+        }
+        send->returnBus->hasAuxReturnInput = 1;
+    }
+}
+
+/**
+ * Filters a batch of events rendered into consecutive slots of a buffer, processing the channels 
+ * of several events in parallel, then applies the event gains and mixes the events into 
+ * the bus scratch buffer in batch order.
+ */
+static void kwlMixBus_flushFilterBatch(kwlEventInstance** batch,
+                                       int batchSize,
+                                       float* batchBuffer,
+                                       int numOutChannels,
+                                       int numFrames,
+                                       float* busScratchBuffer,
+                                       float busGainLeft,
+                                       float busGainRight,
+                                       kwlMixerCPUCost* cpuCost)
+{
+    if (batchSize == 0)
+    {
+        return;
+    }
+    
+    const int slotSize = numOutChannels * numFrames;
+    kwlDSPFilterLane lanes[KWL_FILTER_NUM_LANES];
+    int numLanes = 0;
+    for (int i = 0; i < batchSize; i++)
+    {
+        kwlDSPUnit* dspUnit = kwlDSPChain_getSingleUnit(&batch[i]->dspChain);
+        for (int ch = 0; ch < numOutChannels; ch++)
+        {
+            lanes[numLanes].filter = (kwlDSPFilter*)dspUnit->data;
+            lanes[numLanes].channel = ch;
+            lanes[numLanes].samples = &batchBuffer[i * slotSize + ch];
+            lanes[numLanes].stride = numOutChannels;
+            numLanes++;
+        }
+    }
+    
+    const long long start = cpuCost != NULL ? kwlCPUCost_getTicks() : 0;
+    kwlDSPFilter_processLanes(lanes, numLanes, numFrames);
+    if (cpuCost != NULL)
+    {
+        /*attribute an equal share of the batch cost to each filter.*/
+        const long long numTicks = kwlCPUCost_getTicks() - start;
+        for (int i = 0; i < batchSize; i++)
+        {
+            kwlDSPUnit* dspUnit = kwlDSPChain_getSingleUnit(&batch[i]->dspChain);
+            dspUnit->cpuTicks.valueMixer += numTicks / batchSize;
+        }
+        cpuCost->dspTicks.valueMixer += numTicks;
+    }
+    
+    for (int i = 0; i < batchSize; i++)
+    {
+        const kwlEventDefinition* definition = batch[i]->definition_mixer;
+        kwlEventInstance_applyGain(batch[i], &batchBuffer[i * slotSize], numOutChannels, numFrames);
+        kwlMixBus_mixAuxSends(definition->auxSends, definition->numAuxSends, &batchBuffer[i * slotSize],
+                              numOutChannels, numFrames, busGainLeft, busGainRight);
+        kwlMixFloatBuffer(&batchBuffer[i * slotSize], busScratchBuffer, slotSize);
+    }
+}
+
+int kwlMixBus_render(kwlMixBus* mixBus, 
+                     void* mixerVoid, //TODO: made this a void* to get things to compile. should be kwlMixer*
+                     int numOutChannels,
+                     int numFrames, 
+                     float* busScratchBuffer,
+                     float* eventScratchBuffer,
+                     float* outBuffer,
+                     float accumulatedPitch,
+                     float accumulatedGainLeft,
+                     float accumulatedGainRight)
 {
     kwlMixer* mixer = (kwlMixer*)mixerVoid;
     const int numSubBuses = mixBus->numSubBuses;
     
+    /*the CPU cost totals, if profiling is enabled.*/
+    kwlMixerCPUCost* cpuCost = mixer->isCPUProfilingEnabled.valueMixer ? &mixer->cpuCost : NULL;
+    const long long renderStart = cpuCost != NULL ? kwlCPUCost_getTicks() : 0;
+    
     /* Render sub buses recursively. */
+    int hasMixedSubBuses = 0;
     for (int i = 0; i < numSubBuses; i++)
     {
         kwlMixBus* busi = mixBus->subBuses[i];
-        kwlMixBus_render(busi, 
-                         mixer,
-                         numOutChannels, 
-                         numFrames,
-                         busScratchBuffer,
-                         eventScratchBuffer,
-                         outBuffer,
-                         busi->totalPitch.valueMixer * accumulatedPitch,
-                         busi->totalGainLeft.valueMixer * accumulatedGainLeft,
-                         busi->totalGainRight.valueMixer *accumulatedGainRight);
+        if (busi->isAuxReturn != 0)
+        {
+            /*defer rendering until all buses that may send to this one have been rendered.*/
+            busi->auxReturnPitch = busi->totalPitch.valueMixer * accumulatedPitch;
+            busi->auxReturnGainLeft = busi->totalGainLeft.valueMixer * accumulatedGainLeft;
+            busi->auxReturnGainRight = busi->totalGainRight.valueMixer * accumulatedGainRight;
+            continue;
+        }
+        hasMixedSubBuses |= kwlMixBus_render(busi, 
+                                             mixer,
+                                             numOutChannels, 
+                                             numFrames,
+                                             busScratchBuffer,
+                                             eventScratchBuffer,
+                                             outBuffer,
+                                             busi->totalPitch.valueMixer * accumulatedPitch,
+                                             busi->totalGainLeft.valueMixer * accumulatedGainLeft,
+                                             busi->totalGainRight.valueMixer *accumulatedGainRight);
+    }
+    
+    /* Skip silent buses whose DSP units have rung out, keeping the meters running at zero level. */
+    const int hasAuxInput = mixBus->isAuxReturn != 0 && mixBus->hasAuxReturnInput != 0;
+    if (mixBus->eventList == NULL && hasAuxInput == 0 && kwlDSPChain_isRinging(&mixBus->dspChain) == 0)
+    {
+        if (mixBus->isMeteringEnabled.valueMixer != 0)
+        {
+            kwlMixBus_meter(mixBus, NULL, numOutChannels, numFrames, 0, 0.0f, 0.0f);
+        }
+        if (cpuCost != NULL)
+        {
+            mixBus->cpuTicks.valueMixer += kwlCPUCost_getTicks() - renderStart;
+        }
+        return hasMixedSubBuses;
     }
     
-    /* Mix the events of this bus into the out buffer. */
-    kwlClearFloatBuffer(busScratchBuffer, numOutChannels * numFrames);
+    /* Mix the events of this bus into the out buffer, on top of the summed sends for return buses. 
+       The return buffer is only written to by sends, so it is known to be silent without input. */
+    if (hasAuxInput != 0)
+    {
+        kwlMemcpy(busScratchBuffer, mixBus->auxReturnBuffer, numOutChannels * numFrames * sizeof(float));
+        kwlClearFloatBuffer(mixBus->auxReturnBuffer, numOutChannels * numFrames);
+        mixBus->hasAuxReturnInput = 0;
+    }
+    else
+    {
+        kwlClearFloatBuffer(busScratchBuffer, numOutChannels * numFrames);
+    }
     kwlEventInstance* event = mixBus->eventList;
     int numEventsInBus = 0;    
     
+    /*events with built-in filters waiting to be filtered together, if batching is enabled.*/
+    const int isFilterBatchingEnabled = mixBus->isFilterBatchingEnabled.valueMixer != 0;
+    const int maxFilterBatchSize = KWL_FILTER_NUM_LANES / numOutChannels;
+    kwlEventInstance* filterBatch[KWL_FILTER_NUM_LANES];
+    int filterBatchSize = 0;
+    
     while (event != NULL)
     {
-        int eventFinishedPlaying = kwlEventInstance_render(event, 
-                                                   eventScratchBuffer, 
-                                                   numOutChannels,
-                                                   numFrames,
-                                                   accumulatedPitch);
-                
-        /*mix event temp buffer into mixbus temp buffer*/
-        kwlMixFloatBuffer(eventScratchBuffer, 
-                          busScratchBuffer,
-                          numOutChannels * numFrames);
+        /*only events with a single active filter are batched.*/
+        kwlDSPUnit* eventDSPUnit = kwlDSPChain_getSingleUnit(&event->dspChain);
+        const int isBatched = isFilterBatchingEnabled && 
+                              kwlDSPFilter_isFilter(eventDSPUnit) && 
+                              eventDSPUnit->isBypassed == 0;
+        
+        /*flush the batch before mixing any unbatched event or processing a filter twice, 
+          so that events are mixed in the same order as without batching.*/
+        int flushBatch = isBatched == 0;
+        for (int i = 0; i < filterBatchSize && flushBatch == 0; i++)
+        {
+            flushBatch = kwlDSPChain_getSingleUnit(&filterBatch[i]->dspChain) == eventDSPUnit;
+        }
+        if (flushBatch)
+        {
+            kwlMixBus_flushFilterBatch(filterBatch, filterBatchSize, mixer->tempFilterBatchBuffer,
+                                       numOutChannels, numFrames, busScratchBuffer, 
+                                       accumulatedGainLeft, accumulatedGainRight, cpuCost);
+            filterBatchSize = 0;
+        }
+        
+        const long long eventRenderStart = cpuCost != NULL ? kwlCPUCost_getTicks() : 0;
+        int eventFinishedPlaying = 0;
+        if (isBatched)
+        {
+            /*render the event into the next batch slot. filtering, gain and mixing are deferred.*/
+            int needsPostProcessing = 0;
+            eventFinishedPlaying = kwlEventInstance_renderSource(event, 
+                                                                 &mixer->tempFilterBatchBuffer[filterBatchSize * numOutChannels * numFrames], 
+                                                                 numOutChannels,
+                                                                 numFrames,
+                                                                 accumulatedPitch,
+                                                                 cpuCost,
+                                                                 &needsPostProcessing);
+            if (needsPostProcessing != 0)
+            {
+                filterBatch[filterBatchSize++] = event;
+            }
+        }
+        else
+        {
+            eventFinishedPlaying = kwlEventInstance_render(event, 
+                                                           eventScratchBuffer, 
+                                                           numOutChannels,
+                                                           numFrames,
+                                                           accumulatedPitch,
+                                                           cpuCost);
+        }
+        if (cpuCost != NULL)
+        {
+            event->cpuTicks.valueMixer += kwlCPUCost_getTicks() - eventRenderStart;
+        }
+        mixer->stats.numVoicesMixed++;
+        if (event->decoder != NULL)
+        {
+            mixer->stats.numDecoderUnderruns += event->decoder->numUnderruns;
+            event->decoder->numUnderruns = 0;
+        }
+        
+        if (isBatched == 0)
+        {
+            kwlMixBus_mixAuxSends(event->definition_mixer->auxSends, 
+                                  event->definition_mixer->numAuxSends, 
+                                  eventScratchBuffer, 
+                                  numOutChannels, 
+                                  numFrames, 
+                                  accumulatedGainLeft, 
+                                  accumulatedGainRight);
+            
+            /*mix event temp buffer into mixbus temp buffer*/
+            kwlMixFloatBuffer(eventScratchBuffer, 
+                              busScratchBuffer,
+                              numOutChannels * numFrames);
+        }
+        else if (filterBatchSize == maxFilterBatchSize)
+        {
+            kwlMixBus_flushFilterBatch(filterBatch, filterBatchSize, mixer->tempFilterBatchBuffer,
+                                       numOutChannels, numFrames, busScratchBuffer, 
+                                       accumulatedGainLeft, accumulatedGainRight, cpuCost);
+            filterBatchSize = 0;
+        }
         
         numEventsInBus++;
             
@@ -223,20 +478,45 @@ void kwlMixBus_render(kwlMixBus* mixBus,
         }
     }
     
-    /*Feed the bus output through the DSP unit if any.*/
-    if (mixBus->dspUnit.valueMixer)
+    kwlMixBus_flushFilterBatch(filterBatch, filterBatchSize, mixer->tempFilterBatchBuffer,
+                               numOutChannels, numFrames, busScratchBuffer, 
+                               accumulatedGainLeft, accumulatedGainRight, cpuCost);
+    
+    /*Feed the bus output through the DSP units if any, processing and replacing the mixbus temp buffer.
+      units that are still ringing out produce output even if there were no events.*/
+    const int isOutputSilent = kwlDSPChain_processWithTails(&mixBus->dspChain, 
+                                                            busScratchBuffer, 
+                                                            numOutChannels, 
+                                                            numFrames, 
+                                                            numEventsInBus == 0 && hasAuxInput == 0,
+                                                            cpuCost);
+    const int hasOutput = isOutputSilent == 0;
+    if (hasOutput && mixBus->numAuxSends > 0)
     {
-        kwlDSPUnit* dspUnit = (kwlDSPUnit*)mixBus->dspUnit.valueMixer;
-        /*process and replace mixbus temp buffer*/
-        (*dspUnit->dspCallback)(busScratchBuffer,
-                                numOutChannels,
-                                numFrames, 
-                                dspUnit->data);
+        kwlMixBus_mixAuxSends(mixBus->auxSends, 
+                              mixBus->numAuxSends, 
+                              busScratchBuffer, 
+                              numOutChannels, 
+                              numFrames, 
+                              accumulatedGainLeft, 
+                              accumulatedGainRight);
+    }
+    
+    /*meter the bus output while it is still in the cache.*/
+    if (mixBus->isMeteringEnabled.valueMixer != 0)
+    {
+        kwlMixBus_meter(mixBus, 
+                        busScratchBuffer, 
+                        numOutChannels, 
+                        numFrames, 
+                        hasOutput, 
+                        accumulatedGainLeft, 
+                        accumulatedGainRight);
     }
 
-    /*if we have mixed any events for this bus, 
+    /*if we have mixed any events, aux input or DSP tails for this bus, 
       mix the result into the output buffer*/
-    if (numEventsInBus > 0)
+    if (hasOutput)
     {
         /*... and then mix the bus buffer into the out buffer, applying
           the mix bus gain.*/
@@ -252,6 +532,13 @@ void kwlMixBus_render(kwlMixBus* mixBus,
                                                 accumulatedGainRight);
         }
     }
+    
+    if (cpuCost != NULL)
+    {
+        mixBus->cpuTicks.valueMixer += kwlCPUCost_getTicks() - renderStart;
+    }
+    
+    return hasOutput || hasMixedSubBuses;
 }
 
 #ifdef KOWALSKI_DEBUG_LOADING
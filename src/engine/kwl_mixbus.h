@@ -25,6 +25,7 @@ freely, subject to the following restrictions:
 
 /*! \file */ 
 
+#include "kwl_dspchain.h"
 #include "kwl_synchronization.h"
 #include "kowalski.h"
 
@@ -34,6 +35,18 @@ extern "C"
 #endif /* __cplusplus */
   
 struct kwlEvent;
+struct kwlMixBus;
+
+/**
+ * A send of the output of an event or a mix bus to an aux return bus.
+ */
+typedef struct kwlAuxSend
+{
+    /** The aux return bus fed by this send.*/
+    struct kwlMixBus* returnBus;
+    /** The linear gain applied to the signal fed to the return bus.*/
+    kwlSharedFloat level;
+} kwlAuxSend;
     
 /** 
  * A node in a mix bus tree.
@@ -47,9 +60,47 @@ typedef struct kwlMixBus
     kwlSharedFloat totalGainRight;
     /** The total pitch, taking the parent buses into account*/
     kwlSharedFloat totalPitch;
-    /** The DSP unit, if any, that the output of this bus is fed through.*/
-    kwlSharedVoidPointer dspUnit;
+    /** The DSP units that the output of this bus is fed through.*/
+    kwlDSPChain dspChain;
+    /** Non-zero if the output levels of this bus are metered, zero otherwise.*/
+    kwlSharedChar isMeteringEnabled;
+    /** Non-zero if the built-in filters of the events in this bus are processed in batches, zero otherwise.*/
+    kwlSharedChar isFilterBatchingEnabled;
+    /** The sends of the output of this bus to aux return buses.*/
+    kwlAuxSend* auxSends;
+    /** The number of aux sends.*/
+    int numAuxSends;
     
+    //mixer->engine
+    /** 
+     * The time spent rendering this bus and its sub buses, in clock ticks. 
+     * Only measured when CPU profiling is enabled.
+     */
+    kwlSharedLongLong cpuTicks;
+    /** 
+     * The peak absolute level of the left and right channels of the events in this bus,
+     * after the bus DSP unit and gain, since the levels were last published.
+     */
+    kwlSharedFloat peakLevel[2];
+    /** The RMS level of the left and right channels, measured like \c peakLevel. */
+    kwlSharedFloat rmsLevel[2];
+    
+    //mixer only
+    /** The sums of squared samples of each channel since the levels were last published.*/
+    float meterSumOfSquares[2];
+    /** The number of frames metered since the levels were last published.*/
+    int meterNumFrames;
+    /** 
+     * If this is an aux return bus, the sum of the signals sent to it during the current 
+     * render call. Holds \c KWL_TEMP_BUFFER_SIZE_IN_FRAMES frames. NULL otherwise.
+     */
+    float* auxReturnBuffer;
+    /** Non-zero if anything has been sent to \c auxReturnBuffer since the bus was last rendered.*/
+    char hasAuxReturnInput;
+    /** The accumulated pitch and gains of an aux return bus, recorded when its parent is rendered.*/
+    float auxReturnPitch;
+    float auxReturnGainLeft;
+    float auxReturnGainRight;
     
     
     
@@ -58,6 +109,12 @@ typedef struct kwlMixBus
     char* id;
     /** Non-zero if this is the master bus, zero otherwise.*/
     char isMaster;
+    /** 
+     * Non-zero if this is an aux return bus, i.e a bus whose DSP chain processes the 
+     * summed aux sends of other buses and events. Return buses are leaf buses and
+     * are rendered after all other buses.
+     */
+    char isAuxReturn;
     
     /** The number of sub buses under this mix bus.*/
     int numSubBuses;
@@ -91,16 +148,47 @@ void kwlMixBus_addEvent(kwlMixBus* bus, struct kwlEventInstance* event);
 /** Removes an event from a mix bus. */
 void kwlMixBus_removeEvent(kwlMixBus* bus, struct kwlEventInstance* event);
 
-void kwlMixBus_render(kwlMixBus* mixBus, 
-                      void* mixer, //TODO: made this a void* to get things to compile. should be kwlMixer*
-                      int numOutChannels,
-                      int numFrames, 
-                      float* busScratchBuffer,
-                      float* eventScratchBuffer,
-                      float* outBuffer,
-                      float accumulatedPitch,
-                      float accumulatedGainLeft,
-                      float accumulatedGainRight);
+/** 
+ * Publishes the levels metered since the last call and restarts metering. 
+ * Must be called from the mixer thread with the engine/mixer lock held.
+ */
+void kwlMixBus_publishLevels(kwlMixBus* mixBus);
+
+/**
+ * Mixes a buffer into the return buses of a set of aux sends.
+ * @param auxSends The sends to feed.
+ * @param numAuxSends The number of sends.
+ * @param buffer The signal to send.
+ * @param numOutChannels The number of channels of \c buffer.
+ * @param numFrames The number of frames of \c buffer.
+ * @param gainLeft The left channel gain to apply in addition to the send levels.
+ * @param gainRight The right channel gain to apply in addition to the send levels.
+ */
+void kwlMixBus_mixAuxSends(kwlAuxSend* auxSends,
+                           int numAuxSends,
+                           float* buffer,
+                           int numOutChannels,
+                           int numFrames,
+                           float gainLeft,
+                           float gainRight);
+
+/**
+ * Renders the events of a mix bus and its sub buses, except aux return buses, into a given buffer.
+ * Aux return buses get their accumulated pitch and gains recorded and have to be rendered
+ * separately once all buses that may send to them have been rendered. Buses without events
+ * or aux input whose DSP units have rung out are skipped.
+ * @return Non-zero if anything was mixed into \c outBuffer, zero otherwise.
+ */
+int kwlMixBus_render(kwlMixBus* mixBus, 
+                     void* mixer, //TODO: made this a void* to get things to compile. should be kwlMixer*
+                     int numOutChannels,
+                     int numFrames, 
+                     float* busScratchBuffer,
+                     float* eventScratchBuffer,
+                     float* outBuffer,
+                     float accumulatedPitch,
+                     float accumulatedGainLeft,
+                     float accumulatedGainRight);
     
 #ifdef KOWALSKI_DEBUG_LOADING
 void kwlMixBus_print(kwlMixBus* bus, int recursionDepth);
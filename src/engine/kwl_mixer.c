@@ -22,12 +22,14 @@ freely, subject to the following restrictions:
 */
 
 #include "kwl_asm.h"
+#include "kwl_dspfilter.h"
 #include "kwl_synchronization.h"
 #include "kwl_eventinstance.h"
 #include "kwl_memory.h"
 #include "kwl_messagequeue.h"
 #include "kwl_mixbus.h"
 #include "kwl_mixer.h"
+#include "kwl_renderahead.h"
 #include "kwl_sounddefinition.h"
 #include "kwl_engine.h"
 
@@ -49,6 +51,12 @@ kwlMixer* kwlMixer_new(void)
     newMixer->freeformEventsBus.totalGainLeft.valueMixer = 1.0f;
     newMixer->freeformEventsBus.totalGainRight.valueMixer = 1.0f;
     
+    newMixer->stats.messageQueueSize = KWL_MESSAGE_QUEUE_SIZE;
+    newMixer->publishedStats.messageQueueSize = KWL_MESSAGE_QUEUE_SIZE;
+    
+    /*a fixed seed keeps dithered output reproducible.*/
+    kwlDitherState_init(&newMixer->ditherState, 1);
+    
     return newMixer;
 }
 
@@ -57,6 +65,8 @@ void kwlMixer_allocateTempBuffers(kwlMixer* mixer)
     int tempBufferSize = sizeof(float) * KWL_TEMP_BUFFER_SIZE_IN_FRAMES * mixer->numOutChannels;
     mixer->tempMixBusBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp buffer");
     mixer->tempEventBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp buffer");
+    mixer->tempFilterBatchBuffer = (float*)KWL_MALLOC(sizeof(float) * KWL_TEMP_BUFFER_SIZE_IN_FRAMES * KWL_FILTER_NUM_LANES, 
+                                                      "mixer temp filter batch buffer");
     mixer->outBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp out buffer");
     
     if (mixer->numInChannels > 0)
@@ -70,6 +80,7 @@ void kwlMixer_free(kwlMixer* mixer)
     KWL_ASSERT(mixer != NULL);
     KWL_FREE(mixer->tempEventBuffer);
     KWL_FREE(mixer->tempMixBusBuffer);
+    KWL_FREE(mixer->tempFilterBatchBuffer);
     KWL_FREE(mixer->outBuffer);
     
     kwlMessageQueue_free(&mixer->toEngineQueue);
@@ -93,13 +104,7 @@ void kwlMixer_updateInput(kwlMixer* mixer)
      */
     if (kwlMutexLockTryAcquire(mixer->mixerEngineMutexLock) == KWL_LOCK_ACQUIRED)
     {
-        mixer->inputDSPUnit.valueMixer = mixer->inputDSPUnit.valueShared;
-        
-        kwlDSPUnit* dspUnit = (kwlDSPUnit*)mixer->inputDSPUnit.valueMixer;
-        if (dspUnit != NULL && dspUnit->updateDSPMixerCallback != NULL)
-        {
-            dspUnit->updateDSPMixerCallback(dspUnit->data);
-        }
+        kwlDSPChain_updateMixer(&mixer->inputDSPChain);
         
         kwlMutexLockRelease(mixer->mixerEngineMutexLock);
     }
@@ -119,6 +124,16 @@ void kwlMixer_updateOutput(kwlMixer* const mixer)
         /*copy buffered outgoing*/
         kwlMessageQueue_flushTo(&mixer->toEngineQueue, &mixer->toEngineQueueShared);
         
+        /*record message queue high-water marks*/
+        if (mixer->fromEngineQueue.numMessages > mixer->stats.maxIncomingMessageQueueDepth)
+        {
+            mixer->stats.maxIncomingMessageQueueDepth = mixer->fromEngineQueue.numMessages;
+        }
+        if (mixer->toEngineQueueShared.numMessages > mixer->stats.maxOutgoingMessageQueueDepth)
+        {
+            mixer->stats.maxOutgoingMessageQueueDepth = mixer->toEngineQueueShared.numMessages;
+        }
+        
         /*update data driven mix buses and events*/
         int i;
         for (i = 0; i < mixer->numMixBuses; i++)
@@ -129,7 +144,14 @@ void kwlMixer_updateOutput(kwlMixer* const mixer)
             bus->totalGainLeft.valueMixer = bus->totalGainLeft.valueShared;
             bus->totalGainRight.valueMixer = bus->totalGainRight.valueShared;
             bus->totalPitch.valueMixer = bus->totalPitch.valueShared;
-            bus->dspUnit.valueMixer = bus->dspUnit.valueShared;
+            bus->isMeteringEnabled.valueMixer = bus->isMeteringEnabled.valueShared;
+            bus->isFilterBatchingEnabled.valueMixer = bus->isFilterBatchingEnabled.valueShared;
+            kwlMixBus_publishLevels(bus);
+            kwlDSPChain_updateMixer(&bus->dspChain);
+            for (int j = 0; j < bus->numAuxSends; j++)
+            {
+                bus->auxSends[j].level.valueMixer = bus->auxSends[j].level.valueShared;
+            }
         
             /*update parameters of playing events*/
             kwlEventInstance* eventList = bus->eventList;
@@ -138,12 +160,7 @@ void kwlMixer_updateOutput(kwlMixer* const mixer)
                 eventList->gainLeft.valueMixer = eventList->gainLeft.valueShared;
                 eventList->gainRight.valueMixer = eventList->gainRight.valueShared;
                 eventList->pitch.valueMixer = eventList->pitch.valueShared;
-                eventList->dspUnit.valueMixer = eventList->dspUnit.valueShared;
-                if (eventList->dspUnit.valueMixer != NULL)
-                {
-                    kwlDSPUnit* dspUnit = (kwlDSPUnit*)eventList->dspUnit.valueMixer;
-                    dspUnit->updateDSPMixerCallback(dspUnit->data);
-                }
+                kwlDSPChain_updateMixer(&eventList->dspChain);
                 
                 eventList = eventList->nextEvent_mixer;
             }
@@ -156,22 +173,13 @@ void kwlMixer_updateOutput(kwlMixer* const mixer)
             eventList->gainLeft.valueMixer = eventList->gainLeft.valueShared;
             eventList->gainRight.valueMixer = eventList->gainRight.valueShared;
             eventList->pitch.valueMixer = eventList->pitch.valueShared;
-            if (eventList->dspUnit.valueMixer!= NULL)
-            {
-                kwlDSPUnit* dspUnit = (kwlDSPUnit*)eventList->dspUnit.valueMixer;
-                dspUnit->updateDSPMixerCallback(dspUnit->data);
-            }
+            kwlDSPChain_updateMixer(&eventList->dspChain);
             
             eventList = eventList->nextEvent_mixer;
         }
         
-        /*update master dsp unit, if any.*/
-        mixer->outputDSPUnit.valueMixer = mixer->outputDSPUnit.valueShared;
-        kwlDSPUnit* dspUnit = (kwlDSPUnit*)mixer->outputDSPUnit.valueMixer;
-        if (dspUnit != NULL && dspUnit->updateDSPMixerCallback != NULL)
-        {
-            dspUnit->updateDSPMixerCallback(dspUnit->data);
-        }
+        /*update master dsp units, if any.*/
+        kwlDSPChain_updateMixer(&mixer->outputDSPChain);
         
         /*update levels and sync information*/
         mixer->numFramesMixed.valueShared = mixer->numFramesMixed.valueMixer;
@@ -180,164 +188,316 @@ void kwlMixer_updateOutput(kwlMixer* const mixer)
         mixer->latestBufferAbsPeakRight.valueShared = mixer->latestBufferAbsPeakRight.valueMixer;
         mixer->clipFlag.valueShared = mixer->clipFlag.valueMixer;
         mixer->isLevelMeteringEnabled.valueMixer = mixer->isLevelMeteringEnabled.valueShared;
+        mixer->isDitherEnabled.valueMixer = mixer->isDitherEnabled.valueShared;
         mixer->isPaused.valueMixer = mixer->isPaused.valueShared;
+        
+        /*publish CPU costs at the end of each measurement period, discarding
+          any costs measured before profiling was last enabled.*/
+        const char wasCPUProfilingEnabled = mixer->isCPUProfilingEnabled.valueMixer;
+        mixer->isCPUProfilingEnabled.valueMixer = mixer->isCPUProfilingEnabled.valueShared;
+        mixer->cpuProfilingPeriodInFrames.valueMixer = mixer->cpuProfilingPeriodInFrames.valueShared;
+        if (mixer->isCPUProfilingEnabled.valueMixer != 0)
+        {
+            if (wasCPUProfilingEnabled == 0)
+            {
+                kwlMixer_publishCPUCosts(mixer, 0);
+            }
+            else if (mixer->cpuCost.numFrames.valueMixer >= mixer->cpuProfilingPeriodInFrames.valueMixer)
+            {
+                kwlMixer_publishCPUCosts(mixer, 1);
+            }
+        }
     
         kwlMutexLockRelease(mixer->mixerEngineMutexLock);
     }
+    else
+    {
+        mixer->stats.numSkippedUpdates++;
+    }
 }
 
-void kwlMixer_processMessages(kwlMixer* const mixer)
+void kwlMixer_publishCPUCosts(kwlMixer* mixer, int publish)
 {
-    int numMessages = mixer->fromEngineQueue.numMessages;
-    int i;
-    for (i = 0; i < numMessages; i++)    
+    kwlCPUCost_publish(&mixer->cpuCost.renderTicks, publish);
+    kwlCPUCost_publish(&mixer->cpuCost.dspTicks, publish);
+    kwlCPUCost_publish(&mixer->cpuCost.decoderTicks, publish);
+    kwlCPUCost_publish(&mixer->cpuCost.numDecoderRefills, publish);
+    kwlCPUCost_publish(&mixer->cpuCost.numFrames, publish);
+    
+    /*the freeform event bus followed by the data driven buses*/
+    for (int i = -1; i < mixer->numMixBuses; i++)
     {
-        kwlMessage* message = &mixer->fromEngineQueue.messages[i];
-        kwlMessageType type = message->type;
-        void* messageData = message->data;
-        //printf("mixer: processing incoming message %d/%d of type %d\n", i, numMessages, 
-        //       type);
+        kwlMixBus* bus = i < 0 ? &mixer->freeformEventsBus : &mixer->mixBuses[i];
+        kwlCPUCost_publish(&bus->cpuTicks, publish);
+        kwlDSPChain_publishCPUCosts(&bus->dspChain, publish);
         
-        if (type == KWL_EVENT_START ||
-            type == KWL_EVENT_RETRIGGER)
-        {   
-            KWL_ASSERT(messageData != NULL && "message data is null");
-            kwlEventInstance* event = (kwlEventInstance*)message->data;
-            /*Find the bus to put the event in.*/
-            kwlMixBus* targetBus = event->definition_mixer->mixBus;
-            if (targetBus == NULL)
-            {
-                /*If the bus in the event definition is null, we're dealing with a freeform event.*/
-                targetBus = &mixer->freeformEventsBus;
-            }
-            KWL_ASSERT(targetBus != NULL && "target bus is null");
-            
-            const int streamFromDisk = event->decoder != NULL;
-            const int retrigger = (type == KWL_EVENT_RETRIGGER);
+        kwlEventInstance* event = bus->eventList;
+        while (event != NULL)
+        {
+            kwlCPUCost_publish(&event->cpuTicks, publish);
+            kwlDSPChain_publishCPUCosts(&event->dspChain, publish);
+            event = event->nextEvent_mixer;
+        }
+    }
+    
+    kwlDSPChain_publishCPUCosts(&mixer->inputDSPChain, publish);
+    kwlDSPChain_publishCPUCosts(&mixer->outputDSPChain, publish);
+    
+    if (publish != 0)
+    {
+        mixer->numCPUCostSnapshots.valueShared++;
+    }
+}
 
-            kwlEventInstance_start(event);
-            int shouldStop = 0; /*could be non-zero if the event is missing audio data*/
-            if (streamFromDisk == 0)
-            {
-                KWL_ASSERT(event->definition_mixer->streamAudioData == NULL);
-                shouldStop = kwlSoundDefinition_pickNextBufferForEvent(event->definition_mixer->sound, event, 1);
-                /*KWL_ASSERT(result == 0 && "event should not signal stop on picking first buffer");*/
-            }
-            else 
-            {
-                KWL_ASSERT(event->definition_mixer->sound == NULL);
-                //shouldStop = kwlDecoder_decodeNewBufferForEvent(event->decoder, event, 1);
-            }
-            
-            /* check if this event should fade in */
-            float fadeOutTime = message->param;
-            if (fadeOutTime > 0.0f)
-            {
-                event->fadeGain = 0.0f;
-                event->fadeGainIncrPerFrame = 1.0f / (fadeOutTime * mixer->sampleRate);
-            }
-            else
-            {
-                event->fadeGain = 1.0f;
-                event->fadeGainIncrPerFrame = 0.0f;
-            }
-            
-            if (shouldStop != 0)
-            {
-                event->playbackState = KWL_STOP_REQUESTED;
-            }
-            
-            /*add the event to its bus.*/
-            if (retrigger == 0)
+/** 
+ * Updates the render time statistics with the time it took to render a buffer and
+ * publishes the statistics to other threads.
+ */
+static void kwlMixer_updateStats(kwlMixer* mixer, long long renderTicks, int numFrames)
+{
+    kwlMixerStats* stats = &mixer->stats;
+    stats->numBuffersRendered++;
+    stats->numFramesRendered += numFrames;
+    
+    const float renderLoad = kwlCPUCost_getLoad(renderTicks, numFrames, mixer->sampleRate);
+    const int lastBin = KWL_MIXER_STATS_NUM_RENDER_TIME_BINS - 1;
+    const int bin = renderLoad >= 1.0f ? lastBin : (int)(renderLoad * lastBin);
+    stats->renderTimeHistogram[bin]++;
+    if (bin == lastBin)
+    {
+        stats->numDeadlineMisses++;
+    }
+    if (renderLoad > stats->maxRenderLoad)
+    {
+        stats->maxRenderLoad = renderLoad;
+    }
+    if (stats->numVoicesMixed > stats->maxNumVoicesMixed)
+    {
+        stats->maxNumVoicesMixed = stats->numVoicesMixed;
+    }
+    
+    kwlRenderAhead* renderAhead = mixer->renderAhead;
+    stats->numRenderAheadUnderruns = mixer->numRenderAheadUnderruns;
+    stats->renderAheadLeadInFrames = renderAhead != NULL ? renderAhead->numBlocksAhead * renderAhead->blockSize : 0;
+    
+    /*publish using a sequence counter that readers check before and after copying.*/
+    mixer->publishedStatsSequence++;
+    kwlMemoryBarrier();
+    kwlMemcpy(&mixer->publishedStats, stats, sizeof(kwlMixerStats));
+    kwlMemoryBarrier();
+    mixer->publishedStatsSequence++;
+}
+
+void kwlMixer_getStats(kwlMixer* mixer, kwlMixerStats* stats)
+{
+    while (1)
+    {
+        const unsigned int sequence = mixer->publishedStatsSequence;
+        kwlMemoryBarrier();
+        /*an odd sequence number means the mixer is in the middle of publishing.*/
+        if ((sequence & 1) == 0)
+        {
+            kwlMemcpy(stats, &mixer->publishedStats, sizeof(kwlMixerStats));
+            kwlMemoryBarrier();
+            if (sequence == mixer->publishedStatsSequence)
             {
-                kwlMixBus_addEvent(targetBus, event);
+                return;
             }
         }
-        else if (type == KWL_PREPARE_ENGINE_DATA_UNLOAD)
+    }
+}
+
+/** Processes a single message from the engine thread. */
+static void kwlMixer_processMessage(kwlMixer* const mixer, kwlMessage* message)
+{
+    kwlMessageType type = message->type;
+    void* messageData = message->data;
+    
+    if (type == KWL_EVENT_START ||
+        type == KWL_EVENT_RETRIGGER)
+    {   
+        KWL_ASSERT(messageData != NULL && "message data is null");
+        kwlEventInstance* event = (kwlEventInstance*)message->data;
+        /*Find the bus to put the event in.*/
+        kwlMixBus* targetBus = event->definition_mixer->mixBus;
+        if (targetBus == NULL)
         {
-            kwlMixer_stopAllDataDrivenEvents(mixer);
-            //printf("mixer: got KWL_PREPARE_ENGINE_DATA_UNLOAD, sending KWL_UNLOAD_ENGINE_DATA back to engine\n");
-            //int result = kwlMessageQueue_addMessage(&mixer->toEngineQueue, KWL_UNLOAD_ENGINE_DATA, NULL);
-            //KWL_ASSERT(result == 1 && "mixer: outgoing message queue exhausted ");
-            KWL_ASSERT(mixer->resetMixBusesRequested == 0);
-            mixer->resetMixBusesRequested = 1;
+            /*If the bus in the event definition is null, we're dealing with a freeform event.*/
+            targetBus = &mixer->freeformEventsBus;
         }
-        else if (type == KWL_EVENT_STOP)
+        KWL_ASSERT(targetBus != NULL && "target bus is null");
+        
+        const int streamFromDisk = event->decoder != NULL;
+        const int retrigger = (type == KWL_EVENT_RETRIGGER);
+
+        kwlEventInstance_start(event);
+        int shouldStop = 0; /*could be non-zero if the event is missing audio data*/
+        if (streamFromDisk == 0)
         {
-            KWL_ASSERT(messageData != NULL);
-            kwlEventInstance* event = (kwlEventInstance*)message->data;
-            float fadeOutTime = message->param;
-            if (event->isPaused)
-            {
-                /*Always stop paused events immediately.*/
-                event->playbackState = KWL_STOP_REQUESTED;
-            }
-            else if (fadeOutTime > 0.0f)
-            {
-                /*Start the fade out. The event will get removed from the mixer when
-                  the fade gain reaches 0.*/
-                event->fadeGainIncrPerFrame = -1.0f / (fadeOutTime * mixer->sampleRate);
-            }
-            else if (event->definition_mixer->sound != NULL)
-            {
-                if (event->definition_mixer->sound->playbackMode == KWL_IN_RANDOM_OUT ||
-                    event->definition_mixer->sound->playbackMode == KWL_IN_RANDOM_NO_REPEAT_OUT ||
-                    event->definition_mixer->sound->playbackMode == KWL_IN_SEQUENTIAL_OUT)
-                {
-                    event->playbackState = KWL_PLAY_LAST_BUFFER_AND_STOP_REQUESTED;
-                }
-                else
-                {
-                    event->playbackState = KWL_STOP_REQUESTED;
-                }
-            }
-            else
-            {
-                event->playbackState = KWL_STOP_REQUESTED;
-            }
-            
+            KWL_ASSERT(event->definition_mixer->streamAudioData == NULL);
+            shouldStop = kwlSoundDefinition_pickNextBufferForEvent(event->definition_mixer->sound, event, 1);
+            /*KWL_ASSERT(result == 0 && "event should not signal stop on picking first buffer");*/
         }
-        else if (type == KWL_EVENT_PAUSE)
+        else 
         {
-            kwlEventInstance* event = (kwlEventInstance*)message->data;
-            event->isPaused = 1;
+            KWL_ASSERT(event->definition_mixer->sound == NULL);
+            //shouldStop = kwlDecoder_decodeNewBufferForEvent(event->decoder, event, 1);
         }
-        else if (type == KWL_EVENT_RESUME)
+        
+        /* check if this event should fade in */
+        float fadeOutTime = message->param;
+        if (fadeOutTime > 0.0f)
         {
-            kwlEventInstance* event = (kwlEventInstance*)message->data;
-            event->isPaused = 0;
+            event->fadeGain = 0.0f;
+            event->fadeGainIncrPerFrame = 1.0f / (fadeOutTime * mixer->sampleRate);
         }
-        else if (type == KWL_FREEFORM_EVENT_STOP)
+        else
         {
-            kwlEventInstance* event = (kwlEventInstance*)message->data;
-            //printf("stopping freeform event %s\n", event->definition_mixer->id);
-            event->playbackState = KWL_STOP_AND_UNLOAD_REQUESTED;
+            event->fadeGain = 1.0f;
+            event->fadeGainIncrPerFrame = 0.0f;
         }
-        else if (type == KWL_STOP_ALL_EVENTS_REFERENCING_WAVE_BANK)
+        
+        if (shouldStop != 0)
         {
-            kwlWaveBank* waveBank = (kwlWaveBank*)message->data;
-            kwlMixer_stopAllEventsReferencingWaveBank(mixer, waveBank);
-            /*printf("stopped all events referencing %s\n", waveBank->id);*/
-            /* Send a message to the engine thread indicating that it's safe to unload the wave bank.
-               IMPORTANT NOTE: This relies on kwlMixer_updateOutput being called BEFORE kwlMixer_processMessages*/
-            int result = kwlMessageQueue_addMessage(&mixer->toEngineQueue, KWL_UNLOAD_WAVEBANK, waveBank);
-            KWL_ASSERT(result == 1 && "mixer: outgoing message queue exhausted ");
+            event->playbackState = KWL_STOP_REQUESTED;
         }
-        else if (type == KWL_SET_MASTER_BUS)
+        
+        /*add the event to its bus.*/
+        if (retrigger == 0)
         {
-            kwlMixBus* newBusArray = (kwlMixBus*)message->data;
-            int numBuses = (int)message->param;
-            kwlMixer_setMixBusArray(mixer, newBusArray, numBuses);
+            kwlMixBus_addEvent(targetBus, event);
+        }
+    }
+    else if (type == KWL_PREPARE_ENGINE_DATA_UNLOAD)
+    {
+        kwlMixer_stopAllDataDrivenEvents(mixer);
+        //printf("mixer: got KWL_PREPARE_ENGINE_DATA_UNLOAD, sending KWL_UNLOAD_ENGINE_DATA back to engine\n");
+        //int result = kwlMessageQueue_addMessage(&mixer->toEngineQueue, KWL_UNLOAD_ENGINE_DATA, NULL);
+        //KWL_ASSERT(result == 1 && "mixer: outgoing message queue exhausted ");
+        KWL_ASSERT(mixer->resetMixBusesRequested == 0);
+        mixer->resetMixBusesRequested = 1;
+    }
+    else if (type == KWL_EVENT_STOP)
+    {
+        KWL_ASSERT(messageData != NULL);
+        kwlEventInstance* event = (kwlEventInstance*)message->data;
+        float fadeOutTime = message->param;
+        if (event->isPaused)
+        {
+            /*Always stop paused events immediately.*/
+            event->playbackState = KWL_STOP_REQUESTED;
+        }
+        else if (fadeOutTime > 0.0f)
+        {
+            /*Start the fade out. The event will get removed from the mixer when
+              the fade gain reaches 0.*/
+            event->fadeGainIncrPerFrame = -1.0f / (fadeOutTime * mixer->sampleRate);
+        }
+        else if (event->definition_mixer->sound != NULL)
+        {
+            if (event->definition_mixer->sound->playbackMode == KWL_IN_RANDOM_OUT ||
+                event->definition_mixer->sound->playbackMode == KWL_IN_RANDOM_NO_REPEAT_OUT ||
+                event->definition_mixer->sound->playbackMode == KWL_IN_SEQUENTIAL_OUT)
+            {
+                event->playbackState = KWL_PLAY_LAST_BUFFER_AND_STOP_REQUESTED;
+            }
+            else
+            {
+                event->playbackState = KWL_STOP_REQUESTED;
+            }
         }
         else
         {
-            KWL_ASSERT(NULL && "unknown message type");
+            event->playbackState = KWL_STOP_REQUESTED;
         }
+        
+    }
+    else if (type == KWL_EVENT_PAUSE)
+    {
+        kwlEventInstance* event = (kwlEventInstance*)message->data;
+        event->isPaused = 1;
+    }
+    else if (type == KWL_EVENT_RESUME)
+    {
+        kwlEventInstance* event = (kwlEventInstance*)message->data;
+        event->isPaused = 0;
+    }
+    else if (type == KWL_FREEFORM_EVENT_STOP)
+    {
+        kwlEventInstance* event = (kwlEventInstance*)message->data;
+        //printf("stopping freeform event %s\n", event->definition_mixer->id);
+        event->playbackState = KWL_STOP_AND_UNLOAD_REQUESTED;
+    }
+    else if (type == KWL_STOP_ALL_EVENTS_REFERENCING_WAVE_BANK)
+    {
+        kwlWaveBank* waveBank = (kwlWaveBank*)message->data;
+        kwlMixer_stopAllEventsReferencingWaveBank(mixer, waveBank);
+        /*printf("stopped all events referencing %s\n", waveBank->id);*/
+        /* Send a message to the engine thread indicating that it's safe to unload the wave bank.
+           IMPORTANT NOTE: This relies on kwlMixer_updateOutput being called BEFORE kwlMixer_processMessages*/
+        int result = kwlMessageQueue_addMessage(&mixer->toEngineQueue, KWL_UNLOAD_WAVEBANK, waveBank);
+        KWL_ASSERT(result == 1 && "mixer: outgoing message queue exhausted ");
+    }
+    else if (type == KWL_SET_MASTER_BUS)
+    {
+        kwlMixBus* newBusArray = (kwlMixBus*)message->data;
+        int numBuses = (int)message->param;
+        kwlMixer_setMixBusArray(mixer, newBusArray, numBuses);
+    }
+    else if (type == KWL_DSP_CHAIN_INSERT ||
+             type == KWL_DSP_CHAIN_REMOVE ||
+             type == KWL_DSP_CHAIN_CLEAR)
+    {
+        KWL_ASSERT(messageData != NULL);
+        kwlDSPChain_processMessage(message);
+    }
+    else if (type == KWL_DSP_UNIT_SET_BYPASSED)
+    {
+        KWL_ASSERT(messageData != NULL);
+        kwlDSPUnit* dspUnit = (kwlDSPUnit*)messageData;
+        dspUnit->isBypassed = message->param != 0.0f;
+    }
+    else
+    {
+        KWL_ASSERT(NULL && "unknown message type");
+    }
+}
+
+void kwlMixer_processMessages(kwlMixer* const mixer)
+{
+    int numMessages = mixer->fromEngineQueue.numMessages;
+    int i;
+    for (i = 0; i < numMessages; i++)    
+    {
+        //printf("mixer: processing incoming message %d/%d of type %d\n", i, numMessages, 
+        //       mixer->fromEngineQueue.messages[i].type);
+        kwlMixer_processMessage(mixer, &mixer->fromEngineQueue.messages[i]);
     }
     
     mixer->fromEngineQueue.numMessages = 0;
 }
 
+void kwlMixer_processImmediateMessages(kwlMixer* const mixer)
+{
+    kwlMessage message;
+    while (kwlImmediateMessageQueue_removeMessage(&mixer->immediateQueue, &message))
+    {
+        kwlMixer_processMessage(mixer, &message);
+        
+        if (message.type == KWL_EVENT_START)
+        {
+            /*the engine published the parameters of the event before sending the message,
+              so the event doesn't have to wait for the next update to get them. the engine
+              writes them under mixerEngineMutexLock before adding the message, and the barrier
+              in kwlImmediateMessageQueue_removeMessage orders this read after that write.*/
+            kwlEventInstance* event = (kwlEventInstance*)message.data;
+            event->gainLeft.valueMixer = event->gainLeft.valueShared;
+            event->gainRight.valueMixer = event->gainRight.valueShared;
+            event->pitch.valueMixer = event->pitch.valueShared;
+        }
+    }
+}
+
 void kwlMixer_stopAllDataDrivenEvents(kwlMixer* mixer)
 {
     /* loop over playing events to see if any should be stopped.*/
@@ -450,17 +610,28 @@ void kwlMixer_render(kwlMixer* mixer,
                              float* outBuffer, 
                              int numFrames)
 {    
+    const long long statsRenderStart = kwlCPUCost_getTicks();
+    mixer->stats.numVoicesMixed = 0;
+    
     /*process any new messages from the engine thread before rendering.*/
     kwlMixer_processMessages(mixer);
+    kwlMixer_processImmediateMessages(mixer);
     
     /*Update the parameters of the mix buses and currently playing events.*/
     kwlMixer_updateOutput(mixer);
     
+    /*the CPU cost totals, if profiling is enabled.*/
+    kwlMixerCPUCost* cpuCost = mixer->isCPUProfilingEnabled.valueMixer ? &mixer->cpuCost : NULL;
+    const long long renderStart = cpuCost != NULL ? kwlCPUCost_getTicks() : 0;
+    
     /*Clear the output buffer.*/
     const int numOutChannels = mixer->numOutChannels;
     const int numSamples = numFrames * numOutChannels;
     kwlClearFloatBuffer(outBuffer, numSamples);
     
+    /*Non-zero if any bus mixed anything into the output buffer.*/
+    int hasOutput = 0;
+    
     /*Perform mixing if the mixer is not paused.*/
     if (mixer->isPaused.valueMixer == 0)
     {
@@ -473,24 +644,52 @@ void kwlMixer_render(kwlMixer* mixer,
             kwlMixBus* bus = i == 0 ? &mixer->freeformEventsBus : mixer->masterBus;
             if (bus != NULL)
             {
-                kwlMixBus_render(bus,
-                                 mixer,
-                                 numOutChannels, 
-                                 numFrames, 
-                                 mixer->tempMixBusBuffer, 
-                                 mixer->tempEventBuffer, 
-                                 outBuffer, 
-                                 bus->totalPitch.valueMixer, 
-                                 bus->totalGainLeft.valueMixer, 
-                                 bus->totalGainRight.valueMixer);
+                hasOutput |= kwlMixBus_render(bus,
+                                              mixer,
+                                              numOutChannels, 
+                                              numFrames, 
+                                              mixer->tempMixBusBuffer, 
+                                              mixer->tempEventBuffer, 
+                                              outBuffer, 
+                                              bus->totalPitch.valueMixer, 
+                                              bus->totalGainLeft.valueMixer, 
+                                              bus->totalGainRight.valueMixer);
+            }
+        }
+        
+        /*Render aux return buses now that everything that may send to them has been rendered.*/
+        for (int i = 0; i < mixer->numMixBuses; i++)
+        {
+            kwlMixBus* bus = &mixer->mixBuses[i];
+            if (bus->isAuxReturn != 0)
+            {
+                hasOutput |= kwlMixBus_render(bus,
+                                              mixer,
+                                              numOutChannels, 
+                                              numFrames, 
+                                              mixer->tempMixBusBuffer, 
+                                              mixer->tempEventBuffer, 
+                                              outBuffer, 
+                                              bus->auxReturnPitch, 
+                                              bus->auxReturnGainLeft, 
+                                              bus->auxReturnGainRight);
             }
         }
         
-        /*Clamp out buffer to [-1, 1]*/
-        kwlClampBuffer(outBuffer, numFrames * numOutChannels);
+        /*Clamp out buffer to [-1, 1]. There is nothing to clamp or meter if nothing was mixed.*/
+        if (hasOutput)
+        {
+            kwlClampBuffer(outBuffer, numFrames * numOutChannels);
+        }
         
         /*record output peak levels if metering is enabled*/
-        if (mixer->isLevelMeteringEnabled.valueMixer)
+        if (mixer->isLevelMeteringEnabled.valueMixer && hasOutput == 0)
+        {
+            mixer->latestBufferAbsPeakLeft.valueMixer = 0.0f;
+            mixer->latestBufferAbsPeakRight.valueMixer = 0.0f;
+            mixer->clipFlag.valueMixer = 0;
+        }
+        else if (mixer->isLevelMeteringEnabled.valueMixer)
         {
             const int numOutSamples = numFrames * numOutChannels;
             mixer->latestBufferAbsPeakLeft.valueMixer = 
@@ -529,14 +728,93 @@ void kwlMixer_render(kwlMixer* mixer,
         KWL_ASSERT(result == 1 && "mixer: outgoing message queue exhausted ");
     }
     
-    /*pass the filled buffer through the master dsp unit, if any*/
-    kwlDSPUnit* dspUnit = (kwlDSPUnit*)mixer->outputDSPUnit.valueMixer;
-    if (dspUnit != NULL)
+    /*pass the filled buffer through the master dsp units, if any, skipping 
+      units that have rung out if the buffer is silent.*/
+    kwlDSPChain_processWithTails(&mixer->outputDSPChain, outBuffer, mixer->numOutChannels, 
+                                 numFrames, hasOutput == 0, cpuCost);
+    
+    if (cpuCost != NULL)
     {
-        (*dspUnit->dspCallback)(outBuffer,
-                                mixer->numOutChannels,
-                                numFrames, 
-                                dspUnit->data);
+        cpuCost->renderTicks.valueMixer += kwlCPUCost_getTicks() - renderStart;
+        cpuCost->numFrames.valueMixer += numFrames;
+    }
+    
+    kwlMixer_updateStats(mixer, kwlCPUCost_getTicks() - statsRenderStart, numFrames);
+}
+
+void kwlMixer_writeToHostBuffer(kwlMixer* mixer, 
+                                const float* samples, 
+                                void* hostBuffer, 
+                                kwlSampleFormat format, 
+                                int offset,
+                                int numFrames)
+{
+    if (hostBuffer == NULL)
+    {
+        return;
+    }
+    
+    const int sampleOffset = offset * mixer->numOutChannels;
+    const int numSamples = numFrames * mixer->numOutChannels;
+    /*the dither setting is read after rendering, when it has been updated.*/
+    kwlDitherState* dither = mixer->isDitherEnabled.valueMixer != 0 ? &mixer->ditherState : NULL;
+    
+    if (format == KWL_SAMPLE_FORMAT_FLOAT32)
+    {
+        kwlMemcpy(&((float*)hostBuffer)[sampleOffset], samples, numSamples * sizeof(float));
+    }
+    else if (format == KWL_SAMPLE_FORMAT_INT16)
+    {
+        kwlFloatToInt16Clamped(samples, &((short*)hostBuffer)[sampleOffset], numSamples, dither);
+    }
+    else
+    {
+        KWL_ASSERT(format == KWL_SAMPLE_FORMAT_INT24);
+        kwlFloatToInt24Clamped(samples, &((unsigned char*)hostBuffer)[3 * sampleOffset], numSamples, dither);
+    }
+}
+
+void kwlMixer_renderToHostBuffer(kwlMixer* mixer, void* hostBuffer, kwlSampleFormat format, int numFrames)
+{
+    const int numOutChannels = mixer->numOutChannels;
+    
+    /*play audio rendered ahead by the mixing thread, if it has taken over rendering. 
+      the render-ahead may detach itself during the read and must not be accessed after it.*/
+    kwlRenderAhead* renderAhead = mixer->renderAhead;
+    const int isRenderingAhead = renderAhead != NULL && renderAhead->isStarted;
+    int currFrame = 0;
+    if (isRenderingAhead)
+    {
+        currFrame = kwlRenderAhead_read(renderAhead, hostBuffer, format, numFrames);
+    }
+    
+    /*The mixer's temp buffers hold KWL_TEMP_BUFFER_SIZE_IN_FRAMES frames, 
+      so larger requests are rendered in multiple calls to kwlMixer_render.*/
+    while (currFrame < numFrames)
+    {
+        int numFramesToMix = numFrames - currFrame;
+        if (numFramesToMix > KWL_TEMP_BUFFER_SIZE_IN_FRAMES)
+        {
+            numFramesToMix = KWL_TEMP_BUFFER_SIZE_IN_FRAMES;
+        }
+        
+        if (hostBuffer != NULL && format == KWL_SAMPLE_FORMAT_FLOAT32)
+        {
+            kwlMixer_render(mixer, &((float*)hostBuffer)[currFrame * numOutChannels], numFramesToMix);
+        }
+        else
+        {
+            kwlMixer_render(mixer, mixer->outBuffer, numFramesToMix);
+            kwlMixer_writeToHostBuffer(mixer, mixer->outBuffer, hostBuffer, format, currFrame, numFramesToMix);
+        }
+        
+        currFrame += numFramesToMix;
+    }
+    
+    /*a render-ahead attached by the engine takes over once this buffer has been rendered.*/
+    if (renderAhead != NULL && !isRenderingAhead)
+    {
+        kwlRenderAhead_start(renderAhead);
     }
 }
 
@@ -546,15 +824,13 @@ void kwlMixer_processInputBuffer(kwlMixer* mixer,
 {
     kwlMixer_updateInput(mixer);
     
-    kwlDSPUnit* dspUnit = (kwlDSPUnit*)mixer->inputDSPUnit.valueMixer;
-    
     if (inBuffer != NULL && 
-        dspUnit != NULL &&
         mixer->numInChannels > 0)
     {
-        (*dspUnit->dspCallback)(inBuffer,
-                                mixer->numInChannels,
-                                numFrames, 
-                                dspUnit->data);
+        kwlDSPChain_process(&mixer->inputDSPChain, 
+                            (float*)inBuffer, 
+                            mixer->numInChannels, 
+                            numFrames, 
+                            mixer->isCPUProfilingEnabled.valueMixer ? &mixer->cpuCost : NULL);
     }
 }
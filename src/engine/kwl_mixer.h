@@ -25,7 +25,10 @@
 
 /*! \file */
 
+#include "kwl_cpucost.h"
 #include "kwl_decoder.h"
+#include "kwl_asm.h"
+#include "kwl_dspchain.h"
 #include "kwl_eventinstance.h"
 #include "kwl_messagequeue.h"
 #include "kwl_mixbus.h"
@@ -49,6 +52,19 @@ extern "C"
     static const float PITCH_EPSILON = 0.001f;
     
     
+    /** The sample formats the mixer can render host buffers in. */
+    typedef enum kwlSampleFormat
+    {
+        /** Interleaved 32 bit floats. */
+        KWL_SAMPLE_FORMAT_FLOAT32 = 0,
+        /** Interleaved signed 16 bit integers. */
+        KWL_SAMPLE_FORMAT_INT16,
+        /** Interleaved, packed, little endian signed 24 bit integers, i.e three bytes per sample. */
+        KWL_SAMPLE_FORMAT_INT24
+    } kwlSampleFormat;
+    
+    struct kwlRenderAhead;
+    
     /** A struct encapsulating the */
     typedef struct kwlMixer
     {
@@ -60,10 +76,21 @@ extern "C"
         kwlSharedChar isPaused;
         /** Non-zero if level metering is enabled, zero otherwise.*/
         kwlSharedChar isLevelMeteringEnabled;
-        /** The dsp unit that input audio is passed through. Can be null.*/
-        kwlSharedVoidPointer inputDSPUnit;
-        /** The dsp unit that the master output is passed through. Can be null.*/
-        kwlSharedVoidPointer outputDSPUnit;
+        /** Non-zero if integer host output is dithered, zero otherwise.*/
+        kwlSharedChar isDitherEnabled;
+        /** The DSP units that input audio is passed through.*/
+        kwlDSPChain inputDSPChain;
+        /** 
+         * Event start and stop messages sent straight from the engine thread, without
+         * waiting for the next engine update. Processed before each rendered buffer.
+         */
+        kwlImmediateMessageQueue immediateQueue;
+        /** The DSP units that the master output is passed through.*/
+        kwlDSPChain outputDSPChain;
+        /** Non-zero if CPU cost profiling is enabled, zero otherwise.*/
+        kwlSharedChar isCPUProfilingEnabled;
+        /** The number of frames per CPU cost measurement period. */
+        kwlSharedInt cpuProfilingPeriodInFrames;
         
         
         
@@ -78,6 +105,19 @@ extern "C"
         kwlSharedFloat latestBufferAbsPeakRight;
         /** Non-zero if clipping occured, zero otherwise.*/
         kwlSharedInt clipFlag;
+        /** CPU cost totals of the current (mixer) and last completed (shared, engine) measurement period. */
+        kwlMixerCPUCost cpuCost;
+        /** The number of completed CPU cost measurement periods. */
+        kwlSharedInt numCPUCostSnapshots;
+        /** Health statistics, only accessed from the mixer thread. */
+        kwlMixerStats stats;
+        /** 
+         * A copy of \c stats published after each rendered buffer without locking.
+         * Must be read using \c kwlMixer_getStats.
+         */
+        kwlMixerStats publishedStats;
+        /** Incremented before and after \c publishedStats is written, i.e odd while it is being written. */
+        volatile unsigned int publishedStatsSequence;
         
         
         
@@ -123,8 +163,19 @@ extern "C"
         float* tempEventBuffer;
         /** A temporary buffer to mix the output of mix buses into.*/
         float* tempMixBusBuffer;
+        /** A temporary buffer holding the output of events filtered as a batch.*/
+        float* tempFilterBatchBuffer;
+        /** The generator of the dither applied to integer host output. Only accessed from the mixer thread. */
+        kwlDitherState ditherState;
         /** Non-zero if the mix bus hierarchy should be reset, zero otherwise.*/
         int resetMixBusesRequested;
+        /** 
+         * The render-ahead the host callback reads rendered audio from, or NULL if the host
+         * callback renders the mixer itself. Set by the engine thread, cleared by the host callback.
+         */
+        struct kwlRenderAhead* volatile renderAhead;
+        /** The number of host buffers the render-ahead could not fill completely. Only written by the host callback. */
+        volatile int numRenderAheadUnderruns;
         /** */
         kwlMutexLock* mixerEngineMutexLock;
     } kwlMixer;
@@ -147,9 +198,22 @@ extern "C"
     void kwlMixer_resetMixBuses(kwlMixer* mixer);
     /** Processes any enqueued incoming messages from the engine thread. */
     void kwlMixer_processMessages(kwlMixer* mixer);
+    /** Processes any messages sent from the engine thread through the immediate message queue. */
+    void kwlMixer_processImmediateMessages(kwlMixer* mixer);
     void kwlMixer_updateOutput(kwlMixer* mixer);
     void kwlMixer_updateInput(kwlMixer* mixer);
     void kwlMixer_allocateTempBuffers(kwlMixer* mixer);
+    /** 
+     * Publishes the CPU costs accumulated during the current measurement period, or discards
+     * them if \c publish is zero. Must be called with the engine/mixer lock held.
+     */
+    void kwlMixer_publishCPUCosts(kwlMixer* mixer, int publish);
+    
+    /** 
+     * Gets a consistent copy of the mixer statistics published by the mixer thread. 
+     * Never blocks the mixer thread, but may have to retry if the mixer is publishing.
+     */
+    void kwlMixer_getStats(kwlMixer* mixer, kwlMixerStats* stats);
     
     /**
      * Performs mixing into an output buffer of a given size.
@@ -159,6 +223,36 @@ extern "C"
      */
     void kwlMixer_render(kwlMixer* mixer, float* outBuffer, int numFrames);
     
+    /**
+     * Renders a host buffer of any size in a given sample format. Float output is rendered
+     * straight into the host buffer in chunks of at most \c KWL_TEMP_BUFFER_SIZE_IN_FRAMES 
+     * frames. Integer output is rendered into the mixer's output buffer chunk by chunk and 
+     * clamped, optionally dithered and converted into the host buffer in a single pass, 
+     * while the chunk is still in the cache.
+     * @param mixer The mixer responsible for the mixing.
+     * @param hostBuffer The interleaved buffer to render into, or NULL to discard the output.
+     * @param format The sample format of \c hostBuffer.
+     * @param numFrames The buffer size in frames.
+     */
+    void kwlMixer_renderToHostBuffer(kwlMixer* mixer, void* hostBuffer, kwlSampleFormat format, int numFrames);
+    
+    /**
+     * Clamps, optionally dithers and converts rendered samples into a host buffer 
+     * in a given sample format. Must be called from the host callback.
+     * @param mixer The mixer that rendered the samples.
+     * @param samples The interleaved rendered samples.
+     * @param hostBuffer The interleaved buffer to write to, or NULL to discard the samples.
+     * @param format The sample format of \c hostBuffer.
+     * @param offset The frame of \c hostBuffer to start writing at.
+     * @param numFrames The number of frames to write.
+     */
+    void kwlMixer_writeToHostBuffer(kwlMixer* mixer, 
+                                    const float* samples, 
+                                    void* hostBuffer, 
+                                    kwlSampleFormat format, 
+                                    int offset,
+                                    int numFrames);
+    
     /**
      * This method passes an input buffer of a given size to the input dsp unit, if any.
      * @param mixer The mixer.
@@ -30,31 +30,25 @@ extern "C"
 {
 #endif /* __cplusplus */
 
-/** A set of mix bus parameters completely defining the state of a single mixbus. */
-typedef struct kwlMixBusParameters
-{
-    /** 
-     * The index into the mix bus array 
-     * of the mix bus associated with this parameter set
-     */
-    int mixBusIndex;
-    /** The logarithmic gain of the left channel.*/
-    float logGainLeft;
-    /** The logarithmic gain of the right channel.*/
-    float logGainRight;
-    /** The pitch.*/
-    float pitch;
-} kwlMixBusParameters;
-
-/** A collection of mix bus parameter sets, completely defining the state of the entire mix bus hierarchy. */
+/** 
+ * A collection of mix bus parameters, completely defining the state of the entire mix bus hierarchy.
+ * Parameters are stored densely, one entry per mix bus and indexed by mix bus index, 
+ * so that presets can be blended with straight multiply-accumulate loops.
+ */
 typedef struct kwlMixPreset
 {
     /** The ID of the mix preset*/
     char* id; 
     /** The number of parameter sets in this preset. Should equal the number of mix buses.*/
     int numParameterSets;
-    /** An array of parameter sets, one for each mix bus.*/
-    kwlMixBusParameters* parameterSets;
+    /** The logarithmic left channel gain of each mix bus.*/
+    float* logGainLeft;
+    /** The logarithmic right channel gain of each mix bus.*/
+    float* logGainRight;
+    /** The pitch of each mix bus.*/
+    float* pitch;
+    /** The number of seconds it takes to fade to this preset.*/
+    float fadeTime;
     /** The target blending weight of the preset. 0 - 1*/
     float targetWeight;
     /** The current blending weight of the preset. 0 - 1*/
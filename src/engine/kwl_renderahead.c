@@ -0,0 +1,249 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kwl_eventinstance.h"
+#include "kwl_renderahead.h"
+#include "kwl_assert.h"
+#include "kwl_memory.h"
+
+#include <limits.h>
+#include <stdio.h>
+
+/** Returns the number of rendered frames between a read position and a write position. */
+static int kwlRenderAhead_getNumFramesAhead(kwlRenderAhead* renderAhead, int readPosition, int writePosition)
+{
+    const int positionRange = 2 * renderAhead->ringSize;
+    return (writePosition - readPosition + positionRange) % positionRange;
+}
+
+static void* kwlRenderAhead_mixLoop(void* data)
+{
+    kwlRenderAhead* renderAhead = (kwlRenderAhead*)data;
+    const int blockSize = renderAhead->blockSize;
+    
+    while (renderAhead->isStopRequested == 0)
+    {
+        kwlSemaphoreWait(renderAhead->semaphore);
+        
+        if (renderAhead->isStarted == 0)
+        {
+            continue;
+        }
+        
+        /*top up the ring to the current lead time, one block at a time.*/
+        while (renderAhead->isStopRequested == 0)
+        {
+            const int writePosition = renderAhead->writePosition;
+            const int numFramesAhead = kwlRenderAhead_getNumFramesAhead(renderAhead, 
+                                                                        renderAhead->readPosition, 
+                                                                        writePosition);
+            if (numFramesAhead + blockSize > renderAhead->numBlocksAhead * blockSize)
+            {
+                break;
+            }
+            
+            /*blocks never straddle the end of the ring, since its size is a multiple of the block size.*/
+            const int ringFrame = writePosition % renderAhead->ringSize;
+            kwlMixer_render(renderAhead->mixer, 
+                            &renderAhead->ring[ringFrame * renderAhead->numChannels], 
+                            blockSize);
+            
+            /*publish the block only once it has been written.*/
+            kwlMemoryBarrier();
+            renderAhead->writePosition = (writePosition + blockSize) % (2 * renderAhead->ringSize);
+        }
+    }
+    
+    kwlMemoryBarrier();
+    renderAhead->isThreadStopped = 1;
+    
+    return NULL;
+}
+
+kwlRenderAhead* kwlRenderAhead_new(kwlMixer* mixer, int blockSize, int maxNumBlocksAhead)
+{
+    KWL_ASSERT(blockSize > 0 && blockSize <= KWL_TEMP_BUFFER_SIZE_IN_FRAMES);
+    KWL_ASSERT(maxNumBlocksAhead > 0 && maxNumBlocksAhead <= KWL_RENDER_AHEAD_MAX_NUM_BLOCKS);
+    
+    kwlRenderAhead* renderAhead = (kwlRenderAhead*)KWL_MALLOCANDZERO(sizeof(kwlRenderAhead), "render-ahead");
+    renderAhead->mixer = mixer;
+    renderAhead->blockSize = blockSize;
+    renderAhead->maxNumBlocksAhead = maxNumBlocksAhead;
+    renderAhead->numChannels = mixer->numOutChannels;
+    renderAhead->ringSize = blockSize * maxNumBlocksAhead;
+    renderAhead->ring = (float*)KWL_MALLOCANDZERO(renderAhead->ringSize * renderAhead->numChannels * sizeof(float), 
+                                                  "render-ahead ring");
+    
+    /*start with the longest lead time and let it shrink if the mixing thread keeps up.*/
+    renderAhead->numBlocksAhead = maxNumBlocksAhead;
+    renderAhead->minNumFramesToSpare = INT_MAX;
+    renderAhead->relaxPeriodInFrames = (int)(KWL_RENDER_AHEAD_RELAX_PERIOD_SEC * mixer->sampleRate);
+    
+    /*create a semaphore with a unique name based on the address of the render-ahead.*/
+    sprintf(renderAhead->semaphoreName, "renderahead%p", (void*)renderAhead);
+    renderAhead->semaphore = kwlSemaphoreOpen(renderAhead->semaphoreName);
+    
+    kwlThreadCreate(&renderAhead->thread, kwlRenderAhead_mixLoop, renderAhead);
+    kwlThreadSetRealTimePriority(&renderAhead->thread);
+    
+    return renderAhead;
+}
+
+void kwlRenderAhead_requestStop(kwlRenderAhead* renderAhead)
+{
+    renderAhead->isStopRequested = 1;
+    kwlMemoryBarrier();
+    kwlSemaphorePost(renderAhead->semaphore);
+}
+
+void kwlRenderAhead_free(kwlRenderAhead* renderAhead)
+{
+    kwlRenderAhead_requestStop(renderAhead);
+    kwlThreadJoin(&renderAhead->thread);
+    
+    kwlSemaphoreDestroy(renderAhead->semaphore, renderAhead->semaphoreName);
+    KWL_FREE(renderAhead->ring);
+    KWL_FREE(renderAhead);
+}
+
+/** Hands rendering back to the host callback. The render-ahead must not be accessed by the callback afterwards. */
+static void kwlRenderAhead_detach(kwlRenderAhead* renderAhead)
+{
+    renderAhead->mixer->renderAhead = NULL;
+    kwlMemoryBarrier();
+    renderAhead->isDetached = 1;
+}
+
+void kwlRenderAhead_start(kwlRenderAhead* renderAhead)
+{
+    if (renderAhead->isStopRequested != 0)
+    {
+        kwlRenderAhead_detach(renderAhead);
+        return;
+    }
+    
+    renderAhead->isStarted = 1;
+    kwlMemoryBarrier();
+    kwlSemaphorePost(renderAhead->semaphore);
+}
+
+/** Fills a range of frames of a host buffer with silence. */
+static void kwlRenderAhead_writeSilence(kwlRenderAhead* renderAhead, 
+                                        void* hostBuffer, 
+                                        kwlSampleFormat format, 
+                                        int offset, 
+                                        int numFrames)
+{
+    if (hostBuffer == NULL)
+    {
+        return;
+    }
+    
+    const int bytesPerSample = format == KWL_SAMPLE_FORMAT_FLOAT32 ? sizeof(float) : 
+                               format == KWL_SAMPLE_FORMAT_INT16 ? sizeof(short) : 3;
+    const int bytesPerFrame = bytesPerSample * renderAhead->numChannels;
+    kwlMemset(&((unsigned char*)hostBuffer)[offset * bytesPerFrame], 0, numFrames * bytesPerFrame);
+}
+
+/** Adapts the lead time after a read that left a given number of frames in the ring, or -1 after an underrun. */
+static void kwlRenderAhead_adaptLead(kwlRenderAhead* renderAhead, int numFramesToSpare, int numFramesRead)
+{
+    if (numFramesToSpare < 0)
+    {
+        if (renderAhead->numBlocksAhead < renderAhead->maxNumBlocksAhead)
+        {
+            renderAhead->numBlocksAhead++;
+        }
+        renderAhead->minNumFramesToSpare = INT_MAX;
+        renderAhead->numFramesInRelaxPeriod = 0;
+        return;
+    }
+    
+    if (numFramesToSpare < renderAhead->minNumFramesToSpare)
+    {
+        renderAhead->minNumFramesToSpare = numFramesToSpare;
+    }
+    
+    renderAhead->numFramesInRelaxPeriod += numFramesRead;
+    if (renderAhead->numFramesInRelaxPeriod >= renderAhead->relaxPeriodInFrames)
+    {
+        /*a whole block was never needed during the relax period, so one less is rendered ahead.*/
+        if (renderAhead->minNumFramesToSpare >= renderAhead->blockSize &&
+            renderAhead->numBlocksAhead > 1)
+        {
+            renderAhead->numBlocksAhead--;
+        }
+        renderAhead->minNumFramesToSpare = INT_MAX;
+        renderAhead->numFramesInRelaxPeriod = 0;
+    }
+}
+
+int kwlRenderAhead_read(kwlRenderAhead* renderAhead, void* hostBuffer, kwlSampleFormat format, int numFrames)
+{
+    kwlMixer* mixer = renderAhead->mixer;
+    
+    /*the stop flag is read before the write position, so that no block published 
+      before the thread stopped is missed.*/
+    const int isThreadStopped = renderAhead->isThreadStopped;
+    kwlMemoryBarrier();
+    const int writePosition = renderAhead->writePosition;
+    const int readPosition = renderAhead->readPosition;
+    const int numFramesAhead = kwlRenderAhead_getNumFramesAhead(renderAhead, readPosition, writePosition);
+    const int numFramesToRead = numFramesAhead < numFrames ? numFramesAhead : numFrames;
+    
+    /*copy the rendered frames in at most two parts, since they may wrap around the end of the ring.*/
+    const int ringFrame = readPosition % renderAhead->ringSize;
+    int numFramesBeforeWrap = renderAhead->ringSize - ringFrame;
+    if (numFramesBeforeWrap > numFramesToRead)
+    {
+        numFramesBeforeWrap = numFramesToRead;
+    }
+    kwlMixer_writeToHostBuffer(mixer, &renderAhead->ring[ringFrame * renderAhead->numChannels], 
+                               hostBuffer, format, 0, numFramesBeforeWrap);
+    kwlMixer_writeToHostBuffer(mixer, renderAhead->ring, 
+                               hostBuffer, format, numFramesBeforeWrap, numFramesToRead - numFramesBeforeWrap);
+    
+    /*hand the frames back to the mixing thread only once they have been copied.*/
+    kwlMemoryBarrier();
+    renderAhead->readPosition = (readPosition + numFramesToRead) % (2 * renderAhead->ringSize);
+    
+    if (isThreadStopped && numFramesToRead < numFrames)
+    {
+        /*everything rendered ahead has been played. the caller renders the rest.*/
+        kwlRenderAhead_detach(renderAhead);
+        return numFramesToRead;
+    }
+    
+    if (numFramesToRead < numFrames)
+    {
+        kwlRenderAhead_writeSilence(renderAhead, hostBuffer, format, numFramesToRead, numFrames - numFramesToRead);
+        mixer->numRenderAheadUnderruns++;
+    }
+    
+    kwlRenderAhead_adaptLead(renderAhead, numFramesAhead - numFrames, numFrames);
+    
+    /*let the mixing thread top up the ring.*/
+    kwlSemaphorePost(renderAhead->semaphore);
+    
+    return numFrames;
+}
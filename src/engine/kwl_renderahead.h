@@ -0,0 +1,160 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef KWL_RENDER_AHEAD_H
+#define KWL_RENDER_AHEAD_H
+
+/*! \file */ 
+
+#include "kwl_mixer.h"
+#include "kwl_synchronization.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** The largest number of blocks that can be rendered ahead. */
+#define KWL_RENDER_AHEAD_MAX_NUM_BLOCKS 64
+    
+/** 
+ * The length in seconds of the windows over which the host callback measures how
+ * much rendered audio it had to spare, to decide if the lead time can be reduced.
+ */
+#define KWL_RENDER_AHEAD_RELAX_PERIOD_SEC 2.0f
+
+/**
+ * A mixing thread that renders blocks of audio ahead of the host audio callback into a 
+ * lock-free single producer, single consumer ring, so that the callback only has to copy 
+ * rendered audio. The lead time adapts to the load: it grows by one block whenever 
+ * the callback finds too little audio in the ring and shrinks by one block when the 
+ * callback had at least a block to spare during a whole relax period.
+ *
+ * The host callback owns the hand-overs between rendering in the callback and rendering
+ * in the mixing thread, so that the mixer is never rendered by two threads at once:
+ * the mixing thread starts rendering once the callback has rendered a buffer after the 
+ * render-ahead was attached, and the callback detaches the render-ahead and resumes 
+ * rendering once a stop has been requested, the mixing thread has stopped and the 
+ * audio rendered ahead has been played.
+ */
+typedef struct kwlRenderAhead
+{
+    /** The mixer to render. */
+    kwlMixer* mixer;
+    /** The number of frames per rendered block. */
+    int blockSize;
+    /** The maximum number of blocks rendered ahead. */
+    int maxNumBlocksAhead;
+    /** The number of interleaved channels of the ring. */
+    int numChannels;
+    /** The ring of rendered frames, holding \c maxNumBlocksAhead blocks. */
+    float* ring;
+    /** The number of frames the ring holds. */
+    int ringSize;
+    /** 
+     * The position after the last rendered frame, in the range [0, 2 * ringSize) so that 
+     * a full ring can be told from an empty one. Only written by the mixing thread. 
+     */
+    volatile int writePosition;
+    /** The position of the next frame to play, like \c writePosition. Only written by the host callback. */
+    volatile int readPosition;
+    /** The current number of blocks to render ahead. Only written by the host callback. */
+    volatile int numBlocksAhead;
+    
+    //host callback only
+    /** The smallest number of frames left in the ring after a read during the current relax period. */
+    int minNumFramesToSpare;
+    /** The number of frames read during the current relax period. */
+    int numFramesInRelaxPeriod;
+    /** The number of frames per relax period. */
+    int relaxPeriodInFrames;
+    
+    //hand-over flags
+    /** Non-zero once the host callback has handed rendering over to the mixing thread. */
+    volatile int isStarted;
+    /** Non-zero once the engine has requested the mixing thread to stop. */
+    volatile int isStopRequested;
+    /** Non-zero once the mixing thread will not render any more blocks. */
+    volatile int isThreadStopped;
+    /** 
+     * Non-zero once the host callback has resumed rendering and will not access this
+     * render-ahead again, i.e when it may be freed. 
+     */
+    volatile int isDetached;
+    
+    /** The mixing thread. */
+    kwlThread thread;
+    /** Posted when the mixing thread may have something to do. */
+    kwlSemaphore* semaphore;
+    /** The unique name of \c semaphore. */
+    char semaphoreName[64];
+} kwlRenderAhead;
+
+/**
+ * Creates a render-ahead for a given mixer and starts its mixing thread, which waits 
+ * until the host callback hands rendering over to it.
+ * @param mixer The mixer to render.
+ * @param blockSize The number of frames per block, at most \c KWL_TEMP_BUFFER_SIZE_IN_FRAMES.
+ * @param maxNumBlocksAhead The maximum number of blocks to render ahead, at most 
+ * \c KWL_RENDER_AHEAD_MAX_NUM_BLOCKS.
+ * @return The new render-ahead.
+ */
+kwlRenderAhead* kwlRenderAhead_new(kwlMixer* mixer, int blockSize, int maxNumBlocksAhead);
+
+/**
+ * Requests the mixing thread of a render-ahead to stop. Must be called from the engine thread.
+ * The host callback detaches the render-ahead once the audio rendered ahead has been played.
+ */
+void kwlRenderAhead_requestStop(kwlRenderAhead* renderAhead);
+
+/**
+ * Stops the mixing thread of a render-ahead if it is running and frees the render-ahead.
+ * Must only be called once the render-ahead has been detached or the host callback has stopped.
+ */
+void kwlRenderAhead_free(kwlRenderAhead* renderAhead);
+
+/**
+ * Copies frames rendered ahead into a host buffer, converting them to a given sample format.
+ * Missing frames are replaced by silence while the mixing thread is running. Must be 
+ * called from the host callback once the render-ahead has been started.
+ * @param renderAhead The render-ahead. Must not be accessed after this call if it detached itself.
+ * @param hostBuffer The interleaved buffer to fill, or NULL to discard the frames.
+ * @param format The sample format of \c hostBuffer.
+ * @param numFrames The number of frames to fill.
+ * @return The number of frames filled. Fewer than \c numFrames if the render-ahead
+ * detached itself, in which case the host callback must render the remaining frames.
+ */
+int kwlRenderAhead_read(kwlRenderAhead* renderAhead, void* hostBuffer, kwlSampleFormat format, int numFrames);
+
+/**
+ * Hands rendering over to the mixing thread, or detaches the render-ahead if a stop 
+ * was requested before it was started. Must be called from the host callback after
+ * it has rendered a buffer.
+ */
+void kwlRenderAhead_start(kwlRenderAhead* renderAhead);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_RENDER_AHEAD_H*/
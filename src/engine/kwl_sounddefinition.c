@@ -21,6 +21,7 @@ freely, subject to the following restrictions:
    distribution.
 */
 
+#include "kwl_asm.h"
 #include "kwl_memory.h"
 #include "kwl_sounddefinition.h"
 
@@ -67,7 +68,7 @@ int kwlSoundDefinition_pickNextBufferForEvent(kwlSoundDefinition* sound, kwlEven
                      sound->playbackCount >= 0;
     
     /*compute new pitch*/
-    float randVal = -1 + 0.0002f * (rand() % 10000);
+    float randVal = -1 + 0.0002f * (kwlRandomNext(&event->randomState) % 10000);
     float newPitch = sound->pitch + randVal * 0.01f * sound->pitchVariation;
     if (newPitch < PITCH_EPSILON)
     {
@@ -77,7 +78,7 @@ int kwlSoundDefinition_pickNextBufferForEvent(kwlSoundDefinition* sound, kwlEven
     event->soundPitch = newPitch;
     
     /*compute new gain*/
-    randVal = -1 + 0.0002f * (rand() % 10000);
+    randVal = -1 + 0.0002f * (kwlRandomNext(&event->randomState) % 10000);
     float newGain = sound->gain + randVal * 0.01f * sound->gainVariation;
     if (newGain < 0.0f)
     {
@@ -89,13 +90,13 @@ int kwlSoundDefinition_pickNextBufferForEvent(kwlSoundDefinition* sound, kwlEven
     if (sound->playbackMode == KWL_RANDOM)
     {
         /*Pick a new random audio data index.*/
-        newIndex = rand() % sound->numAudioDataEntries;
+        newIndex = kwlRandomNext(&event->randomState) % sound->numAudioDataEntries;
     }
     else if (sound->playbackMode == KWL_RANDOM_NO_REPEAT)
     {
         /*Pick a new random audio data index and make sure it's not the same
          as the last one (it will be in the degenerate case of 1 item).*/
-        newIndex = rand() % sound->numAudioDataEntries;
+        newIndex = kwlRandomNext(&event->randomState) % sound->numAudioDataEntries;
         if (newIndex == event->currentAudioDataIndex)
         {
             newIndex = (newIndex + 1) % sound->numAudioDataEntries;
@@ -135,7 +136,7 @@ int kwlSoundDefinition_pickNextBufferForEvent(kwlSoundDefinition* sound, kwlEven
             }
             else
             {
-                newIndex = 1 + rand() % (sound->numAudioDataEntries - 2);
+                newIndex = 1 + kwlRandomNext(&event->randomState) % (sound->numAudioDataEntries - 2);
             }
         }
     }
@@ -161,7 +162,7 @@ int kwlSoundDefinition_pickNextBufferForEvent(kwlSoundDefinition* sound, kwlEven
             }
             else
             {
-                newIndex = 1 + rand() % (sound->numAudioDataEntries - 2);
+                newIndex = 1 + kwlRandomNext(&event->randomState) % (sound->numAudioDataEntries - 2);
                 if (newIndex == event->currentAudioDataIndex)
                 {
                     newIndex = (newIndex + 1) % (sound->numAudioDataEntries - 2);
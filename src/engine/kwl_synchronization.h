@@ -41,7 +41,7 @@ extern "C"
     #include <windows.h>
     typedef CRITICAL_SECTION kwlMutexLock;
     //TODO kwlSemaphore
-    //TODO kwlThread
+    typedef HANDLE kwlThread;
 #else
     #include <semaphore.h>
     #include <pthread.h>
@@ -188,12 +188,48 @@ void kwlMutexLockAcquire(kwlMutexLock* lock);
  */
 void kwlMutexLockRelease(kwlMutexLock* lock);
     
+/**
+ * A full memory barrier, preventing both the compiler and the CPU from reordering 
+ * memory accesses across the call. Used for data shared between threads without locking.
+ */
+void kwlMemoryBarrier(void);
+
+/**
+ * Atomically replaces a value with \c desired if it equals \c expected. Acts as a full memory barrier.
+ * @return Non-zero if the value was replaced, zero otherwise.
+ */
+int kwlAtomicCompareAndSwap(volatile unsigned int* value, unsigned int expected, unsigned int desired);
+
+/**
+ * Atomically adds \c amount to a value. Acts as a full memory barrier.
+ * @return The new value.
+ */
+unsigned int kwlAtomicAdd(volatile unsigned int* value, int amount);
+
+/**
+ * Atomically reads a pointer that other threads may replace. Acts as a full memory barrier.
+ * @return The current value of the pointer.
+ */
+void* kwlAtomicLoadPointer(void* volatile* pointer);
+
+/**
+ * Atomically replaces a pointer with \c desired if it equals \c expected. Acts as a full memory barrier.
+ * @return Non-zero if the pointer was replaced, zero otherwise.
+ */
+int kwlAtomicCompareAndSwapPointer(void* volatile* pointer, void* expected, void* desired);
+    
 typedef void * (*kwlThreadEntryPoint)(void* data);
     
 void kwlThreadCreate(kwlThread* thread, kwlThreadEntryPoint entryPoint, void* data);
     
 void kwlThreadJoin(kwlThread* thread);
 
+/**
+ * Gives a thread the highest real time scheduling priority available, for threads
+ * that render audio. Fails silently if the process is not allowed to raise priorities.
+ */
+void kwlThreadSetRealTimePriority(kwlThread* thread);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
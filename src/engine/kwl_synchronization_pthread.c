@@ -25,6 +25,7 @@ freely, subject to the following restrictions:
 #include "kwl_assert.h"
 #include <semaphore.h>
 #include <pthread.h>
+#include <sched.h>
 #include <errno.h>
 #include <stdio.h>
 
@@ -112,28 +113,32 @@ void kwlSemaphoreWait(kwlSemaphore* semaphore)
 {
     int rc = sem_wait(semaphore);
     //printf("errno %d\n", errno);
-    switch (errno) {
-        case EBADF:
-            KWL_ASSERT(0);
-            break;
-        case EAGAIN:
-            KWL_ASSERT(0);
-            break;
-        case EINVAL:
-            KWL_ASSERT(0);
-            break;
-        case ENOSYS:
-            KWL_ASSERT(0);
-            break;
-        case EDEADLK:
-            KWL_ASSERT(0);
-            break;
-        case EINTR:
-            KWL_ASSERT(0);
-            break;
-        default:
-            break;
-    }        
+    if (rc != 0)
+    {
+        /*errno is only meaningful if the wait failed.*/
+        switch (errno) {
+            case EBADF:
+                KWL_ASSERT(0);
+                break;
+            case EAGAIN:
+                KWL_ASSERT(0);
+                break;
+            case EINVAL:
+                KWL_ASSERT(0);
+                break;
+            case ENOSYS:
+                KWL_ASSERT(0);
+                break;
+            case EDEADLK:
+                KWL_ASSERT(0);
+                break;
+            case EINTR:
+                KWL_ASSERT(0);
+                break;
+            default:
+                break;
+        }
+    }
     KWL_ASSERT(rc == 0);
 }
 
@@ -177,8 +182,8 @@ kwlMutexLockAcquisitionResult kwlMutexLockTryAcquire(kwlMutexLock* lock)
 
 void kwlMutexLockAcquire(kwlMutexLock* lock)
 {
-    int rc = pthread_mutex_trylock(lock);
-    KWL_ASSERT(rc == 0 || rc == EBUSY);
+    int rc = pthread_mutex_lock(lock);
+    KWL_ASSERT(rc == 0);
 }
 
 void kwlMutexLockRelease(kwlMutexLock* lock)
@@ -187,6 +192,31 @@ void kwlMutexLockRelease(kwlMutexLock* lock)
     KWL_ASSERT(rc == 0);
 }
 
+void kwlMemoryBarrier(void)
+{
+    __sync_synchronize();
+}
+
+int kwlAtomicCompareAndSwap(volatile unsigned int* value, unsigned int expected, unsigned int desired)
+{
+    return __sync_bool_compare_and_swap(value, expected, desired);
+}
+
+unsigned int kwlAtomicAdd(volatile unsigned int* value, int amount)
+{
+    return __sync_add_and_fetch(value, (unsigned int)amount);
+}
+
+void* kwlAtomicLoadPointer(void* volatile* pointer)
+{
+    return __sync_val_compare_and_swap(pointer, NULL, NULL);
+}
+
+int kwlAtomicCompareAndSwapPointer(void* volatile* pointer, void* expected, void* desired)
+{
+    return __sync_bool_compare_and_swap(pointer, expected, desired);
+}
+
 void kwlThreadCreate(kwlThread* thread, kwlThreadEntryPoint entryPoint, void* data)
 {
     int rc = pthread_create(thread, NULL, entryPoint, data);
@@ -220,3 +250,11 @@ void kwlThreadJoin(kwlThread* thread)
     
     debugThreadCount--;
 }
+
+void kwlThreadSetRealTimePriority(kwlThread* thread)
+{
+    struct sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    /*this requires privileges on most systems. the thread keeps its priority if it fails.*/
+    pthread_setschedparam(*thread, SCHED_FIFO, &param);
+}
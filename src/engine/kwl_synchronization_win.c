@@ -69,3 +69,34 @@ void kwlMutexLockRelease(kwlMutexLock* lock)
 {
     LeaveCriticalSection(&lock);
 }
+
+void kwlMemoryBarrier(void)
+{
+    MemoryBarrier();
+}
+
+int kwlAtomicCompareAndSwap(volatile unsigned int* value, unsigned int expected, unsigned int desired)
+{
+    return (unsigned int)InterlockedCompareExchange((volatile LONG*)value, (LONG)desired, (LONG)expected) == expected;
+}
+
+unsigned int kwlAtomicAdd(volatile unsigned int* value, int amount)
+{
+    return (unsigned int)InterlockedExchangeAdd((volatile LONG*)value, (LONG)amount) + (unsigned int)amount;
+}
+
+void* kwlAtomicLoadPointer(void* volatile* pointer)
+{
+    return InterlockedCompareExchangePointer(pointer, NULL, NULL);
+}
+
+int kwlAtomicCompareAndSwapPointer(void* volatile* pointer, void* expected, void* desired)
+{
+    return InterlockedCompareExchangePointer(pointer, desired, expected) == expected;
+}
+
+void kwlThreadSetRealTimePriority(kwlThread* thread)
+{
+    /*the thread keeps its priority if this fails.*/
+    SetThreadPriority(*thread, THREAD_PRIORITY_TIME_CRITICAL);
+}
@@ -29,6 +29,265 @@
 #include "kwl_engine.h"
 #include "kwl_wavebank.h"
 
+/** A process-wide list of the wave bank audio data shared between engine instances. */
+static kwlSharedWaveBankData* sharedWaveBankDataList = NULL;
+/** A spin lock protecting \c sharedWaveBankDataList, non-zero when held. */
+static volatile unsigned int sharedWaveBankDataLock = 0;
+
+static void kwlWaveBank_lockSharedData(void)
+{
+    while (kwlAtomicCompareAndSwap(&sharedWaveBankDataLock, 0, 1) == 0)
+    {
+        /*wave bank loading is rare and the lock is only held for list lookups, so just spin.*/
+    }
+}
+
+static void kwlWaveBank_unlockSharedData(void)
+{
+    kwlMemoryBarrier();
+    sharedWaveBankDataLock = 0;
+}
+
+/**
+ * Writes a normalized form of a wave bank file path, so that different spellings of the path 
+ * to the same file share their audio data. Backslashes become slashes and empty, "." and 
+ * resolvable ".." components are removed. The path is not looked up in the file system.
+ * @param path The path to normalize.
+ * @param normalizedPath Receives the normalized path. Must have room for strlen(path) + 2 characters.
+ */
+static void kwlWaveBank_normalizePath(const char* path, char* normalizedPath)
+{
+    int length = 0;
+    /*the leading part of the path that ".." components can't remove, i.e a drive and/or a root slash.*/
+    int rootLength = 0;
+    const char* component = path;
+    const char* colon = strchr(path, ':');
+    if (colon != NULL && strcspn(path, "/\\") > (size_t)(colon - path))
+    {
+        rootLength = (int)(colon - path) + 1;
+        kwlMemcpy(normalizedPath, path, rootLength);
+        component += rootLength;
+    }
+    if (*component == '/' || *component == '\\')
+    {
+        normalizedPath[rootLength++] = '/';
+    }
+    length = rootLength;
+    
+    while (*component != '\0')
+    {
+        const char* end = component;
+        while (*end != '\0' && *end != '/' && *end != '\\')
+        {
+            end++;
+        }
+        const int componentLength = (int)(end - component);
+        const int isCurrent = componentLength == 1 && component[0] == '.';
+        const int isParent = componentLength == 2 && component[0] == '.' && component[1] == '.';
+        
+        /*the start of the last component written, if any.*/
+        int lastStart = length;
+        while (lastStart > rootLength && normalizedPath[lastStart - 1] != '/')
+        {
+            lastStart--;
+        }
+        const int isLastParent = length - lastStart == 2 && 
+                                 normalizedPath[lastStart] == '.' && normalizedPath[lastStart + 1] == '.';
+        
+        if (componentLength == 0 || isCurrent)
+        {
+            /*nothing to add.*/
+        }
+        else if (isParent && length > rootLength && isLastParent == 0)
+        {
+            length = lastStart > rootLength ? lastStart - 1 : rootLength;
+        }
+        else if (isParent && rootLength > 0 && normalizedPath[rootLength - 1] == '/' && length == rootLength)
+        {
+            /*the parent of the root is the root.*/
+        }
+        else
+        {
+            if (length > rootLength)
+            {
+                normalizedPath[length++] = '/';
+            }
+            kwlMemcpy(&normalizedPath[length], component, componentLength);
+            length += componentLength;
+        }
+        
+        component = *end != '\0' ? end + 1 : end;
+    }
+    
+    if (length == 0)
+    {
+        normalizedPath[length++] = '.';
+    }
+    normalizedPath[length] = '\0';
+}
+
+/** Returns a hash of a normalized wave bank file path, used to find shared wave bank data without comparing paths. */
+static unsigned int kwlWaveBank_hashPath(const char* normalizedPath)
+{
+    /*FNV-1a*/
+    unsigned int hash = 2166136261u;
+    for (const char* c = normalizedPath; *c != '\0'; c++)
+    {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    return hash;
+}
+
+/** 
+ * Returns the shared wave bank data loaded from a given normalized path, or NULL.
+ * The shared data lock must be held.
+ */
+static kwlSharedWaveBankData* kwlWaveBank_findSharedData(const char* normalizedPath, unsigned int pathHash)
+{
+    kwlSharedWaveBankData* sharedData = sharedWaveBankDataList;
+    while (sharedData != NULL && 
+           (sharedData->pathHash != pathHash || strcmp(sharedData->path, normalizedPath) != 0))
+    {
+        sharedData = sharedData->next;
+    }
+    return sharedData;
+}
+
+/** 
+ * Points the audio data entries of a wave bank to some shared wave bank data loaded by another 
+ * engine instance. The shared data lock must be held. Entries are matched by index, since the
+ * entries of a wave bank are listed in the same order by all instances using the same engine data.
+ * @return Non-zero if the entries of the wave bank match the shared data and were bound, zero 
+ * otherwise, in which case the wave bank should load its own copy of the audio data.
+ */
+static int kwlWaveBank_bindSharedData(kwlWaveBank* waveBank, kwlSharedWaveBankData* sharedData)
+{
+    if (sharedData->numAudioDataEntries != waveBank->numAudioDataEntries)
+    {
+        return 0;
+    }
+    
+    for (int i = 0; i < waveBank->numAudioDataEntries; i++)
+    {
+        if (strcmp(sharedData->audioDataItems[i].filePath, waveBank->audioDataItems[i].filePath) != 0)
+        {
+            return 0;
+        }
+    }
+    
+    for (int i = 0; i < waveBank->numAudioDataEntries; i++)
+    {
+        kwlAudioData* audioData = &waveBank->audioDataItems[i];
+        const kwlAudioData* sharedAudioData = &sharedData->audioDataItems[i];
+        
+        /*free any old data*/
+        kwlAudioData_free(audioData);
+        
+        audioData->numFrames = sharedAudioData->numFrames;
+        audioData->numChannels = sharedAudioData->numChannels;
+        audioData->numBytes = sharedAudioData->numBytes;
+        audioData->encoding = sharedAudioData->encoding;
+        audioData->streamFromDisk = sharedAudioData->streamFromDisk;
+        audioData->fileOffset = sharedAudioData->fileOffset;
+        audioData->bytes = sharedAudioData->bytes;
+        audioData->isLoaded = 1;
+    }
+    
+    sharedData->referenceCount++;
+    waveBank->sharedData = sharedData;
+    waveBank->isLoaded = 1;
+    return 1;
+}
+
+/**
+ * Hands the sample memory of a freshly loaded wave bank over to a new shared wave bank data 
+ * entry, so that other engine instances loading the same file can use it. Does nothing if 
+ * another instance has shared data for the same file in the meantime.
+ * @param normalizedPath The normalized path of the wave bank file.
+ * @param pathHash The hash of \c normalizedPath.
+ */
+static void kwlWaveBank_shareAudioData(kwlWaveBank* waveBank, const char* normalizedPath, unsigned int pathHash)
+{
+    kwlWaveBank_lockSharedData();
+    
+    kwlSharedWaveBankData* sharedData = kwlWaveBank_findSharedData(normalizedPath, pathHash);
+    
+    if (sharedData == NULL)
+    {
+        sharedData = (kwlSharedWaveBankData*)KWL_MALLOCANDZERO(sizeof(kwlSharedWaveBankData), "shared wave bank data");
+        sharedData->path = (char*)KWL_MALLOC((strlen(normalizedPath) + 1) * sizeof(char), "shared wave bank path string");
+        strcpy(sharedData->path, normalizedPath);
+        sharedData->pathHash = pathHash;
+        
+        const int numAudioDataEntries = waveBank->numAudioDataEntries;
+        sharedData->numAudioDataEntries = numAudioDataEntries;
+        sharedData->audioDataItems = (kwlAudioData*)KWL_MALLOC(numAudioDataEntries * sizeof(kwlAudioData), 
+                                                               "shared wave bank audio data");
+        for (int i = 0; i < numAudioDataEntries; i++)
+        {
+            kwlAudioData* sharedAudioData = &sharedData->audioDataItems[i];
+            const kwlAudioData* audioData = &waveBank->audioDataItems[i];
+            *sharedAudioData = *audioData;
+            sharedAudioData->waveBank = NULL;
+            
+            char* filePath = (char*)KWL_MALLOC((strlen(audioData->filePath) + 1) * sizeof(char), 
+                                               "shared wave bank entry path string");
+            strcpy(filePath, audioData->filePath);
+            sharedAudioData->filePath = filePath;
+        }
+        
+        sharedData->referenceCount = 1;
+        sharedData->next = sharedWaveBankDataList;
+        sharedWaveBankDataList = sharedData;
+        waveBank->sharedData = sharedData;
+    }
+    
+    kwlWaveBank_unlockSharedData();
+}
+
+/**
+ * Detaches a wave bank from the audio data it shares with other engine instances,
+ * freeing the shared data if no other wave bank uses it.
+ */
+static void kwlWaveBank_releaseSharedData(kwlWaveBank* waveBank)
+{
+    kwlSharedWaveBankData* sharedData = waveBank->sharedData;
+    KWL_ASSERT(sharedData != NULL);
+    
+    /*the sample memory belongs to the shared data.*/
+    for (int i = 0; i < waveBank->numAudioDataEntries; i++)
+    {
+        waveBank->audioDataItems[i].bytes = NULL;
+    }
+    waveBank->sharedData = NULL;
+    
+    kwlWaveBank_lockSharedData();
+    sharedData->referenceCount--;
+    const int isUnused = sharedData->referenceCount == 0;
+    if (isUnused)
+    {
+        kwlSharedWaveBankData** link = &sharedWaveBankDataList;
+        while (*link != sharedData)
+        {
+            link = &(*link)->next;
+        }
+        *link = sharedData->next;
+    }
+    kwlWaveBank_unlockSharedData();
+    
+    if (isUnused)
+    {
+        for (int i = 0; i < sharedData->numAudioDataEntries; i++)
+        {
+            KWL_FREE((void*)sharedData->audioDataItems[i].filePath);
+            kwlAudioData_free(&sharedData->audioDataItems[i]);
+        }
+        KWL_FREE(sharedData->audioDataItems);
+        KWL_FREE(sharedData->path);
+        KWL_FREE(sharedData);
+    }
+}
+
 kwlError kwlWaveBank_verifyWaveBankBinary(kwlEngine* engine, 
                                           const char* const waveBankPath,
                                           kwlWaveBank** waveBank)
@@ -139,12 +398,41 @@ kwlError kwlWaveBank_loadAudioData(kwlWaveBank* waveBank,
                                    const char* path, 
                                    int threaded)
 {
+    if (waveBank->sharedData != NULL)
+    {
+        kwlWaveBank_releaseSharedData(waveBank);
+    }
+    
     if (threaded == 0)
     {
+        /*use the audio data of another engine instance that loaded the same file, if any.*/
+        char* normalizedPath = (char*)KWL_MALLOC((strlen(path) + 2) * sizeof(char), "normalized wave bank path string");
+        kwlWaveBank_normalizePath(path, normalizedPath);
+        const unsigned int pathHash = kwlWaveBank_hashPath(normalizedPath);
+        
+        kwlWaveBank_lockSharedData();
+        kwlSharedWaveBankData* sharedData = kwlWaveBank_findSharedData(normalizedPath, pathHash);
+        const int isBound = sharedData != NULL && kwlWaveBank_bindSharedData(waveBank, sharedData);
+        kwlWaveBank_unlockSharedData();
+        
+        if (isBound)
+        {
+            KWL_FREE(normalizedPath);
+            return KWL_NO_ERROR;
+        }
+        
         /*perform blocking loading*/
         kwlInputStream stream;
         kwlInputStream_initWithFile(&stream, path);
-        return kwlWaveBank_loadAudioDataItems(waveBank, &stream);
+        kwlError result = kwlWaveBank_loadAudioDataItems(waveBank, &stream);
+        kwlInputStream_close(&stream);
+        
+        if (result == KWL_NO_ERROR)
+        {
+            kwlWaveBank_shareAudioData(waveBank, normalizedPath, pathHash);
+        }
+        KWL_FREE(normalizedPath);
+        return result;
     }
     else
     {
@@ -274,6 +562,11 @@ void kwlWaveBank_unload(kwlWaveBank* waveBank)
         return;
     }
     
+    if (waveBank->sharedData != NULL)
+    {
+        kwlWaveBank_releaseSharedData(waveBank);
+    }
+    
     /* Free all allocated audio data in the wave bank*/
     const int numAudioDataEntriesInBank = waveBank->numAudioDataEntries;
     int i;
@@ -69,6 +69,30 @@ typedef struct kwlWaveBankLoadingThread
     kwlInputStream inputStream;
 } kwlWaveBankLoadingThread;
     
+/**
+ * Audio data loaded from a wave bank file, shared by the wave banks of all engine 
+ * instances in the process that have loaded the same file. Loaded audio data is never
+ * modified, so instances can mix it concurrently.
+ */
+typedef struct kwlSharedWaveBankData
+{
+    /** The normalized path of the wave bank file the data was loaded from. */
+    char* path;
+    /** A hash of \c path, compared before the path itself when looking up shared data. */
+    unsigned int pathHash;
+    /** The number of audio data entries. */
+    int numAudioDataEntries;
+    /** 
+     * The loaded audio data entries, whose file paths are owned by this struct. 
+     * The wave banks sharing the data point to the same sample memory.
+     */
+    struct kwlAudioData* audioDataItems;
+    /** The number of wave banks sharing the data. */
+    int referenceCount;
+    /** The next shared wave bank data in the process-wide list. */
+    struct kwlSharedWaveBankData* next;
+} kwlSharedWaveBankData;
+
 /** 
  * A named collection of pieces of audio data.
  */
@@ -86,6 +110,11 @@ typedef struct kwlWaveBank
     int numAudioDataEntries;
     /** Used for threaded loading (if requested). */
     kwlWaveBankLoadingThread loadingThread;
+    /** 
+     * The audio data shared with other engine instances, or NULL if the audio data of 
+     * the wave bank is not shared, in which case the wave bank owns its sample memory.
+     */
+    kwlSharedWaveBankData* sharedData;
 } kwlWaveBank;
 
 /** 
@@ -106,6 +135,8 @@ kwlError kwlWaveBank_loadAudioDataItems(kwlWaveBank* waveBank, kwlInputStream* i
  * Load wave bank audio data from a file at a given path. If callback is not NULL, this method returns immediately and 
  * loading is performed in a separate thread and the callback gets invoked when loading finishes.
  * If callback is NULL, this function returns when all data has been loaded.
+ * A blocking load of a file that another engine instance has already loaded shares the audio data 
+ * of that instance instead of reading the file again. Files are identified by their path.
  */
 kwlError kwlWaveBank_loadAudioData(kwlWaveBank* waveBank, 
                                    const char* path, 
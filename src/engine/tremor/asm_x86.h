@@ -0,0 +1,217 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggVorbis 'TREMOR' CODEC SOURCE CODE.   *
+ *                                                                  *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE OggVorbis 'TREMOR' SOURCE CODE IS (C) COPYRIGHT 1994-2002    *
+ * BY THE Xiph.Org FOUNDATION http://www.xiph.org/                  *
+ *                                                                  *
+ ********************************************************************
+
+ function: x86 SSE2/AVX2 vector math functions
+
+ Enabled at build time by defining _X86_SSE2_ASSEM_ (and compiling
+ with -msse2, the default on x86_64) or _X86_AVX2_ASSEM_ (compiling
+ with -mavx2).  AVX2 implies SSE2.  Both cover windowing, overlap/add
+ and residue accumulation; the MDCT butterflies are vectorized for
+ AVX2 only.  Every routine here produces
+ exactly the same output as the C path in misc.h; in particular the
+ vector MULT31 keeps the high word of the full signed 64 bit product
+ and differences of products are formed after the multiply, as the
+ scalar XPROD31/XNPROD31 do.
+
+ ********************************************************************/
+
+#if defined(_X86_AVX2_ASSEM_) && !defined(_X86_SSE2_ASSEM_)
+#define _X86_SSE2_ASSEM_
+#endif
+
+#if defined(_X86_SSE2_ASSEM_) && !defined(_LOW_ACCURACY_)
+
+#ifndef _V_X86_VECT
+#define _V_X86_VECT
+
+#include <emmintrin.h>
+#ifdef _X86_AVX2_ASSEM_
+#include <immintrin.h>
+#endif
+
+/* 128 bit primitives, always available */
+
+static inline __m128i mult31_x4(__m128i a, __m128i b){
+  /* SSE2 only has an unsigned 32x32->64 multiply; the signed high
+     word is recovered by subtracting b where a<0 and a where b<0 */
+  __m128i even = _mm_mul_epu32(a,b);
+  __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a,32),_mm_srli_epi64(b,32));
+  __m128i hi   = _mm_or_si128(_mm_srli_epi64(even,32),
+                              _mm_and_si128(odd,_mm_set_epi32(-1,0,-1,0)));
+  hi = _mm_sub_epi32(hi,_mm_and_si128(_mm_srai_epi32(a,31),b));
+  hi = _mm_sub_epi32(hi,_mm_and_si128(_mm_srai_epi32(b,31),a));
+  return _mm_slli_epi32(hi,1);
+}
+
+/* negates the lanes where mask is all ones */
+static inline __m128i negate_x4(__m128i a, __m128i mask){
+  return _mm_sub_epi32(_mm_xor_si128(a,mask),mask);
+}
+
+/* swaps the members of each (even,odd) pair */
+static inline __m128i swap_pairs_x4(__m128i a){
+  return _mm_shuffle_epi32(a,_MM_SHUFFLE(2,3,0,1));
+}
+
+static inline __m128i reverse_x4(__m128i a){
+  return _mm_shuffle_epi32(a,_MM_SHUFFLE(0,1,2,3));
+}
+
+/* vector width used by the block kernels below */
+
+#ifdef _X86_AVX2_ASSEM_
+
+#define VECT_LANES 8
+typedef __m256i vect_t;
+
+/* the MDCT butterflies only pay off with a native signed 32x32->64
+   multiply; on plain SSE2 the sign fix-ups and twiddle shuffles cost
+   more than the scalar imul path they replace */
+#define _V_X86_VECT_MDCT
+
+#define VECT_LOAD(p)     _mm256_loadu_si256((const __m256i *)(p))
+#define VECT_STORE(p,v)  _mm256_storeu_si256((__m256i *)(p),(v))
+#define VECT_ADD(a,b)    _mm256_add_epi32((a),(b))
+#define VECT_SUB(a,b)    _mm256_sub_epi32((a),(b))
+
+static inline vect_t VECT_MULT31(vect_t a, vect_t b){
+  vect_t even = _mm256_mul_epi32(a,b);
+  vect_t odd  = _mm256_mul_epi32(_mm256_srli_epi64(a,32),
+                                 _mm256_srli_epi64(b,32));
+  return _mm256_slli_epi32(_mm256_blend_epi32(_mm256_srli_epi64(even,32),
+                                              odd,0xaa),1);
+}
+
+static inline vect_t VECT_NEGATE(vect_t a, vect_t mask){
+  return _mm256_sub_epi32(_mm256_xor_si256(a,mask),mask);
+}
+
+static inline vect_t VECT_SWAP_PAIRS(vect_t a){
+  return _mm256_shuffle_epi32(a,_MM_SHUFFLE(2,3,0,1));
+}
+
+static inline vect_t VECT_REVERSE(vect_t a){
+  return _mm256_permutevar8x32_epi32(a,_mm256_set_epi32(0,1,2,3,4,5,6,7));
+}
+
+#define VECT_EVEN_MASK() _mm256_set_epi32(0,-1,0,-1,0,-1,0,-1)
+#define VECT_ODD_MASK()  _mm256_set_epi32(-1,0,-1,0,-1,0,-1,0)
+
+/* builds the (t,t,...) and (v,v,...) twiddle vectors for the pairs
+   of one vector; T[o[k]] is the sin/cos entry of the k-th pair
+   counting down from the top of the vector */
+#define VECT_TWIDDLES(T,o,t,v) do{					\
+    (t)=_mm256_set_epi32((T)[(o)[0]],(T)[(o)[0]],(T)[(o)[1]],(T)[(o)[1]],	\
+                         (T)[(o)[2]],(T)[(o)[2]],(T)[(o)[3]],(T)[(o)[3]]);	\
+    (v)=_mm256_set_epi32((T)[(o)[0]+1],(T)[(o)[0]+1],(T)[(o)[1]+1],(T)[(o)[1]+1],	\
+                         (T)[(o)[2]+1],(T)[(o)[2]+1],(T)[(o)[3]+1],(T)[(o)[3]+1]);	\
+  }while(0)
+
+#else
+
+#define VECT_LANES 4
+typedef __m128i vect_t;
+
+#define VECT_LOAD(p)       _mm_loadu_si128((const __m128i *)(p))
+#define VECT_STORE(p,v)    _mm_storeu_si128((__m128i *)(p),(v))
+#define VECT_ADD(a,b)      _mm_add_epi32((a),(b))
+#define VECT_SUB(a,b)      _mm_sub_epi32((a),(b))
+#define VECT_MULT31        mult31_x4
+#define VECT_NEGATE        negate_x4
+#define VECT_SWAP_PAIRS    swap_pairs_x4
+#define VECT_REVERSE       reverse_x4
+
+#define VECT_EVEN_MASK()   _mm_set_epi32(0,-1,0,-1)
+#define VECT_ODD_MASK()    _mm_set_epi32(-1,0,-1,0)
+
+/* as the AVX2 variant, with two pairs per vector */
+#define VECT_TWIDDLES(T,o,t,v) do{					\
+    (t)=_mm_set_epi32((T)[(o)[0]],(T)[(o)[0]],(T)[(o)[1]],(T)[(o)[1]]);	\
+    (v)=_mm_set_epi32((T)[(o)[0]+1],(T)[(o)[0]+1],(T)[(o)[1]+1],(T)[(o)[1]+1]); \
+  }while(0)
+
+#endif
+
+/* Block kernels.  These replace the C fallbacks in misc.h. */
+
+#define _V_VECT_OPS
+
+/* x[i]+=y[i] */
+static inline void vect_add(ogg_int32_t *x, const ogg_int32_t *y, int n){
+  int i=0;
+  for(;i+VECT_LANES<=n;i+=VECT_LANES)
+    VECT_STORE(x+i,VECT_ADD(VECT_LOAD(x+i),VECT_LOAD(y+i)));
+  for(;i<n;i++)
+    x[i]+=y[i];
+}
+
+/* x[i]=y[i] */
+static inline void vect_copy(ogg_int32_t *x, const ogg_int32_t *y, int n){
+  int i=0;
+  for(;i+VECT_LANES<=n;i+=VECT_LANES)
+    VECT_STORE(x+i,VECT_LOAD(y+i));
+  for(;i<n;i++)
+    x[i]=y[i];
+}
+
+/* x[i]=MULT31(x[i],w[i]) */
+static inline void vect_mult_fw(ogg_int32_t *x, const ogg_int32_t *w, int n){
+  int i=0;
+  for(;i+VECT_LANES<=n;i+=VECT_LANES)
+    VECT_STORE(x+i,VECT_MULT31(VECT_LOAD(x+i),VECT_LOAD(w+i)));
+  for(;i<n;i++)
+    x[i]=MULT31(x[i],w[i]);
+}
+
+/* x[i]=MULT31(x[i],w[-i]) */
+static inline void vect_mult_bw(ogg_int32_t *x, const ogg_int32_t *w, int n){
+  int i=0;
+  for(;i+VECT_LANES<=n;i+=VECT_LANES)
+    VECT_STORE(x+i,VECT_MULT31(VECT_LOAD(x+i),
+                               VECT_REVERSE(VECT_LOAD(w-i-VECT_LANES+1))));
+  for(;i<n;i++)
+    x[i]=MULT31(x[i],w[-i]);
+}
+
+/* residue vectors are short (codebook dimension), so these stay on
+   128 bit registers regardless of the selected width */
+
+/* x[i]+=y[i]>>shift */
+static inline void vect_add_shr(ogg_int32_t *x, const ogg_int32_t *y,
+                                int n, int shift){
+  __m128i s=_mm_cvtsi32_si128(shift);
+  int i=0;
+  for(;i+4<=n;i+=4)
+    _mm_storeu_si128((__m128i *)(x+i),
+                     _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x+i)),
+                                   _mm_sra_epi32(_mm_loadu_si128((const __m128i *)(y+i)),s)));
+  for(;i<n;i++)
+    x[i]+=y[i]>>shift;
+}
+
+/* x[i]+=y[i]<<shift */
+static inline void vect_add_shl(ogg_int32_t *x, const ogg_int32_t *y,
+                                int n, int shift){
+  __m128i s=_mm_cvtsi32_si128(shift);
+  int i=0;
+  for(;i+4<=n;i+=4)
+    _mm_storeu_si128((__m128i *)(x+i),
+                     _mm_add_epi32(_mm_loadu_si128((const __m128i *)(x+i)),
+                                   _mm_sll_epi32(_mm_loadu_si128((const __m128i *)(y+i)),s)));
+  for(;i<n;i++)
+    x[i]+=y[i]<<shift;
+}
+
+#endif
+#endif
+
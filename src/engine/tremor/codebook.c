@@ -260,7 +260,7 @@ long vorbis_book_decodevs_add(codebook *book,ogg_int32_t *a,
 long vorbis_book_decodev_add(codebook *book,ogg_int32_t *a,
 			     oggpack_buffer *b,int n,int point){
   if(book->used_entries>0){
-    int i,j,entry;
+    int i,entry;
     ogg_int32_t *t;
     int shift=point-book->binarypoint;
     
@@ -269,16 +269,16 @@ long vorbis_book_decodev_add(codebook *book,ogg_int32_t *a,
 	entry = decode_packed_entry_number(book,b);
 	if(entry==-1)return(-1);
 	t     = book->valuelist+entry*book->dim;
-	for (j=0;j<book->dim;)
-	  a[i++]+=t[j++]>>shift;
+	vect_add_shr(a+i,t,book->dim,shift);
+	i+=book->dim;
       }
     }else{
       for(i=0;i<n;){
 	entry = decode_packed_entry_number(book,b);
 	if(entry==-1)return(-1);
 	t     = book->valuelist+entry*book->dim;
-	for (j=0;j<book->dim;)
-	  a[i++]+=t[j++]<<-shift;
+	vect_add_shl(a+i,t,book->dim,-shift);
+	i+=book->dim;
       }
     }
   }
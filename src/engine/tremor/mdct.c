@@ -144,6 +144,68 @@ STIN void mdct_butterfly_32(DATA_TYPE *x){
 	   mdct_butterfly_16(x+16);
 }
 
+#ifdef _V_X86_VECT_MDCT
+
+/* one 8 point slice of the generic butterfly: x1+=x2 and x2 is
+   replaced by the rotated difference.  sel picks the operands of the
+   cross product: 0 is (x2-x1 odd, x1-x2 even), 1 is x1-x2 and 2 is
+   x2-x1; xprod picks XPROD31 over XNPROD31.  o holds the offsets into
+   T of the four pairs, top pair first, as the C loops step through
+   them. */
+STIN void mdct_butterfly_slice(DATA_TYPE *x1,DATA_TYPE *x2,LOOKUP_T *T,
+			       const int *o,int sel,int xprod){
+  int k;
+  for(k=0;k<8;k+=VECT_LANES){
+    vect_t a=VECT_LOAD(x1+k);
+    vect_t b=VECT_LOAD(x2+k);
+    vect_t r,t,v,m1,m2;
+
+    VECT_STORE(x1+k,VECT_ADD(a,b));
+
+    if(sel==0)
+      r=VECT_NEGATE(VECT_SWAP_PAIRS(VECT_SUB(a,b)),VECT_EVEN_MASK());
+    else if(sel==1)
+      r=VECT_SUB(a,b);
+    else
+      r=VECT_SUB(b,a);
+
+    VECT_TWIDDLES(T,o+(8-VECT_LANES-k)/2,t,v);
+    m1=VECT_MULT31(r,t);
+    m2=VECT_MULT31(VECT_SWAP_PAIRS(r),v);
+    m2=VECT_NEGATE(m2,xprod?VECT_ODD_MASK():VECT_EVEN_MASK());
+    VECT_STORE(x2+k,VECT_ADD(m1,m2));
+  }
+}
+
+/* N/stage point generic N stage butterfly (in place, vectorized) */
+STIN void mdct_butterfly_generic(DATA_TYPE *x,int points,int step){
+
+  LOOKUP_T *T   = sincos_lookup0;
+  DATA_TYPE *x1        = x + points      - 8;
+  DATA_TYPE *x2        = x + (points>>1) - 8;
+  int up[4]   = {0,step,2*step,3*step};
+  int down[4] = {0,-step,-2*step,-3*step};
+
+  do{
+    mdct_butterfly_slice(x1,x2,T,up,0,1);
+    T+=4*step; x1-=8; x2-=8;
+  }while(T<sincos_lookup0+1024);
+  do{
+    mdct_butterfly_slice(x1,x2,T,down,1,0);
+    T-=4*step; x1-=8; x2-=8;
+  }while(T>sincos_lookup0);
+  do{
+    mdct_butterfly_slice(x1,x2,T,up,2,1);
+    T+=4*step; x1-=8; x2-=8;
+  }while(T<sincos_lookup0+1024);
+  do{
+    mdct_butterfly_slice(x1,x2,T,down,0,0);
+    T-=4*step; x1-=8; x2-=8;
+  }while(T>sincos_lookup0);
+}
+
+#else
+
 /* N/stage point generic N stage butterfly (in place, 2 register) */
 STIN void mdct_butterfly_generic(DATA_TYPE *x,int points,int step){
 
@@ -231,6 +293,8 @@ STIN void mdct_butterfly_generic(DATA_TYPE *x,int points,int step){
   }while(T>sincos_lookup0);
 }
 
+#endif
+
 STIN void mdct_butterflies(DATA_TYPE *x,int points,int shift){
 
   int stages=8-shift;
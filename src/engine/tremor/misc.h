@@ -158,6 +158,54 @@ STIN void XNPROD31(ogg_int32_t  a, ogg_int32_t  b,
 
 #endif
 
+#include "asm_x86.h"
+
+#ifndef _V_VECT_OPS
+#define _V_VECT_OPS
+
+/* block operations on the decoder's PCM and residue vectors; these
+   may be provided by an architecture specific header instead */
+
+STIN void vect_add(ogg_int32_t *x, const ogg_int32_t *y, int n){
+  int i;
+  for(i=0;i<n;i++)
+    x[i]+=y[i];
+}
+
+STIN void vect_copy(ogg_int32_t *x, const ogg_int32_t *y, int n){
+  int i;
+  for(i=0;i<n;i++)
+    x[i]=y[i];
+}
+
+STIN void vect_mult_fw(ogg_int32_t *x, LOOKUP_T *w, int n){
+  int i;
+  for(i=0;i<n;i++)
+    x[i]=MULT31(x[i],w[i]);
+}
+
+STIN void vect_mult_bw(ogg_int32_t *x, LOOKUP_T *w, int n){
+  int i;
+  for(i=0;i<n;i++)
+    x[i]=MULT31(x[i],w[-i]);
+}
+
+STIN void vect_add_shr(ogg_int32_t *x, const ogg_int32_t *y,
+                       int n, int shift){
+  int i;
+  for(i=0;i<n;i++)
+    x[i]+=y[i]>>shift;
+}
+
+STIN void vect_add_shl(ogg_int32_t *x, const ogg_int32_t *y,
+                       int n, int shift){
+  int i;
+  for(i=0;i<n;i++)
+    x[i]+=y[i]<<shift;
+}
+
+#endif
+
 #ifndef _V_CLIP_MATH
 #define _V_CLIP_MATH
 
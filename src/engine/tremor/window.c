@@ -66,17 +66,14 @@ void _vorbis_apply_window(ogg_int32_t *d,const void *window_p[2],
   long rightbegin=n/2+n/4-rn/4;
   long rightend=rightbegin+rn/2;
   
-  int i,p;
+  int i;
 
   for(i=0;i<leftbegin;i++)
     d[i]=0;
 
-  for(p=0;i<leftend;i++,p++)
-    d[i]=MULT31(d[i],window[lW][p]);
+  vect_mult_fw(d+leftbegin,window[lW],leftend-leftbegin);
+  vect_mult_bw(d+rightbegin,window[nW]+rn/2-1,rightend-rightbegin);
 
-  for(i=rightbegin,p=rn/2-1;i<rightend;i++,p--)
-    d[i]=MULT31(d[i],window[nW][p]);
-
-  for(;i<n;i++)
+  for(i=rightend;i<n;i++)
     d[i]=0;
 }
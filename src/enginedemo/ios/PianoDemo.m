@@ -129,7 +129,7 @@
     
     if (idx >= 0)
     {
-        kwlEventStart(m_keyEventHandles[idx]);
+        kwlEventStartImmediately(m_keyEventHandles[idx], 0.0f);
     }
 }
 
@@ -272,7 +272,7 @@ void PianoDemo::onKeyDown(SDLKey key)
     
     if (idx >= 0)
     {
-        kwlEventStart(m_keyEventHandles[idx]);
+        kwlEventStartImmediately(m_keyEventHandles[idx], 0.0f);
         kwlError e = kwlGetError();
         assert(e == KWL_NO_ERROR);
     }
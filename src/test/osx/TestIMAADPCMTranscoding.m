@@ -0,0 +1,158 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#import "TestIMAADPCMTranscoding.h"
+
+#import "kwl_decoder_imaadpcm.h"
+#import "kwl_enginedatabinary.h"
+#import "kwl_logging.h"
+#import "kwl_memory.h"
+#import "kwl_wavebankbinary.h"
+
+/** The sample rate of the generated source files. */
+#define TEST_SAMPLE_RATE 22050
+
+@implementation TestIMAADPCMTranscoding
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // Set-up code here.
+}
+
+- (void)tearDown
+{
+    // Tear-down code here.
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * ROUND TRIP TESTS
+ ***************************************************************************/
+
+-(void)testRoundTripLengthMono
+{
+    /*1000 frames is not a multiple of the 504 frames per 256 byte block.*/
+    [self requireRoundTripLength:1000 :1 :256];
+    [self requireRoundTripLength:504 :1 :256];
+    [self requireRoundTripLength:1 :1 :256];
+}
+
+-(void)testRoundTripLengthStereo
+{
+    [self requireRoundTripLength:1000 :2 :256];
+    [self requireRoundTripLength:4097 :2 :1024];
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(void)requireRoundTripLength:(int)numFrames
+                             :(int)numChannels
+                             :(int)blockSize
+{
+    NSString* wavPath = [self writeTestWAV:numFrames :numChannels :TEST_SAMPLE_RATE];
+    
+    kwlWaveBankEntrySettings settings;
+    kwlMemset(&settings, 0, sizeof(kwlWaveBankEntrySettings));
+    settings.encodeToIMAADPCM = 1;
+    settings.adpcmBlockSize = blockSize;
+    
+    kwlWaveBankEntryChunk entry;
+    kwlResultCode result = kwlWaveBankBinary_createEntry(&entry,
+                                                         "test.wav",
+                                                         [wavPath UTF8String],
+                                                         &settings,
+                                                         NULL,
+                                                         kwlDefaultLogCallback);
+    [[NSFileManager defaultManager] removeItemAtPath:wavPath error:nil];
+    STAssertEquals(result, KWL_SUCCESS, @"failed to encode the test file");
+    
+    /*decode the encoded file the way the engine does and count the output frames.*/
+    kwlDecoder decoder;
+    kwlMemset(&decoder, 0, sizeof(kwlDecoder));
+    kwlInputStream_initWithBuffer(&decoder.audioDataStream, entry.data, 0, entry.numBytes);
+    kwlInitDecoderIMAADPCM(&decoder);
+    STAssertEquals(((kwlIMAADPCMCodecData*)decoder.codecData)->adpcmDataDescription.sampleRate,
+                   TEST_SAMPLE_RATE,
+                   @"the encoded file should have the sample rate of the source");
+    decoder.currentDecodedBuffer = (short*)KWL_MALLOC(sizeof(short) * decoder.maxDecodedBufferSize, "test decode buffer");
+    
+    int numDecodedFrames = 0;
+    int isLastBlock = 0;
+    while (!isLastBlock)
+    {
+        isLastBlock = kwlDecodeBufferIMAADPCM(&decoder);
+        numDecodedFrames += decoder.currentDecodedBufferSizeInBytes / (2 * numChannels);
+    }
+    
+    KWL_FREE(decoder.currentDecodedBuffer);
+    kwlDeinitDecoderIMAADPCM(&decoder);
+    KWL_FREE(entry.data);
+    KWL_FREE(entry.fileName);
+    
+    STAssertEquals(numDecodedFrames,
+                   numFrames,
+                   [NSString stringWithFormat:@"%d frames of %d channel audio should decode to the same number of frames", numFrames, numChannels]);
+}
+
+-(NSString*)writeTestWAV:(int)numFrames
+                        :(int)numChannels
+                        :(int)sampleRate
+{
+    const int dataSize = 2 * numFrames * numChannels;
+    NSMutableData* wav = [NSMutableData data];
+    
+    int intValue = 0;
+    short shortValue = 0;
+    
+    /*the test only runs on little endian hosts, so values can be written as they are.*/
+    [wav appendBytes:"RIFF" length:4];
+    intValue = 36 + dataSize; [wav appendBytes:&intValue length:4];
+    [wav appendBytes:"WAVEfmt " length:8];
+    intValue = 16; [wav appendBytes:&intValue length:4];
+    shortValue = 1; [wav appendBytes:&shortValue length:2];
+    shortValue = numChannels; [wav appendBytes:&shortValue length:2];
+    intValue = sampleRate; [wav appendBytes:&intValue length:4];
+    intValue = 2 * numChannels * sampleRate; [wav appendBytes:&intValue length:4];
+    shortValue = 2 * numChannels; [wav appendBytes:&shortValue length:2];
+    shortValue = 16; [wav appendBytes:&shortValue length:2];
+    [wav appendBytes:"data" length:4];
+    intValue = dataSize; [wav appendBytes:&intValue length:4];
+    
+    /*a saw tooth, so the last frames are not silent.*/
+    for (int i = 0; i < numFrames * numChannels; i++)
+    {
+        shortValue = (short)((i * 97) % 20000 - 10000);
+        [wav appendBytes:&shortValue length:2];
+    }
+    
+    NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_adpcm_round_trip.wav"];
+    [wav writeToFile:path atomically:YES];
+    return path;
+}
+
+@end
@@ -83,6 +83,12 @@
                                     :KWL_PROJECT_XML_STRUCTURE_ERROR];
 }
 
+-(void)testEventAuxSendToNonReturnBus
+{
+    [self requireXMLValidationResult:@"event_aux_send_to_non_return_bus.xml"
+                                    :KWL_PROJECT_XML_STRUCTURE_ERROR];
+}
+
 
 /***************************************************************************
  * MIX BUS STRUCTURE TESTS
@@ -94,6 +100,42 @@
                                     :KWL_PROJECT_XML_STRUCTURE_ERROR];
 }
 
+-(void)testAuxSendToNonReturnBus
+{
+    [self requireXMLValidationResult:@"mix_bus_aux_send_to_non_return_bus.xml"
+                                    :KWL_PROJECT_XML_STRUCTURE_ERROR];
+}
+
+-(void)testInvalidAuxSendBusReference
+{
+    [self requireXMLValidationResult:@"mix_bus_aux_send_invalid_bus_reference.xml"
+                                    :KWL_PROJECT_XML_STRUCTURE_ERROR];
+}
+
+-(void)testDuplicateAuxSendBusReference
+{
+    [self requireXMLValidationResult:@"mix_bus_aux_send_duplicate_bus_reference.xml"
+                                    :KWL_PROJECT_XML_STRUCTURE_ERROR];
+}
+
+-(void)testAuxReturnWithSubBuses
+{
+    [self requireXMLValidationResult:@"mix_bus_aux_return_with_sub_buses.xml"
+                                    :KWL_PROJECT_XML_STRUCTURE_ERROR];
+}
+
+-(void)testAuxReturnWithAuxSends
+{
+    [self requireXMLValidationResult:@"mix_bus_aux_return_with_aux_sends.xml"
+                                    :KWL_PROJECT_XML_STRUCTURE_ERROR];
+}
+
+-(void)testMasterAuxReturn
+{
+    [self requireXMLValidationResult:@"mix_bus_master_aux_return.xml"
+                                    :KWL_PROJECT_XML_STRUCTURE_ERROR];
+}
+
 /***************************************************************************
  * SOUND STRUCTURE TESTS
  ***************************************************************************/
@@ -224,6 +266,8 @@
                                     :KWL_SUCCESS];
     [self requireXMLValidationResult:@"valid_project_minimal_reordered_root_groups.xml"
                                     :KWL_SUCCESS];
+    [self requireXMLValidationResult:@"valid_project_aux_sends.xml"
+                                    :KWL_SUCCESS];
 }
 
 /***************************************************************************
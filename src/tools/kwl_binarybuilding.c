@@ -21,13 +21,16 @@
  distribution.
  */
 
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "kwl_binarybuilding.h"
 #include "kwl_enginedatabinary.h"
 #include "kwl_wavebankbinary.h"
 #include "kwl_xmlutil.h"
 #include "kwl_fileutil.h"
+#include "kwl_synchronization.h"
 
 kwlResultCode kwlBuildEngineData(const char* xmlPath,
                                  const char* xsdPath,
@@ -76,6 +79,401 @@ kwlResultCode kwlBuildEngineData(const char* xmlPath,
     return KWL_SUCCESS;
 }
 
+/** The maximum number of wave bank build worker threads.*/
+#define KWL_MAX_WAVE_BANK_BUILD_THREADS 16
+/** 
+ * The number of entries each worker thread may build ahead of the
+ * entry currently being written. Bounds the memory held by built entries.
+ */
+#define KWL_WAVE_BANK_BUILD_ENTRIES_AHEAD_PER_THREAD 2
+
+/**
+ * A single entry of a wave bank binary to write.
+ */
+typedef struct kwlWaveBankBuildJob
+{
+    /** The audio file name as referenced by the project data.*/
+    const char* fileName;
+    /** The absolute path to the audio file.*/
+    char* audioFilePath;
+    /** The build settings, read from the XML before any worker threads are started.*/
+    kwlWaveBankEntrySettings settings;
+    /** The size of the audio file in bytes.*/
+    long sourceSize;
+    /** The time stamp of the audio file.*/
+    long sourceTimeStamp;
+    /** A hash of the audio file contents. Set by the worker for entries that are built.*/
+    unsigned long long sourceHash;
+    /** 
+     * If not NULL, the entry is unchanged since the previous build and
+     * its payload is copied from the existing wave bank binary.
+     */
+    const kwlWaveBankBuildCacheEntry* cachedEntry;
+    /** The built entry. Owned by the writer once \c isDone is set.*/
+    kwlWaveBankEntryChunk entry;
+    /** The outcome of building the entry.*/
+    kwlResultCode result;
+    /** Non-zero once a worker has finished building the entry. Guarded by \c lock.*/
+    int isDone;
+} kwlWaveBankBuildJob;
+
+/**
+ * A wave bank binary to build, along with the cache describing the previous build, if any.
+ */
+typedef struct kwlWaveBankBuildTarget
+{
+    char* path;
+    char* cachePath;
+    /** The cache of the existing binary. Only valid if \c hasCache is non-zero.*/
+    kwlWaveBankBuildCache cache;
+    int hasCache;
+    /** The index of the first job of this wave bank.*/
+    int firstJobIndex;
+    /** Non-zero if the existing binary has the same entries as the one that would be built.*/
+    int isUpToDate;
+    /** Non-zero if the binary is up to date but its cache has outdated source file time stamps.*/
+    int cacheNeedsUpdate;
+} kwlWaveBankBuildTarget;
+
+/**
+ * State shared between the wave bank writer and the worker threads building entries.
+ * Jobs are claimed in the order they are written, so the writer never waits for 
+ * more than the entries currently being built.
+ */
+typedef struct kwlWaveBankBuilder
+{
+    kwlWaveBankBuildJob* jobs;
+    int numJobs;
+    /** The indices of the jobs that need building, in write order.*/
+    int* buildQueue;
+    int buildQueueLength;
+    /** The index in \c buildQueue of the next job to claim. Guarded by \c lock.*/
+    int nextQueueIndex;
+    /** A binary semaphore guarding \c nextQueueIndex and the \c isDone flags.*/
+    kwlSemaphore* lock;
+    /** Posted each time a job is done.*/
+    kwlSemaphore* jobDone;
+    /** Counts the jobs that may be claimed without exceeding the build ahead limit.*/
+    kwlSemaphore* freeSlots;
+    char lockName[48];
+    char jobDoneName[48];
+    char freeSlotsName[48];
+    kwlLogCallback errorLogCallback;
+} kwlWaveBankBuilder;
+
+static void* kwlWaveBankBuilder_workerThreadEntryPoint(void* data)
+{
+    kwlWaveBankBuilder* builder = (kwlWaveBankBuilder*)data;
+    
+    while (1)
+    {
+        kwlSemaphoreWait(builder->freeSlots);
+        
+        kwlSemaphoreWait(builder->lock);
+        const int queueIndex = builder->nextQueueIndex;
+        if (queueIndex < builder->buildQueueLength)
+        {
+            builder->nextQueueIndex++;
+        }
+        kwlSemaphorePost(builder->lock);
+        
+        if (queueIndex >= builder->buildQueueLength)
+        {
+            break;
+        }
+        
+        kwlWaveBankBuildJob* job = &builder->jobs[builder->buildQueue[queueIndex]];
+        job->result = kwlWaveBankBinary_createEntry(&job->entry,
+                                                    job->fileName,
+                                                    job->audioFilePath,
+                                                    &job->settings,
+                                                    &job->sourceHash,
+                                                    builder->errorLogCallback);
+        
+        kwlSemaphoreWait(builder->lock);
+        job->isDone = 1;
+        kwlSemaphorePost(builder->lock);
+        kwlSemaphorePost(builder->jobDone);
+    }
+    
+    return NULL;
+}
+
+/**
+ * Blocks until a given job has been built by a worker thread.
+ */
+static void kwlWaveBankBuilder_waitForJob(kwlWaveBankBuilder* builder, int jobIndex)
+{
+    while (1)
+    {
+        kwlSemaphoreWait(builder->lock);
+        const int isDone = builder->jobs[jobIndex].isDone;
+        kwlSemaphorePost(builder->lock);
+        
+        if (isDone)
+        {
+            return;
+        }
+        
+        kwlSemaphoreWait(builder->jobDone);
+    }
+}
+
+/**
+ * Returns the number of worker threads to use for building wave banks.
+ */
+static int kwlGetNumWaveBankBuildThreads(int numJobs)
+{
+    int numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    
+    if (numThreads > KWL_MAX_WAVE_BANK_BUILD_THREADS)
+    {
+        numThreads = KWL_MAX_WAVE_BANK_BUILD_THREADS;
+    }
+    if (numThreads > numJobs)
+    {
+        numThreads = numJobs;
+    }
+    if (numThreads < 1)
+    {
+        numThreads = 1;
+    }
+    return numThreads;
+}
+
+/**
+ * Returns a newly allocated string consisting of a given path followed by an extension.
+ */
+static char* kwlAppendExtension(const char* path, const char* extension)
+{
+    const size_t pathLen = strlen(path);
+    const size_t extLen = strlen(extension);
+    char* result = KWL_MALLOCANDZERO((pathLen + extLen + 1) * sizeof(char), "path w ext");
+    strcpy(result, path);
+    strcpy(result + pathLen, extension);
+    return result;
+}
+
+/**
+ * Returns a newly allocated string containing the path of the binary file of a given wave bank.
+ */
+static char* kwlGetWaveBankBinaryPath(const char* targetDir, const char* wbId)
+{
+    char* wbFilePathNoExt = kwlAppendPathElement(targetDir, wbId);
+    char* wbFilePath = kwlAppendExtension(wbFilePathNoExt, ".kwb");
+    KWL_FREE(wbFilePathNoExt);
+    return wbFilePath;
+}
+
+static int kwlWaveBankEntrySettings_equals(const kwlWaveBankEntrySettings* s1,
+                                           const kwlWaveBankEntrySettings* s2)
+{
+    return s1->isStreaming == s2->isStreaming &&
+           s1->encodeToIMAADPCM == s2->encodeToIMAADPCM &&
+           s1->adpcmBlockSize == s2->adpcmBlockSize;
+}
+
+/**
+ * Looks for a cached entry that was built from the same, unchanged audio file using 
+ * the same settings as a given job. The audio file is only hashed if its size matches 
+ * but its time stamp does not.
+ */
+static const kwlWaveBankBuildCacheEntry* kwlFindReusableCacheEntry(const kwlWaveBankBuildCache* cache,
+                                                                   int expectedIndex,
+                                                                   kwlWaveBankBuildJob* job)
+{
+    const kwlWaveBankBuildCacheEntry* cachedEntry = NULL;
+    if (expectedIndex < cache->numEntries &&
+        strcmp(cache->entries[expectedIndex].fileName, job->fileName) == 0)
+    {
+        cachedEntry = &cache->entries[expectedIndex];
+    }
+    else
+    {
+        for (int i = 0; i < cache->numEntries; i++)
+        {
+            if (strcmp(cache->entries[i].fileName, job->fileName) == 0)
+            {
+                cachedEntry = &cache->entries[i];
+                break;
+            }
+        }
+    }
+    
+    if (cachedEntry == NULL ||
+        cachedEntry->sourceSize != job->sourceSize ||
+        !kwlWaveBankEntrySettings_equals(&cachedEntry->settings, &job->settings))
+    {
+        return NULL;
+    }
+    
+    if (cachedEntry->sourceTimeStamp != job->sourceTimeStamp)
+    {
+        unsigned long long hash = 0;
+        if (!kwlWaveBankBuildCache_hashFile(job->audioFilePath, &hash) ||
+            hash != cachedEntry->sourceHash)
+        {
+            return NULL;
+        }
+    }
+    
+    job->sourceHash = cachedEntry->sourceHash;
+    return cachedEntry;
+}
+
+/**
+ * Reads the payload of a cached entry from the existing wave bank binary.
+ */
+static int kwlReadCachedEntry(kwlInputStream* previousBinary,
+                              const kwlWaveBankBuildCacheEntry* cachedEntry,
+                              kwlWaveBankEntryChunk* entry)
+{
+    kwlMemset(entry, 0, sizeof(kwlWaveBankEntryChunk));
+    if (cachedEntry->numBytes < 0 ||
+        kwlInputStream_seek(previousBinary, cachedEntry->dataOffset, SEEK_SET) != 0)
+    {
+        return 0;
+    }
+    
+    void* data = KWL_MALLOC(cachedEntry->numBytes > 0 ? cachedEntry->numBytes : 1, "cached wb entry");
+    if (kwlInputStream_read(previousBinary, (signed char*)data, cachedEntry->numBytes) != cachedEntry->numBytes)
+    {
+        KWL_FREE(data);
+        return 0;
+    }
+    
+    entry->encoding = cachedEntry->encoding;
+    entry->isStreaming = cachedEntry->isStreaming;
+    entry->numChannels = cachedEntry->numChannels;
+    entry->numBytes = cachedEntry->numBytes;
+    entry->data = data;
+    return 1;
+}
+
+/**
+ * Writes the binary of a wave bank that is not up to date, along with a new cache. The 
+ * binary is written to a temporary file that replaces the existing one once complete, so
+ * unchanged entries can be copied from the existing binary and a failed build leaves it intact.
+ */
+static kwlResultCode kwlWriteWaveBankBinary(kwlWaveBankBuilder* builder,
+                                            kwlWaveBankBuildTarget* target,
+                                            kwlWaveBankChunk* edwb,
+                                            kwlLogCallback errorLogCallback)
+{
+    kwlResultCode result = KWL_SUCCESS;
+    const int numEntries = edwb->numAudioDataEntries;
+    
+    kwlInputStream previousBinary;
+    int hasPreviousBinary = target->hasCache &&
+                            kwlInputStream_initWithFile(&previousBinary, target->path) == KWL_NO_ERROR;
+    
+    kwlWaveBankBuildCache newCache;
+    kwlMemset(&newCache, 0, sizeof(kwlWaveBankBuildCache));
+    newCache.entries = KWL_MALLOCANDZERO((numEntries > 0 ? numEntries : 1) * sizeof(kwlWaveBankBuildCacheEntry),
+                                         "wb build cache entries");
+    
+    char* tempPath = kwlAppendExtension(target->path, ".tmp");
+    kwlFileOutputStream fos;
+    const int isOpen = kwlFileOutputStream_initWithPath(&fos, tempPath);
+    if (!isOpen)
+    {
+        errorLogCallback("Could not open wave bank binary '%s' for writing.\n", tempPath);
+        result = KWL_INVALID_PATH;
+    }
+    else
+    {
+        kwlWaveBankBinary_writeHeader(&fos, edwb->id, numEntries);
+    }
+    
+    for (int i = 0; i < numEntries; i++)
+    {
+        const int jobIndex = target->firstJobIndex + i;
+        kwlWaveBankBuildJob* job = &builder->jobs[jobIndex];
+        
+        if (job->cachedEntry == NULL)
+        {
+            /*built by a worker. always consume it so the workers can proceed.*/
+            kwlWaveBankBuilder_waitForJob(builder, jobIndex);
+            kwlSemaphorePost(builder->freeSlots);
+            if (job->result != KWL_SUCCESS && result == KWL_SUCCESS)
+            {
+                result = job->result;
+            }
+        }
+        else if (result == KWL_SUCCESS)
+        {
+            if (!hasPreviousBinary || !kwlReadCachedEntry(&previousBinary, job->cachedEntry, &job->entry))
+            {
+                errorLogCallback("Could not read entry '%s' from wave bank binary '%s'. Try a forced rebuild.\n",
+                                 job->fileName, target->path);
+                result = KWL_COULD_NOT_OPEN_WAVE_BANK_BINARY_FILE;
+            }
+        }
+        
+        if (result == KWL_SUCCESS)
+        {
+            /*the entry name is the one referenced by the project data, also for copied entries.*/
+            char* builtFileName = job->entry.fileName;
+            job->entry.fileName = (char*)job->fileName;
+            kwlWaveBankBinary_writeEntry(&fos, &job->entry);
+            job->entry.fileName = builtFileName;
+            
+            kwlWaveBankBuildCacheEntry* cachedEntry = &newCache.entries[i];
+            const size_t fileNameLen = strlen(job->fileName);
+            cachedEntry->fileName = KWL_MALLOCANDZERO(fileNameLen + 1, "cached file name");
+            kwlMemcpy(cachedEntry->fileName, job->fileName, fileNameLen);
+            newCache.numEntries = i + 1;
+            cachedEntry->settings = job->settings;
+            cachedEntry->sourceSize = job->sourceSize;
+            cachedEntry->sourceTimeStamp = job->sourceTimeStamp;
+            cachedEntry->sourceHash = job->sourceHash;
+            cachedEntry->encoding = job->entry.encoding;
+            cachedEntry->isStreaming = job->entry.isStreaming;
+            cachedEntry->numChannels = job->entry.numChannels;
+            cachedEntry->numBytes = job->entry.numBytes;
+            cachedEntry->dataOffset = kwlFileOutputStream_tell(&fos) - job->entry.numBytes;
+        }
+        
+        kwlWaveBankEntryChunk_free(&job->entry);
+    }
+    
+    if (hasPreviousBinary)
+    {
+        kwlInputStream_close(&previousBinary);
+    }
+    
+    if (isOpen)
+    {
+        kwlFileOutputStream_close(&fos);
+    }
+    
+    if (result == KWL_SUCCESS && rename(tempPath, target->path) != 0)
+    {
+        errorLogCallback("Could not replace wave bank binary '%s'.\n", target->path);
+        result = KWL_INVALID_PATH;
+    }
+    
+    if (result == KWL_SUCCESS)
+    {
+        newCache.waveBankSize = kwlGetFileSize(target->path);
+        newCache.waveBankTimeStamp = kwlGetFileTimeStamp(target->path);
+        if (!kwlWaveBankBuildCache_writeToFile(&newCache, target->cachePath))
+        {
+            /*not fatal, the next build just can't reuse any entries.*/
+            errorLogCallback("Could not write wave bank build cache '%s'.\n", target->cachePath);
+        }
+    }
+    else
+    {
+        remove(tempPath);
+    }
+    
+    kwlWaveBankBuildCache_free(&newCache);
+    KWL_FREE(tempPath);
+    
+    return result;
+}
+
 kwlResultCode kwlBuildWaveBanks(const char* xmlPath,
                                 const char* xsdPath,
                                 const char* targetDir,
@@ -111,92 +509,209 @@ kwlResultCode kwlBuildWaveBanks(const char* xmlPath,
     if (r != KWL_SUCCESS)
     {
         errorLogCallback("Error loading project XML data '%s'.\n", xmlPath);
+        KWL_FREE(audioFileRoot);
         xmlFreeDoc(doc);
         return r;
     }
     
-    kwlResultCode finalResult = KWL_SUCCESS;
+    /*check file references once for all wave banks*/
+    r = kwlEngineDataBinary_validateFileReferences(&edb,
+                                                   xmlPath,
+                                                   audioFileRoot,
+                                                   rootIsRelative,
+                                                   errorLogCallback);
+    if (r != KWL_SUCCESS)
+    {
+        kwlEngineDataBinary_free(&edb);
+        KWL_FREE(audioFileRoot);
+        xmlFreeDoc(doc);
+        return r;
+    }
+    
+    /*index the project document once, for looking up the settings of each entry.*/
+    kwlProjectIndex projectIndex;
+    kwlProjectIndex_init(&projectIndex, projNode, errorLogCallback);
+    
+    /*create a job for every entry of every wave bank.*/
+    const int numWaveBanks = edb.waveBanksChunk.numWaveBanks;
+    kwlWaveBankBuildTarget* targets = KWL_MALLOCANDZERO((numWaveBanks > 0 ? numWaveBanks : 1) * sizeof(kwlWaveBankBuildTarget),
+                                                        "wb build targets");
+    int numJobs = 0;
+    for (int i = 0; i < numWaveBanks; i++)
+    {
+        targets[i].firstJobIndex = numJobs;
+        numJobs += edb.waveBanksChunk.waveBanks[i].numAudioDataEntries;
+    }
+    
+    kwlWaveBankBuilder builder;
+    kwlMemset(&builder, 0, sizeof(kwlWaveBankBuilder));
+    builder.numJobs = numJobs;
+    builder.errorLogCallback = errorLogCallback;
+    builder.jobs = KWL_MALLOCANDZERO((numJobs > 0 ? numJobs : 1) * sizeof(kwlWaveBankBuildJob), "wb build jobs");
+    builder.buildQueue = KWL_MALLOCANDZERO((numJobs > 0 ? numJobs : 1) * sizeof(int), "wb build queue");
     
-    for (int i = 0; i < edb.waveBanksChunk.numWaveBanks; i++)
+    /*do dependency checking before loading any audio data. an entry is reused if the 
+     previous build has an entry built from an identical audio file using the same settings. 
+     a wave bank is only written if its entries differ from those of the previous build.*/
+    for (int i = 0; i < numWaveBanks; i++)
     {
         kwlWaveBankChunk* edwb = &edb.waveBanksChunk.waveBanks[i];
+        kwlWaveBankBuildTarget* target = &targets[i];
+        target->path = kwlGetWaveBankBinaryPath(targetDir, edwb->id);
+        target->cachePath = kwlAppendExtension(target->path, KWL_WAVE_BANK_BUILD_CACHE_FILE_EXTENSION);
         
-        /*create a wave bank structure...*/
-        const char* wbId = edb.waveBanksChunk.waveBanks[i].id;
-        
-        kwlWaveBankBinary wbBin;
-        kwlResultCode wbResult = kwlWaveBankBinary_create(&wbBin,
-                                                          &edb,
-                                                          projNode,
-                                                          xmlPath,
-                                                          audioFileRoot,
-                                                          rootIsRelative,
-                                                          wbId,
-                                                          errorLogCallback);
-        
-        if (wbResult != KWL_SUCCESS)
+        if (!forceRebuild && kwlDoesFileExist(target->path))
         {
-            errorLogCallback("Failed to write wave bank binary '%s'.\n", wbId);
-            finalResult = wbResult;
+            target->hasCache = kwlWaveBankBuildCache_loadFromFile(&target->cache, target->cachePath);
+            if (target->hasCache &&
+                (target->cache.waveBankSize != kwlGetFileSize(target->path) ||
+                 target->cache.waveBankTimeStamp != kwlGetFileTimeStamp(target->path)))
+            {
+                /*the binary was not written along with this cache.*/
+                kwlWaveBankBuildCache_free(&target->cache);
+                target->hasCache = 0;
+            }
         }
-        else
+        
+        int isUpToDate = target->hasCache && target->cache.numEntries == edwb->numAudioDataEntries;
+        int cacheNeedsUpdate = 0;
+        for (int j = 0; j < edwb->numAudioDataEntries; j++)
         {
-            /*create the path of the output file*/
-            char* wbFilePathNoExt = kwlAppendPathElement(targetDir, wbId);
-            size_t fullPathLen = strlen(wbFilePathNoExt) + 5;
-            char* wbFilePath = KWL_MALLOCANDZERO(fullPathLen * sizeof(char), "wb path w ext");
-            strcpy(wbFilePath, wbFilePathNoExt);
-            
-            wbFilePath[fullPathLen - 5] = '.';
-            wbFilePath[fullPathLen - 4] = 'k';
-            wbFilePath[fullPathLen - 3] = 'w';
-            wbFilePath[fullPathLen - 2] = 'b';
-            wbFilePath[fullPathLen - 1] = '\0';
+            kwlWaveBankBuildJob* job = &builder.jobs[target->firstJobIndex + j];
+            job->fileName = edwb->audioDataEntries[j];
+            job->audioFilePath = kwlGetAudioFilePath(xmlPath,
+                                                     audioFileRoot,
+                                                     rootIsRelative,
+                                                     job->fileName);
+            job->sourceSize = kwlGetFileSize(job->audioFilePath);
+            job->sourceTimeStamp = kwlGetFileTimeStamp(job->audioFilePath);
+            const kwlNodeIndexEntry* audioDataEntry = kwlProjectIndex_findAudioData(&projectIndex, i, job->fileName);
+            KWL_ASSERT(audioDataEntry != NULL);
+            kwlWaveBankEntrySettings_initWithAudioDataNode(&job->settings, audioDataEntry->node);
             
-            /*do dependency checking.*/
-            int shouldWrite = 1;
-            if (kwlDoesFileExist(wbFilePath) && !forceRebuild)
+            if (target->hasCache)
             {
-                /*only write the binary
-                 if the project data or any containing audio file
-                 has more recent changes than the wave bank file that
-                 already exists*/
-                long wbTimestamp = kwlGetFileTimeStamp(wbFilePath);
-                long projectTimestamp = kwlGetFileTimeStamp(xmlPath);
-                long latestAudioFileTimeStamp = 0;
-                for (int j = 0; j < edwb->numAudioDataEntries; j++)
-                {
-                    char* audioFilePath = kwlGetAudioFilePath(xmlPath,
-                                                              audioFileRoot,
-                                                              rootIsRelative,
-                                                              edwb->audioDataEntries[j]);
-                    long timeStamp = kwlGetFileTimeStamp(audioFilePath);
-                    if (timeStamp > latestAudioFileTimeStamp)
-                    {
-                        latestAudioFileTimeStamp = timeStamp;
-                    }
-                    KWL_FREE(audioFilePath);
-                }
-                
-                if (wbTimestamp > projectTimestamp &&
-                    wbTimestamp > latestAudioFileTimeStamp)
-                {
-                    errorLogCallback("Wave bank binary '%s' is up to date.\n", wbFilePath);
-                    shouldWrite = 0;
-                }
+                job->cachedEntry = kwlFindReusableCacheEntry(&target->cache, j, job);
             }
             
-            if (shouldWrite)
+            if (job->cachedEntry == NULL || job->cachedEntry != &target->cache.entries[j])
             {
-                kwlWaveBankBinary_writeToFile(&wbBin, wbFilePath);
-                errorLogCallback("Built wave bank binary '%s'.\n", wbFilePath);
+                isUpToDate = 0;
             }
-            
-            KWL_FREE(wbFilePath);
-            KWL_FREE(wbFilePathNoExt);
+            else if (job->cachedEntry->sourceTimeStamp != job->sourceTimeStamp)
+            {
+                cacheNeedsUpdate = 1;
+            }
+        }
+        
+        target->isUpToDate = isUpToDate;
+        target->cacheNeedsUpdate = cacheNeedsUpdate;
+        if (isUpToDate)
+        {
+            errorLogCallback("Wave bank binary '%s' is up to date.\n", target->path);
+            continue;
+        }
+        
+        for (int j = 0; j < edwb->numAudioDataEntries; j++)
+        {
+            const int jobIndex = target->firstJobIndex + j;
+            if (builder.jobs[jobIndex].cachedEntry == NULL)
+            {
+                builder.buildQueue[builder.buildQueueLength++] = jobIndex;
+            }
+        }
+    }
+    
+    /*start the worker threads. each one may build a few entries ahead of the writer.*/
+    const int numThreads = kwlGetNumWaveBankBuildThreads(builder.buildQueueLength);
+    /*semaphore names are system wide, so make them unique per process and per build.*/
+    sprintf(builder.lockName, "wbb%d_%p_l", (int)getpid(), (void*)&builder);
+    sprintf(builder.jobDoneName, "wbb%d_%p_d", (int)getpid(), (void*)&builder);
+    sprintf(builder.freeSlotsName, "wbb%d_%p_s", (int)getpid(), (void*)&builder);
+    builder.lock = kwlSemaphoreOpen(builder.lockName);
+    builder.jobDone = kwlSemaphoreOpen(builder.jobDoneName);
+    builder.freeSlots = kwlSemaphoreOpen(builder.freeSlotsName);
+    kwlSemaphorePost(builder.lock);
+    for (int i = 0; i < numThreads * KWL_WAVE_BANK_BUILD_ENTRIES_AHEAD_PER_THREAD; i++)
+    {
+        kwlSemaphorePost(builder.freeSlots);
+    }
+    
+    kwlThread threads[KWL_MAX_WAVE_BANK_BUILD_THREADS];
+    for (int i = 0; i < numThreads; i++)
+    {
+        kwlThreadCreate(&threads[i], kwlWaveBankBuilder_workerThreadEntryPoint, &builder);
+    }
+    
+    /*write the entries in order as they become available,
+     releasing each one once it has been written.*/
+    kwlResultCode finalResult = KWL_SUCCESS;
+    for (int i = 0; i < numWaveBanks; i++)
+    {
+        kwlWaveBankChunk* edwb = &edb.waveBanksChunk.waveBanks[i];
+        kwlWaveBankBuildTarget* target = &targets[i];
+        
+        if (target->isUpToDate)
+        {
+            if (target->cacheNeedsUpdate)
+            {
+                /*record the new time stamps so the files are not hashed again next time.*/
+                for (int j = 0; j < target->cache.numEntries; j++)
+                {
+                    target->cache.entries[j].sourceTimeStamp = builder.jobs[target->firstJobIndex + j].sourceTimeStamp;
+                }
+                kwlWaveBankBuildCache_writeToFile(&target->cache, target->cachePath);
+            }
+            continue;
+        }
+        
+        kwlResultCode wbResult = kwlWriteWaveBankBinary(&builder, target, edwb, errorLogCallback);
+        if (wbResult != KWL_SUCCESS)
+        {
+            errorLogCallback("Failed to write wave bank binary '%s'.\n", edwb->id);
+            finalResult = wbResult;
+        }
+        else
+        {
+            errorLogCallback("Built wave bank binary '%s'.\n", target->path);
+        }
+    }
+    
+    /*release any workers waiting for a slot and wait for them to finish.*/
+    for (int i = 0; i < numThreads; i++)
+    {
+        kwlSemaphorePost(builder.freeSlots);
+    }
+    for (int i = 0; i < numThreads; i++)
+    {
+        kwlThreadJoin(&threads[i]);
+    }
+    
+    kwlSemaphoreDestroy(builder.lock, builder.lockName);
+    kwlSemaphoreDestroy(builder.jobDone, builder.jobDoneName);
+    kwlSemaphoreDestroy(builder.freeSlots, builder.freeSlotsName);
+    
+    for (int i = 0; i < numJobs; i++)
+    {
+        KWL_FREE(builder.jobs[i].audioFilePath);
+    }
+    KWL_FREE(builder.jobs);
+    KWL_FREE(builder.buildQueue);
+    
+    for (int i = 0; i < numWaveBanks; i++)
+    {
+        KWL_FREE(targets[i].path);
+        KWL_FREE(targets[i].cachePath);
+        if (targets[i].hasCache)
+        {
+            kwlWaveBankBuildCache_free(&targets[i].cache);
         }
     }
+    KWL_FREE(targets);
     
+    kwlProjectIndex_free(&projectIndex);
+    kwlEngineDataBinary_free(&edb);
+    KWL_FREE(audioFileRoot);
     xmlFreeDoc(doc);
     
     return finalResult;
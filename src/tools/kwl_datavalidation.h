@@ -51,7 +51,8 @@ extern "C"
         KWL_COULD_NOT_OPEN_WAVE_BANK_BINARY_FILE,
         KWL_COULD_NOT_OPEN_ENGINE_DATA_BINARY_FILE,
         KWL_AUDIO_FILE_REFERENCE_ERROR,
-        KWL_ENGINE_DATA_STRUCTURE_ERROR
+        KWL_ENGINE_DATA_STRUCTURE_ERROR,
+        KWL_AUDIO_ENCODING_ERROR
     } kwlResultCode;
     
     
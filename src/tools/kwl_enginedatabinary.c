@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "kwl_asm.h"
 #include "kwl_assert.h"
 #include "kwl_audiofileutil.h"
 #include "kwl_binarybuilding.h"
@@ -32,6 +33,7 @@
 #include "kwl_inputstream.h"
 #include "kwl_memory.h"
 #include "kwl_fileoutputstream.h"
+#include "kwl_enginedata.h"
 #include "kwl_enginedatabinary.h"
 #include "kwl_sounddefinition.h"
 #include "kwl_xmlutil.h"
@@ -39,9 +41,19 @@
 #define KWL_TEMP_STRING_LENGTH 1024
 
 /*TODO: these shouldnt be global*/
-static char** soundDefinitionNames = NULL;
 const char* projectXmlPath = NULL;
 
+/**
+ * The state shared by the node tree traversal callbacks while building an engine data binary.
+ */
+typedef struct kwlEngineDataBuildContext
+{
+    /** The binary being built.*/
+    kwlEngineDataBinary* bin;
+    /** Indices of the project document being loaded, used to resolve all references.*/
+    const kwlProjectIndex* index;
+} kwlEngineDataBuildContext;
+
 int kwlFileIsEngineDataBinary(const char* path)
 {
     kwlInputStream is;
@@ -52,18 +64,24 @@ int kwlFileIsEngineDataBinary(const char* path)
     }
     
     int isEngineData = 1;
+    int isPackedEngineData = 1;
     for (int i = 0; i < KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH; i++)
     {
         char ci = kwlInputStream_readChar(&is);
         if (ci != KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER[i])
         {
             isEngineData = 0;
-            break;
+        }
+        if (ci != KWL_PACKED_ENGINE_DATA_BINARY_FILE_IDENTIFIER[i])
+        {
+            isPackedEngineData = 0;
         }
     }
     
     kwlInputStream_close(&is);
     
+    isEngineData = isEngineData || isPackedEngineData;
+    
     return isEngineData;
 }
 
@@ -113,7 +131,8 @@ static void kwlGatherMixBusesCallback(xmlNode* currentNode,
                                       int* errorOccurred,
                                       kwlLogCallback errorLogCallback)
 {
-    kwlEngineDataBinary* bin = (kwlEngineDataBinary*)b;
+    kwlEngineDataBuildContext* context = (kwlEngineDataBuildContext*)b;
+    kwlEngineDataBinary* bin = context->bin;
     bin->mixBusesChunk.numMixBuses += 1;
     bin->mixBusesChunk.mixBuses = KWL_REALLOC(bin->mixBusesChunk.mixBuses,
                                               sizeof(kwlMixBusChunk) * bin->mixBusesChunk.numMixBuses,
@@ -122,12 +141,98 @@ static void kwlGatherMixBusesCallback(xmlNode* currentNode,
     c->id = kwlGetAttributeValueCopy(currentNode, "id");
     KWL_ASSERT(c->id != NULL);
     c->numSubBuses = kwlGetChildCount(currentNode, KWL_XML_MIX_BUS_NODE);
+    c->isAuxReturn = kwlGetBoolAttributeValue(currentNode, KWL_XML_MIX_BUS_AUX_RETURN);
+    /*aux sends are gathered along with the sub buses, once the return bus flags of all buses are known.*/
+    c->numAuxSends = 0;
+    c->auxSendBusIndices = NULL;
+    c->auxSendLevels = NULL;
     if (c->numSubBuses > 0)
     {
         c->subBusIndices = KWL_MALLOCANDZERO(c->numSubBuses * sizeof(int), "xml 2 bin sub buses");
     }
 }
 
+static int kwlGetMixBusIndex(const kwlProjectIndex* index, kwlEngineDataBinary* bin, const char* id)
+{
+    KWL_ASSERT(bin->mixBusesChunk.numMixBuses > 0);
+    
+    const kwlNodeIndexEntry* entry = kwlNodeIndex_find(&index->mixBuses, id);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+    
+    KWL_ASSERT(entry->value < bin->mixBusesChunk.numMixBuses);
+    KWL_ASSERT(strcmp(bin->mixBusesChunk.mixBuses[entry->value].id, id) == 0);
+    return entry->value;
+}
+
+static int kwlDoesMixBusExist(const kwlProjectIndex* index, kwlEngineDataBinary* bin, const char* id)
+{
+    return kwlNodeIndex_find(&index->mixBuses, id) != NULL;
+}
+
+/**
+ * Gathers the aux sends of a mix bus or event node, making sure that each send 
+ * feeds an existing aux return bus.
+ */
+static void kwlGatherAuxSends(xmlNode* node,
+                              const kwlProjectIndex* index,
+                              kwlEngineDataBinary* bin,
+                              const char* ownerId,
+                              int* numAuxSends,
+                              int** busIndices,
+                              float** levels,
+                              int* errorOccurred,
+                              kwlLogCallback errorLogCallback)
+{
+    *numAuxSends = kwlGetChildCount(node, KWL_XML_AUX_SEND_NODE);
+    *busIndices = NULL;
+    *levels = NULL;
+    if (*numAuxSends == 0)
+    {
+        return;
+    }
+    
+    *busIndices = KWL_MALLOCANDZERO(*numAuxSends * sizeof(int), "xml 2 bin aux send buses");
+    *levels = KWL_MALLOCANDZERO(*numAuxSends * sizeof(float), "xml 2 bin aux send levels");
+    
+    int sendIdx = 0;
+    for (xmlNode* curr = node->children; curr != NULL; curr = curr->next)
+    {
+        if (!xmlStrEqual(curr->name, (xmlChar*)KWL_XML_AUX_SEND_NODE))
+        {
+            continue;
+        }
+        
+        const char* busId = (const char*)kwlGetAttributeValue(curr, KWL_XML_AUX_SEND_BUS);
+        const int busIdx = kwlGetMixBusIndex(index, bin, busId);
+        if (busIdx < 0)
+        {
+            *errorOccurred = 1;
+            errorLogCallback("'%s' sends to non-existing mix bus '%s'.\n", ownerId, busId);
+        }
+        else if (bin->mixBusesChunk.mixBuses[busIdx].isAuxReturn == 0)
+        {
+            *errorOccurred = 1;
+            errorLogCallback("'%s' sends to mix bus '%s', which is not an aux return bus.\n", ownerId, busId);
+        }
+        
+        for (int i = 0; i < sendIdx; i++)
+        {
+            if (busIdx >= 0 && (*busIndices)[i] == busIdx)
+            {
+                *errorOccurred = 1;
+                errorLogCallback("'%s' sends to mix bus '%s' more than once.\n", ownerId, busId);
+            }
+        }
+        
+        (*busIndices)[sendIdx] = busIdx;
+        (*levels)[sendIdx] = kwlGetFloatAttributeValue(curr, KWL_XML_AUX_SEND_LEVEL);
+        sendIdx++;
+    }
+}
+
 /**
  * gather sub buses of already gathered mix buses
  */
@@ -136,20 +241,13 @@ static void kwlGatherSubBusesCallback(xmlNode* node,
                                       int* errorOccurred,
                                       kwlLogCallback errorLogCallback)
 {
-    kwlEngineDataBinary* bin = (kwlEngineDataBinary*)b;
+    kwlEngineDataBuildContext* context = (kwlEngineDataBuildContext*)b;
+    kwlEngineDataBinary* bin = context->bin;
     
     //find the mix bus to attach the children to
-    kwlMixBusChunk* mb = NULL;
-    for (int i = 0; i < bin->mixBusesChunk.numMixBuses; i++)
-    {
-        kwlMixBusChunk* mbi = &bin->mixBusesChunk.mixBuses[i];
-        if (strcmp(mbi->id, kwlGetAttributeValue(node, KWL_XML_MIX_BUS_ID)) == 0)
-        {
-            mb = mbi;
-            break;
-        }
-    }
-    KWL_ASSERT(mb != NULL);
+    const int mbIdx = kwlGetMixBusIndex(context->index, bin, (const char*)kwlGetAttributeValue(node, KWL_XML_MIX_BUS_ID));
+    KWL_ASSERT(mbIdx >= 0);
+    kwlMixBusChunk* mb = &bin->mixBusesChunk.mixBuses[mbIdx];
     
     int childIdx = 0;
     for (xmlNode* curr = node->children; curr != NULL; curr = curr->next)
@@ -162,15 +260,7 @@ static void kwlGatherSubBusesCallback(xmlNode* node,
         //find the index of this sub bus
         const xmlChar* id = kwlGetAttributeValue(curr, "id");
         KWL_ASSERT(id != NULL);
-        int idx = -1;
-        for (int i = 0; i < bin->mixBusesChunk.numMixBuses; i++)
-        {
-            if (strcmp(bin->mixBusesChunk.mixBuses[i].id, id) == 0)
-            {
-                idx = i;
-                break;
-            }
-        }
+        const int idx = kwlGetMixBusIndex(context->index, bin, (const char*)id);
         
         mb->subBusIndices[childIdx] = idx;
         
@@ -178,83 +268,45 @@ static void kwlGatherSubBusesCallback(xmlNode* node,
         KWL_ASSERT(idx >= 0);
         childIdx++;
     }
+    
+    kwlGatherAuxSends(node, context->index, bin, mb->id, &mb->numAuxSends, &mb->auxSendBusIndices, &mb->auxSendLevels,
+                      errorOccurred, errorLogCallback);
+    
+    /*return buses are rendered after all other buses, which requires them to be leaves that don't send.*/
+    if (mb->isAuxReturn != 0 && 
+        (mb->numSubBuses > 0 || mb->numAuxSends > 0 || strcmp(mb->id, "master") == 0))
+    {
+        *errorOccurred = 1;
+        errorLogCallback("The aux return bus '%s' must not be the master bus, have sub buses or have aux sends.\n", mb->id);
+    }
 }
 
-static void kwlCreateMixBusChunk(xmlNode* projectRoot, kwlEngineDataBinary* bin, int* errorOccurred, kwlLogCallback errorLogCallback)
+static void kwlCreateMixBusChunk(xmlNode* projectRoot, kwlEngineDataBuildContext* context, int* errorOccurred, kwlLogCallback errorLogCallback)
 {
+    kwlEngineDataBinary* bin = context->bin;
     bin->mixBusesChunk.chunkId = KWL_MIX_BUSES_CHUNK_ID;
     
     kwlTraverseNodeTree(projectRoot,
                         KWL_XML_MIX_BUS_NODE,
                         KWL_XML_MIX_BUS_NODE,
                         kwlGatherMixBusesCallback,
-                        bin,
+                        context,
                         errorOccurred,
                         errorLogCallback);
     
-    /*check that all mix bus names are unique*/
-    for (int i = 0; i < bin->mixBusesChunk.numMixBuses; i++)
-    {
-        const char* idi = bin->mixBusesChunk.mixBuses[i].id;
-        for (int j = 0; j < bin->mixBusesChunk.numMixBuses; j++)
-        {
-            if (j != i)
-            {
-                const char* idj = bin->mixBusesChunk.mixBuses[j].id;
-                if (strcmp(idj, idi) == 0)
-                {
-                    errorLogCallback("Mix bus id '%s' is not unique.\n", idi);
-                    *errorOccurred = 1;
-                }
-            }
-        }
-    }
-    
-    if (*errorOccurred != 0)
-    {
-        /*if duplicate names were found, return now and skip gathering the sub buses*/
-        return;
-    }
+    /*mix bus id uniqueness has already been checked when building the project index*/
+    KWL_ASSERT(bin->mixBusesChunk.numMixBuses == context->index->mixBuses.numEntries);
     
     kwlTraverseNodeTree(projectRoot,
                         KWL_XML_MIX_BUS_NODE,
                         KWL_XML_MIX_BUS_NODE,
                         kwlGatherSubBusesCallback,
-                        bin,
+                        context,
                         errorOccurred,
                         errorLogCallback);
     
 }
 
-static int kwlGetMixBusIndex(kwlEngineDataBinary* bin, const char* id)
-{
-    KWL_ASSERT(bin->mixBusesChunk.numMixBuses > 0);
-    
-    for (int i = 0; i < bin->mixBusesChunk.numMixBuses; i++)
-    {
-        kwlMixBusChunk* mbi = &bin->mixBusesChunk.mixBuses[i];
-        if (strcmp(id, mbi->id) == 0)
-        {
-            return i;
-        }
-    }
-    
-    return -1;
-}
-
-static int kwlDoesMixBusExist(kwlEngineDataBinary* bin, const char* id)
-{
-    for (int i = 0; i < bin->mixBusesChunk.numMixBuses; i++)
-    {
-        if (strcmp(id, bin->mixBusesChunk.mixBuses[i].id) == 0)
-        {
-            return 1;
-        }
-    }
-    
-    return 0;
-}
-
 /**
  * Gather mix presets
  */
@@ -263,7 +315,8 @@ static void kwlGatherMixPresetsCallback(xmlNode* node,
                                         int* errorOccurred,
                                         kwlLogCallback errorLogCallback)
 {
-    kwlEngineDataBinary* bin = (kwlEngineDataBinary*)b;
+    kwlEngineDataBuildContext* context = (kwlEngineDataBuildContext*)b;
+    kwlEngineDataBinary* bin = context->bin;
     const int numMixBuses = bin->mixBusesChunk.numMixBuses;
     KWL_ASSERT(numMixBuses > 0);
     
@@ -274,6 +327,7 @@ static void kwlGatherMixPresetsCallback(xmlNode* node,
     kwlMixPresetChunk* c = &bin->mixPresetsChunk.mixPresets[bin->mixPresetsChunk.numMixPresets - 1];
     c->id = kwlGetNodePath(node);
     c->isDefault = kwlGetBoolAttributeValue(node, KWL_XML_MIX_PRESET_DEFAULT);
+    c->fadeTime = kwlGetFloatAttributeValue(node, KWL_XML_MIX_PRESET_FADE_TIME);
     c->mixBusIndices = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), "xml 2 bin mix preset bus indices");
     c->gainLeft = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), "xml 2 bin mix preset bus gain l");
     c->gainRight = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), "xml 2 bin mix preset bus gain r");
@@ -286,7 +340,7 @@ static void kwlGatherMixPresetsCallback(xmlNode* node,
         {
             //TODO: dont write bus index, use the already established bus order
             char* busId = kwlGetAttributeValue(curr, KWL_XML_MIX_BUS_PARAM_SET_BUS);
-            const int busIdx = kwlGetMixBusIndex(bin, busId);
+            const int busIdx = kwlGetMixBusIndex(context->index, bin, busId);
             
             if (busIdx < 0)
             {
@@ -305,7 +359,7 @@ static void kwlGatherMixPresetsCallback(xmlNode* node,
                 break;
             }
             c->gainLeft[paramSetIdx] = gainLeft;
-            c->gainLeft[paramSetIdx] = gainRight;
+            c->gainRight[paramSetIdx] = gainRight;
             c->pitch[paramSetIdx] = pitch;
             c->mixBusIndices[paramSetIdx] = busIdx;
             paramSetIdx++;
@@ -339,7 +393,7 @@ static void kwlGatherMixPresetsCallback(xmlNode* node,
                 if (busRefIds[j] != NULL)
                 {
                     if (strcmp(idOfRefedBus, busRefIds[j]) == 0 &&
-                        kwlDoesMixBusExist(bin, idOfRefedBus))
+                        kwlDoesMixBusExist(context->index, bin, idOfRefedBus))
                     {
                         errorLogCallback("Mix preset '%s' references the mix bus '%s' more than once.\n", c->id, idOfRefedBus);
                         *errorOccurred = 1;
@@ -366,17 +420,18 @@ static void kwlGatherMixPresetsCallback(xmlNode* node,
 }
 
 static void kwlCreateMixPresetChunk(xmlNode* projectRoot,
-                                    kwlEngineDataBinary* bin,
+                                    kwlEngineDataBuildContext* context,
                                     int* errorOccurred,
                                     kwlLogCallback errorLogCallback)
 {
+    kwlEngineDataBinary* bin = context->bin;
     bin->mixPresetsChunk.chunkId = KWL_MIX_PRESETS_CHUNK_ID;
     
     kwlTraverseNodeTree(projectRoot,
                         KWL_XML_MIX_PRESET_GROUP_NODE,
                         KWL_XML_MIX_PRESET_NODE,
                         kwlGatherMixPresetsCallback,
-                        bin,
+                        context,
                         errorOccurred,
                         errorLogCallback);
     
@@ -408,7 +463,8 @@ static void kwlGatherWaveBanksCallback(xmlNode* node,
                                        int* errorOccurred,
                                        kwlLogCallback errorLogCallback)
 {
-    kwlEngineDataBinary* bin = (kwlEngineDataBinary*)b;
+    kwlEngineDataBuildContext* context = (kwlEngineDataBuildContext*)b;
+    kwlEngineDataBinary* bin = context->bin;
     bin->waveBanksChunk.numWaveBanks += 1;
     bin->waveBanksChunk.waveBanks = KWL_REALLOC(bin->waveBanksChunk.waveBanks,
                                                 sizeof(kwlWaveBankChunk) * bin->waveBanksChunk.numWaveBanks,
@@ -436,8 +492,9 @@ static void kwlGatherWaveBanksCallback(xmlNode* node,
     KWL_ASSERT(path != NULL);
 }
 
-static void kwlCreateWaveBankChunk(xmlNode* projectRoot, kwlEngineDataBinary* bin, int* errorOccurred, kwlLogCallback errorLogCallback)
+static void kwlCreateWaveBankChunk(xmlNode* projectRoot, kwlEngineDataBuildContext* context, int* errorOccurred, kwlLogCallback errorLogCallback)
 {
+    kwlEngineDataBinary* bin = context->bin;
     bin->waveBanksChunk.chunkId = KWL_WAVE_BANKS_CHUNK_ID;
     
     /*collect wave banks and their ids and audio data entry counts*/
@@ -445,7 +502,7 @@ static void kwlCreateWaveBankChunk(xmlNode* projectRoot, kwlEngineDataBinary* bi
                         KWL_XML_WAVE_BANK_GROUP_NODE,
                         KWL_XML_WAVE_BANK_NODE,
                         kwlGatherWaveBanksCallback,
-                        bin,
+                        context,
                         errorOccurred,
                         errorLogCallback);
     /*store the total number of audio data items*/
@@ -458,51 +515,48 @@ static void kwlCreateWaveBankChunk(xmlNode* projectRoot, kwlEngineDataBinary* bi
     bin->waveBanksChunk.numAudioDataItemsTotal = totalNumItems;
 }
 
-static int kwlGetWaveBankIndex(kwlEngineDataBinary* bin, const char* id)
+static int kwlGetWaveBankIndex(const kwlProjectIndex* index, kwlEngineDataBinary* bin, const char* id)
 {
-    for (int i = 0; i < bin->waveBanksChunk.numWaveBanks; i++)
+    /*group paths are indexed too, but have negative values*/
+    const kwlNodeIndexEntry* entry = kwlNodeIndex_find(&index->waveBanks, id);
+    if (entry == NULL || entry->value < 0)
     {
-        kwlWaveBankChunk* wbi = &bin->waveBanksChunk.waveBanks[i];
-        if (strcmp(id, wbi->id) == 0)
-        {
-            return i;
-        }
+        return -1;
     }
     
-    return -1;
+    KWL_ASSERT(entry->value < bin->waveBanksChunk.numWaveBanks);
+    KWL_ASSERT(strcmp(bin->waveBanksChunk.waveBanks[entry->value].id, id) == 0);
+    return entry->value;
 }
 
-static int kwlGetSoundIndex(kwlEngineDataBinary* bin, const char* id)
+static int kwlGetSoundIndex(const kwlProjectIndex* index, kwlEngineDataBinary* bin, const char* id)
 {
-    KWL_ASSERT(soundDefinitionNames != NULL);
-    for (int i = 0; i < bin->soundsChunk.numSoundDefinitions; i++)
+    const kwlNodeIndexEntry* entry = kwlNodeIndex_find(&index->sounds, id);
+    if (entry == NULL || entry->value < 0)
     {
-        if (strcmp(id, soundDefinitionNames[i]) == 0)
-        {
-            return i;
-        }
+        return -1;
     }
     
-    return -1;
+    KWL_ASSERT(entry->value < bin->soundsChunk.numSoundDefinitions);
+    return entry->value;
 }
 
-static int kwlGetAudioDataIndex(kwlWaveBankChunk* wb, const char* id)
+static int kwlGetAudioDataIndex(const kwlProjectIndex* index, int waveBankIndex, const char* id)
 {
-    KWL_ASSERT(wb != NULL);
+    KWL_ASSERT(waveBankIndex >= 0);
     KWL_ASSERT(id != NULL);
-    KWL_ASSERT(wb->audioDataEntries != NULL);
-    
-    for (int i = 0; i < wb->numAudioDataEntries; i++)
-    {
-        
-        KWL_ASSERT(wb->audioDataEntries[i] != NULL);
-        if (strcmp(id, wb->audioDataEntries[i]) == 0)
-        {
-            return i;
-        }
-    }
     
-    return -1;
+    const kwlNodeIndexEntry* entry = kwlProjectIndex_findAudioData(index, waveBankIndex, id);
+    return entry == NULL ? -1 : entry->value;
+}
+
+static xmlNode* kwlGetAudioDataNode(const kwlProjectIndex* index, int waveBankIndex, int audioDataIndex, kwlEngineDataBinary* bin)
+{
+    kwlWaveBankChunk* wb = &bin->waveBanksChunk.waveBanks[waveBankIndex];
+    const kwlNodeIndexEntry* entry = kwlProjectIndex_findAudioData(index,
+                                                                   waveBankIndex,
+                                                                   wb->audioDataEntries[audioDataIndex]);
+    return entry == NULL ? NULL : entry->node;
 }
 
 static int kwlGetSoundPlaybackModeInt(xmlChar* playbackMode)
@@ -552,18 +606,14 @@ static void kwlGatherSoundsCallback(xmlNode* node,
 {
     *errorOccurred = 0;
     
-    kwlEngineDataBinary* bin = (kwlEngineDataBinary*)b;
+    kwlEngineDataBuildContext* context = (kwlEngineDataBuildContext*)b;
+    kwlEngineDataBinary* bin = context->bin;
     bin->soundsChunk.numSoundDefinitions += 1;
     bin->soundsChunk.soundDefinitions = KWL_REALLOC(bin->soundsChunk.soundDefinitions,
                                                     sizeof(kwlSoundChunk) * bin->soundsChunk.numSoundDefinitions,
                                                     "xml 2 bin sound realloc");
     kwlSoundChunk* c = &bin->soundsChunk.soundDefinitions[bin->soundsChunk.numSoundDefinitions - 1];
     
-    soundDefinitionNames = KWL_REALLOC(soundDefinitionNames,
-                                       bin->soundsChunk.numSoundDefinitions * sizeof(char*),
-                                       "sound def id list realloc");
-    soundDefinitionNames[bin->soundsChunk.numSoundDefinitions - 1] = kwlGetNodePath(node);
-    
     c->gain = kwlGetFloatAttributeValue(node, KWL_XML_SOUND_GAIN);
     c->gainVariation = kwlGetFloatAttributeValue(node, KWL_XML_SOUND_GAIN_VAR);
     c->pitch = kwlGetFloatAttributeValue(node, KWL_XML_SOUND_PITCH);
@@ -587,7 +637,7 @@ static void kwlGatherSoundsCallback(xmlNode* node,
             xmlChar* filePath = kwlGetAttributeValue(curr, KWL_XML_AUDIO_DATA_REFERENCE_PATH);
             xmlChar* waveBankId = kwlGetAttributeValue(curr, KWL_XML_AUDIO_DATA_REFERENCE_WAVEBANK);
             
-            const int wbIdx = kwlGetWaveBankIndex(bin, waveBankId);
+            const int wbIdx = kwlGetWaveBankIndex(context->index, bin, waveBankId);
             c->waveBankIndices[refIdx] = wbIdx;
             
             
@@ -602,7 +652,7 @@ static void kwlGatherSoundsCallback(xmlNode* node,
             else
             {
                 kwlWaveBankChunk* wb = &bin->waveBanksChunk.waveBanks[wbIdx];
-                const int itemIdx = kwlGetAudioDataIndex(wb, filePath);
+                const int itemIdx = kwlGetAudioDataIndex(context->index, wbIdx, (const char*)filePath);
                 c->audioDataIndices[refIdx] = itemIdx;
                 const char* soundPath = kwlGetNodePath(node);
                 if (itemIdx < 0)
@@ -614,7 +664,7 @@ static void kwlGatherSoundsCallback(xmlNode* node,
                 }
                 else
                 {
-                    xmlNode* audioDataNode = kwlResolveAudioDataReference(node, wb->id, wb->audioDataEntries[itemIdx]);
+                    xmlNode* audioDataNode = kwlGetAudioDataNode(context->index, wbIdx, itemIdx, bin);
                     KWL_ASSERT(audioDataNode != NULL);
                     int streamFromDisk = kwlGetBoolAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_STREAM);
                     if (streamFromDisk)
@@ -636,15 +686,16 @@ static void kwlGatherSoundsCallback(xmlNode* node,
     KWL_ASSERT(refIdx == c->numWaveReferences);
 }
 
-static void kwlCreateSoundChunk(xmlNode* projectRoot, kwlEngineDataBinary* bin, int* errorOccurred, kwlLogCallback errorLogCallback)
+static void kwlCreateSoundChunk(xmlNode* projectRoot, kwlEngineDataBuildContext* context, int* errorOccurred, kwlLogCallback errorLogCallback)
 {
+    kwlEngineDataBinary* bin = context->bin;
     bin->soundsChunk.chunkId = KWL_SOUNDS_CHUNK_ID;
     
     kwlTraverseNodeTree(projectRoot,
                         KWL_XML_SOUND_GROUP_NODE,
                         KWL_XML_SOUND_NODE,
                         kwlGatherSoundsCallback,
-                        bin,
+                        context,
                         errorOccurred,
                         errorLogCallback);
 }
@@ -690,7 +741,8 @@ static void kwlGatherEventsCallback(xmlNode* node,
                                     int* errorOccurred,
                                     kwlLogCallback errorLogCallback)
 {
-    kwlEngineDataBinary* bin = (kwlEngineDataBinary*)b;
+    kwlEngineDataBuildContext* context = (kwlEngineDataBuildContext*)b;
+    kwlEngineDataBinary* bin = context->bin;
     bin->eventsChunk.numEventDefinitions += 1;
     bin->eventsChunk.eventDefinitions = KWL_REALLOC(bin->eventsChunk.eventDefinitions,
                                                     sizeof(kwlEventChunk) * bin->eventsChunk.numEventDefinitions,
@@ -706,7 +758,7 @@ static void kwlGatherEventsCallback(xmlNode* node,
     c->pitch = kwlGetFloatAttributeValue(node, KWL_XML_EVENT_PITCH);
     c->instanceCount = kwlGetFloatAttributeValue(node, KWL_XML_EVENT_INSTANCE_COUNT);
     c->isPositional = kwlGetBoolAttributeValue(node, KWL_XML_EVENT_IS_POSITIONAL);
-    c->mixBusIndex = kwlGetMixBusIndex(bin, kwlGetAttributeValue(node, KWL_XML_EVENT_BUS));
+    c->mixBusIndex = kwlGetMixBusIndex(context->index, bin, kwlGetAttributeValue(node, KWL_XML_EVENT_BUS));
     c->retriggerMode = kwlGetEventRetriggerModeInt(kwlGetAttributeValue(node, KWL_XML_EVENT_RETRIGGER_MODE));
     c->instanceStealingMode = kwlGetEventInstanceStealingModeInt(kwlGetAttributeValue(node, KWL_XML_EVENT_INSTANCE_STEALING_MODE));
     
@@ -718,6 +770,14 @@ static void kwlGatherEventsCallback(xmlNode* node,
                          c->id);
     }
     
+    kwlGatherAuxSends(node, context->index, bin, c->id, &c->numAuxSends, &c->auxSendBusIndices, &c->auxSendLevels,
+                      errorOccurred, errorLogCallback);
+    if (c->numAuxSends > 0 && c->mixBusIndex >= 0 && bin->mixBusesChunk.mixBuses[c->mixBusIndex].isAuxReturn != 0)
+    {
+        *errorOccurred = 1;
+        errorLogCallback("Event definition '%s' is in an aux return bus and can not have aux sends.\n", c->id);
+    }
+    
     const int eventHasAudioRef = kwlGetChildCount(node, KWL_XML_SOUND_REFERENCE_NODE) == 0;
     
     c->soundIndex = -1;
@@ -733,7 +793,7 @@ static void kwlGatherEventsCallback(xmlNode* node,
         const int loop = kwlGetBoolAttributeValue(audioDataRefNode, KWL_XML_AUDIO_DATA_REFERENCE_LOOP);
         
         
-        c->waveBankIndex = kwlGetWaveBankIndex(bin, wbPath);
+        c->waveBankIndex = kwlGetWaveBankIndex(context->index, bin, wbPath);
         c->audioDataIndex = -1;
         c->loopIfStreaming = loop;
         if (c->waveBankIndex < 0)
@@ -744,8 +804,7 @@ static void kwlGatherEventsCallback(xmlNode* node,
         else
         {
             KWL_ASSERT(c->waveBankIndex >= 0 && c->waveBankIndex < bin->waveBanksChunk.numWaveBanks);
-            kwlWaveBankChunk* wb = &bin->waveBanksChunk.waveBanks[c->waveBankIndex];
-            const int itemIdx = kwlGetAudioDataIndex(wb, audioDataPath);
+            const int itemIdx = kwlGetAudioDataIndex(context->index, c->waveBankIndex, audioDataPath);
             if (itemIdx < 0)
             {
                 *errorOccurred = 1;
@@ -753,7 +812,7 @@ static void kwlGatherEventsCallback(xmlNode* node,
             }
             else
             {
-                c->audioDataIndex = kwlGetAudioDataIndex(wb, audioDataPath);
+                c->audioDataIndex = itemIdx;
             }
         }
         
@@ -766,7 +825,7 @@ static void kwlGatherEventsCallback(xmlNode* node,
         xmlNode* soundRefNode = kwlGetChild(node, KWL_XML_SOUND_REFERENCE_NODE);
         KWL_ASSERT(soundRefNode != NULL);
         xmlChar* soundPath = kwlGetAttributeValue(soundRefNode, KWL_XML_SOUND_REFERENCE_SOUND);
-        c->soundIndex = kwlGetSoundIndex(bin, soundPath);
+        c->soundIndex = kwlGetSoundIndex(context->index, bin, soundPath);
         
         if (c->soundIndex < 0)
         {
@@ -809,28 +868,21 @@ static void kwlGatherEventsCallback(xmlNode* node,
 }
 
 static void kwlCreateEventChunk(xmlNode* eventsRootGroup,
-                                kwlEngineDataBinary* bin,
+                                kwlEngineDataBuildContext* context,
                                 int* errorOccurred,
                                 kwlLogCallback errorLogCallback)
 {
+    kwlEngineDataBinary* bin = context->bin;
     bin->eventsChunk.chunkId = KWL_EVENTS_CHUNK_ID;
     
     kwlTraverseNodeTree(eventsRootGroup,
                         KWL_XML_EVENT_GROUP_NODE,
                         KWL_XML_EVENT_NODE,
                         kwlGatherEventsCallback,
-                        bin,
+                        context,
                         errorOccurred,
                         errorLogCallback);
     
-    /*we don't need the sound definition names anymore*/
-    for (int i = 0; i < bin->soundsChunk.numSoundDefinitions; i++)
-    {
-        KWL_FREE(soundDefinitionNames[i]);
-    }
-    
-    KWL_FREE(soundDefinitionNames);
-    
     if (*errorOccurred)
     {
         return;
@@ -850,9 +902,7 @@ static void kwlCreateEventChunk(xmlNode* eventsRootGroup,
         const int adIdx = ei->audioDataIndex;
         if (ei->soundIndex < 0)
         {
-            xmlNode* audioDataNode = kwlResolveAudioDataReference(eventsRootGroup,
-                                                                  bin->waveBanksChunk.waveBanks[wbIdx].id,
-                                                                  bin->waveBanksChunk.waveBanks[wbIdx].audioDataEntries[adIdx]);
+            xmlNode* audioDataNode = kwlGetAudioDataNode(context->index, wbIdx, adIdx, bin);
             KWL_ASSERT(audioDataNode);
             char* relFilePath = kwlGetAttributeValueCopy(audioDataNode, KWL_XML_ATTR_REL_PATH);
             const int streaming = kwlGetBoolAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_STREAM);
@@ -908,68 +958,6 @@ static void kwlCreateEventChunk(xmlNode* eventsRootGroup,
     KWL_FREE(audioFileRoot);
 }
 
-static void kwlCheckPathUniqueness(xmlNode* node,
-                                   const char* branchNodeName,
-                                   const char* leafNodeName,
-                                   int* uniquenessErrorOccurred,
-                                   kwlLogCallback errorLogCallback)
-{
-    const int childCount = kwlGetChildCount(node, branchNodeName) + kwlGetChildCount(node, leafNodeName);
-    
-    /*gather child id list*/
-    const xmlChar** childNames = KWL_MALLOC(childCount * sizeof(char*), "path uniqueness check list");
-    int childIdx = 0;
-    for (xmlNode* curr = node->children; curr != NULL; curr = curr->next)
-    {
-        if (xmlStrEqual(curr->name, (xmlChar*)branchNodeName) ||
-            xmlStrEqual(curr->name, (xmlChar*)leafNodeName))
-        {
-            childNames[childIdx] = kwlGetAttributeValue(curr, "id");
-            KWL_ASSERT(childNames[childIdx] != NULL);
-            childIdx++;
-        }
-    }
-    
-    KWL_ASSERT(childCount == childIdx);
-    
-    /*check id uniqueness*/
-    for (int i = 0; i < childCount; i++)
-    {
-        int numMatches = 0;
-        for (int j = 0; j < childCount; j++)
-        {
-            if (xmlStrEqual(childNames[i], childNames[j]))
-            {
-                numMatches++;
-            }
-        }
-        
-        KWL_ASSERT(numMatches > 0);
-        
-        if (numMatches > 1)
-        {
-            errorLogCallback("The id '%s' is not unique among the children of the %s node with id '%s'.\n",
-                             childNames[i], branchNodeName, kwlGetAttributeValue(node, "id"));
-            *uniquenessErrorOccurred = 1;
-        }
-    }
-    
-    KWL_FREE(childNames);
-    
-    /*traverse branch nodes*/
-    for (xmlNode* curr = node->children; curr != NULL; curr = curr->next)
-    {
-        if (xmlStrEqual(curr->name, (xmlChar*)branchNodeName))
-        {
-            kwlCheckPathUniqueness(curr,
-                                   branchNodeName,
-                                   leafNodeName,
-                                   uniquenessErrorOccurred,
-                                   errorLogCallback);
-        }
-    }
-}
-
 kwlResultCode kwlEngineDataBinary_loadFromXMLDocument(kwlEngineDataBinary* bin,
                                                       const char* xmlPath,
                                                       xmlDocPtr doc,
@@ -1018,38 +1006,12 @@ kwlResultCode kwlEngineDataBinary_loadFromXMLDocument(kwlEngineDataBinary* bin,
     KWL_ASSERT(soundRootNode != NULL);
     KWL_ASSERT(eventRootNode != NULL);
     
-    /*before starting to build the binary, check path uniqueness*/
+    /*before starting to build the binary, index all nodes by path. this also checks path uniqueness*/
+    kwlProjectIndex projectIndex;
+    if (!kwlProjectIndex_init(&projectIndex, projectRootNode, errorLogCallback))
     {
-        int uniquenessErrorOccurred = 0;
-        
-        kwlCheckPathUniqueness(mixPresetRootNode,
-                               KWL_XML_MIX_PRESET_GROUP_NODE,
-                               KWL_XML_MIX_PRESET_NODE,
-                               &uniquenessErrorOccurred,
-                               errorLogCallback);
-        
-        kwlCheckPathUniqueness(waveBankRootNode,
-                               KWL_XML_WAVE_BANK_GROUP_NODE,
-                               KWL_XML_WAVE_BANK_NODE,
-                               &uniquenessErrorOccurred,
-                               errorLogCallback);
-        
-        kwlCheckPathUniqueness(soundRootNode,
-                               KWL_XML_SOUND_GROUP_NODE,
-                               KWL_XML_SOUND_NODE,
-                               &uniquenessErrorOccurred,
-                               errorLogCallback);
-        
-        kwlCheckPathUniqueness(eventRootNode,
-                               KWL_XML_EVENT_GROUP_NODE,
-                               KWL_XML_EVENT_NODE,
-                               &uniquenessErrorOccurred,
-                               errorLogCallback);
-        
-        if (uniquenessErrorOccurred != 0)
-        {
-            return KWL_PROJECT_XML_STRUCTURE_ERROR;
-        }
+        kwlProjectIndex_free(&projectIndex);
+        return KWL_PROJECT_XML_STRUCTURE_ERROR;
     }
     
     kwlMemset(bin, 0, sizeof(kwlEngineDataBinary));
@@ -1060,21 +1022,23 @@ kwlResultCode kwlEngineDataBinary_loadFromXMLDocument(kwlEngineDataBinary* bin,
     }
     
     /*then gather the different chunks*/
-    soundDefinitionNames = NULL;
-    
+    kwlEngineDataBuildContext context;
+    context.bin = bin;
+    context.index = &projectIndex;
     int mixBusErrorOccurred = 0;
-    kwlCreateMixBusChunk(projectRootNode, bin, &mixBusErrorOccurred, errorLogCallback);
+    kwlCreateMixBusChunk(projectRootNode, &context, &mixBusErrorOccurred, errorLogCallback);
     int mixPresetErrorOccurred = 0;
-    kwlCreateMixPresetChunk(mixPresetRootNode, bin, &mixPresetErrorOccurred, errorLogCallback);
+    kwlCreateMixPresetChunk(mixPresetRootNode, &context, &mixPresetErrorOccurred, errorLogCallback);
     int waveBankErrorOccurred = 0;
-    kwlCreateWaveBankChunk(waveBankRootNode, bin, &waveBankErrorOccurred, errorLogCallback);
+    kwlCreateWaveBankChunk(waveBankRootNode, &context, &waveBankErrorOccurred, errorLogCallback);
     int soundErrorOccurred = 0;
-    kwlCreateSoundChunk(soundRootNode, bin, &soundErrorOccurred, errorLogCallback);
+    kwlCreateSoundChunk(soundRootNode, &context, &soundErrorOccurred, errorLogCallback);
     int eventErrorOccurred = 0;
-    kwlCreateEventChunk(eventRootNode, bin, &eventErrorOccurred, errorLogCallback);
+    kwlCreateEventChunk(eventRootNode, &context, &eventErrorOccurred, errorLogCallback);
     
     int audioDataReferenceErrorOccurred = 0;
     
+    kwlProjectIndex_free(&projectIndex);
     
     /*check if everything went well*/
     if (mixBusErrorOccurred ||
@@ -1167,8 +1131,334 @@ kwlResultCode kwlEngineDataBinary_validateFileReferences(kwlEngineDataBinary* bi
     return result;
 }
 
+/**
+ * A growing blob of null terminated strings where each unique string is stored once.
+ */
+typedef struct kwlStringBlob
+{
+    char* data;
+    int size;
+    int capacity;
+    /** Maps each string in the blob to its offset.*/
+    kwlNodeIndex offsets;
+} kwlStringBlob;
+
+/**
+ * Returns the offset of a given string in a string blob, adding the string if it's not already in the blob.
+ */
+static int kwlStringBlob_intern(kwlStringBlob* blob, const char* str)
+{
+    const kwlNodeIndexEntry* entry = kwlNodeIndex_find(&blob->offsets, str);
+    if (entry != NULL)
+    {
+        return entry->value;
+    }
+    
+    const int length = (int)strlen(str) + 1;
+    if (blob->size + length > blob->capacity)
+    {
+        blob->capacity = 2 * (blob->size + length);
+        blob->data = KWL_REALLOC(blob->data, blob->capacity, "string blob");
+    }
+    
+    const int offset = blob->size;
+    kwlMemcpy(&blob->data[offset], str, length);
+    blob->size += length;
+    
+    kwlNodeIndex_add(&blob->offsets, str, NULL, offset);
+    
+    return offset;
+}
+
+/**
+ * Returns the index of the first audio data entry of a given wave bank in the 
+ * concatenated audio data entries of all wave banks.
+ */
+static int kwlGetFirstAudioDataEntryIndex(kwlEngineDataBinary* bin, int waveBankIndex)
+{
+    int firstIndex = 0;
+    for (int i = 0; i < waveBankIndex; i++)
+    {
+        firstIndex += bin->waveBanksChunk.waveBanks[i].numAudioDataEntries;
+    }
+    return firstIndex;
+}
+
 kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
                                               const char* path)
+{
+    const int numMixBuses = bin->mixBusesChunk.numMixBuses;
+    const int numMixPresets = bin->mixPresetsChunk.numMixPresets;
+    const int numWaveBanks = bin->waveBanksChunk.numWaveBanks;
+    const int numSounds = bin->soundsChunk.numSoundDefinitions;
+    const int numEvents = bin->eventsChunk.numEventDefinitions;
+    const int numAudioDataEntries = kwlGetFirstAudioDataEntryIndex(bin, numWaveBanks);
+    
+    /*count the entries of the shared index array*/
+    int numIndices = 0;
+    for (int i = 0; i < numMixBuses; i++)
+    {
+        numIndices += bin->mixBusesChunk.mixBuses[i].numSubBuses;
+    }
+    for (int i = 0; i < numSounds; i++)
+    {
+        numIndices += bin->soundsChunk.soundDefinitions[i].numWaveReferences;
+    }
+    for (int i = 0; i < numEvents; i++)
+    {
+        numIndices += bin->eventsChunk.eventDefinitions[i].numReferencedWaveBanks;
+    }
+    const int numMixPresetParameters = 3 * numMixBuses * numMixPresets;
+    
+    /*count the aux sends*/
+    int numAuxSends = 0;
+    for (int i = 0; i < numMixBuses; i++)
+    {
+        numAuxSends += bin->mixBusesChunk.mixBuses[i].numAuxSends;
+    }
+    for (int i = 0; i < numEvents; i++)
+    {
+        numAuxSends += bin->eventsChunk.eventDefinitions[i].numAuxSends;
+    }
+    
+    /*intern all ids and paths*/
+    kwlStringBlob strings;
+    kwlMemset(&strings, 0, sizeof(kwlStringBlob));
+    kwlNodeIndex_init(&strings.offsets);
+    int* mixBusIds = KWL_MALLOCANDZERO((numMixBuses + 1) * sizeof(int), "packed mix bus ids");
+    int* mixPresetIds = KWL_MALLOCANDZERO((numMixPresets + 1) * sizeof(int), "packed mix preset ids");
+    int* waveBankIds = KWL_MALLOCANDZERO((numWaveBanks + 1) * sizeof(int), "packed wave bank ids");
+    int* audioDataPaths = KWL_MALLOCANDZERO((numAudioDataEntries + 1) * sizeof(int), "packed audio data paths");
+    int* eventIds = KWL_MALLOCANDZERO((numEvents + 1) * sizeof(int), "packed event ids");
+    for (int i = 0; i < numMixBuses; i++)
+    {
+        mixBusIds[i] = kwlStringBlob_intern(&strings, bin->mixBusesChunk.mixBuses[i].id);
+    }
+    for (int i = 0; i < numMixPresets; i++)
+    {
+        mixPresetIds[i] = kwlStringBlob_intern(&strings, bin->mixPresetsChunk.mixPresets[i].id);
+    }
+    int audioDataIdx = 0;
+    for (int i = 0; i < numWaveBanks; i++)
+    {
+        kwlWaveBankChunk* wbi = &bin->waveBanksChunk.waveBanks[i];
+        waveBankIds[i] = kwlStringBlob_intern(&strings, wbi->id);
+        for (int j = 0; j < wbi->numAudioDataEntries; j++)
+        {
+            audioDataPaths[audioDataIdx++] = kwlStringBlob_intern(&strings, wbi->audioDataEntries[j]);
+        }
+    }
+    for (int i = 0; i < numEvents; i++)
+    {
+        eventIds[i] = kwlStringBlob_intern(&strings, bin->eventsChunk.eventDefinitions[i].id);
+    }
+    
+    /*lay out the sections*/
+    kwlPackedEngineDataHeader header;
+    kwlMemset(&header, 0, sizeof(kwlPackedEngineDataHeader));
+    kwlMemcpy(header.identifier, KWL_PACKED_ENGINE_DATA_BINARY_FILE_IDENTIFIER, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH);
+    header.version = KWL_PACKED_ENGINE_DATA_VERSION;
+    int offset = sizeof(kwlPackedEngineDataHeader);
+    header.numMixBuses = numMixBuses;
+    header.mixBusesOffset = offset;
+    offset += numMixBuses * sizeof(kwlPackedMixBus);
+    header.numMixPresets = numMixPresets;
+    header.mixPresetsOffset = offset;
+    offset += numMixPresets * sizeof(kwlPackedMixPreset);
+    header.numWaveBanks = numWaveBanks;
+    header.waveBanksOffset = offset;
+    offset += numWaveBanks * sizeof(kwlPackedWaveBank);
+    header.numAudioDataEntries = numAudioDataEntries;
+    header.audioDataEntriesOffset = offset;
+    offset += numAudioDataEntries * sizeof(kwlPackedAudioData);
+    header.numSoundDefinitions = numSounds;
+    header.soundDefinitionsOffset = offset;
+    offset += numSounds * sizeof(kwlPackedSoundDefinition);
+    header.numEventDefinitions = numEvents;
+    header.eventDefinitionsOffset = offset;
+    offset += numEvents * sizeof(kwlPackedEventDefinition);
+    header.numAuxSends = numAuxSends;
+    header.auxSendsOffset = offset;
+    offset += numAuxSends * sizeof(kwlPackedAuxSend);
+    header.numIndices = numIndices;
+    header.indicesOffset = offset;
+    offset += numIndices * sizeof(int);
+    header.numMixPresetParameters = numMixPresetParameters;
+    header.mixPresetParametersOffset = offset;
+    offset += numMixPresetParameters * sizeof(float);
+    header.stringsSize = strings.size;
+    header.stringsOffset = offset;
+    offset += strings.size;
+    header.fileSize = offset;
+    
+    /*fill in the file image*/
+    char* image = KWL_MALLOCANDZERO(header.fileSize, "packed engine data image");
+    kwlMemcpy(image, &header, sizeof(kwlPackedEngineDataHeader));
+    kwlPackedMixBus* packedMixBuses = (kwlPackedMixBus*)&image[header.mixBusesOffset];
+    kwlPackedMixPreset* packedMixPresets = (kwlPackedMixPreset*)&image[header.mixPresetsOffset];
+    kwlPackedWaveBank* packedWaveBanks = (kwlPackedWaveBank*)&image[header.waveBanksOffset];
+    kwlPackedAudioData* packedAudioData = (kwlPackedAudioData*)&image[header.audioDataEntriesOffset];
+    kwlPackedSoundDefinition* packedSounds = (kwlPackedSoundDefinition*)&image[header.soundDefinitionsOffset];
+    kwlPackedEventDefinition* packedEvents = (kwlPackedEventDefinition*)&image[header.eventDefinitionsOffset];
+    kwlPackedAuxSend* packedAuxSends = (kwlPackedAuxSend*)&image[header.auxSendsOffset];
+    int* indices = (int*)&image[header.indicesOffset];
+    float* mixPresetParameters = (float*)&image[header.mixPresetParametersOffset];
+    int indexIdx = 0;
+    int auxSendIdx = 0;
+    
+    for (int i = 0; i < numMixBuses; i++)
+    {
+        kwlMixBusChunk* mbi = &bin->mixBusesChunk.mixBuses[i];
+        packedMixBuses[i].idOffset = mixBusIds[i];
+        packedMixBuses[i].numSubBuses = mbi->numSubBuses;
+        packedMixBuses[i].firstSubBusIndex = indexIdx;
+        for (int j = 0; j < mbi->numSubBuses; j++)
+        {
+            indices[indexIdx++] = mbi->subBusIndices[j];
+        }
+        packedMixBuses[i].isAuxReturn = mbi->isAuxReturn;
+        packedMixBuses[i].numAuxSends = mbi->numAuxSends;
+        packedMixBuses[i].firstAuxSend = auxSendIdx;
+        for (int j = 0; j < mbi->numAuxSends; j++)
+        {
+            packedAuxSends[auxSendIdx].returnBusIndex = mbi->auxSendBusIndices[j];
+            packedAuxSends[auxSendIdx].level = mbi->auxSendLevels[j];
+            auxSendIdx++;
+        }
+    }
+    
+    for (int i = 0; i < numMixPresets; i++)
+    {
+        kwlMixPresetChunk* mpi = &bin->mixPresetsChunk.mixPresets[i];
+        const int firstParameterIndex = 3 * numMixBuses * i;
+        packedMixPresets[i].idOffset = mixPresetIds[i];
+        packedMixPresets[i].isDefault = mpi->isDefault;
+        packedMixPresets[i].fadeTime = mpi->fadeTime;
+        packedMixPresets[i].firstParameterIndex = firstParameterIndex;
+        
+        /*store parameters densely, in mix bus index order*/
+        float* gainLeft = &mixPresetParameters[firstParameterIndex];
+        float* gainRight = gainLeft + numMixBuses;
+        float* pitch = gainRight + numMixBuses;
+        for (int j = 0; j < numMixBuses; j++)
+        {
+            const int busIndex = mpi->mixBusIndices[j];
+            KWL_ASSERT(busIndex >= 0 && busIndex < numMixBuses);
+            gainLeft[busIndex] = mpi->gainLeft[j];
+            gainRight[busIndex] = mpi->gainRight[j];
+            pitch[busIndex] = mpi->pitch[j];
+        }
+    }
+    
+    for (int i = 0; i < numWaveBanks; i++)
+    {
+        packedWaveBanks[i].idOffset = waveBankIds[i];
+        packedWaveBanks[i].numAudioDataEntries = bin->waveBanksChunk.waveBanks[i].numAudioDataEntries;
+        packedWaveBanks[i].firstAudioDataEntry = kwlGetFirstAudioDataEntryIndex(bin, i);
+    }
+    
+    for (int i = 0; i < numAudioDataEntries; i++)
+    {
+        packedAudioData[i].filePathOffset = audioDataPaths[i];
+    }
+    
+    for (int i = 0; i < numSounds; i++)
+    {
+        kwlSoundChunk* si = &bin->soundsChunk.soundDefinitions[i];
+        packedSounds[i].playbackCount = si->playbackCount;
+        packedSounds[i].deferStop = si->deferStop;
+        packedSounds[i].gain = si->gain;
+        packedSounds[i].gainVariation = si->gainVariation;
+        packedSounds[i].pitch = si->pitch;
+        packedSounds[i].pitchVariation = si->pitchVariation;
+        packedSounds[i].playbackMode = si->playbackMode;
+        packedSounds[i].numAudioDataEntries = si->numWaveReferences;
+        packedSounds[i].firstAudioDataEntryIndex = indexIdx;
+        for (int j = 0; j < si->numWaveReferences; j++)
+        {
+            indices[indexIdx++] = kwlGetFirstAudioDataEntryIndex(bin, si->waveBankIndices[j]) + si->audioDataIndices[j];
+        }
+    }
+    
+    for (int i = 0; i < numEvents; i++)
+    {
+        kwlEventChunk* ei = &bin->eventsChunk.eventDefinitions[i];
+        kwlPackedEventDefinition* pe = &packedEvents[i];
+        pe->idOffset = eventIds[i];
+        pe->instanceCount = ei->instanceCount;
+        pe->gain = ei->gain;
+        pe->pitch = ei->pitch;
+        pe->innerConeAngleDeg = ei->innerConeAngleDeg;
+        pe->outerConeAngleDeg = ei->outerConeAngleDeg;
+        pe->outerConeGain = ei->outerConeGain;
+        pe->mixBusIndex = ei->mixBusIndex;
+        pe->isPositional = ei->isPositional;
+        pe->soundIndex = ei->soundIndex;
+        pe->retriggerMode = ei->retriggerMode;
+        pe->streamAudioDataEntry = -1;
+        if (ei->waveBankIndex >= 0 && ei->waveBankIndex < numWaveBanks &&
+            ei->audioDataIndex >= 0 && 
+            ei->audioDataIndex < bin->waveBanksChunk.waveBanks[ei->waveBankIndex].numAudioDataEntries)
+        {
+            pe->streamAudioDataEntry = kwlGetFirstAudioDataEntryIndex(bin, ei->waveBankIndex) + ei->audioDataIndex;
+        }
+        pe->loopIfStreaming = ei->loopIfStreaming;
+        pe->numReferencedWaveBanks = ei->numReferencedWaveBanks;
+        pe->firstReferencedWaveBankIndex = indexIdx;
+        for (int j = 0; j < ei->numReferencedWaveBanks; j++)
+        {
+            indices[indexIdx++] = ei->waveBankIndices[j];
+        }
+        pe->numAuxSends = ei->numAuxSends;
+        pe->firstAuxSend = auxSendIdx;
+        for (int j = 0; j < ei->numAuxSends; j++)
+        {
+            packedAuxSends[auxSendIdx].returnBusIndex = ei->auxSendBusIndices[j];
+            packedAuxSends[auxSendIdx].level = ei->auxSendLevels[j];
+            auxSendIdx++;
+        }
+    }
+    KWL_ASSERT(indexIdx == numIndices);
+    KWL_ASSERT(auxSendIdx == numAuxSends);
+    
+    if (strings.size > 0)
+    {
+        kwlMemcpy(&image[header.stringsOffset], strings.data, strings.size);
+    }
+    
+    /*the file is little endian. swap everything but the identifier and the strings on big endian hosts.*/
+    if (kwlIsBigEndianHost())
+    {
+        const int wordsStart = sizeof(header.identifier);
+        kwlSwapEndian32((int*)&image[wordsStart], (header.stringsOffset - wordsStart) / 4);
+    }
+    
+    KWL_FREE(mixBusIds);
+    KWL_FREE(mixPresetIds);
+    KWL_FREE(waveBankIds);
+    KWL_FREE(audioDataPaths);
+    KWL_FREE(eventIds);
+    KWL_FREE(strings.data);
+    kwlNodeIndex_free(&strings.offsets);
+    
+    /*write the image in one go*/
+    kwlFileOutputStream fos;
+    int success = kwlFileOutputStream_initWithPath(&fos, path);
+    if (!success)
+    {
+        KWL_FREE(image);
+        return KWL_COULD_NOT_OPEN_FILE_FOR_WRITING;
+    }
+    
+    kwlFileOutputStream_write(&fos, image, header.fileSize);
+    kwlFileOutputStream_close(&fos);
+    KWL_FREE(image);
+    
+    return KWL_SUCCESS;
+}
+
+kwlResultCode kwlEngineDataBinary_writeChunkedToFile(kwlEngineDataBinary* bin,
+                                                     const char* path)
 {
     kwlFileOutputStream fos;
     int success = kwlFileOutputStream_initWithPath(&fos, path);
@@ -1178,7 +1468,7 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
     }
     
     /*write file identifier*/
-    kwlFileOutputStream_write(&fos, bin->fileIdentifier, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH);
+    kwlFileOutputStream_write(&fos, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH);
     
     long chunkStartPositions[5] = {0, 0, 0, 0, 0};
     long chunkEndPositions[5] = {0, 0, 0, 0, 0};
@@ -1223,6 +1513,19 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
                 kwlFileOutputStream_writeInt32BE(&fos, mbi->subBusIndices[j]);
             }
         }
+        
+        /*aux returns and sends go last, so that older engine versions can skip them.*/
+        for (int i = 0; i < mbc->numMixBuses; i++)
+        {
+            kwlMixBusChunk* mbi = &mbc->mixBuses[i];
+            kwlFileOutputStream_writeInt32BE(&fos, mbi->isAuxReturn);
+            kwlFileOutputStream_writeInt32BE(&fos, mbi->numAuxSends);
+            for (int j = 0; j < mbi->numAuxSends; j++)
+            {
+                kwlFileOutputStream_writeInt32BE(&fos, mbi->auxSendBusIndices[j]);
+                kwlFileOutputStream_writeFloat32BE(&fos, mbi->auxSendLevels[j]);
+            }
+        }
         chunkEndPositions[1] = ftell(fos.file);
     }
     
@@ -1250,6 +1553,12 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
                 kwlFileOutputStream_writeFloat32BE(&fos, mpi->pitch[j]);
             }
         }
+        
+        /*fade times go last, so that older engine versions can skip them.*/
+        for (int i = 0; i < mpc->numMixPresets; i++)
+        {
+            kwlFileOutputStream_writeFloat32BE(&fos, mpc->mixPresets[i].fadeTime);
+        }
         chunkEndPositions[2] = ftell(fos.file);
     }
     
@@ -1314,6 +1623,18 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
             }
         }
         
+        /*aux sends go last, so that older engine versions can skip them.*/
+        for (int i = 0; i < edc->numEventDefinitions; i++)
+        {
+            kwlEventChunk* ei = &edc->eventDefinitions[i];
+            kwlFileOutputStream_writeInt32BE(&fos, ei->numAuxSends);
+            for (int j = 0; j < ei->numAuxSends; j++)
+            {
+                kwlFileOutputStream_writeInt32BE(&fos, ei->auxSendBusIndices[j]);
+                kwlFileOutputStream_writeFloat32BE(&fos, ei->auxSendLevels[j]);
+            }
+        }
+        
         chunkEndPositions[4] = ftell(fos.file);
     }
     
@@ -1333,6 +1654,432 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
     return KWL_SUCCESS;
 }
 
+/**
+ * Returns a copy of the string at a given offset in the string blob of a packed engine data image,
+ * or NULL if the offset is out of range.
+ */
+static char* kwlCopyPackedString(const char* image, const kwlPackedEngineDataHeader* header, int offset)
+{
+    if (offset < 0 || offset >= header->stringsSize)
+    {
+        return NULL;
+    }
+    const char* str = &image[header->stringsOffset + offset];
+    const int length = (int)strlen(str) + 1;
+    char* copy = KWL_MALLOC(length, "bin packed string");
+    kwlMemcpy(copy, str, length);
+    return copy;
+}
+
+/**
+ * Copies a range of aux sends of a packed engine data image to chunk representation.
+ * Returns zero if the range or any of the return bus indices is out of bounds.
+ */
+static int kwlCopyPackedAuxSends(const char* image, 
+                                 const kwlPackedEngineDataHeader* header,
+                                 int first,
+                                 int count,
+                                 int* numAuxSends,
+                                 int** busIndices,
+                                 float** levels)
+{
+    *numAuxSends = 0;
+    *busIndices = NULL;
+    *levels = NULL;
+    if (count < 0 || first < 0 || count > header->numAuxSends - first)
+    {
+        return 0;
+    }
+    if (count == 0)
+    {
+        return 1;
+    }
+    
+    const kwlPackedAuxSend* packedAuxSends = (const kwlPackedAuxSend*)&image[header->auxSendsOffset];
+    *numAuxSends = count;
+    *busIndices = KWL_MALLOCANDZERO(count * sizeof(int), "bin aux send buses");
+    *levels = KWL_MALLOCANDZERO(count * sizeof(float), "bin aux send levels");
+    for (int i = 0; i < count; i++)
+    {
+        (*busIndices)[i] = packedAuxSends[first + i].returnBusIndex;
+        (*levels)[i] = packedAuxSends[first + i].level;
+        if ((*busIndices)[i] < 0 || (*busIndices)[i] >= header->numMixBuses)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Reads the packed engine data format from a stream positioned right after the file identifier
+ * and converts it to chunk representation.
+ */
+static kwlResultCode kwlEngineDataBinary_loadFromPackedStream(kwlEngineDataBinary* binaryRep,
+                                                              kwlInputStream* is,
+                                                              const char* binaryPath,
+                                                              kwlLogCallback errorLogCallback)
+{
+    /*read the header and the rest of the file*/
+    kwlPackedEngineDataHeader header;
+    kwlMemset(&header, 0, sizeof(kwlPackedEngineDataHeader));
+    kwlMemcpy(header.identifier, binaryRep->fileIdentifier, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH);
+    const int headerBytesLeft = sizeof(kwlPackedEngineDataHeader) - KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH;
+    if (kwlInputStream_read(is, (signed char*)&header.identifier[KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH], 
+                            headerBytesLeft) != headerBytesLeft)
+    {
+        errorLogCallback("Truncated packed engine data header in %s\n", binaryPath);
+        return KWL_ENGINE_DATA_STRUCTURE_ERROR;
+    }
+    
+    const int numHeaderWords = (sizeof(kwlPackedEngineDataHeader) - sizeof(header.identifier)) / 4;
+    if (kwlIsBigEndianHost())
+    {
+        kwlSwapEndian32(&header.version, numHeaderWords);
+    }
+    
+    if (header.version != KWL_PACKED_ENGINE_DATA_VERSION)
+    {
+        errorLogCallback("Unsupported packed engine data version %d in %s\n", header.version, binaryPath);
+        return KWL_ENGINE_DATA_STRUCTURE_ERROR;
+    }
+    
+    if (header.fileSize < (int)sizeof(kwlPackedEngineDataHeader) ||
+        header.stringsOffset < (int)sizeof(kwlPackedEngineDataHeader) ||
+        header.stringsSize < 0 ||
+        header.stringsOffset > header.fileSize - header.stringsSize)
+    {
+        errorLogCallback("Invalid packed engine data layout in %s\n", binaryPath);
+        return KWL_ENGINE_DATA_STRUCTURE_ERROR;
+    }
+    
+    char* image = KWL_MALLOCANDZERO(header.fileSize, "bin packed engine data image");
+    kwlMemcpy(image, &header, sizeof(kwlPackedEngineDataHeader));
+    const int bodySize = header.fileSize - sizeof(kwlPackedEngineDataHeader);
+    if (kwlInputStream_read(is, (signed char*)&image[sizeof(kwlPackedEngineDataHeader)], bodySize) != bodySize)
+    {
+        KWL_FREE(image);
+        errorLogCallback("Truncated packed engine data in %s\n", binaryPath);
+        return KWL_ENGINE_DATA_STRUCTURE_ERROR;
+    }
+    
+    if (kwlIsBigEndianHost())
+    {
+        const int wordsStart = sizeof(kwlPackedEngineDataHeader);
+        kwlSwapEndian32((int*)&image[wordsStart], (header.stringsOffset - wordsStart) / 4);
+    }
+    
+    /*make sure all sections are in range*/
+    const int sectionCounts[] = {header.numMixBuses, header.numMixPresets, header.numWaveBanks,
+                                 header.numAudioDataEntries, header.numSoundDefinitions,
+                                 header.numEventDefinitions, header.numAuxSends, 
+                                 header.numIndices, header.numMixPresetParameters};
+    const int sectionOffsets[] = {header.mixBusesOffset, header.mixPresetsOffset, header.waveBanksOffset,
+                                  header.audioDataEntriesOffset, header.soundDefinitionsOffset,
+                                  header.eventDefinitionsOffset, header.auxSendsOffset,
+                                  header.indicesOffset, header.mixPresetParametersOffset};
+    const int sectionItemSizes[] = {sizeof(kwlPackedMixBus), sizeof(kwlPackedMixPreset), sizeof(kwlPackedWaveBank),
+                                    sizeof(kwlPackedAudioData), sizeof(kwlPackedSoundDefinition),
+                                    sizeof(kwlPackedEventDefinition), sizeof(kwlPackedAuxSend), 
+                                    sizeof(int), sizeof(float)};
+    for (int i = 0; i < 9; i++)
+    {
+        if (sectionCounts[i] < 0 ||
+            sectionOffsets[i] < (int)sizeof(kwlPackedEngineDataHeader) ||
+            sectionOffsets[i] > header.stringsOffset ||
+            sectionCounts[i] > (header.stringsOffset - sectionOffsets[i]) / sectionItemSizes[i])
+        {
+            KWL_FREE(image);
+            errorLogCallback("Invalid packed engine data section %d in %s\n", i, binaryPath);
+            return KWL_ENGINE_DATA_STRUCTURE_ERROR;
+        }
+    }
+    
+    if (header.stringsSize == 0 || image[header.stringsOffset + header.stringsSize - 1] != '\0' ||
+        header.numMixPresetParameters != 3 * header.numMixBuses * header.numMixPresets)
+    {
+        KWL_FREE(image);
+        errorLogCallback("Invalid packed engine data contents in %s\n", binaryPath);
+        return KWL_ENGINE_DATA_STRUCTURE_ERROR;
+    }
+    
+    const kwlPackedMixBus* packedMixBuses = (const kwlPackedMixBus*)&image[header.mixBusesOffset];
+    const kwlPackedMixPreset* packedMixPresets = (const kwlPackedMixPreset*)&image[header.mixPresetsOffset];
+    const kwlPackedWaveBank* packedWaveBanks = (const kwlPackedWaveBank*)&image[header.waveBanksOffset];
+    const kwlPackedAudioData* packedAudioData = (const kwlPackedAudioData*)&image[header.audioDataEntriesOffset];
+    const kwlPackedSoundDefinition* packedSounds = (const kwlPackedSoundDefinition*)&image[header.soundDefinitionsOffset];
+    const kwlPackedEventDefinition* packedEvents = (const kwlPackedEventDefinition*)&image[header.eventDefinitionsOffset];
+    const int* indices = (const int*)&image[header.indicesOffset];
+    const float* mixPresetParameters = (const float*)&image[header.mixPresetParametersOffset];
+    
+    /*maps global audio data indices to wave bank indices*/
+    int* audioDataWaveBanks = KWL_MALLOCANDZERO((header.numAudioDataEntries + 1) * sizeof(int), "bin packed audio data banks");
+    for (int i = 0; i < header.numAudioDataEntries; i++)
+    {
+        audioDataWaveBanks[i] = -1;
+    }
+    
+    //mix buses
+    binaryRep->mixBusesChunk.chunkId = KWL_MIX_BUSES_CHUNK_ID;
+    binaryRep->mixBusesChunk.numMixBuses = header.numMixBuses;
+    binaryRep->mixBusesChunk.mixBuses = KWL_MALLOCANDZERO(header.numMixBuses * sizeof(kwlMixBusChunk), "bin mix buses");
+    for (int i = 0; i < header.numMixBuses; i++)
+    {
+        const kwlPackedMixBus* pmb = &packedMixBuses[i];
+        kwlMixBusChunk* mi = &binaryRep->mixBusesChunk.mixBuses[i];
+        mi->id = kwlCopyPackedString(image, &header, pmb->idOffset);
+        if (mi->id == NULL ||
+            pmb->numSubBuses < 0 || pmb->firstSubBusIndex < 0 ||
+            pmb->numSubBuses > header.numIndices - pmb->firstSubBusIndex)
+        {
+            errorLogCallback("Invalid packed mix bus %d in %s\n", i, binaryPath);
+            goto onDataError;
+        }
+        mi->numSubBuses = pmb->numSubBuses;
+        if (mi->numSubBuses > 0)
+        {
+            mi->subBusIndices = KWL_MALLOCANDZERO(mi->numSubBuses * sizeof(int), "bin sub bus list");
+            for (int j = 0; j < mi->numSubBuses; j++)
+            {
+                mi->subBusIndices[j] = indices[pmb->firstSubBusIndex + j];
+                if (mi->subBusIndices[j] < 0 || mi->subBusIndices[j] >= header.numMixBuses)
+                {
+                    errorLogCallback("Mix bus %s sub bus index at %d is %d. Expected value in [0, %d]\n",
+                                     mi->id, j, mi->subBusIndices[j], header.numMixBuses - 1);
+                    goto onDataError;
+                }
+            }
+        }
+        mi->isAuxReturn = pmb->isAuxReturn;
+        if (!kwlCopyPackedAuxSends(image, &header, pmb->firstAuxSend, pmb->numAuxSends,
+                                   &mi->numAuxSends, &mi->auxSendBusIndices, &mi->auxSendLevels))
+        {
+            errorLogCallback("Invalid aux sends of packed mix bus %s in %s\n", mi->id, binaryPath);
+            goto onDataError;
+        }
+    }
+    
+    //mix presets
+    binaryRep->mixPresetsChunk.chunkId = KWL_MIX_PRESETS_CHUNK_ID;
+    binaryRep->mixPresetsChunk.numMixPresets = header.numMixPresets;
+    binaryRep->mixPresetsChunk.mixPresets = KWL_MALLOCANDZERO(header.numMixPresets * sizeof(kwlMixPresetChunk), "bin mix presets");
+    for (int i = 0; i < header.numMixPresets; i++)
+    {
+        const kwlPackedMixPreset* pmp = &packedMixPresets[i];
+        kwlMixPresetChunk* mpi = &binaryRep->mixPresetsChunk.mixPresets[i];
+        mpi->id = kwlCopyPackedString(image, &header, pmp->idOffset);
+        if (mpi->id == NULL || pmp->fadeTime < 0.0f || 
+            pmp->firstParameterIndex < 0 ||
+            pmp->firstParameterIndex > header.numMixPresetParameters - 3 * header.numMixBuses)
+        {
+            errorLogCallback("Invalid packed mix preset %d in %s\n", i, binaryPath);
+            goto onDataError;
+        }
+        mpi->isDefault = pmp->isDefault;
+        mpi->fadeTime = pmp->fadeTime;
+        
+        const int numMixBuses = header.numMixBuses;
+        const float* gainLeft = &mixPresetParameters[pmp->firstParameterIndex];
+        mpi->mixBusIndices = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), "bin mix preset bus indices");
+        mpi->gainLeft = KWL_MALLOCANDZERO(numMixBuses * sizeof(float), "bin mix preset gain left");
+        mpi->gainRight = KWL_MALLOCANDZERO(numMixBuses * sizeof(float), "bin mix preset gain right");
+        mpi->pitch = KWL_MALLOCANDZERO(numMixBuses * sizeof(float), "bin mix preset pitch");
+        for (int j = 0; j < numMixBuses; j++)
+        {
+            mpi->mixBusIndices[j] = j;
+            mpi->gainLeft[j] = gainLeft[j];
+            mpi->gainRight[j] = gainLeft[numMixBuses + j];
+            mpi->pitch[j] = gainLeft[2 * numMixBuses + j];
+        }
+    }
+    
+    //wave banks
+    binaryRep->waveBanksChunk.chunkId = KWL_WAVE_BANKS_CHUNK_ID;
+    binaryRep->waveBanksChunk.numAudioDataItemsTotal = header.numAudioDataEntries;
+    binaryRep->waveBanksChunk.numWaveBanks = header.numWaveBanks;
+    binaryRep->waveBanksChunk.waveBanks = KWL_MALLOCANDZERO(header.numWaveBanks * sizeof(kwlWaveBankChunk), "bin wave banks");
+    for (int i = 0; i < header.numWaveBanks; i++)
+    {
+        const kwlPackedWaveBank* pwb = &packedWaveBanks[i];
+        kwlWaveBankChunk* wbi = &binaryRep->waveBanksChunk.waveBanks[i];
+        wbi->id = kwlCopyPackedString(image, &header, pwb->idOffset);
+        if (wbi->id == NULL ||
+            pwb->numAudioDataEntries < 0 || pwb->firstAudioDataEntry < 0 ||
+            pwb->numAudioDataEntries > header.numAudioDataEntries - pwb->firstAudioDataEntry)
+        {
+            errorLogCallback("Invalid packed wave bank %d in %s\n", i, binaryPath);
+            goto onDataError;
+        }
+        wbi->numAudioDataEntries = pwb->numAudioDataEntries;
+        wbi->audioDataEntries = KWL_MALLOCANDZERO(wbi->numAudioDataEntries * sizeof(char*), "bin wave bank entries");
+        for (int j = 0; j < wbi->numAudioDataEntries; j++)
+        {
+            const int audioDataIndex = pwb->firstAudioDataEntry + j;
+            wbi->audioDataEntries[j] = kwlCopyPackedString(image, &header, packedAudioData[audioDataIndex].filePathOffset);
+            audioDataWaveBanks[audioDataIndex] = i;
+            if (wbi->audioDataEntries[j] == NULL)
+            {
+                errorLogCallback("Invalid audio data path in packed wave bank %s in %s\n", wbi->id, binaryPath);
+                goto onDataError;
+            }
+        }
+    }
+    
+    //sounds
+    binaryRep->soundsChunk.chunkId = KWL_SOUNDS_CHUNK_ID;
+    binaryRep->soundsChunk.numSoundDefinitions = header.numSoundDefinitions;
+    binaryRep->soundsChunk.soundDefinitions = KWL_MALLOCANDZERO(header.numSoundDefinitions * sizeof(kwlSoundChunk), "bin sounds");
+    for (int i = 0; i < header.numSoundDefinitions; i++)
+    {
+        const kwlPackedSoundDefinition* ps = &packedSounds[i];
+        kwlSoundChunk* si = &binaryRep->soundsChunk.soundDefinitions[i];
+        if (ps->numAudioDataEntries < 0 || ps->firstAudioDataEntryIndex < 0 ||
+            ps->numAudioDataEntries > header.numIndices - ps->firstAudioDataEntryIndex)
+        {
+            errorLogCallback("Invalid packed sound definition %d in %s\n", i, binaryPath);
+            goto onDataError;
+        }
+        si->playbackCount = ps->playbackCount;
+        si->deferStop = ps->deferStop;
+        si->gain = ps->gain;
+        si->gainVariation = ps->gainVariation;
+        si->pitch = ps->pitch;
+        si->pitchVariation = ps->pitchVariation;
+        si->playbackMode = ps->playbackMode;
+        si->numWaveReferences = ps->numAudioDataEntries;
+        if (si->numWaveReferences > 0)
+        {
+            si->waveBankIndices = KWL_MALLOCANDZERO(si->numWaveReferences * sizeof(int), "bin sound wave bank indices");
+            si->audioDataIndices = KWL_MALLOCANDZERO(si->numWaveReferences * sizeof(int), "bin sound audio data indices");
+        }
+        for (int j = 0; j < si->numWaveReferences; j++)
+        {
+            const int audioDataIndex = indices[ps->firstAudioDataEntryIndex + j];
+            if (audioDataIndex < 0 || audioDataIndex >= header.numAudioDataEntries ||
+                audioDataWaveBanks[audioDataIndex] < 0)
+            {
+                errorLogCallback("Invalid audio data index %d in packed sound definition %d in %s\n",
+                                 audioDataIndex, i, binaryPath);
+                goto onDataError;
+            }
+            si->waveBankIndices[j] = audioDataWaveBanks[audioDataIndex];
+            si->audioDataIndices[j] = audioDataIndex - packedWaveBanks[si->waveBankIndices[j]].firstAudioDataEntry;
+        }
+    }
+    
+    //events
+    binaryRep->eventsChunk.chunkId = KWL_EVENTS_CHUNK_ID;
+    binaryRep->eventsChunk.numEventDefinitions = header.numEventDefinitions;
+    binaryRep->eventsChunk.eventDefinitions = KWL_MALLOCANDZERO(header.numEventDefinitions * sizeof(kwlEventChunk), "bin events");
+    for (int i = 0; i < header.numEventDefinitions; i++)
+    {
+        const kwlPackedEventDefinition* pe = &packedEvents[i];
+        kwlEventChunk* ei = &binaryRep->eventsChunk.eventDefinitions[i];
+        ei->id = kwlCopyPackedString(image, &header, pe->idOffset);
+        if (ei->id == NULL ||
+            pe->mixBusIndex < 0 || pe->mixBusIndex >= header.numMixBuses ||
+            pe->soundIndex < -1 || pe->soundIndex >= header.numSoundDefinitions ||
+            pe->streamAudioDataEntry < -1 || pe->streamAudioDataEntry >= header.numAudioDataEntries ||
+            pe->numReferencedWaveBanks < 0 || pe->firstReferencedWaveBankIndex < 0 ||
+            pe->numReferencedWaveBanks > header.numIndices - pe->firstReferencedWaveBankIndex)
+        {
+            errorLogCallback("Invalid packed event definition %d in %s\n", i, binaryPath);
+            goto onDataError;
+        }
+        ei->instanceCount = pe->instanceCount;
+        ei->gain = pe->gain;
+        ei->pitch = pe->pitch;
+        ei->innerConeAngleDeg = pe->innerConeAngleDeg;
+        ei->outerConeAngleDeg = pe->outerConeAngleDeg;
+        ei->outerConeGain = pe->outerConeGain;
+        ei->mixBusIndex = pe->mixBusIndex;
+        ei->isPositional = pe->isPositional;
+        ei->soundIndex = pe->soundIndex;
+        ei->retriggerMode = pe->retriggerMode;
+        ei->waveBankIndex = -1;
+        ei->audioDataIndex = -1;
+        if (pe->streamAudioDataEntry >= 0)
+        {
+            ei->waveBankIndex = audioDataWaveBanks[pe->streamAudioDataEntry];
+            if (ei->waveBankIndex < 0)
+            {
+                errorLogCallback("Invalid streaming audio data in packed event definition %s in %s\n", ei->id, binaryPath);
+                goto onDataError;
+            }
+            ei->audioDataIndex = pe->streamAudioDataEntry - packedWaveBanks[ei->waveBankIndex].firstAudioDataEntry;
+        }
+        ei->loopIfStreaming = pe->loopIfStreaming;
+        ei->numReferencedWaveBanks = pe->numReferencedWaveBanks;
+        if (ei->numReferencedWaveBanks > 0)
+        {
+            ei->waveBankIndices = KWL_MALLOCANDZERO(ei->numReferencedWaveBanks * sizeof(int), "bin event wave bank indices");
+        }
+        for (int j = 0; j < ei->numReferencedWaveBanks; j++)
+        {
+            ei->waveBankIndices[j] = indices[pe->firstReferencedWaveBankIndex + j];
+            if (ei->waveBankIndices[j] < 0 || ei->waveBankIndices[j] >= header.numWaveBanks)
+            {
+                errorLogCallback("Invalid wave bank index %d in packed event definition %s in %s\n",
+                                 ei->waveBankIndices[j], ei->id, binaryPath);
+                goto onDataError;
+            }
+        }
+        if (!kwlCopyPackedAuxSends(image, &header, pe->firstAuxSend, pe->numAuxSends,
+                                   &ei->numAuxSends, &ei->auxSendBusIndices, &ei->auxSendLevels))
+        {
+            errorLogCallback("Invalid aux sends of packed event definition %s in %s\n", ei->id, binaryPath);
+            goto onDataError;
+        }
+    }
+    
+    KWL_FREE(audioDataWaveBanks);
+    KWL_FREE(image);
+    return KWL_SUCCESS;
+    
+onDataError:
+    KWL_FREE(audioDataWaveBanks);
+    KWL_FREE(image);
+    kwlEngineDataBinary_free(binaryRep);
+    return KWL_ENGINE_DATA_STRUCTURE_ERROR;
+}
+
+/**
+ * Reads the aux sends of a mix bus or event definition from a chunked engine data stream.
+ * Returns zero if any of the return bus indices is out of bounds.
+ */
+static int kwlReadAuxSends(kwlInputStream* is,
+                           int numMixBuses,
+                           int* numAuxSends,
+                           int** busIndices,
+                           float** levels)
+{
+    *numAuxSends = kwlInputStream_readIntBE(is);
+    *busIndices = NULL;
+    *levels = NULL;
+    if (*numAuxSends < 0 || *numAuxSends > numMixBuses)
+    {
+        *numAuxSends = 0;
+        return 0;
+    }
+    if (*numAuxSends == 0)
+    {
+        return 1;
+    }
+    
+    *busIndices = KWL_MALLOCANDZERO(*numAuxSends * sizeof(int), "bin aux send buses");
+    *levels = KWL_MALLOCANDZERO(*numAuxSends * sizeof(float), "bin aux send levels");
+    for (int i = 0; i < *numAuxSends; i++)
+    {
+        (*busIndices)[i] = kwlInputStream_readIntBE(is);
+        (*levels)[i] = kwlInputStream_readFloatBE(is);
+        if ((*busIndices)[i] < 0 || (*busIndices)[i] >= numMixBuses)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
 kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binaryRep,
                                                      const char* binaryPath,
                                                      kwlLogCallback errorLogCallbackIn)
@@ -1352,17 +2099,34 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
     }
     
     /*check file identifier*/
+    int isChunked = 1;
+    int isPacked = 1;
     for (int i = 0; i < KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH; i++)
     {
         const char identifierChari = kwlInputStream_readChar(&is);
         binaryRep->fileIdentifier[i] = identifierChari;
         if (identifierChari != KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER[i])
         {
-            //invalid file format
-            kwlInputStream_close(&is);
-            errorLogCallback("Invalid engine data binary file header in %s\n", binaryPath);
-            return KWL_INVALID_FILE_IDENTIFIER;
+            isChunked = 0;
         }
+        if (identifierChari != KWL_PACKED_ENGINE_DATA_BINARY_FILE_IDENTIFIER[i])
+        {
+            isPacked = 0;
+        }
+    }
+    
+    if (isPacked)
+    {
+        kwlResultCode packedResult = kwlEngineDataBinary_loadFromPackedStream(binaryRep, &is, binaryPath, errorLogCallback);
+        kwlInputStream_close(&is);
+        return packedResult;
+    }
+    else if (!isChunked)
+    {
+        //invalid file format
+        kwlInputStream_close(&is);
+        errorLogCallback("Invalid engine data binary file header in %s\n", binaryPath);
+        return KWL_INVALID_FILE_IDENTIFIER;
     }
     
     kwlResultCode result = KWL_SUCCESS;
@@ -1371,6 +2135,7 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
     {
         binaryRep->mixBusesChunk.chunkId = KWL_MIX_BUSES_CHUNK_ID;
         binaryRep->mixBusesChunk.chunkSize = kwlInputStream_seekToEngineDataChunk(&is, KWL_MIX_BUSES_CHUNK_ID);
+        const int mixBusesChunkStart = kwlInputStream_tell(&is);
         
         //allocate memory for the mix bus data
         binaryRep->mixBusesChunk.numMixBuses = kwlInputStream_readIntBE(&is);
@@ -1402,6 +2167,23 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
                 }
             }
         }
+        
+        //optional trailing aux returns and sends
+        if (kwlInputStream_tell(&is) - mixBusesChunkStart < binaryRep->mixBusesChunk.chunkSize)
+        {
+            for (int i = 0; i < binaryRep->mixBusesChunk.numMixBuses; i++)
+            {
+                kwlMixBusChunk* mi = &binaryRep->mixBusesChunk.mixBuses[i];
+                mi->isAuxReturn = kwlInputStream_readIntBE(&is);
+                if (!kwlReadAuxSends(&is, binaryRep->mixBusesChunk.numMixBuses,
+                                     &mi->numAuxSends, &mi->auxSendBusIndices, &mi->auxSendLevels))
+                {
+                    errorLogCallback("Invalid aux sends of mix bus %s\n", mi->id);
+                    result = KWL_ENGINE_DATA_STRUCTURE_ERROR;
+                    goto onDataError;
+                }
+            }
+        }
     }
     
     
@@ -1409,6 +2191,7 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
     {
         binaryRep->mixPresetsChunk.chunkId = KWL_MIX_PRESETS_CHUNK_ID;
         binaryRep->mixPresetsChunk.chunkSize = kwlInputStream_seekToEngineDataChunk(&is, KWL_MIX_PRESETS_CHUNK_ID);
+        const int mixPresetsChunkStart = kwlInputStream_tell(&is);
         
         //allocate memory for the mix preset data
         binaryRep->mixPresetsChunk.numMixPresets = kwlInputStream_readIntBE(&is);
@@ -1458,6 +2241,27 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
             }
         }
         
+        //optional trailing fade times
+        for (int i = 0; i < binaryRep->mixPresetsChunk.numMixPresets; i++)
+        {
+            binaryRep->mixPresetsChunk.mixPresets[i].fadeTime = KWL_DEFAULT_MIX_PRESET_FADE_TIME;
+        }
+        
+        if (kwlInputStream_tell(&is) - mixPresetsChunkStart < binaryRep->mixPresetsChunk.chunkSize)
+        {
+            for (int i = 0; i < binaryRep->mixPresetsChunk.numMixPresets; i++)
+            {
+                kwlMixPresetChunk* mpi = &binaryRep->mixPresetsChunk.mixPresets[i];
+                mpi->fadeTime = kwlInputStream_readFloatBE(&is);
+                if (mpi->fadeTime < 0.0f)
+                {
+                    errorLogCallback("Mix preset %s has negative fade time %f\n", mpi->id, mpi->fadeTime);
+                    result = KWL_ENGINE_DATA_STRUCTURE_ERROR;
+                    goto onDataError;
+                }
+            }
+        }
+        
         if (defaultPresetIndex < 0)
         {
             errorLogCallback("No default mix preset found\n");
@@ -1564,6 +2368,7 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
     {
         binaryRep->eventsChunk.chunkId = KWL_EVENTS_CHUNK_ID;
         binaryRep->eventsChunk.chunkSize = kwlInputStream_seekToEngineDataChunk(&is, KWL_EVENTS_CHUNK_ID);
+        const int eventsChunkStart = kwlInputStream_tell(&is);
         
         /*read the total number of event definitions*/
         binaryRep->eventsChunk.numEventDefinitions = kwlInputStream_readIntBE(&is);
@@ -1647,6 +2452,22 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
                 }
             }
         }
+        
+        /*optional trailing aux sends*/
+        if (kwlInputStream_tell(&is) - eventsChunkStart < binaryRep->eventsChunk.chunkSize)
+        {
+            for (int i = 0; i < binaryRep->eventsChunk.numEventDefinitions; i++)
+            {
+                kwlEventChunk* ei = &binaryRep->eventsChunk.eventDefinitions[i];
+                if (!kwlReadAuxSends(&is, binaryRep->mixBusesChunk.numMixBuses,
+                                     &ei->numAuxSends, &ei->auxSendBusIndices, &ei->auxSendLevels))
+                {
+                    errorLogCallback("Invalid aux sends of event definition %s\n", ei->id);
+                    result = KWL_ENGINE_DATA_STRUCTURE_ERROR;
+                    goto onDataError;
+                }
+            }
+        }
     }
     
     kwlInputStream_close(&is);
@@ -1668,6 +2489,11 @@ void kwlEngineDataBinary_free(kwlEngineDataBinary* bin)
         {
             KWL_FREE(mbi->subBusIndices);
         }
+        if (mbi->numAuxSends > 0)
+        {
+            KWL_FREE(mbi->auxSendBusIndices);
+            KWL_FREE(mbi->auxSendLevels);
+        }
     }
     
     KWL_FREE(bin->mixBusesChunk.mixBuses);
@@ -1717,6 +2543,11 @@ void kwlEngineDataBinary_free(kwlEngineDataBinary* bin)
         {
             KWL_FREE(ei->waveBankIndices);
         }
+        if (ei->numAuxSends > 0)
+        {
+            KWL_FREE(ei->auxSendBusIndices);
+            KWL_FREE(ei->auxSendLevels);
+        }
     }
     
     KWL_FREE(bin->eventsChunk.eventDefinitions);
@@ -1746,6 +2577,11 @@ void kwlEngineDataBinary_dump(kwlEngineDataBinary* bin, kwlLogCallback logCallba
         {
             logCallback("%s%d%s", j == 0 ? ": " : "", mbi->subBusIndices[j], j < mbi->numSubBuses - 1 ? ", " : "");
         }
+        logCallback(", aux return %d, %d aux sends", mbi->isAuxReturn, mbi->numAuxSends);
+        for (int j = 0; j < mbi->numAuxSends; j++)
+        {
+            logCallback("%s%d (%f)", j == 0 ? ": " : ", ", mbi->auxSendBusIndices[j], mbi->auxSendLevels[j]);
+        }
         logCallback(")\n");
     }
     
@@ -1757,7 +2593,7 @@ void kwlEngineDataBinary_dump(kwlEngineDataBinary* bin, kwlLogCallback logCallba
     for (int i = 0; i < bin->mixPresetsChunk.numMixPresets; i++)
     {
         kwlMixPresetChunk* mpi = &bin->mixPresetsChunk.mixPresets[i];
-        logCallback("        '%s' (default %d)\n", mpi->id, mpi->isDefault);
+        logCallback("        '%s' (default %d, fade time %f)\n", mpi->id, mpi->isDefault, mpi->fadeTime);
         for (int j = 0; j < bin->mixBusesChunk.numMixBuses; j++)
         {
             logCallback("            bus idx %d: gain left %f, gain right %f, pitch %f\n",
@@ -1825,5 +2661,10 @@ void kwlEngineDataBinary_dump(kwlEngineDataBinary* bin, kwlLogCallback logCallba
         {
             logCallback("                    idx %d\n", ei->waveBankIndices[j]);
         }
+        logCallback("                %d aux send(s):\n", ei->numAuxSends);
+        for (int j = 0; j < ei->numAuxSends; j++)
+        {
+            logCallback("                    bus idx %d, level %f\n", ei->auxSendBusIndices[j], ei->auxSendLevels[j]);
+        }
     }
 }
@@ -43,6 +43,10 @@ extern "C"
         char* id;
         int numSubBuses;
         int* subBusIndices;
+        int isAuxReturn;
+        int numAuxSends;
+        int* auxSendBusIndices;
+        float* auxSendLevels;
     } kwlMixBusChunk;
     
     /**
@@ -63,6 +67,7 @@ extern "C"
     {
         char* id;
         int isDefault;
+        float fadeTime;
         float* gainLeft;
         float* gainRight;
         float* pitch;
@@ -152,6 +157,9 @@ extern "C"
         int loopIfStreaming;
         int numReferencedWaveBanks;
         int* waveBankIndices;
+        int numAuxSends;
+        int* auxSendBusIndices;
+        float* auxSendLevels;
     } kwlEventChunk;
     
     /**
@@ -211,7 +219,7 @@ extern "C"
                                                              kwlLogCallback errorLogCallback);
     
     /**
-     * Writes a given engine data binary to a file.
+     * Writes a given engine data binary to a file using the packed, load-in-place format.
      * @param bin The binary to write.
      * @param binPath The path to write the file to.
      * @return A result code.
@@ -219,6 +227,16 @@ extern "C"
     kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
                                                   const char* binPath);
     
+    /**
+     * Writes a given engine data binary to a file using the legacy chunked format,
+     * for engines that predate the packed format.
+     * @param bin The binary to write.
+     * @param binPath The path to write the file to.
+     * @return A result code.
+     */
+    kwlResultCode kwlEngineDataBinary_writeChunkedToFile(kwlEngineDataBinary* bin,
+                                                         const char* binPath);
+    
     /**
      * Loads an engine data binary from a given project data XML file.
      * @param bin The binary to load data into.
@@ -31,6 +31,11 @@ void kwlFileOutputStream_close(kwlFileOutputStream* stream)
     }
 }
 
+long kwlFileOutputStream_tell(kwlFileOutputStream* stream)
+{
+    return ftell(stream->file);
+}
+
 void kwlFileOutputStream_writeASCIIString(kwlFileOutputStream* stream, const char* str)
 {
     int l = 0;
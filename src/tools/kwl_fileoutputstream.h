@@ -33,6 +33,13 @@ extern "C"
      */
     void kwlFileOutputStream_close(kwlFileOutputStream* stream);
     
+    /**
+     * Returns the number of bytes written to a given output stream so far.
+     * @param stream The output stream.
+     * @return The current write position.
+     */
+    long kwlFileOutputStream_tell(kwlFileOutputStream* stream);
+    
     /**
      * Writes an ASCII string (an int32 length + that many chars) to a given output stream.
      * @param stream The output stream to write to.
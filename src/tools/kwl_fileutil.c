@@ -71,6 +71,18 @@ long kwlGetFileTimeStamp(const char* path)
     return st.st_mtimespec.tv_sec;
 }
 
+long kwlGetFileSize(const char* path)
+{
+    struct stat st;
+    
+    if (stat(path, &st) < 0)
+    {
+        return -1;
+    }
+    
+    return (long)st.st_size;
+}
+
 char* kwlAppendPathElement(const char* path, const char* toAppend)
 {
     size_t plen = strlen(path);
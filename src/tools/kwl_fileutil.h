@@ -51,6 +51,13 @@ extern "C"
      */
     long kwlGetFileTimeStamp(const char* path);
     
+    /**
+     * Gets the size of a file.
+     * @param path The file.
+     * @return The size in bytes, or -1 if the file does not exist.
+     */
+    long kwlGetFileSize(const char* path);
+    
     /**
      * Appends a path element to a base path.
      * The returned string must be freed by the caller.
@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "kwl_audiofileutil.h"
+#include "kwl_decoder_imaadpcm.h"
 #include "kwl_fileoutputstream.h"
 #include "kwl_fileutil.h"
 #include "kwl_enginedatabinary.h"
@@ -67,29 +68,41 @@ void kwlWaveBankBinary_writeToFile(kwlWaveBankBinary* bin,
         return;
     }
     
-    /*write file identifier*/
-    kwlFileOutputStream_write(&fos, bin->fileIdentifier, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH);
-    
-    /*write id and entry count*/
-    kwlFileOutputStream_writeASCIIString(&fos, bin->id);
-    kwlFileOutputStream_writeInt32BE(&fos, bin->numEntries);
+    kwlWaveBankBinary_writeHeader(&fos, bin->id, bin->numEntries);
     
     /*write entries*/
     for (int i = 0; i < bin->numEntries; i++)
     {
-        kwlWaveBankEntryChunk* ei = &bin->entries[i];
-        kwlFileOutputStream_writeASCIIString(&fos, ei->fileName);
-        kwlFileOutputStream_writeInt32BE(&fos, ei->encoding);
-        kwlFileOutputStream_writeInt32BE(&fos, ei->isStreaming);
-        kwlFileOutputStream_writeInt32BE(&fos, ei->numChannels);
-        kwlFileOutputStream_writeInt32BE(&fos, ei->numBytes);
-        kwlFileOutputStream_write(&fos, ei->data, ei->numBytes);
+        kwlWaveBankBinary_writeEntry(&fos, &bin->entries[i]);
     }
     
     /*done*/
     kwlFileOutputStream_close(&fos);
 }
 
+void kwlWaveBankBinary_writeHeader(kwlFileOutputStream* fos,
+                                   const char* id,
+                                   int numEntries)
+{
+    /*write file identifier*/
+    kwlFileOutputStream_write(fos, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH);
+    
+    /*write id and entry count*/
+    kwlFileOutputStream_writeASCIIString(fos, id);
+    kwlFileOutputStream_writeInt32BE(fos, numEntries);
+}
+
+void kwlWaveBankBinary_writeEntry(kwlFileOutputStream* fos,
+                                  const kwlWaveBankEntryChunk* entry)
+{
+    kwlFileOutputStream_writeASCIIString(fos, entry->fileName);
+    kwlFileOutputStream_writeInt32BE(fos, entry->encoding);
+    kwlFileOutputStream_writeInt32BE(fos, entry->isStreaming);
+    kwlFileOutputStream_writeInt32BE(fos, entry->numChannels);
+    kwlFileOutputStream_writeInt32BE(fos, entry->numBytes);
+    kwlFileOutputStream_write(fos, entry->data, entry->numBytes);
+}
+
 kwlResultCode kwlWaveBankBinary_loadFromBinaryFile(kwlWaveBankBinary* binaryRep,
                                                    const char* path,
                                                    kwlLogCallback errorLogCallback)
@@ -160,6 +173,313 @@ static char* kwlDuplicateString(const char* str)
     return copy;
 }
 
+/**
+ * Writes a 32 bit little endian integer to a buffer.
+ */
+static void kwlWriteIntLE(unsigned char* buffer, int value)
+{
+    buffer[0] = value & 0xff;
+    buffer[1] = (value >> 8) & 0xff;
+    buffer[2] = (value >> 16) & 0xff;
+    buffer[3] = (value >> 24) & 0xff;
+}
+
+/**
+ * Writes a 16 bit little endian integer to a buffer.
+ */
+static void kwlWriteShortLE(unsigned char* buffer, int value)
+{
+    buffer[0] = value & 0xff;
+    buffer[1] = (value >> 8) & 0xff;
+}
+
+/**
+ * Encodes a 16 bit sample to an IMA ADPCM nibble, updating the predictor and step index
+ * exactly the way the decoder will.
+ */
+static int kwlEncodeIMAADPCMNibble(int sample, int* predictor, int* stepIndex)
+{
+    int step = KWL_IMA_ADPCM_STEP_TABLE[*stepIndex];
+    int diff = sample - *predictor;
+    int nibble = 0;
+    if (diff < 0)
+    {
+        nibble = 8;
+        diff = -diff;
+    }
+    
+    if (diff >= step)
+    {
+        nibble |= 4;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        nibble |= 2;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        nibble |= 1;
+    }
+    
+    decodeNibble(nibble, predictor, stepIndex);
+    return nibble;
+}
+
+/**
+ * Encodes interleaved 16 bit samples to an in-memory IMA ADPCM WAV file, in the
+ * block layout expected by the IMA ADPCM decoder. This layout is kowalski specific:
+ * the header word of a block holds the running predictor and is not an output sample,
+ * so a block decodes to \c wSamplesPerBlock frames instead of the standard 
+ * \c wSamplesPerBlock + 1. The last block is padded and the \c fact chunk holds the
+ * number of frames to decode.
+ * @param samples The samples to encode.
+ * @param numFrames The number of frames in \c samples.
+ * @param numChannels The number of channels.
+ * @param sampleRate The sample rate of the source in Hz.
+ * @param blockSize The number of bytes per channel per block. Rounded down to a multiple of 4.
+ * @param numBytesOut The size of the returned WAV file.
+ * @return The WAV file data. Must be freed by the caller.
+ */
+static unsigned char* kwlEncodeIMAADPCMWAV(const short* samples,
+                                           int numFrames,
+                                           int numChannels,
+                                           int sampleRate,
+                                           int blockSize,
+                                           int* numBytesOut)
+{
+    KWL_ASSERT(numChannels > 0);
+    
+    const int nWordsPerChannel = (blockSize & ~3) / 4 - 1;
+    KWL_ASSERT(nWordsPerChannel > 0);
+    const int nBlockAlign = 4 * (nWordsPerChannel + 1) * numChannels;
+    const int framesPerBlock = 8 * nWordsPerChannel;
+    int numBlocks = (numFrames + framesPerBlock - 1) / framesPerBlock;
+    if (numBlocks == 0)
+    {
+        numBlocks = 1;
+    }
+    
+    const int fmtChunkSize = 20;
+    const int dataChunkSize = numBlocks * nBlockAlign;
+    const int headerSize = 12 + (8 + fmtChunkSize) + (8 + 4) + 8;
+    const int fileSize = headerSize + dataChunkSize;
+    unsigned char* wav = KWL_MALLOCANDZERO(fileSize, "ima adpcm wav");
+    
+    /*RIFF header*/
+    unsigned char* p = wav;
+    kwlMemcpy(p, "RIFF", 4);
+    kwlWriteIntLE(p + 4, fileSize - 8);
+    kwlMemcpy(p + 8, "WAVE", 4);
+    p += 12;
+    
+    /*fmt chunk*/
+    kwlMemcpy(p, "fmt ", 4);
+    kwlWriteIntLE(p + 4, fmtChunkSize);
+    kwlWriteShortLE(p + 8, 0x11);
+    kwlWriteShortLE(p + 10, numChannels);
+    kwlWriteIntLE(p + 12, sampleRate);
+    kwlWriteIntLE(p + 16, (int)((long long)sampleRate * nBlockAlign / framesPerBlock));
+    kwlWriteShortLE(p + 20, nBlockAlign);
+    kwlWriteShortLE(p + 22, 4);
+    kwlWriteShortLE(p + 24, 2);
+    kwlWriteShortLE(p + 26, framesPerBlock);
+    p += 8 + fmtChunkSize;
+    
+    /*fact chunk*/
+    kwlMemcpy(p, "fact", 4);
+    kwlWriteIntLE(p + 4, 4);
+    kwlWriteIntLE(p + 8, numFrames);
+    p += 12;
+    
+    /*data chunk*/
+    kwlMemcpy(p, "data", 4);
+    kwlWriteIntLE(p + 4, dataChunkSize);
+    p += 8;
+    
+    /*
+     The decoder does not output the header sample of a block, so the header
+     stores the running predictor and every frame is encoded as a nibble. This
+     keeps the decoded signal continuous across block boundaries.
+     */
+    int predictor[2] = {0, 0};
+    int stepIndex[2] = {0, 0};
+    KWL_ASSERT(numChannels <= 2);
+    
+    for (int block = 0; block < numBlocks; block++)
+    {
+        unsigned char* blockData = &p[block * nBlockAlign];
+        const int firstFrame = block * framesPerBlock;
+        
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            kwlWriteShortLE(&blockData[4 * ch], predictor[ch]);
+            blockData[4 * ch + 2] = (unsigned char)stepIndex[ch];
+            blockData[4 * ch + 3] = 0;
+            
+            for (int w = 0; w < nWordsPerChannel; w++)
+            {
+                unsigned char* word = &blockData[4 * numChannels + 4 * (w * numChannels + ch)];
+                for (int k = 0; k < 8; k++)
+                {
+                    const int frame = firstFrame + 8 * w + k;
+                    const int sample = frame < numFrames ? samples[frame * numChannels + ch] : 0;
+                    const int nibble = kwlEncodeIMAADPCMNibble(sample, &predictor[ch], &stepIndex[ch]);
+                    word[k >> 1] |= (k & 1) ? (nibble << 4) : nibble;
+                }
+            }
+        }
+    }
+    
+    *numBytesOut = fileSize;
+    return wav;
+}
+
+void kwlWaveBankEntrySettings_initWithAudioDataNode(kwlWaveBankEntrySettings* settings,
+                                                    xmlNode* audioDataNode)
+{
+    kwlMemset(settings, 0, sizeof(kwlWaveBankEntrySettings));
+    settings->isStreaming = kwlGetBoolAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_STREAM);
+    
+    xmlChar* encoding = kwlGetAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_ENCODING);
+    settings->encodeToIMAADPCM = encoding != NULL && 
+                                 xmlStrcmp(encoding, (xmlChar*)KWL_XML_AUDIO_DATA_ENCODING_IMA_ADPCM) == 0;
+    if (settings->encodeToIMAADPCM)
+    {
+        settings->adpcmBlockSize = kwlGetIntAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_ADPCM_BLOCK_SIZE);
+    }
+}
+
+/**
+ * Reads the entire contents of a file into a newly allocated buffer.
+ */
+static void* kwlReadEntireFile(const char* path, int* numBytesOut)
+{
+    *numBytesOut = 0;
+    
+    kwlInputStream stream;
+    kwlError result = kwlInputStream_initWithFile(&stream, path);
+    if (result != KWL_NO_ERROR)
+    {
+        return NULL;
+    }
+    
+    const int numBytes = stream.fileSize;
+    void* data = KWL_MALLOC(numBytes > 0 ? numBytes : 1, "entire audio file");
+    const int numBytesRead = kwlInputStream_read(&stream, (signed char*)data, numBytes);
+    kwlInputStream_close(&stream);
+    
+    if (numBytesRead != numBytes)
+    {
+        KWL_FREE(data);
+        return NULL;
+    }
+    
+    *numBytesOut = numBytes;
+    return data;
+}
+
+kwlResultCode kwlWaveBankBinary_createEntry(kwlWaveBankEntryChunk* entry,
+                                            const char* fileName,
+                                            const char* audioFilePath,
+                                            const kwlWaveBankEntrySettings* settings,
+                                            unsigned long long* sourceHash,
+                                            kwlLogCallback errorLogCallback)
+{
+    kwlMemset(entry, 0, sizeof(kwlWaveBankEntryChunk));
+    
+    /*read the source file once. all parsing below works on the in-memory copy.*/
+    int fileSize = 0;
+    void* fileData = kwlReadEntireFile(audioFilePath, &fileSize);
+    if (fileData == NULL)
+    {
+        errorLogCallback("Could not read audio file '%s'.\n", audioFilePath);
+        return KWL_AUDIO_FILE_REFERENCE_ERROR;
+    }
+    
+    if (sourceHash != NULL)
+    {
+        *sourceHash = kwlWaveBankBuildCache_hash(fileData, fileSize, KWL_WAVE_BANK_BUILD_CACHE_HASH_SEED);
+    }
+    
+    kwlAudioData audioData;
+    kwlLoadAudioFileFromBuffer(fileData, fileSize, &audioData, KWL_SKIP_AUDIO_DATA);
+    const int isLinearPCM = kwlAudioData_isLinearPCM(&audioData);
+    
+    if (!settings->encodeToIMAADPCM)
+    {
+        if (isLinearPCM && !settings->isStreaming)
+        {
+            kwlLoadAudioFileFromBuffer(fileData, fileSize, &audioData, KWL_CONVERT_TO_INT16_OR_FAIL);
+        }
+        else
+        {
+            kwlLoadAudioFileFromBuffer(fileData, fileSize, &audioData, KWL_LOAD_ENTIRE_FILE);
+        }
+        KWL_FREE(fileData);
+        
+        entry->fileName = kwlDuplicateString(fileName);
+        entry->isStreaming = settings->isStreaming;
+        entry->encoding = audioData.encoding;
+        entry->numBytes = audioData.numBytes;
+        entry->numChannels = audioData.numChannels;
+        entry->data = audioData.bytes;
+        return KWL_SUCCESS;
+    }
+    
+    if (!isLinearPCM)
+    {
+        KWL_FREE(fileData);
+        errorLogCallback("Can't encode '%s' to IMA ADPCM. Only linear PCM source files can be transcoded.\n",
+                         audioFilePath);
+        return KWL_AUDIO_ENCODING_ERROR;
+    }
+    
+    kwlError loadResult = kwlLoadAudioFileFromBuffer(fileData, fileSize, &audioData, KWL_CONVERT_TO_INT16_OR_FAIL);
+    KWL_FREE(fileData);
+    if (loadResult != KWL_NO_ERROR || audioData.numChannels < 1 || audioData.numChannels > 2)
+    {
+        if (loadResult == KWL_NO_ERROR && audioData.numBytes > 0)
+        {
+            KWL_FREE(audioData.bytes);
+        }
+        errorLogCallback("Failed to load '%s' for IMA ADPCM encoding.\n", audioFilePath);
+        return KWL_AUDIO_ENCODING_ERROR;
+    }
+    
+    int numBytes = 0;
+    entry->data = kwlEncodeIMAADPCMWAV((const short*)audioData.bytes,
+                                       audioData.numBytes / (2 * audioData.numChannels),
+                                       audioData.numChannels,
+                                       audioData.sampleRate,
+                                       settings->adpcmBlockSize,
+                                       &numBytes);
+    entry->fileName = kwlDuplicateString(fileName);
+    entry->isStreaming = settings->isStreaming;
+    entry->encoding = KWL_ENCODING_IMA_ADPCM;
+    entry->numBytes = numBytes;
+    entry->numChannels = audioData.numChannels;
+    KWL_FREE(audioData.bytes);
+    
+    return KWL_SUCCESS;
+}
+
+void kwlWaveBankEntryChunk_free(kwlWaveBankEntryChunk* entry)
+{
+    if (entry->fileName != NULL)
+    {
+        KWL_FREE(entry->fileName);
+    }
+    if (entry->numBytes > 0)
+    {
+        KWL_FREE(entry->data);
+    }
+    kwlMemset(entry, 0, sizeof(kwlWaveBankEntryChunk));
+}
+
 kwlResultCode kwlWaveBankBinary_create(kwlWaveBankBinary* wbBin,
                                        kwlEngineDataBinary* edBin,
                                        xmlNode* projNode,
@@ -213,40 +533,220 @@ kwlResultCode kwlWaveBankBinary_create(kwlWaveBankBinary* wbBin,
     
     wbBin->id = kwlDuplicateString(waveBank->id);
     wbBin->entries = KWL_MALLOCANDZERO(waveBank->numAudioDataEntries * sizeof(kwlWaveBankEntryChunk), "bin wb entries");
+    
+    kwlProjectIndex projectIndex;
+    kwlProjectIndex_init(&projectIndex, projNode, errorLogCallback);
+    
     for (int i = 0; i < waveBank->numAudioDataEntries; i++)
     {
         kwlWaveBankEntryChunk* ei = &wbBin->entries[i];
-        ei->fileName = kwlDuplicateString(waveBank->audioDataEntries[i]);
-        const char* audioFilePath = kwlGetAudioFilePath(xmlPath, audioFileRoot, rootIsRelative, ei->fileName);
+        const char* fileName = waveBank->audioDataEntries[i];
+        char* audioFilePath = kwlGetAudioFilePath(xmlPath, audioFileRoot, rootIsRelative, fileName);
         KWL_ASSERT(kwlDoesFileExist(audioFilePath) && "audio file does not exist. should have been caught in validation");
         
-        kwlAudioData audioData;
-        kwlLoadAudioFile(audioFilePath, &audioData, KWL_SKIP_AUDIO_DATA);
-        
-        xmlNode* audioDataNode = kwlResolveAudioDataReference(projNode,
-                                                              wbBin->id,
-                                                              ei->fileName);
+        xmlNode* audioDataNode = kwlProjectIndex_resolveAudioDataReference(&projectIndex,
+                                                                           wbBin->id,
+                                                                           fileName);
         KWL_ASSERT(audioDataNode != 0);
-        const int isStreaming = kwlGetBoolAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_STREAM);
+        kwlWaveBankEntrySettings settings;
+        kwlWaveBankEntrySettings_initWithAudioDataNode(&settings, audioDataNode);
         
-        if (kwlAudioData_isLinearPCM(&audioData) && !isStreaming)
+        kwlResultCode entryResult = kwlWaveBankBinary_createEntry(ei,
+                                                                  fileName,
+                                                                  audioFilePath,
+                                                                  &settings,
+                                                                  NULL,
+                                                                  errorLogCallback);
+        KWL_FREE(audioFilePath);
+        if (entryResult != KWL_SUCCESS)
         {
-            kwlLoadAudioFile(audioFilePath, &audioData, KWL_CONVERT_TO_INT16_OR_FAIL);
+            /*entries from this one on have no data yet*/
+            wbBin->numEntries = i;
+            kwlWaveBankBinary_free(wbBin);
+            kwlProjectIndex_free(&projectIndex);
+            return entryResult;
         }
-        else
+    }
+    
+    kwlProjectIndex_free(&projectIndex);
+    return KWL_SUCCESS;
+}
+
+unsigned long long kwlWaveBankBuildCache_hash(const void* data, int numBytes, unsigned long long hash)
+{
+    /*64 bit FNV-1a*/
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (int i = 0; i < numBytes; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+int kwlWaveBankBuildCache_hashFile(const char* path, unsigned long long* hash)
+{
+    kwlInputStream stream;
+    kwlError result = kwlInputStream_initWithFile(&stream, path);
+    if (result != KWL_NO_ERROR)
+    {
+        return 0;
+    }
+    
+    unsigned long long h = KWL_WAVE_BANK_BUILD_CACHE_HASH_SEED;
+    signed char buffer[KWL_INPUT_STREAM_READ_AHEAD_BUFFER_SIZE];
+    int numBytesLeft = stream.fileSize;
+    while (numBytesLeft > 0)
+    {
+        const int chunkSize = numBytesLeft < (int)sizeof(buffer) ? numBytesLeft : (int)sizeof(buffer);
+        const int numBytesRead = kwlInputStream_read(&stream, buffer, chunkSize);
+        if (numBytesRead != chunkSize)
         {
-            /**/
-            kwlLoadAudioFile(audioFilePath, &audioData, KWL_LOAD_ENTIRE_FILE);
+            kwlInputStream_close(&stream);
+            return 0;
+        }
+        h = kwlWaveBankBuildCache_hash(buffer, chunkSize, h);
+        numBytesLeft -= chunkSize;
+    }
+    
+    kwlInputStream_close(&stream);
+    *hash = h;
+    return 1;
+}
+
+static void kwlWriteInt64BE(kwlFileOutputStream* fos, unsigned long long value)
+{
+    kwlFileOutputStream_writeInt32BE(fos, (int)(value >> 32));
+    kwlFileOutputStream_writeInt32BE(fos, (int)(value & 0xffffffff));
+}
+
+static unsigned long long kwlReadInt64BE(kwlInputStream* stream)
+{
+    const unsigned long long hi = (unsigned int)kwlInputStream_readIntBE(stream);
+    const unsigned long long lo = (unsigned int)kwlInputStream_readIntBE(stream);
+    return (hi << 32) | lo;
+}
+
+int kwlWaveBankBuildCache_loadFromFile(kwlWaveBankBuildCache* cache, const char* path)
+{
+    kwlMemset(cache, 0, sizeof(kwlWaveBankBuildCache));
+    
+    kwlInputStream stream;
+    kwlError result = kwlInputStream_initWithFile(&stream, path);
+    if (result != KWL_NO_ERROR)
+    {
+        return 0;
+    }
+    
+    for (int i = 0; i < KWL_WAVE_BANK_BUILD_CACHE_FILE_IDENTIFIER_LENGTH; i++)
+    {
+        const char identifierChari = kwlInputStream_readChar(&stream);
+        if (identifierChari != KWL_WAVE_BANK_BUILD_CACHE_FILE_IDENTIFIER[i])
+        {
+            kwlInputStream_close(&stream);
+            return 0;
+        }
+    }
+    
+    const int version = kwlInputStream_readIntBE(&stream);
+    cache->waveBankSize = (long)kwlReadInt64BE(&stream);
+    cache->waveBankTimeStamp = (long)kwlReadInt64BE(&stream);
+    const int numEntries = kwlInputStream_readIntBE(&stream);
+    
+    /*each entry takes up at least 65 bytes.*/
+    if (version != KWL_WAVE_BANK_BUILD_CACHE_VERSION ||
+        numEntries < 0 ||
+        numEntries > stream.fileSize / 65)
+    {
+        kwlInputStream_close(&stream);
+        kwlMemset(cache, 0, sizeof(kwlWaveBankBuildCache));
+        return 0;
+    }
+    
+    cache->entries = KWL_MALLOCANDZERO((numEntries > 0 ? numEntries : 1) * sizeof(kwlWaveBankBuildCacheEntry),
+                                       "wb build cache entries");
+    for (int i = 0; i < numEntries; i++)
+    {
+        if (kwlInputStream_isAtEndOfStream(&stream))
+        {
+            break;
         }
         
-        ei->encoding = audioData.encoding;
-        ei->isStreaming = isStreaming;
-        ei->numBytes = audioData.numBytes;
-        ei->numChannels = audioData.numChannels;
-        ei->data = audioData.bytes;
+        kwlWaveBankBuildCacheEntry* ei = &cache->entries[i];
+        ei->fileName = kwlInputStream_readASCIIString(&stream);
+        cache->numEntries = i + 1;
+        ei->settings.isStreaming = kwlInputStream_readIntBE(&stream);
+        ei->settings.encodeToIMAADPCM = kwlInputStream_readIntBE(&stream);
+        ei->settings.adpcmBlockSize = kwlInputStream_readIntBE(&stream);
+        ei->sourceSize = (long)kwlReadInt64BE(&stream);
+        ei->sourceTimeStamp = (long)kwlReadInt64BE(&stream);
+        ei->sourceHash = kwlReadInt64BE(&stream);
+        ei->encoding = kwlInputStream_readIntBE(&stream);
+        ei->isStreaming = kwlInputStream_readIntBE(&stream);
+        ei->numChannels = kwlInputStream_readIntBE(&stream);
+        ei->numBytes = kwlInputStream_readIntBE(&stream);
+        ei->dataOffset = (long)kwlReadInt64BE(&stream);
     }
     
-    return KWL_SUCCESS;
+    const int isComplete = cache->numEntries == numEntries && 
+                           kwlInputStream_tell(&stream) <= stream.fileSize;
+    kwlInputStream_close(&stream);
+    
+    if (!isComplete)
+    {
+        kwlWaveBankBuildCache_free(cache);
+        return 0;
+    }
+    
+    return 1;
+}
+
+int kwlWaveBankBuildCache_writeToFile(const kwlWaveBankBuildCache* cache, const char* path)
+{
+    kwlFileOutputStream fos;
+    if (!kwlFileOutputStream_initWithPath(&fos, path))
+    {
+        return 0;
+    }
+    
+    kwlFileOutputStream_write(&fos, KWL_WAVE_BANK_BUILD_CACHE_FILE_IDENTIFIER, KWL_WAVE_BANK_BUILD_CACHE_FILE_IDENTIFIER_LENGTH);
+    kwlFileOutputStream_writeInt32BE(&fos, KWL_WAVE_BANK_BUILD_CACHE_VERSION);
+    kwlWriteInt64BE(&fos, cache->waveBankSize);
+    kwlWriteInt64BE(&fos, cache->waveBankTimeStamp);
+    kwlFileOutputStream_writeInt32BE(&fos, cache->numEntries);
+    
+    for (int i = 0; i < cache->numEntries; i++)
+    {
+        const kwlWaveBankBuildCacheEntry* ei = &cache->entries[i];
+        kwlFileOutputStream_writeASCIIString(&fos, ei->fileName);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->settings.isStreaming);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->settings.encodeToIMAADPCM);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->settings.adpcmBlockSize);
+        kwlWriteInt64BE(&fos, ei->sourceSize);
+        kwlWriteInt64BE(&fos, ei->sourceTimeStamp);
+        kwlWriteInt64BE(&fos, ei->sourceHash);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->encoding);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->isStreaming);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->numChannels);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->numBytes);
+        kwlWriteInt64BE(&fos, ei->dataOffset);
+    }
+    
+    kwlFileOutputStream_close(&fos);
+    return 1;
+}
+
+void kwlWaveBankBuildCache_free(kwlWaveBankBuildCache* cache)
+{
+    for (int i = 0; i < cache->numEntries; i++)
+    {
+        KWL_FREE(cache->entries[i].fileName);
+    }
+    if (cache->entries != NULL)
+    {
+        KWL_FREE(cache->entries);
+    }
+    kwlMemset(cache, 0, sizeof(kwlWaveBankBuildCache));
 }
 
 void kwlWaveBankBinary_dump(kwlWaveBankBinary* bin,
@@ -280,12 +780,7 @@ void kwlWaveBankBinary_free(kwlWaveBankBinary* bin)
     
     for (int i = 0; i < bin->numEntries; i++)
     {
-        kwlWaveBankEntryChunk* ei = &bin->entries[i];
-        KWL_FREE(ei->fileName);
-        if (ei->numBytes > 0)
-        {
-            KWL_FREE(ei->data);
-        }
+        kwlWaveBankEntryChunk_free(&bin->entries[i]);
     }
     
     KWL_FREE(bin->entries);
@@ -24,6 +24,7 @@
 #ifndef KWL_WAVE_BANK_BINARY_H
 #define KWL_WAVE_BANK_BINARY_H
 
+#include "kwl_fileoutputstream.h"
 #include "kwl_logging.h"
 #include "kwl_wavebank.h"
 
@@ -32,6 +33,27 @@ extern "C"
 {
 #endif /* __cplusplus */
     
+    /** The length of the wave bank build cache file identifier.*/
+    #define KWL_WAVE_BANK_BUILD_CACHE_FILE_IDENTIFIER_LENGTH 9
+    
+    /** 
+     * The file identifier for wave bank build caches.
+     */
+    static const char KWL_WAVE_BANK_BUILD_CACHE_FILE_IDENTIFIER[KWL_WAVE_BANK_BUILD_CACHE_FILE_IDENTIFIER_LENGTH] =
+    {
+        0xAB, 'K', 'W', 'C', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+    
+    /** 
+     * The version of the wave bank build cache format. Should be increased whenever 
+     * the cache format or the way entries are converted changes, so that stale
+     * cached payloads are not reused.
+     */
+    #define KWL_WAVE_BANK_BUILD_CACHE_VERSION 1
+    
+    /** The file name extension of wave bank build caches, stored next to the wave bank binaries.*/
+    #define KWL_WAVE_BANK_BUILD_CACHE_FILE_EXTENSION ".cache"
+    
     /**
      * A wave bank binary entry, corresponding to a pice of audio data.
      */
@@ -45,6 +67,60 @@ extern "C"
         void* data;
     } kwlWaveBankEntryChunk;
     
+    /**
+     * Per entry build settings, read from an AudioData node. Kept separate from
+     * the XML so entries can be built without touching the document.
+     */
+    typedef struct kwlWaveBankEntrySettings
+    {
+        /** Non-zero if the audio data should be streamed.*/
+        int isStreaming;
+        /** Non-zero if the audio data should be transcoded to IMA ADPCM.*/
+        int encodeToIMAADPCM;
+        /** The IMA ADPCM block size in bytes per channel.*/
+        int adpcmBlockSize;
+    } kwlWaveBankEntrySettings;
+    
+    /**
+     * Describes an entry of a previously built wave bank binary: where its
+     * payload is and what it was built from.
+     */
+    typedef struct kwlWaveBankBuildCacheEntry
+    {
+        /** The audio file name as referenced by the project data.*/
+        char* fileName;
+        /** The settings the entry was built with.*/
+        kwlWaveBankEntrySettings settings;
+        /** The size of the source audio file in bytes.*/
+        long sourceSize;
+        /** The time stamp of the source audio file.*/
+        long sourceTimeStamp;
+        /** A hash of the contents of the source audio file.*/
+        unsigned long long sourceHash;
+        int encoding;
+        int isStreaming;
+        int numChannels;
+        int numBytes;
+        /** The offset of the entry payload from the start of the wave bank binary.*/
+        long dataOffset;
+    } kwlWaveBankBuildCacheEntry;
+    
+    /**
+     * A wave bank build cache, recording how each entry of a wave bank binary was built
+     * so that unchanged entries can be copied from it rather than rebuilt.
+     */
+    typedef struct kwlWaveBankBuildCache
+    {
+        /** The size of the wave bank binary the cache describes.*/
+        long waveBankSize;
+        /** The time stamp of the wave bank binary the cache describes.*/
+        long waveBankTimeStamp;
+        /** The number of cached entries.*/
+        int numEntries;
+        /** The cached entries, in wave bank binary order.*/
+        kwlWaveBankBuildCacheEntry* entries;
+    } kwlWaveBankBuildCache;
+    
     /**
      * A struct representation of a wave bank binary file.
      */
@@ -76,6 +152,25 @@ extern "C"
     void kwlWaveBankBinary_writeToFile(kwlWaveBankBinary* bin,
                                        const char* path);
     
+    /**
+     * Writes the file identifier, id and entry count of a wave bank binary. 
+     * Should be followed by \c numEntries calls to \c kwlWaveBankBinary_writeEntry.
+     * @param fos The stream to write to.
+     * @param id The id of the wave bank.
+     * @param numEntries The number of entries that will follow.
+     */
+    void kwlWaveBankBinary_writeHeader(kwlFileOutputStream* fos,
+                                       const char* id,
+                                       int numEntries);
+    
+    /**
+     * Writes a single wave bank binary entry, including its audio data.
+     * @param fos The stream to write to.
+     * @param entry The entry to write.
+     */
+    void kwlWaveBankBinary_writeEntry(kwlFileOutputStream* fos,
+                                      const kwlWaveBankEntryChunk* entry);
+    
     /**
      * Loads a wave bank binary file (including audio data) into into a \kwlWaveBankBinary struct.
      * @param bin The wave bank binary to load data into.
@@ -87,6 +182,39 @@ extern "C"
                                                        const char* path,
                                                        kwlLogCallback errorLogCallback);
     
+    /**
+     * Reads the build settings of an entry from its AudioData node.
+     * @param settings The settings struct to fill in.
+     * @param audioDataNode The AudioData node of the entry.
+     */
+    void kwlWaveBankEntrySettings_initWithAudioDataNode(kwlWaveBankEntrySettings* settings,
+                                                        xmlNode* audioDataNode);
+    
+    /**
+     * Builds a single wave bank binary entry from an audio file. The file is read
+     * from disk once. Does not access any shared state and may be called 
+     * concurrently for different entries.
+     * @param entry The entry to build.
+     * @param fileName The audio file name as referenced by the project data.
+     * @param audioFilePath The path of the audio file.
+     * @param settings The build settings of the entry.
+     * @param sourceHash If not NULL, receives the hash of the contents of the audio file.
+     * @param errorLogCallback Any errors are printed using this callback.
+     * @return A result code.
+     */
+    kwlResultCode kwlWaveBankBinary_createEntry(kwlWaveBankEntryChunk* entry,
+                                                const char* fileName,
+                                                const char* audioFilePath,
+                                                const kwlWaveBankEntrySettings* settings,
+                                                unsigned long long* sourceHash,
+                                                kwlLogCallback errorLogCallback);
+    
+    /**
+     * Releases all memory, if any, associated with a given wave bank binary entry.
+     * @param entry The entry to free.
+     */
+    void kwlWaveBankEntryChunk_free(kwlWaveBankEntryChunk* entry);
+    
     /**
      * Creates a wave bank binary corresponding to a specific wave bank entry
      * in an engine data binary.
@@ -109,6 +237,48 @@ extern "C"
                                            const char* waveBankId,
                                            kwlLogCallback errorLogCallback);
     
+    /**
+     * Computes the hash used to detect changes to audio files.
+     * @param data The data to hash.
+     * @param numBytes The size of \c data in bytes.
+     * @param hash The hash of any preceding data, or \c KWL_WAVE_BANK_BUILD_CACHE_HASH_SEED.
+     * @return The updated hash.
+     */
+    unsigned long long kwlWaveBankBuildCache_hash(const void* data, int numBytes, unsigned long long hash);
+    
+    /** The initial value passed to \c kwlWaveBankBuildCache_hash.*/
+    #define KWL_WAVE_BANK_BUILD_CACHE_HASH_SEED 14695981039346656037ULL
+    
+    /**
+     * Computes the hash of the contents of a given file.
+     * @param path The path of the file.
+     * @param hash Receives the hash.
+     * @return Non-zero on success, zero if the file could not be read.
+     */
+    int kwlWaveBankBuildCache_hashFile(const char* path, unsigned long long* hash);
+    
+    /**
+     * Loads a wave bank build cache.
+     * @param cache The cache to load into.
+     * @param path The path of the cache file.
+     * @return Non-zero if a valid cache was loaded, zero otherwise.
+     */
+    int kwlWaveBankBuildCache_loadFromFile(kwlWaveBankBuildCache* cache, const char* path);
+    
+    /**
+     * Writes a wave bank build cache.
+     * @param cache The cache to write.
+     * @param path The path of the cache file.
+     * @return Non-zero on success, zero otherwise.
+     */
+    int kwlWaveBankBuildCache_writeToFile(const kwlWaveBankBuildCache* cache, const char* path);
+    
+    /**
+     * Releases all memory, if any, associated with a given wave bank build cache.
+     * @param cache The cache to free.
+     */
+    void kwlWaveBankBuildCache_free(kwlWaveBankBuildCache* cache);
+    
     /**
      * Prints the contents of a given wave bank binary.
      * @param bin The wave bank binary to print.
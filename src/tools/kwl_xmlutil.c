@@ -24,6 +24,7 @@
 #include <libxml/parser.h>
 #include <libxml/xmlschemas.h>
 
+#include <stdio.h>
 #include <string.h>
 
 #include "kwl_assert.h"
@@ -338,3 +339,348 @@ xmlNode* kwlResolveAudioDataReference(xmlNode* someNode, const char* wbPath, con
     
     return NULL;
 }
+
+/**
+ * Returns the 32 bit FNV-1a hash of a null terminated string.
+ */
+static unsigned int kwlNodeIndex_hash(const char* key)
+{
+    unsigned int hash = 2166136261u;
+    for (const unsigned char* c = (const unsigned char*)key; *c != '\0'; c++)
+    {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void kwlNodeIndex_init(kwlNodeIndex* index)
+{
+    kwlMemset(index, 0, sizeof(kwlNodeIndex));
+}
+
+/**
+ * Returns the slot of the entry with a given key, or the empty slot where it would be inserted.
+ */
+static kwlNodeIndexEntry* kwlNodeIndex_getSlot(const kwlNodeIndex* index, const char* key)
+{
+    KWL_ASSERT(index->capacity > 0);
+    
+    const unsigned int mask = (unsigned int)index->capacity - 1;
+    unsigned int slot = kwlNodeIndex_hash(key) & mask;
+    while (index->entries[slot].key != NULL &&
+           strcmp(index->entries[slot].key, key) != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    
+    return &index->entries[slot];
+}
+
+static void kwlNodeIndex_grow(kwlNodeIndex* index)
+{
+    kwlNodeIndexEntry* oldEntries = index->entries;
+    const int oldCapacity = index->capacity;
+    
+    index->capacity = oldCapacity == 0 ? 64 : 2 * oldCapacity;
+    index->entries = KWL_MALLOCANDZERO(index->capacity * sizeof(kwlNodeIndexEntry), "node index entries");
+    
+    for (int i = 0; i < oldCapacity; i++)
+    {
+        if (oldEntries[i].key != NULL)
+        {
+            *kwlNodeIndex_getSlot(index, oldEntries[i].key) = oldEntries[i];
+        }
+    }
+    
+    if (oldEntries != NULL)
+    {
+        KWL_FREE(oldEntries);
+    }
+}
+
+int kwlNodeIndex_add(kwlNodeIndex* index, const char* key, xmlNode* node, int value)
+{
+    /*keep the load factor at or below one half*/
+    if (2 * (index->numEntries + 1) > index->capacity)
+    {
+        kwlNodeIndex_grow(index);
+    }
+    
+    kwlNodeIndexEntry* entry = kwlNodeIndex_getSlot(index, key);
+    if (entry->key != NULL)
+    {
+        return 0;
+    }
+    
+    const size_t keyLength = strlen(key);
+    entry->key = KWL_MALLOC(keyLength + 1, "node index key");
+    kwlMemcpy(entry->key, key, keyLength + 1);
+    entry->node = node;
+    entry->value = value;
+    index->numEntries++;
+    
+    return 1;
+}
+
+const kwlNodeIndexEntry* kwlNodeIndex_find(const kwlNodeIndex* index, const char* key)
+{
+    if (index->numEntries == 0 || key == NULL)
+    {
+        return NULL;
+    }
+    
+    const kwlNodeIndexEntry* entry = kwlNodeIndex_getSlot(index, key);
+    return entry->key != NULL ? entry : NULL;
+}
+
+void kwlNodeIndex_free(kwlNodeIndex* index)
+{
+    for (int i = 0; i < index->capacity; i++)
+    {
+        if (index->entries[i].key != NULL)
+        {
+            KWL_FREE(index->entries[i].key);
+        }
+    }
+    
+    if (index->entries != NULL)
+    {
+        KWL_FREE(index->entries);
+    }
+    
+    kwlMemset(index, 0, sizeof(kwlNodeIndex));
+}
+
+/**
+ * Returns a newly allocated AudioData index key for a given wave bank index and relative path.
+ */
+static char* kwlProjectIndex_createAudioDataKey(int waveBankIndex, const char* audioDataPath)
+{
+    const size_t keyLength = strlen(audioDataPath) + 16;
+    char* key = KWL_MALLOC(keyLength, "audio data key");
+    snprintf(key, keyLength, "%d:%s", waveBankIndex, audioDataPath);
+    return key;
+}
+
+/**
+ * Adds the AudioData children of a wave bank node to the AudioData index.
+ */
+static void kwlProjectIndex_addAudioData(kwlProjectIndex* index, xmlNode* waveBankNode, int waveBankIndex)
+{
+    int audioDataIndex = 0;
+    for (xmlNode* curr = waveBankNode->children; curr != NULL; curr = curr->next)
+    {
+        if (!xmlStrEqual(curr->name, (xmlChar*)KWL_XML_AUDIO_DATA_NODE))
+        {
+            continue;
+        }
+        
+        xmlChar* relPath = kwlGetAttributeValue(curr, KWL_XML_ATTR_REL_PATH);
+        KWL_ASSERT(relPath != NULL);
+        char* key = kwlProjectIndex_createAudioDataKey(waveBankIndex, (const char*)relPath);
+        /*like a linear search, duplicate paths resolve to the first node.*/
+        kwlNodeIndex_add(&index->audioData, key, curr, audioDataIndex);
+        KWL_FREE(key);
+        audioDataIndex++;
+    }
+}
+
+/**
+ * Adds the descendants of a group node to a node index, visiting leaf nodes in 
+ * the same order as \c kwlTraverseNodeTree.
+ */
+static void kwlProjectIndex_addNodes(kwlProjectIndex* projectIndex,
+                                     kwlNodeIndex* index,
+                                     xmlNode* node,
+                                     const char* nodePath,
+                                     const char* branchNodeName,
+                                     const char* leafNodeName,
+                                     int* leafCount,
+                                     int* uniquenessErrorOccurred,
+                                     kwlLogCallback errorLogCallback)
+{
+    const size_t nodePathLength = nodePath == NULL ? 0 : strlen(nodePath);
+    
+    for (xmlNode* curr = node->children; curr != NULL; curr = curr->next)
+    {
+        const int isBranch = xmlStrEqual(curr->name, (xmlChar*)branchNodeName);
+        const int isLeaf = xmlStrEqual(curr->name, (xmlChar*)leafNodeName);
+        if (!isBranch && !isLeaf)
+        {
+            continue;
+        }
+        
+        xmlChar* id = kwlGetAttributeValue(curr, KWL_XML_ATTR_ID);
+        KWL_ASSERT(id != NULL);
+        
+        /*the path of a child of a root group is its id, otherwise it's the parent path, a slash and the id.*/
+        const size_t idLength = (size_t)xmlStrlen(id);
+        char* path = KWL_MALLOC(nodePathLength + idLength + 2, "node index path");
+        if (nodePath == NULL)
+        {
+            kwlMemcpy(path, id, idLength + 1);
+        }
+        else
+        {
+            kwlMemcpy(path, nodePath, nodePathLength);
+            path[nodePathLength] = '/';
+            kwlMemcpy(&path[nodePathLength + 1], id, idLength + 1);
+        }
+        
+        const int value = isLeaf ? *leafCount : -1;
+        if (!kwlNodeIndex_add(index, path, curr, value))
+        {
+            errorLogCallback("The id '%s' is not unique among the children of the %s node with id '%s'.\n",
+                             id, branchNodeName, kwlGetAttributeValue(node, KWL_XML_ATTR_ID));
+            *uniquenessErrorOccurred = 1;
+        }
+        
+        if (isBranch)
+        {
+            kwlProjectIndex_addNodes(projectIndex,
+                                     index,
+                                     curr,
+                                     path,
+                                     branchNodeName,
+                                     leafNodeName,
+                                     leafCount,
+                                     uniquenessErrorOccurred,
+                                     errorLogCallback);
+        }
+        
+        if (isLeaf)
+        {
+            if (index == &projectIndex->waveBanks)
+            {
+                kwlProjectIndex_addAudioData(projectIndex, curr, *leafCount);
+            }
+            (*leafCount)++;
+        }
+        
+        KWL_FREE(path);
+    }
+}
+
+/**
+ * Adds the mix bus children of a given node and their descendants to the mix bus index,
+ * visiting them in the same order as \c kwlTraverseNodeTree.
+ */
+static void kwlProjectIndex_addMixBuses(kwlProjectIndex* index,
+                                        xmlNode* node,
+                                        int* mixBusCount,
+                                        int* uniquenessErrorOccurred,
+                                        kwlLogCallback errorLogCallback)
+{
+    for (xmlNode* curr = node->children; curr != NULL; curr = curr->next)
+    {
+        if (!xmlStrEqual(curr->name, (xmlChar*)KWL_XML_MIX_BUS_NODE))
+        {
+            continue;
+        }
+        
+        kwlProjectIndex_addMixBuses(index, curr, mixBusCount, uniquenessErrorOccurred, errorLogCallback);
+        
+        xmlChar* id = kwlGetAttributeValue(curr, KWL_XML_MIX_BUS_ID);
+        KWL_ASSERT(id != NULL);
+        if (!kwlNodeIndex_add(&index->mixBuses, (const char*)id, curr, *mixBusCount))
+        {
+            errorLogCallback("Mix bus id '%s' is not unique.\n", id);
+            *uniquenessErrorOccurred = 1;
+        }
+        (*mixBusCount)++;
+    }
+}
+
+int kwlProjectIndex_init(kwlProjectIndex* index,
+                         xmlNode* projectNode,
+                         kwlLogCallback errorLogCallback)
+{
+    kwlMemset(index, 0, sizeof(kwlProjectIndex));
+    kwlNodeIndex_init(&index->mixBuses);
+    kwlNodeIndex_init(&index->mixPresets);
+    kwlNodeIndex_init(&index->waveBanks);
+    kwlNodeIndex_init(&index->sounds);
+    kwlNodeIndex_init(&index->events);
+    kwlNodeIndex_init(&index->audioData);
+    
+    const char* branchNodeNames[4] = {KWL_XML_MIX_PRESET_GROUP_NODE,
+                                      KWL_XML_WAVE_BANK_GROUP_NODE,
+                                      KWL_XML_SOUND_GROUP_NODE,
+                                      KWL_XML_EVENT_GROUP_NODE};
+    const char* leafNodeNames[4] = {KWL_XML_MIX_PRESET_NODE,
+                                    KWL_XML_WAVE_BANK_NODE,
+                                    KWL_XML_SOUND_NODE,
+                                    KWL_XML_EVENT_NODE};
+    kwlNodeIndex* indices[4] = {&index->mixPresets,
+                                &index->waveBanks,
+                                &index->sounds,
+                                &index->events};
+    
+    int uniquenessErrorOccurred = 0;
+    int mixBusCount = 0;
+    kwlProjectIndex_addMixBuses(index, projectNode, &mixBusCount, &uniquenessErrorOccurred, errorLogCallback);
+    
+    for (int i = 0; i < 4; i++)
+    {
+        xmlNode* rootNode = kwlGetChild(projectNode, branchNodeNames[i]);
+        if (rootNode == NULL)
+        {
+            continue;
+        }
+        
+        int leafCount = 0;
+        kwlProjectIndex_addNodes(index,
+                                 indices[i],
+                                 rootNode,
+                                 NULL,
+                                 branchNodeNames[i],
+                                 leafNodeNames[i],
+                                 &leafCount,
+                                 &uniquenessErrorOccurred,
+                                 errorLogCallback);
+    }
+    
+    return uniquenessErrorOccurred == 0;
+}
+
+const kwlNodeIndexEntry* kwlProjectIndex_findAudioData(const kwlProjectIndex* index,
+                                                       int waveBankIndex,
+                                                       const char* audioDataPath)
+{
+    if (audioDataPath == NULL)
+    {
+        return NULL;
+    }
+    
+    char* key = kwlProjectIndex_createAudioDataKey(waveBankIndex, audioDataPath);
+    const kwlNodeIndexEntry* entry = kwlNodeIndex_find(&index->audioData, key);
+    KWL_FREE(key);
+    return entry;
+}
+
+xmlNode* kwlProjectIndex_resolveAudioDataReference(const kwlProjectIndex* index,
+                                                   const char* wbPath,
+                                                   const char* audioDataPath)
+{
+    const kwlNodeIndexEntry* waveBankEntry = kwlNodeIndex_find(&index->waveBanks, wbPath);
+    if (waveBankEntry == NULL || waveBankEntry->value < 0)
+    {
+        return NULL;
+    }
+    
+    const kwlNodeIndexEntry* audioDataEntry = kwlProjectIndex_findAudioData(index,
+                                                                            waveBankEntry->value,
+                                                                            audioDataPath);
+    return audioDataEntry == NULL ? NULL : audioDataEntry->node;
+}
+
+void kwlProjectIndex_free(kwlProjectIndex* index)
+{
+    kwlNodeIndex_free(&index->mixBuses);
+    kwlNodeIndex_free(&index->mixPresets);
+    kwlNodeIndex_free(&index->waveBanks);
+    kwlNodeIndex_free(&index->sounds);
+    kwlNodeIndex_free(&index->events);
+    kwlNodeIndex_free(&index->audioData);
+}
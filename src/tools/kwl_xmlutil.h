@@ -34,6 +34,8 @@
 
 #define KWL_XML_AUDIO_DATA_NODE "AudioData"
 #define KWL_XML_AUDIO_DATA_STREAM "streamFromDisk"
+#define KWL_XML_AUDIO_DATA_ENCODING "encoding"
+#define KWL_XML_AUDIO_DATA_ADPCM_BLOCK_SIZE "adpcmBlockSize"
 
 #define KWL_XML_AUDIO_DATA_REFERENCE_NODE "AudioDataReference"
 #define KWL_XML_AUDIO_DATA_REFERENCE_PATH "relativePath"
@@ -60,6 +62,11 @@
 
 #define KWL_XML_MIX_BUS_NODE "MixBus"
 #define KWL_XML_MIX_BUS_ID "id"
+#define KWL_XML_MIX_BUS_AUX_RETURN "auxReturn"
+
+#define KWL_XML_AUX_SEND_NODE "AuxSend"
+#define KWL_XML_AUX_SEND_BUS "bus"
+#define KWL_XML_AUX_SEND_LEVEL "level"
 
 #define KWL_XML_MIX_BUS_PARAM_SET_NODE "MixBusParameters"
 #define KWL_XML_MIX_BUS_PARAM_SET_GAIN_L "leftGain"
@@ -70,6 +77,7 @@
 #define KWL_XML_MIX_PRESET_GROUP_NODE "MixPresetGroup"
 #define KWL_XML_MIX_PRESET_NODE "MixPreset"
 #define KWL_XML_MIX_PRESET_DEFAULT "default"
+#define KWL_XML_MIX_PRESET_FADE_TIME "fadeTime"
 
 #define KWL_XML_SOUND_NODE "Sound"
 #define KWL_XML_SOUND_GAIN "gain"
@@ -109,6 +117,9 @@
 #define KWL_XML_INSTACE_STEALING_MODE_RANDOM "STEAL_RANDOM"
 #define KWL_XML_INSTACE_STEALING_MODE_NO_STEAL "DONT_STEAL"
 
+#define KWL_XML_AUDIO_DATA_ENCODING_SOURCE "SOURCE"
+#define KWL_XML_AUDIO_DATA_ENCODING_IMA_ADPCM "IMA_ADPCM"
+
 
 #ifdef __cplusplus
 extern "C"
@@ -239,6 +250,134 @@ extern "C"
      */
     xmlNode* kwlResolveAudioDataReference(xmlNode* someNode, const char* wbPath, const char* audioDataPath);
     
+    /**
+     * An entry in a node index.
+     */
+    typedef struct kwlNodeIndexEntry
+    {
+        /** The key of the entry, owned by the index. NULL for unused slots.*/
+        char* key;
+        /** The node associated with the key.*/
+        xmlNode* node;
+        /** An integer associated with the key, for example the index of the corresponding chunk.*/
+        int value;
+    } kwlNodeIndexEntry;
+    
+    /**
+     * A hash map from strings, typically node paths, to XML nodes and integer values.
+     * Used to resolve references without walking the document for every lookup.
+     */
+    typedef struct kwlNodeIndex
+    {
+        /** The number of slots in \c entries. Always a power of two.*/
+        int capacity;
+        /** The number of used slots.*/
+        int numEntries;
+        /** The slots, addressed by open addressing with linear probing.*/
+        kwlNodeIndexEntry* entries;
+    } kwlNodeIndex;
+    
+    /**
+     * Initializes an empty node index.
+     * @param index The index to initialize.
+     */
+    void kwlNodeIndex_init(kwlNodeIndex* index);
+    
+    /**
+     * Adds an entry to a node index. 
+     * @param index The index to add the entry to.
+     * @param key The key of the entry. Copied by the index.
+     * @param node The node to associate with \c key.
+     * @param value The value to associate with \c key.
+     * @return Non-zero if the entry was added, zero if the index already contains \c key, in 
+     * which case the existing entry is kept.
+     */
+    int kwlNodeIndex_add(kwlNodeIndex* index, const char* key, xmlNode* node, int value);
+    
+    /**
+     * Looks up an entry in a node index.
+     * @param index The index to search.
+     * @param key The key to look for.
+     * @return The entry with the given key, or NULL if there is no such entry.
+     */
+    const kwlNodeIndexEntry* kwlNodeIndex_find(const kwlNodeIndex* index, const char* key);
+    
+    /**
+     * Releases all memory associated with a node index.
+     * @param index The index to free.
+     */
+    void kwlNodeIndex_free(kwlNodeIndex* index);
+    
+    /**
+     * Indices of the nodes of a project data document, built in a single traversal.
+     * Group and leaf nodes are keyed by their node paths, i.e the same paths that
+     * are used as ids in the engine data. Leaf nodes are valued by their index in document 
+     * order, which is the order in which the engine data binary gathers them. Group nodes
+     * have the value -1.
+     */
+    typedef struct kwlProjectIndex
+    {
+        /** 
+         * Mix buses, keyed by their ids (mix bus ids are global rather than paths) and 
+         * valued by their index in the order sub buses precede their parents.
+         */
+        kwlNodeIndex mixBuses;
+        /** Mix preset groups and mix presets.*/
+        kwlNodeIndex mixPresets;
+        /** Wave bank groups and wave banks.*/
+        kwlNodeIndex waveBanks;
+        /** Sound groups and sounds.*/
+        kwlNodeIndex sounds;
+        /** Event groups and events.*/
+        kwlNodeIndex events;
+        /** 
+         * AudioData nodes, keyed by the index of their wave bank and their relative path
+         * (see \c kwlProjectIndex_findAudioData) and valued by their index in the wave bank.
+         */
+        kwlNodeIndex audioData;
+    } kwlProjectIndex;
+    
+    /**
+     * Builds the indices of a project data document. Also checks that the ids of all 
+     * mix preset, wave bank, sound and event nodes are unique among their siblings, since
+     * otherwise their node paths would be ambiguous, and that all mix bus ids are unique.
+     * @param index The index to build.
+     * @param projectNode The KowalskiProject root node.
+     * @param errorLogCallback Any non-unique ids are reported using this callback.
+     * @return Non-zero if all ids were unique, zero otherwise.
+     */
+    int kwlProjectIndex_init(kwlProjectIndex* index,
+                             xmlNode* projectNode,
+                             kwlLogCallback errorLogCallback);
+    
+    /**
+     * Looks up an AudioData node by its wave bank and relative path.
+     * @param index The project index.
+     * @param waveBankIndex The index of the wave bank, as stored in \c kwlProjectIndex.waveBanks.
+     * @param audioDataPath The relative path of the AudioData node.
+     * @return The index entry of the AudioData node, or NULL if there is no such node.
+     */
+    const kwlNodeIndexEntry* kwlProjectIndex_findAudioData(const kwlProjectIndex* index,
+                                                           int waveBankIndex,
+                                                           const char* audioDataPath);
+    
+    /**
+     * The indexed equivalent of \c kwlResolveAudioDataReference.
+     * @param index The project index.
+     * @param wbPath The node path to the wave bank.
+     * @param audioDataPath The name of the wave bank entry.
+     * @return The referenced AudioData node or NULL if the reference could not be resolved.
+     */
+    xmlNode* kwlProjectIndex_resolveAudioDataReference(const kwlProjectIndex* index,
+                                                       const char* wbPath,
+                                                       const char* audioDataPath);
+    
+    /**
+     * Releases all memory associated with a project index.
+     * @param index The index to free.
+     */
+    void kwlProjectIndex_free(kwlProjectIndex* index);
+    
     
 #ifdef __cplusplus
 }
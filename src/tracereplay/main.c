@@ -0,0 +1,221 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "kowalski.h"
+#include "hosts/offline/kwl_engine_offline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** 
+ * Replays an API call trace using the offline host, e.g for profiling the 
+ * mixer or checking that two builds produce bit-exact output.
+ */
+
+/** The maximum number of frames rendered per render callback. */
+#define MAX_RENDER_SIZE_IN_FRAMES 8192
+
+typedef struct replayContext
+{
+    /** The output file, or NULL if output is not written. */
+    FILE* outFile;
+    /** Receives the rendered samples. */
+    float buffer[2 * MAX_RENDER_SIZE_IN_FRAMES];
+    /** A running FNV-1a hash of the rendered samples. */
+    unsigned int hash;
+    /** The total number of frames rendered. */
+    long long numFramesRendered;
+    /** The CPU time spent rendering. */
+    clock_t renderTime;
+} replayContext;
+
+static void printUsage()
+{
+    printf("Replay an API call trace recorded with kwlTraceRecordingStart:\n");
+    printf("    kwltracereplay tracefile\n");
+    printf("        -out rawfile\n");
+    printf("            Writes the rendered output as raw interleaved 32 bit floats (optional).\n");
+    printf("        -runs n\n");
+    printf("            The number of times to replay the trace (optional, defaults to 1).\n");
+    printf("        -verify tracefile\n");
+    printf("            Records the first run to a new trace, replays that trace and checks that it\n");
+    printf("            reproduces the output of the first run (optional).\n");
+    printf("\n");
+    printf("Relative paths in the trace are resolved against the current working directory.\n");
+}
+
+static const char* getArgumentValue(int argc, const char * argv[], const char* name)
+{
+    for (int i = 0; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    
+    return NULL;
+}
+
+static void render(int numFrames, void* userData)
+{
+    replayContext* context = (replayContext*)userData;
+    
+    while (numFrames > 0)
+    {
+        const int numFramesToRender = numFrames < MAX_RENDER_SIZE_IN_FRAMES ? numFrames : MAX_RENDER_SIZE_IN_FRAMES;
+        
+        const clock_t start = clock();
+        kwlOfflineHost_render(context->buffer, numFramesToRender);
+        context->renderTime += clock() - start;
+        
+        const int numSamples = numFramesToRender * kwlOfflineHost_getNumOutputChannels();
+        const unsigned char* bytes = (const unsigned char*)context->buffer;
+        for (int i = 0; i < numSamples * (int)sizeof(float); i++)
+        {
+            context->hash = (context->hash ^ bytes[i]) * 16777619u;
+        }
+        
+        if (context->outFile != NULL)
+        {
+            fwrite(context->buffer, sizeof(float), numSamples, context->outFile);
+        }
+        
+        context->numFramesRendered += numFramesToRender;
+        numFrames -= numFramesToRender;
+    }
+}
+
+int main(int argc, const char * argv[])
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+    
+    const char* tracePath = argv[1];
+    const char* outPath = getArgumentValue(argc - 2, &argv[2], "-out");
+    const char* runsArg = getArgumentValue(argc - 2, &argv[2], "-runs");
+    const int numRuns = runsArg != NULL ? atoi(runsArg) : 1;
+    const char* verifyPath = getArgumentValue(argc - 2, &argv[2], "-verify");
+    
+    replayContext* context = (replayContext*)malloc(sizeof(replayContext));
+    unsigned int firstHash = 0;
+    int result = 0;
+    
+    for (int run = 0; run < numRuns; run++)
+    {
+        memset(context, 0, sizeof(replayContext));
+        context->hash = 2166136261u;
+        if (outPath != NULL && run == 0)
+        {
+            context->outFile = fopen(outPath, "wb");
+            if (context->outFile == NULL)
+            {
+                printf("Could not open %s\n", outPath);
+                result = 1;
+                break;
+            }
+        }
+        
+        /*the replayed calls are recorded like those of any other offline session.*/
+        if (verifyPath != NULL && run == 0)
+        {
+            kwlTraceRecordingStart(verifyPath);
+            if (kwlGetError() != KWL_NO_ERROR)
+            {
+                printf("Could not create %s\n", verifyPath);
+                result = 1;
+                break;
+            }
+        }
+        
+        const clock_t start = clock();
+        kwlError error = kwlTraceReplay(tracePath, render, context);
+        const clock_t totalTime = clock() - start;
+        
+        if (verifyPath != NULL && run == 0)
+        {
+            kwlTraceRecordingStop();
+        }
+        
+        if (context->outFile != NULL)
+        {
+            fclose(context->outFile);
+        }
+        
+        if (error != KWL_NO_ERROR)
+        {
+            printf("Replay failed with error code %d\n", error);
+            result = 1;
+            break;
+        }
+        
+        printf("run %d: %lld frames, render %.3f ms, total %.3f ms, output hash %08x\n",
+               run + 1,
+               context->numFramesRendered,
+               1000.0 * context->renderTime / CLOCKS_PER_SEC,
+               1000.0 * totalTime / CLOCKS_PER_SEC,
+               context->hash);
+        
+        if (run == 0)
+        {
+            firstHash = context->hash;
+        }
+        else if (context->hash != firstHash)
+        {
+            printf("Output differs from the first run.\n");
+            result = 1;
+        }
+    }
+    
+    if (verifyPath != NULL && result == 0)
+    {
+        memset(context, 0, sizeof(replayContext));
+        context->hash = 2166136261u;
+        
+        kwlError error = kwlTraceReplay(verifyPath, render, context);
+        if (error != KWL_NO_ERROR)
+        {
+            printf("Replaying %s failed with error code %d\n", verifyPath, error);
+            result = 1;
+        }
+        else if (context->hash != firstHash)
+        {
+            printf("Replaying %s gives output hash %08x, which differs from the recorded run.\n", 
+                   verifyPath, 
+                   context->hash);
+            result = 1;
+        }
+        else
+        {
+            printf("Replaying %s reproduces the recorded run.\n", verifyPath);
+        }
+    }
+    
+    free(context);
+    return result;
+}
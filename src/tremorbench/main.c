@@ -0,0 +1,335 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include "ivorbisfile.h"
+#include "misc.h"
+#include "mdct.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Measures the decoding throughput of the Tremor Ogg Vorbis decoder and checks
+ * that its vector paths are bit-exact. Build it together with the Tremor sources
+ * once per vector path, e.g
+ *
+ *     cc -O2 -Isrc/engine/tremor src/tremorbench/main.c src/engine/tremor/[a-z]*.c
+ *     cc -O2 -msse2 -D_X86_SSE2_ASSEM_ ...
+ *     cc -O2 -mavx2 -D_X86_AVX2_ASSEM_ ...
+ *
+ * and compare the printed hashes, which must be the same for all builds.
+ */
+
+/** The size of the buffer decoded PCM data is read into. */
+#define PCM_BUFFER_SIZE 8192
+
+/** The largest block length checked by the kernel tests. */
+#define MAX_KERNEL_LENGTH 1024
+
+/** The largest MDCT size hashed by the kernel tests. */
+#define MAX_MDCT_SIZE 8192
+
+#if defined(_LOW_ACCURACY_)
+#define VECTOR_PATH "C (low accuracy)"
+#elif defined(_X86_AVX2_ASSEM_)
+#define VECTOR_PATH "AVX2"
+#elif defined(_X86_SSE2_ASSEM_)
+#define VECTOR_PATH "SSE2"
+#else
+#define VECTOR_PATH "C"
+#endif
+
+/** The state of the pseudo random number generator used for test data. */
+static unsigned int randomState = 12345;
+
+/** Returns a 32 bit pseudo random number, the same sequence on every platform. */
+static ogg_int32_t nextRandom(void)
+{
+    randomState = randomState * 1103515245u + 12345u;
+    const unsigned int high = randomState & 0xffff0000u;
+    randomState = randomState * 1103515245u + 12345u;
+    return (ogg_int32_t)(high | (randomState >> 16));
+}
+
+/** Updates a running FNV-1a hash with a block of bytes. */
+static unsigned int updateHash(unsigned int hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void printUsage()
+{
+    printf("Measure the decoding speed of Ogg Vorbis files and check the decoder vector paths:\n");
+    printf("    kwltremorbench oggfile1 oggfile2 ...\n");
+    printf("        -runs n\n");
+    printf("            The number of times to decode each file (optional, defaults to 10).\n");
+    printf("\n");
+    printf("The vector kernels are checked against the scalar code and the output of the inverse\n");
+    printf("MDCT and of each decoded file is hashed. Hashes must match between builds using\n");
+    printf("different vector paths.\n");
+}
+
+static const char* getArgumentValue(int argc, const char * argv[], const char* name)
+{
+    for (int i = 0; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * Checks the vector kernels against the scalar expressions they replace using random
+ * blocks of random lengths, including the extreme values MULT31 has to handle.
+ * @return The number of mismatching samples.
+ */
+static int checkKernels(void)
+{
+    static ogg_int32_t x[MAX_KERNEL_LENGTH];
+    static ogg_int32_t expected[MAX_KERNEL_LENGTH];
+    static ogg_int32_t w[MAX_KERNEL_LENGTH];
+    int numMismatches = 0;
+    
+    for (int test = 0; test < 200; test++)
+    {
+        const int length = nextRandom() & (MAX_KERNEL_LENGTH - 1);
+        const int shift = nextRandom() & 15;
+        
+        for (int i = 0; i < length; i++)
+        {
+            x[i] = nextRandom();
+            w[i] = nextRandom();
+        }
+        if (test < 4 && length > 0)
+        {
+            x[0] = (ogg_int32_t)0x80000000;
+            w[0] = (test & 1) ? (ogg_int32_t)0x80000000 : 0x7fffffff;
+        }
+        
+        /*forward windowing*/
+        for (int i = 0; i < length; i++)
+        {
+            expected[i] = MULT31(x[i], w[i]);
+        }
+        vect_mult_fw(x, w, length);
+        for (int i = 0; i < length; i++)
+        {
+            numMismatches += x[i] != expected[i];
+        }
+        
+        /*backward windowing*/
+        for (int i = 0; i < length; i++)
+        {
+            x[i] = nextRandom();
+            expected[i] = MULT31(x[i], w[length - 1 - i]);
+        }
+        if (length > 0)
+        {
+            vect_mult_bw(x, &w[length - 1], length);
+        }
+        for (int i = 0; i < length; i++)
+        {
+            numMismatches += x[i] != expected[i];
+        }
+        
+        /*overlap/add and copy*/
+        for (int i = 0; i < length; i++)
+        {
+            x[i] = nextRandom() >> 1;
+            w[i] = nextRandom() >> 1;
+            expected[i] = x[i] + w[i];
+        }
+        vect_add(x, w, length);
+        for (int i = 0; i < length; i++)
+        {
+            numMismatches += x[i] != expected[i];
+        }
+        vect_copy(x, w, length);
+        for (int i = 0; i < length; i++)
+        {
+            numMismatches += x[i] != w[i];
+        }
+        
+        /*residue accumulation*/
+        for (int i = 0; i < length; i++)
+        {
+            x[i] = nextRandom() >> 1;
+            w[i] = nextRandom() >> 1;
+            expected[i] = x[i] + (w[i] >> shift);
+        }
+        vect_add_shr(x, w, length, shift);
+        for (int i = 0; i < length; i++)
+        {
+            numMismatches += x[i] != expected[i];
+        }
+        for (int i = 0; i < length; i++)
+        {
+            x[i] = nextRandom() >> 1;
+            w[i] = nextRandom() >> 17;
+            expected[i] = x[i] + w[i] * (1 << shift);
+        }
+        vect_add_shl(x, w, length, shift);
+        for (int i = 0; i < length; i++)
+        {
+            numMismatches += x[i] != expected[i];
+        }
+    }
+    
+    return numMismatches;
+}
+
+/**
+ * Runs the inverse MDCT on random input for all block sizes Vorbis uses.
+ * @return A hash of the output.
+ */
+static unsigned int hashMDCT(void)
+{
+    static ogg_int32_t data[MAX_MDCT_SIZE];
+    unsigned int hash = 2166136261u;
+    for (int n = 64; n <= MAX_MDCT_SIZE; n *= 2)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            data[i] = nextRandom() >> 6;
+        }
+        mdct_backward(n, data, data);
+        hash = updateHash(hash, data, n * sizeof(ogg_int32_t));
+    }
+    return hash;
+}
+
+/**
+ * Decodes a file a number of times, printing the decoding speed and a hash of the output.
+ * @return Zero on success, non-zero if the file could not be decoded.
+ */
+static int benchmarkFile(const char* path, int numRuns)
+{
+    static char pcm[PCM_BUFFER_SIZE];
+    unsigned int hash = 2166136261u;
+    long long numBytes = 0;
+    double durationSec = 0.0;
+    clock_t decodeTime = 0;
+    
+    for (int run = 0; run < numRuns; run++)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            printf("Could not open %s\n", path);
+            return 1;
+        }
+        
+        const clock_t start = clock();
+        
+        OggVorbis_File vorbisFile;
+        if (ov_open(file, &vorbisFile, NULL, 0) < 0)
+        {
+            printf("%s is not an Ogg Vorbis file\n", path);
+            fclose(file);
+            return 1;
+        }
+        
+        if (run == 0)
+        {
+            durationSec = (double)ov_pcm_total(&vorbisFile, -1) / ov_info(&vorbisFile, -1)->rate;
+        }
+        
+        int bitstream = 0;
+        long numBytesRead = 0;
+        while ((numBytesRead = ov_read(&vorbisFile, pcm, PCM_BUFFER_SIZE, &bitstream)) > 0)
+        {
+            if (run == 0)
+            {
+                hash = updateHash(hash, pcm, numBytesRead);
+                numBytes += numBytesRead;
+            }
+        }
+        
+        /*closes the file*/
+        ov_clear(&vorbisFile);
+        decodeTime += clock() - start;
+        
+        if (numBytesRead < 0)
+        {
+            printf("Decoding %s failed with error code %ld\n", path, numBytesRead);
+            return 1;
+        }
+    }
+    
+    const double decodeTimeSec = (double)decodeTime / CLOCKS_PER_SEC;
+    printf("%s: %lld bytes, %.3f ms per run, %.1fx realtime, output hash %08x\n",
+           path,
+           numBytes,
+           1000.0 * decodeTimeSec / numRuns,
+           decodeTimeSec > 0.0 ? durationSec * numRuns / decodeTimeSec : 0.0,
+           hash);
+    return 0;
+}
+
+int main(int argc, const char * argv[])
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+    
+    const char* runsArg = getArgumentValue(argc - 1, &argv[1], "-runs");
+    const int numRuns = runsArg != NULL ? atoi(runsArg) : 10;
+    if (numRuns <= 0)
+    {
+        printUsage();
+        return 1;
+    }
+    
+    printf("vector path: %s\n", VECTOR_PATH);
+    
+    const int numMismatches = checkKernels();
+    printf("kernel mismatches: %d\n", numMismatches);
+    printf("mdct hash %08x\n", hashMDCT());
+    
+    int result = numMismatches != 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-runs") == 0)
+        {
+            i++;
+            continue;
+        }
+        
+        result |= benchmarkFile(argv[i], numRuns);
+    }
+    
+    return result;
+}